@@ -241,6 +241,7 @@ std::optional<BinaryMessage> AudioToolboxDecoder::Impl::Decode(const BinaryMessa
             }
             std::memcpy(memory.GetFCRAMPointer(dst - Memory::FCRAM_PADDR), out_streams[ch].data(),
                         byte_size);
+            memory.MarkRegionDirty(dst, static_cast<u32>(byte_size));
         }
     }
 
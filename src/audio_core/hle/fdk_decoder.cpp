@@ -215,6 +215,7 @@ std::optional<BinaryMessage> FDKDecoder::Impl::Decode(const BinaryMessage& reque
             }
             std::memcpy(memory.GetFCRAMPointer(dst - Memory::FCRAM_PADDR), out_streams[ch].data(),
                         byte_size);
+            memory.MarkRegionDirty(dst, static_cast<u32>(byte_size));
         }
     }
 
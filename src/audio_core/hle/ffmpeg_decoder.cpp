@@ -258,6 +258,8 @@ std::optional<BinaryMessage> FFMPEGDecoder::Impl::Decode(const BinaryMessage& re
         std::memcpy(
             memory.GetFCRAMPointer(request.decode_aac_request.dst_addr_ch0 - Memory::FCRAM_PADDR),
             out_streams[0].data(), out_streams[0].size());
+        memory.MarkRegionDirty(request.decode_aac_request.dst_addr_ch0,
+                               static_cast<u32>(out_streams[0].size()));
     }
 
     if (out_streams[1].size() != 0) {
@@ -271,6 +273,8 @@ std::optional<BinaryMessage> FFMPEGDecoder::Impl::Decode(const BinaryMessage& re
         std::memcpy(
             memory.GetFCRAMPointer(request.decode_aac_request.dst_addr_ch1 - Memory::FCRAM_PADDR),
             out_streams[1].data(), out_streams[1].size());
+        memory.MarkRegionDirty(request.decode_aac_request.dst_addr_ch1,
+                               static_cast<u32>(out_streams[1].size()));
     }
     return response;
 }
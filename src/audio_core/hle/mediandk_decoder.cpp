@@ -218,6 +218,8 @@ std::optional<BinaryMessage> MediaNDKDecoder::Impl::Decode(const BinaryMessage&
         std::memcpy(
             memory.GetFCRAMPointer(request.decode_aac_request.dst_addr_ch0 - Memory::FCRAM_PADDR),
             out_streams[0].data(), stream0_size);
+        memory.MarkRegionDirty(request.decode_aac_request.dst_addr_ch0,
+                               static_cast<u32>(stream0_size));
     }
 
     size_t stream1_size = out_streams[1].size() * sizeof(u16);
@@ -232,6 +234,8 @@ std::optional<BinaryMessage> MediaNDKDecoder::Impl::Decode(const BinaryMessage&
         std::memcpy(
             memory.GetFCRAMPointer(request.decode_aac_request.dst_addr_ch1 - Memory::FCRAM_PADDR),
             out_streams[1].data(), stream1_size);
+        memory.MarkRegionDirty(request.decode_aac_request.dst_addr_ch1,
+                               static_cast<u32>(stream1_size));
     }
     return response;
 }
@@ -279,6 +279,8 @@ std::optional<BinaryMessage> WMFDecoder::Impl::Decode(const BinaryMessage& reque
         std::memcpy(
             memory.GetFCRAMPointer(request.decode_aac_request.dst_addr_ch0 - Memory::FCRAM_PADDR),
             out_streams[0].data(), out_streams[0].size());
+        memory.MarkRegionDirty(request.decode_aac_request.dst_addr_ch0,
+                               static_cast<u32>(out_streams[0].size()));
     }
 
     if (out_streams[1].size() != 0) {
@@ -292,6 +294,8 @@ std::optional<BinaryMessage> WMFDecoder::Impl::Decode(const BinaryMessage& reque
         std::memcpy(
             memory.GetFCRAMPointer(request.decode_aac_request.dst_addr_ch1 - Memory::FCRAM_PADDR),
             out_streams[1].data(), out_streams[1].size());
+        memory.MarkRegionDirty(request.decode_aac_request.dst_addr_ch1,
+                               static_cast<u32>(out_streams[1].size()));
     }
 
     return response;
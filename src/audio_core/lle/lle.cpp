@@ -492,6 +492,7 @@ DspLle::DspLle(Memory::MemorySystem& memory, Core::Timing& timing, bool multithr
     };
     ahbm.write8 = [&memory](u32 address, u8 value) {
         *memory.GetFCRAMPointer(address - Memory::FCRAM_PADDR) = value;
+        memory.MarkRegionDirty(address, sizeof(u8));
     };
     ahbm.read16 = [&memory](u32 address) -> u16 {
         u16 value;
@@ -500,6 +501,7 @@ DspLle::DspLle(Memory::MemorySystem& memory, Core::Timing& timing, bool multithr
     };
     ahbm.write16 = [&memory](u32 address, u16 value) {
         std::memcpy(memory.GetFCRAMPointer(address - Memory::FCRAM_PADDR), &value, sizeof(u16));
+        memory.MarkRegionDirty(address, sizeof(u16));
     };
     ahbm.read32 = [&memory](u32 address) -> u32 {
         u32 value;
@@ -508,6 +510,7 @@ DspLle::DspLle(Memory::MemorySystem& memory, Core::Timing& timing, bool multithr
     };
     ahbm.write32 = [&memory](u32 address, u32 value) {
         std::memcpy(memory.GetFCRAMPointer(address - Memory::FCRAM_PADDR), &value, sizeof(u32));
+        memory.MarkRegionDirty(address, sizeof(u32));
     };
     impl->teakra.SetAHBMCallback(ahbm);
     impl->teakra.SetAudioCallback(
@@ -129,6 +129,13 @@ void Config::ReadValues() {
 
     // Core
     ReadSetting("Core", Settings::values.use_cpu_jit);
+    ReadSetting("Core", Settings::values.use_fastmem);
+    ReadSetting("Core", Settings::values.use_multi_core);
+    ReadSetting("Core", Settings::values.skip_idle_loops);
+    ReadSetting("Core", Settings::values.jit_code_cache_size);
+    ReadSetting("Core", Settings::values.enable_rewind);
+    ReadSetting("Core", Settings::values.rewind_interval);
+    ReadSetting("Core", Settings::values.rewind_buffer_size);
     ReadSetting("Core", Settings::values.cpu_clock_percentage);
 
     // Renderer
@@ -137,6 +144,11 @@ void Config::ReadValues() {
     ReadSetting("Renderer", Settings::values.use_hw_shader);
     ReadSetting("Renderer", Settings::values.shaders_accurate_mul);
     ReadSetting("Renderer", Settings::values.use_shader_jit);
+    ReadSetting("Renderer", Settings::values.sw_rasterizer_threads);
+    ReadSetting("Renderer", Settings::values.use_gpu_thread);
+    ReadSetting("Renderer", Settings::values.vertex_shader_threads);
+    ReadSetting("Renderer", Settings::values.vertex_cache_size);
+    ReadSetting("Renderer", Settings::values.texture_decode_cache_size);
     ReadSetting("Renderer", Settings::values.resolution_factor);
     ReadSetting("Renderer", Settings::values.use_disk_shader_cache);
     ReadSetting("Renderer", Settings::values.frame_limit);
@@ -91,6 +91,36 @@ udp_pad_index=
 # 0: Interpreter (slow), 1 (default): JIT (fast)
 use_cpu_jit =
 
+# Whether the JIT accesses guest memory directly through a reserved host address space window,
+# skipping the page table lookup. Falls back to the page table if the host doesn't support it.
+# 0: Off, 1 (default): On
+use_fastmem =
+
+# Whether to run each emulated CPU core on its own host thread. Requires the JIT.
+# Can improve performance in titles that use several cores, but is less accurate.
+# 0 (default): Off, 1: On
+use_multi_core =
+
+# Whether to fast-forward to the next event when the guest spins in a loop waiting for it,
+# instead of emulating every iteration.
+# 0 (default): Off, 1: On
+skip_idle_loops =
+
+# Total size in MiB of JIT compiled code kept per CPU core. Each process run on a core needs
+# 128 MiB, when the budget is full the least recently run process's code is discarded.
+# Default is 512
+jit_code_cache_size =
+
+# Keeps recent emulation states in memory so that emulation can be rewound.
+# 0 (default): Off, 1: On
+enable_rewind =
+
+# Number of frames between the states kept for rewinding. Default is 10
+rewind_interval =
+
+# Memory in MiB used for the states kept for rewinding. Default is 512
+rewind_buffer_size =
+
 # Change the Clock Frequency of the emulated 3DS CPU.
 # Underclocking can increase the performance of the game at the risk of freezing.
 # Overclocking may fix lag that happens on console, but also comes with the risk of freezing.
@@ -118,6 +148,32 @@ shaders_accurate_mul =
 # 0: Interpreter (slow), 1 (default): JIT (fast)
 use_shader_jit =
 
+# Number of host threads used by the software renderer to shade screen tiles in parallel
+# 0: One per host core, 1 (default): Off (single-threaded), N: N threads
+sw_rasterizer_threads =
+
+# Runs GPU command lists, display transfers and memory fills on a separate host thread, letting
+# the emulated CPU run in the meantime. Only takes effect with the software renderer. Emulated CPU
+# memory accesses are only ordered with the GPU thread through GPU interrupts.
+# 0 (default): Off, 1: On
+use_gpu_thread =
+
+# Number of host threads used to run the vertex shader of large non-indexed draws in parallel.
+# Only takes effect when hardware shaders are disabled or unavailable.
+# 0: One per host core, 1 (default): Off (single-threaded), N: N threads
+vertex_shader_threads =
+
+# Number of transformed vertices kept around during an indexed draw so that repeated indices don't
+# run the vertex shader again. Rounded up to a power of two, at most 65536.
+# Only takes effect when hardware shaders are disabled or unavailable.
+# 0: Off, 512 (default)
+vertex_cache_size =
+
+# Memory budget in MiB for decoded ETC1 textures, so that textures recreated after being evicted
+# from the texture cache don't need to be decoded again.
+# 0: Off, 64 (default)
+texture_decode_cache_size =
+
 # Forces VSync on the display thread. Usually doesn't impact performance, but on some drivers it can
 # so only turn this off if you notice a speed difference.
 # 0: Off, 1 (default): On
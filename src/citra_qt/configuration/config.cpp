@@ -54,7 +54,7 @@ const std::array<std::array<int, 5>, Settings::NativeAnalog::NumAnalogs> Config:
 // This must be in alphabetical order according to action name as it must have the same order as
 // UISetting::values.shortcuts, which is alphabetically ordered.
 // clang-format off
-const std::array<UISettings::Shortcut, 28> Config::default_hotkeys {{
+const std::array<UISettings::Shortcut, 29> Config::default_hotkeys {{
      {QStringLiteral("Advance Frame"),            QStringLiteral("Main Window"), {QStringLiteral(""),     Qt::ApplicationShortcut}},
      {QStringLiteral("Capture Screenshot"),       QStringLiteral("Main Window"), {QStringLiteral("Ctrl+P"), Qt::WidgetWithChildrenShortcut}},
      {QStringLiteral("Continue/Pause Emulation"), QStringLiteral("Main Window"), {QStringLiteral("F4"),     Qt::WindowShortcut}},
@@ -71,6 +71,7 @@ const std::array<UISettings::Shortcut, 28> Config::default_hotkeys {{
      {QStringLiteral("Mute Audio"),               QStringLiteral("Main Window"), {QStringLiteral("Ctrl+M"), Qt::WindowShortcut}},
      {QStringLiteral("Remove Amiibo"),            QStringLiteral("Main Window"), {QStringLiteral("F3"),     Qt::ApplicationShortcut}},
      {QStringLiteral("Restart Emulation"),        QStringLiteral("Main Window"), {QStringLiteral("F6"),     Qt::WindowShortcut}},
+     {QStringLiteral("Rewind"),                   QStringLiteral("Main Window"), {QStringLiteral("Ctrl+R"), Qt::WindowShortcut}},
      {QStringLiteral("Rotate Screens Upright"),   QStringLiteral("Main Window"), {QStringLiteral("F8"),     Qt::WindowShortcut}},
      {QStringLiteral("Save to Oldest Slot"),      QStringLiteral("Main Window"), {QStringLiteral("Ctrl+C"), Qt::WindowShortcut}},
      {QStringLiteral("Stop Emulation"),           QStringLiteral("Main Window"), {QStringLiteral("F5"),     Qt::WindowShortcut}},
@@ -450,6 +451,13 @@ void Config::ReadCoreValues() {
 
     if (global) {
         ReadBasicSetting(Settings::values.use_cpu_jit);
+        ReadBasicSetting(Settings::values.use_fastmem);
+        ReadBasicSetting(Settings::values.use_multi_core);
+        ReadBasicSetting(Settings::values.skip_idle_loops);
+        ReadBasicSetting(Settings::values.jit_code_cache_size);
+        ReadBasicSetting(Settings::values.enable_rewind);
+        ReadBasicSetting(Settings::values.rewind_interval);
+        ReadBasicSetting(Settings::values.rewind_buffer_size);
     }
 
     qt_config->endGroup();
@@ -642,6 +650,11 @@ void Config::ReadRendererValues() {
 
     if (global) {
         ReadBasicSetting(Settings::values.use_shader_jit);
+        ReadBasicSetting(Settings::values.sw_rasterizer_threads);
+        ReadBasicSetting(Settings::values.use_gpu_thread);
+        ReadBasicSetting(Settings::values.vertex_shader_threads);
+        ReadBasicSetting(Settings::values.vertex_cache_size);
+        ReadBasicSetting(Settings::values.texture_decode_cache_size);
     }
 
     qt_config->endGroup();
@@ -967,6 +980,13 @@ void Config::SaveCoreValues() {
 
     if (global) {
         WriteBasicSetting(Settings::values.use_cpu_jit);
+        WriteBasicSetting(Settings::values.use_fastmem);
+        WriteBasicSetting(Settings::values.use_multi_core);
+        WriteBasicSetting(Settings::values.skip_idle_loops);
+        WriteBasicSetting(Settings::values.jit_code_cache_size);
+        WriteBasicSetting(Settings::values.enable_rewind);
+        WriteBasicSetting(Settings::values.rewind_interval);
+        WriteBasicSetting(Settings::values.rewind_buffer_size);
     }
 
     qt_config->endGroup();
@@ -1123,6 +1143,11 @@ void Config::SaveRendererValues() {
     if (global) {
         WriteSetting(QStringLiteral("use_shader_jit"), Settings::values.use_shader_jit.GetValue(),
                      true);
+        WriteBasicSetting(Settings::values.sw_rasterizer_threads);
+        WriteBasicSetting(Settings::values.use_gpu_thread);
+        WriteBasicSetting(Settings::values.vertex_shader_threads);
+        WriteBasicSetting(Settings::values.vertex_cache_size);
+        WriteBasicSetting(Settings::values.texture_decode_cache_size);
     }
 
     qt_config->endGroup();
@@ -522,10 +522,12 @@ void GraphicsVertexShaderWidget::Reload(bool replace_vertex_data, void* vertex_d
     u32 entry_point = Pica::g_state.regs.vs.main_offset;
     info.labels.insert({entry_point, "main"});
 
-    // Generate debug information
+    // Generate debug information. The engine is local, so it runs on a copy of the setup to keep
+    // its cached program from being left behind in the emulated state.
+    Pica::Shader::ShaderSetup debug_setup = shader_setup;
     Pica::Shader::InterpreterEngine shader_engine;
-    shader_engine.SetupBatch(shader_setup, entry_point);
-    debug_data = shader_engine.ProduceDebugInfo(shader_setup, input_vertex, shader_config);
+    shader_engine.SetupBatch(debug_setup, entry_point);
+    debug_data = shader_engine.ProduceDebugInfo(debug_setup, input_vertex, shader_config);
 
     // Reload widget state
     for (int attr = 0; attr < num_attributes; ++attr) {
@@ -387,8 +387,12 @@ void GMainWindow::InitializeWidgets() {
     emu_frametime_label->setToolTip(
         tr("Time taken to emulate a 3DS frame, not counting framelimiting or v-sync. For "
            "full-speed emulation this should be at most 16.67 ms."));
+    idle_skip_label = new QLabel();
+    idle_skip_label->setToolTip(
+        tr("Share of the emulated CPU time that was skipped because the game was waiting in an "
+           "idle loop, summed over all CPU cores. Skipped time isn't emulated."));
 
-    for (auto& label : {emu_speed_label, game_fps_label, emu_frametime_label}) {
+    for (auto& label : {emu_speed_label, game_fps_label, emu_frametime_label, idle_skip_label}) {
         label->setVisible(false);
         label->setFrameStyle(QFrame::NoFrame);
         label->setContentsMargins(4, 0, 4, 0);
@@ -658,6 +662,13 @@ void GMainWindow::InitializeHotkeys() {
     });
     connect_shortcut(QStringLiteral("Mute Audio"),
                      [] { Settings::values.audio_muted = !Settings::values.audio_muted; });
+    // Goes back about a second each time
+    static constexpr u32 REWIND_FRAMES = 60;
+    connect_shortcut(QStringLiteral("Rewind"), [&] {
+        if (emulation_running) {
+            system.SendSignal(Core::System::Signal::Rewind, REWIND_FRAMES);
+        }
+    });
 
     // We use "static" here in order to avoid capturing by lambda due to a MSVC bug, which makes the
     // variable hold a garbage value after this function exits
@@ -1339,6 +1350,7 @@ void GMainWindow::ShutdownGame() {
     emu_speed_label->setVisible(false);
     game_fps_label->setVisible(false);
     emu_frametime_label->setVisible(false);
+    idle_skip_label->setVisible(false);
 
     UpdateSaveStates();
 
@@ -2421,10 +2433,12 @@ void GMainWindow::UpdateStatusBar() {
     }
     game_fps_label->setText(tr("Game: %1 FPS").arg(results.game_fps, 0, 'f', 0));
     emu_frametime_label->setText(tr("Frame: %1 ms").arg(results.frametime * 1000.0, 0, 'f', 2));
+    idle_skip_label->setText(tr("Idle: %1%").arg(results.idle_skip_ratio * 100.0, 0, 'f', 0));
 
     emu_speed_label->setVisible(true);
     game_fps_label->setVisible(true);
     emu_frametime_label->setVisible(true);
+    idle_skip_label->setVisible(Settings::values.skip_idle_loops.GetValue());
 }
 
 void GMainWindow::UpdateBootHomeMenuState() {
@@ -2840,6 +2854,9 @@ void GMainWindow::RetranslateStatusBar() {
     emu_frametime_label->setToolTip(
         tr("Time taken to emulate a 3DS frame, not counting framelimiting or v-sync. For "
            "full-speed emulation this should be at most 16.67 ms."));
+    idle_skip_label->setToolTip(
+        tr("Share of the emulated CPU time that was skipped because the game was waiting in an "
+           "idle loop, summed over all CPU cores. Skipped time isn't emulated."));
 
     multiplayer_state->retranslateUi();
 }
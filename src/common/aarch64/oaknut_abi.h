@@ -0,0 +1,136 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "common/arch.h"
+#if CITRA_ARCH(arm64)
+
+#include <bitset>
+#include <initializer_list>
+#include <vector>
+#include <oaknut/oaknut.hpp>
+#include "common/assert.h"
+#include "common/common_types.h"
+
+namespace Common::A64 {
+
+constexpr std::size_t RegToIndex(const oaknut::Reg& reg) {
+    ASSERT_MSG(reg.index() >= 0 && reg.index() < 32, "RegSet only supports X0-X30 and V0-V31.");
+    return static_cast<std::size_t>(reg.index()) + (reg.is_vector() ? 32 : 0);
+}
+
+inline std::bitset<64> BuildRegSet(std::initializer_list<oaknut::Reg> regs) {
+    std::bitset<64> bits;
+    for (const oaknut::Reg& reg : regs) {
+        bits[RegToIndex(reg)] = true;
+    }
+    return bits;
+}
+
+constexpr inline std::bitset<64> ABI_ALL_GPRS(0x00000000'FFFFFFFF);
+constexpr inline std::bitset<64> ABI_ALL_FPRS(0xFFFFFFFF'00000000);
+
+constexpr inline oaknut::XReg ABI_RETURN = oaknut::util::X0;
+constexpr inline oaknut::XReg ABI_PARAM1 = oaknut::util::X0;
+constexpr inline oaknut::XReg ABI_PARAM2 = oaknut::util::X1;
+constexpr inline oaknut::XReg ABI_PARAM3 = oaknut::util::X2;
+constexpr inline oaknut::XReg ABI_PARAM4 = oaknut::util::X3;
+
+// AAPCS64: X0-X18 are caller saved. Only the lower 64 bits of V8-V15 are preserved by the callee,
+// so all vector registers are treated as caller saved.
+constexpr inline std::bitset<64> ABI_ALL_CALLER_SAVED(0xFFFFFFFF'0007FFFF);
+
+// X19-X28, the frame pointer X29, the link register X30 and V8-V15
+constexpr inline std::bitset<64> ABI_ALL_CALLEE_SAVED(0x0000FF00'7FF80000);
+
+struct ABIFrameInfo {
+    u32 gprs_size;
+    u32 fprs_size;
+};
+
+inline ABIFrameInfo ABI_CalculateFrameSize(std::bitset<64> regs) {
+    const u32 gprs_count = static_cast<u32>((regs & ABI_ALL_GPRS).count());
+    const u32 fprs_count = static_cast<u32>((regs & ABI_ALL_FPRS).count());
+    // The stack pointer must stay 16-byte aligned at all times
+    return ABIFrameInfo{(gprs_count * 8 + 15) & ~15u, fprs_count * 16};
+}
+
+inline void ABI_PushRegisters(oaknut::CodeGenerator& code, std::bitset<64> regs) {
+    const ABIFrameInfo frame_info = ABI_CalculateFrameSize(regs);
+    const u32 frame_size = frame_info.gprs_size + frame_info.fprs_size;
+    if (frame_size == 0) {
+        return;
+    }
+
+    std::vector<oaknut::XReg> gprs;
+    std::vector<oaknut::QReg> fprs;
+    for (int i = 0; i < 32; ++i) {
+        if (regs[i]) {
+            gprs.emplace_back(i);
+        }
+        if (regs[i + 32]) {
+            fprs.emplace_back(i);
+        }
+    }
+
+    code.SUB(oaknut::util::SP, oaknut::util::SP, frame_size);
+
+    u32 offset = 0;
+    for (std::size_t i = 0; i + 1 < gprs.size(); i += 2, offset += 16) {
+        code.STP(gprs[i], gprs[i + 1], oaknut::util::SP, offset);
+    }
+    if (gprs.size() % 2 != 0) {
+        code.STR(gprs.back(), oaknut::util::SP, offset);
+    }
+
+    offset = frame_info.gprs_size;
+    for (std::size_t i = 0; i + 1 < fprs.size(); i += 2, offset += 32) {
+        code.STP(fprs[i], fprs[i + 1], oaknut::util::SP, offset);
+    }
+    if (fprs.size() % 2 != 0) {
+        code.STR(fprs.back(), oaknut::util::SP, offset);
+    }
+}
+
+inline void ABI_PopRegisters(oaknut::CodeGenerator& code, std::bitset<64> regs) {
+    const ABIFrameInfo frame_info = ABI_CalculateFrameSize(regs);
+    const u32 frame_size = frame_info.gprs_size + frame_info.fprs_size;
+    if (frame_size == 0) {
+        return;
+    }
+
+    std::vector<oaknut::XReg> gprs;
+    std::vector<oaknut::QReg> fprs;
+    for (int i = 0; i < 32; ++i) {
+        if (regs[i]) {
+            gprs.emplace_back(i);
+        }
+        if (regs[i + 32]) {
+            fprs.emplace_back(i);
+        }
+    }
+
+    u32 offset = 0;
+    for (std::size_t i = 0; i + 1 < gprs.size(); i += 2, offset += 16) {
+        code.LDP(gprs[i], gprs[i + 1], oaknut::util::SP, offset);
+    }
+    if (gprs.size() % 2 != 0) {
+        code.LDR(gprs.back(), oaknut::util::SP, offset);
+    }
+
+    offset = frame_info.gprs_size;
+    for (std::size_t i = 0; i + 1 < fprs.size(); i += 2, offset += 32) {
+        code.LDP(fprs[i], fprs[i + 1], oaknut::util::SP, offset);
+    }
+    if (fprs.size() % 2 != 0) {
+        code.LDR(fprs.back(), oaknut::util::SP, offset);
+    }
+
+    code.ADD(oaknut::util::SP, oaknut::util::SP, frame_size);
+}
+
+} // namespace Common::A64
+
+#endif // CITRA_ARCH(arm64)
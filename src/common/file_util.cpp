@@ -51,6 +51,7 @@
 #include <cstring>
 #include <dirent.h>
 #include <pwd.h>
+#include <sys/mman.h>
 #include <unistd.h>
 #endif
 
@@ -1184,6 +1185,51 @@ bool IOFile::Resize(u64 size) {
     return m_good;
 }
 
+MappedFile::MappedFile(const std::string& filename) : file(filename, "rb") {
+    const u64 file_size = file.GetSize();
+    if (!file.IsOpen() || file_size == 0 || file_size > std::numeric_limits<std::size_t>::max()) {
+        return;
+    }
+
+#ifdef _WIN32
+    const auto handle = reinterpret_cast<HANDLE>(_get_osfhandle(file.GetFd()));
+    mapping = CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        LOG_ERROR(Common_Filesystem, "Failed to map file {}: {}", filename, GetLastErrorMsg());
+        return;
+    }
+    data = static_cast<const u8*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (data == nullptr) {
+        LOG_ERROR(Common_Filesystem, "Failed to map file {}: {}", filename, GetLastErrorMsg());
+        return;
+    }
+#else
+    void* const pointer =
+        mmap(nullptr, static_cast<std::size_t>(file_size), PROT_READ, MAP_PRIVATE, file.GetFd(), 0);
+    if (pointer == MAP_FAILED) {
+        LOG_ERROR(Common_Filesystem, "Failed to map file {}: {}", filename, GetLastErrorMsg());
+        return;
+    }
+    data = static_cast<const u8*>(pointer);
+#endif
+    size = static_cast<std::size_t>(file_size);
+}
+
+MappedFile::~MappedFile() {
+#ifdef _WIN32
+    if (data != nullptr) {
+        UnmapViewOfFile(data);
+    }
+    if (mapping != nullptr) {
+        CloseHandle(mapping);
+    }
+#else
+    if (data != nullptr) {
+        munmap(const_cast<u8*>(data), size);
+    }
+#endif
+}
+
 template <typename T>
 using boost_iostreams = boost::iostreams::stream<T>;
 
@@ -10,6 +10,7 @@
 #include <ios>
 #include <limits>
 #include <optional>
+#include <span>
 #include <string>
 #include <string_view>
 #include <type_traits>
@@ -393,6 +394,30 @@ private:
     friend class boost::serialization::access;
 };
 
+// Read-only mapping of a whole file into memory, so that it can be read without copying it into
+// a buffer first
+class MappedFile : public NonCopyable {
+public:
+    explicit MappedFile(const std::string& filename);
+    ~MappedFile();
+
+    [[nodiscard]] bool IsOpen() const {
+        return data != nullptr;
+    }
+
+    [[nodiscard]] std::span<const u8> Data() const {
+        return {data, size};
+    }
+
+private:
+    IOFile file;
+    const u8* data = nullptr;
+    std::size_t size = 0;
+#ifdef _WIN32
+    void* mapping = nullptr;
+#endif
+};
+
 template <std::ios_base::openmode o, typename T>
 void OpenFStream(T& fstream, const std::string& filename);
 } // namespace FileUtil
@@ -0,0 +1,171 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+#endif
+
+#include <fmt/format.h>
+#include "common/assert.h"
+#include "common/host_memory.h"
+#include "common/logging/log.h"
+
+namespace Common {
+
+#ifdef _WIN32
+
+// Aliasing on Windows needs the placeholder APIs of Windows 10 1803, so only the plain
+// allocation is provided there for now.
+
+HostMemory::HostMemory(std::size_t backing_size_) : backing_size{backing_size_} {
+    backing_base = static_cast<u8*>(
+        VirtualAlloc(nullptr, backing_size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+    ASSERT_MSG(backing_base, "Failed to allocate {} bytes of host memory", backing_size);
+}
+
+HostMemory::~HostMemory() {
+    VirtualFree(backing_base, 0, MEM_RELEASE);
+}
+
+std::unique_ptr<HostMemory::Window> HostMemory::ReserveWindow(std::size_t) {
+    return nullptr;
+}
+
+HostMemory::Window::Window(int fd_, u8* base_, std::size_t size_)
+    : fd{fd_}, base{base_}, size{size_} {}
+
+HostMemory::Window::~Window() = default;
+
+void HostMemory::Window::Map(std::size_t, std::size_t, std::size_t) {
+    UNREACHABLE();
+}
+
+void HostMemory::Window::Unmap(std::size_t, std::size_t) {
+    UNREACHABLE();
+}
+
+void HostMemory::Window::Protect(std::size_t, std::size_t, bool) {
+    UNREACHABLE();
+}
+
+#else
+
+#ifndef MAP_NORESERVE
+#define MAP_NORESERVE 0
+#endif
+
+namespace {
+
+/// Creates an anonymous shared memory file descriptor, or returns -1 on failure
+int CreateSharedMemoryFile() {
+#if defined(__linux__)
+    return static_cast<int>(syscall(SYS_memfd_create, "HostMemory", 0));
+#elif defined(__FreeBSD__)
+    return shm_open(SHM_ANON, O_RDWR, 0600);
+#else
+    static int counter = 0;
+    const std::string name = fmt::format("/citra-host-memory-{}-{}", getpid(), counter++);
+    const int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd != -1) {
+        shm_unlink(name.c_str());
+    }
+    return fd;
+#endif
+}
+
+} // Anonymous namespace
+
+HostMemory::HostMemory(std::size_t backing_size_) : backing_size{backing_size_} {
+    fd = CreateSharedMemoryFile();
+    if (fd != -1 && ftruncate(fd, static_cast<off_t>(backing_size)) == 0) {
+        void* const ptr = mmap(nullptr, backing_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (ptr != MAP_FAILED) {
+            backing_base = static_cast<u8*>(ptr);
+            return;
+        }
+    }
+
+    LOG_WARNING(Common_Memory, "Shared host memory is unavailable, aliasing disabled: {}",
+                std::strerror(errno));
+    if (fd != -1) {
+        close(fd);
+        fd = -1;
+    }
+
+    void* const ptr = mmap(nullptr, backing_size, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    ASSERT_MSG(ptr != MAP_FAILED, "Failed to allocate {} bytes of host memory", backing_size);
+    backing_base = static_cast<u8*>(ptr);
+}
+
+HostMemory::~HostMemory() {
+    munmap(backing_base, backing_size);
+    if (fd != -1) {
+        close(fd);
+    }
+}
+
+std::unique_ptr<HostMemory::Window> HostMemory::ReserveWindow(std::size_t size) {
+    if (!SupportsWindows()) {
+        return nullptr;
+    }
+
+    void* const ptr =
+        mmap(nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (ptr == MAP_FAILED) {
+        LOG_WARNING(Common_Memory, "Failed to reserve a {:#x} byte host memory window: {}", size,
+                    std::strerror(errno));
+        return nullptr;
+    }
+    return std::unique_ptr<Window>(new Window(fd, static_cast<u8*>(ptr), size));
+}
+
+HostMemory::Window::Window(int fd_, u8* base_, std::size_t size_)
+    : fd{fd_}, base{base_}, size{size_} {}
+
+HostMemory::Window::~Window() {
+    munmap(base, size);
+}
+
+void HostMemory::Window::Map(std::size_t window_offset, std::size_t host_offset,
+                             std::size_t length) {
+    ASSERT(window_offset + length <= size);
+    void* const ptr = mmap(base + window_offset, length, PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_FIXED, fd, static_cast<off_t>(host_offset));
+    // Leaving the range inaccessible is safe, accesses will just take the slow path
+    if (ptr == MAP_FAILED) {
+        LOG_ERROR(Common_Memory, "Failed to map {:#x} bytes at window offset {:#x}: {}", length,
+                  window_offset, std::strerror(errno));
+    }
+}
+
+void HostMemory::Window::Unmap(std::size_t window_offset, std::size_t length) {
+    ASSERT(window_offset + length <= size);
+    void* const ptr = mmap(base + window_offset, length, PROT_NONE,
+                           MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0);
+    ASSERT_MSG(ptr != MAP_FAILED, "Failed to unmap {:#x} bytes at window offset {:#x}: {}", length,
+               window_offset, std::strerror(errno));
+}
+
+void HostMemory::Window::Protect(std::size_t window_offset, std::size_t length, bool writable) {
+    ASSERT(window_offset + length <= size);
+    const int result =
+        mprotect(base + window_offset, length, writable ? PROT_READ | PROT_WRITE : PROT_READ);
+    ASSERT_MSG(result == 0, "Failed to protect {:#x} bytes at window offset {:#x}: {}", length,
+               window_offset, std::strerror(errno));
+}
+
+#endif
+
+} // namespace Common
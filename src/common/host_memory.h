@@ -0,0 +1,84 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include "common/common_types.h"
+
+namespace Common {
+
+/**
+ * Zero initialized host memory that can be aliased into reserved ranges of host address space,
+ * so that the same memory is visible at several host addresses. Aliasing requires host support
+ * (currently POSIX shared memory); without it the memory is a plain allocation.
+ */
+class HostMemory {
+public:
+    explicit HostMemory(std::size_t backing_size);
+    ~HostMemory();
+
+    HostMemory(const HostMemory&) = delete;
+    HostMemory& operator=(const HostMemory&) = delete;
+
+    /**
+     * A reserved range of host address space. Unmapped parts of the window are inaccessible and
+     * fault when accessed.
+     */
+    class Window {
+    public:
+        ~Window();
+
+        Window(const Window&) = delete;
+        Window& operator=(const Window&) = delete;
+
+        u8* BasePointer() const noexcept {
+            return base;
+        }
+
+        /// Makes [window_offset, window_offset + length) alias the backing memory at host_offset
+        void Map(std::size_t window_offset, std::size_t host_offset, std::size_t length);
+
+        /// Makes [window_offset, window_offset + length) inaccessible
+        void Unmap(std::size_t window_offset, std::size_t length);
+
+        /// Allows or forbids writes to the mapped range [window_offset, window_offset + length)
+        void Protect(std::size_t window_offset, std::size_t length, bool writable);
+
+    private:
+        friend class HostMemory;
+        Window(int fd, u8* base, std::size_t size);
+
+        int fd;
+        u8* base;
+        std::size_t size;
+    };
+
+    u8* BackingBasePointer() const noexcept {
+        return backing_base;
+    }
+
+    std::size_t BackingSize() const noexcept {
+        return backing_size;
+    }
+
+    /// Returns true if the backing memory can be aliased into windows
+    bool SupportsWindows() const noexcept {
+        return fd != -1;
+    }
+
+    /**
+     * Reserves a window of size bytes with nothing mapped in it.
+     * @returns The window, or nullptr if windows aren't supported or the reservation failed.
+     */
+    std::unique_ptr<Window> ReserveWindow(std::size_t size);
+
+private:
+    std::size_t backing_size;
+    u8* backing_base = nullptr;
+    int fd = -1;
+};
+
+} // namespace Common
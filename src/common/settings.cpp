@@ -69,6 +69,13 @@ void LogSettings() {
 
     LOG_INFO(Config, "Citra Configuration:");
     log_setting("Core_UseCpuJit", values.use_cpu_jit.GetValue());
+    log_setting("Core_UseFastmem", values.use_fastmem.GetValue());
+    log_setting("Core_UseMultiCore", values.use_multi_core.GetValue());
+    log_setting("Core_SkipIdleLoops", values.skip_idle_loops.GetValue());
+    log_setting("Core_JitCodeCacheSize", values.jit_code_cache_size.GetValue());
+    log_setting("Core_EnableRewind", values.enable_rewind.GetValue());
+    log_setting("Core_RewindInterval", values.rewind_interval.GetValue());
+    log_setting("Core_RewindBufferSize", values.rewind_buffer_size.GetValue());
     log_setting("Core_CPUClockPercentage", values.cpu_clock_percentage.GetValue());
     log_setting("Renderer_UseGLES", values.use_gles.GetValue());
     log_setting("Renderer_GraphicsAPI", GetGraphicsAPIName(values.graphics_api.GetValue()));
@@ -76,6 +83,11 @@ void LogSettings() {
     log_setting("Renderer_UseHwShader", values.use_hw_shader.GetValue());
     log_setting("Renderer_ShadersAccurateMul", values.shaders_accurate_mul.GetValue());
     log_setting("Renderer_UseShaderJit", values.use_shader_jit.GetValue());
+    log_setting("Renderer_SwRasterizerThreads", values.sw_rasterizer_threads.GetValue());
+    log_setting("Renderer_UseGpuThread", values.use_gpu_thread.GetValue());
+    log_setting("Renderer_VertexShaderThreads", values.vertex_shader_threads.GetValue());
+    log_setting("Renderer_VertexCacheSize", values.vertex_cache_size.GetValue());
+    log_setting("Renderer_TextureDecodeCacheSize", values.texture_decode_cache_size.GetValue());
     log_setting("Renderer_UseResolutionFactor", values.resolution_factor.GetValue());
     log_setting("Renderer_FrameLimit", values.frame_limit.GetValue());
     log_setting("Renderer_VSyncNew", values.use_vsync_new.GetValue());
@@ -412,6 +412,13 @@ struct Values {
 
     // Core
     Setting<bool> use_cpu_jit{true, "use_cpu_jit"};
+    Setting<bool> use_fastmem{true, "use_fastmem"};
+    Setting<bool> use_multi_core{false, "use_multi_core"};
+    Setting<bool> skip_idle_loops{false, "skip_idle_loops"};
+    Setting<u32> jit_code_cache_size{512, "jit_code_cache_size"};
+    Setting<bool> enable_rewind{false, "enable_rewind"};
+    Setting<u32> rewind_interval{10, "rewind_interval"};
+    Setting<u32> rewind_buffer_size{512, "rewind_buffer_size"};
     SwitchableSetting<s32, true> cpu_clock_percentage{100, 5, 400, "cpu_clock_percentage"};
     SwitchableSetting<bool> is_new_3ds{true, "is_new_3ds"};
 
@@ -439,6 +446,11 @@ struct Values {
     SwitchableSetting<bool> shaders_accurate_mul{true, "shaders_accurate_mul"};
     SwitchableSetting<bool> use_vsync_new{true, "use_vsync_new"};
     Setting<bool> use_shader_jit{true, "use_shader_jit"};
+    Setting<u32> sw_rasterizer_threads{1, "sw_rasterizer_threads"};
+    Setting<bool> use_gpu_thread{false, "use_gpu_thread"};
+    Setting<u32> vertex_shader_threads{1, "vertex_shader_threads"};
+    Setting<u32> vertex_cache_size{512, "vertex_cache_size"};
+    Setting<u32> texture_decode_cache_size{64, "texture_decode_cache_size"};
     SwitchableSetting<u32, true> resolution_factor{1, 0, 10, "resolution_factor"};
     SwitchableSetting<u16, true> frame_limit{100, 0, 1000, "frame_limit"};
     SwitchableSetting<TextureFilter> texture_filter{TextureFilter::None, "texture_filter"};
@@ -4,9 +4,11 @@
 
 #pragma once
 
+#include <algorithm>
 #include <atomic>
 #include <condition_variable>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
@@ -120,4 +122,17 @@ private:
 
 using ThreadWorker = StatefulThreadWorker<>;
 
+/**
+ * Returns a process wide worker pool for splitting short CPU bound jobs across the host cores,
+ * or nullptr if the host has too few cores for it to be worthwhile.
+ */
+inline ThreadWorker* GetSharedThreadWorker() {
+    static const std::unique_ptr<ThreadWorker> workers = [] {
+        const unsigned num_workers = std::max(std::thread::hardware_concurrency(), 2U) - 1;
+        return num_workers > 1 ? std::make_unique<ThreadWorker>(num_workers, "SharedWorker")
+                               : nullptr;
+    }();
+    return workers.get();
+}
+
 } // namespace Common
@@ -32,6 +32,35 @@ std::vector<u8> CompressDataZSTDDefault(std::span<const u8> source) {
     return CompressDataZSTD(source, ZSTD_CLEVEL_DEFAULT);
 }
 
+std::vector<u8> CompressDataZSTDMultithreaded(std::span<const u8> source, s32 compression_level,
+                                              u32 num_threads) {
+    compression_level = std::clamp(compression_level, ZSTD_minCLevel(), ZSTD_maxCLevel());
+
+    ZSTD_CCtx* const context = ZSTD_createCCtx();
+    if (context == nullptr) {
+        return {};
+    }
+    ZSTD_CCtx_setParameter(context, ZSTD_c_compressionLevel, compression_level);
+    // This fails without multithreading support, leaving all the work to the calling thread
+    ZSTD_CCtx_setParameter(context, ZSTD_c_nbWorkers,
+                           num_threads > 1 ? static_cast<int>(num_threads) : 0);
+
+    std::vector<u8> compressed(ZSTD_compressBound(source.size()));
+    const std::size_t compressed_size = ZSTD_compress2(context, compressed.data(),
+                                                       compressed.size(), source.data(),
+                                                       source.size());
+    ZSTD_freeCCtx(context);
+
+    if (ZSTD_isError(compressed_size)) {
+        // Compression failed
+        return {};
+    }
+
+    compressed.resize(compressed_size);
+
+    return compressed;
+}
+
 std::vector<u8> DecompressDataZSTD(std::span<const u8> compressed) {
     const std::size_t decompressed_size =
         ZSTD_getFrameContentSize(compressed.data(), compressed.size());
@@ -47,4 +76,38 @@ std::vector<u8> DecompressDataZSTD(std::span<const u8> compressed) {
     return decompressed;
 }
 
+ZSTDDecompressStreamBuffer::ZSTDDecompressStreamBuffer(std::span<const u8> compressed_)
+    : context(ZSTD_createDCtx()), compressed(compressed_), buffer(ZSTD_DStreamOutSize()) {
+    failed = context == nullptr;
+    setg(buffer.data(), buffer.data(), buffer.data());
+}
+
+ZSTDDecompressStreamBuffer::~ZSTDDecompressStreamBuffer() {
+    ZSTD_freeDCtx(context);
+}
+
+ZSTDDecompressStreamBuffer::int_type ZSTDDecompressStreamBuffer::underflow() {
+    if (gptr() < egptr()) {
+        return traits_type::to_int_type(*gptr());
+    }
+
+    // Output can still be pending after all input was consumed if the buffer was filled up
+    while (!failed && (compressed_offset < compressed.size() || output_pending)) {
+        ZSTD_inBuffer input{compressed.data(), compressed.size(), compressed_offset};
+        ZSTD_outBuffer output{buffer.data(), buffer.size(), 0};
+        const std::size_t result = ZSTD_decompressStream(context, &output, &input);
+        if (ZSTD_isError(result)) {
+            failed = true;
+            break;
+        }
+        compressed_offset = input.pos;
+        output_pending = output.pos == output.size;
+        if (output.pos != 0) {
+            setg(buffer.data(), buffer.data(), buffer.data() + output.pos);
+            return traits_type::to_int_type(*gptr());
+        }
+    }
+    return traits_type::eof();
+}
+
 } // namespace Common::Compression
@@ -5,10 +5,13 @@
 #pragma once
 
 #include <span>
+#include <streambuf>
 #include <vector>
 
 #include "common/common_types.h"
 
+struct ZSTD_DCtx_s;
+
 namespace Common::Compression {
 
 /**
@@ -31,6 +34,21 @@ namespace Common::Compression {
  */
 [[nodiscard]] std::vector<u8> CompressDataZSTDDefault(std::span<const u8> source);
 
+/**
+ * Compresses a source memory region with Zstandard using several threads and returns the
+ * compressed data in a vector. If Zstandard was built without multithreading support, the data is
+ * compressed on the calling thread only.
+ *
+ * @param source the uncompressed source memory region.
+ * @param compression_level the used compression level. Should be between 1 and 22.
+ * @param num_threads the number of threads to compress with.
+ *
+ * @return the compressed data.
+ */
+[[nodiscard]] std::vector<u8> CompressDataZSTDMultithreaded(std::span<const u8> source,
+                                                            s32 compression_level,
+                                                            u32 num_threads);
+
 /**
  * Decompresses a source memory region with Zstandard and returns the uncompressed data in a vector.
  *
@@ -40,4 +58,34 @@ namespace Common::Compression {
  */
 [[nodiscard]] std::vector<u8> DecompressDataZSTD(std::span<const u8> compressed);
 
+/**
+ * Stream buffer that decompresses a Zstandard compressed memory region as it is read, so that the
+ * decompressed data never has to be held in memory as a whole.
+ */
+class ZSTDDecompressStreamBuffer : public std::streambuf {
+public:
+    /// @param compressed the compressed source memory region, which must outlive the buffer.
+    explicit ZSTDDecompressStreamBuffer(std::span<const u8> compressed);
+    ~ZSTDDecompressStreamBuffer() override;
+
+    ZSTDDecompressStreamBuffer(const ZSTDDecompressStreamBuffer&) = delete;
+    ZSTDDecompressStreamBuffer& operator=(const ZSTDDecompressStreamBuffer&) = delete;
+
+    /// Returns true if decompression stopped because the compressed data is invalid
+    [[nodiscard]] bool HasFailed() const {
+        return failed;
+    }
+
+protected:
+    int_type underflow() override;
+
+private:
+    ZSTD_DCtx_s* context;
+    std::span<const u8> compressed;
+    std::size_t compressed_offset = 0;
+    std::vector<char> buffer;
+    bool output_pending = false;
+    bool failed = false;
+};
+
 } // namespace Common::Compression
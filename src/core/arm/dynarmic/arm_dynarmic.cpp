@@ -2,11 +2,13 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cstring>
 #include <dynarmic/interface/A32/a32.h>
 #include <dynarmic/interface/optimization_flags.h>
 #include "common/assert.h"
 #include "common/microprofile.h"
+#include "common/settings.h"
 #include "core/arm/dynarmic/arm_dynarmic.h"
 #include "core/arm/dynarmic/arm_dynarmic_cp15.h"
 #include "core/arm/dynarmic/arm_exclusive_monitor.h"
@@ -17,6 +19,28 @@
 #include "core/hle/kernel/svc.h"
 #include "core/memory.h"
 
+namespace {
+
+/// Number of slices in a row that must end in the same guest state before it is treated as idle
+constexpr u32 IDLE_LOOP_MIN_SLICES = 2;
+
+/// Maximum number of instructions stepped while waiting for an idle loop to come around again
+constexpr u32 IDLE_LOOP_PROBE_STEPS = 64;
+
+/// Size of the code cache of each JIT instance, the Dynarmic default
+constexpr std::size_t JIT_CODE_CACHE_SIZE = 128 * 1024 * 1024;
+
+/// Size of the code cache of the JIT instance probing idle loops, which only runs a few blocks
+constexpr std::size_t IDLE_PROBE_CODE_CACHE_SIZE = 8 * 1024 * 1024;
+
+/// Total code cache size allowed per core, always enough for at least one JIT instance
+std::size_t JitCodeCacheBudget() {
+    const std::size_t budget = std::size_t{Settings::values.jit_code_cache_size.GetValue()} << 20;
+    return std::max(budget, JIT_CODE_CACHE_SIZE);
+}
+
+} // Anonymous namespace
+
 class DynarmicThreadContext final : public ARM_Interface::ThreadContext {
 public:
     DynarmicThreadContext() {
@@ -79,42 +103,92 @@ public:
         : parent(parent), svc_context(parent.system), memory(parent.memory) {}
     ~DynarmicUserCallbacks() = default;
 
+    /**
+     * Holds System::LockCore for a callback. A core that runs guest code on its own host thread
+     * holds the page table mutex shared, which it gives up until the callback returns so that
+     * the kernel can change page tables while it holds the core lock.
+     */
+    class CoreLock {
+    public:
+        explicit CoreLock(ARM_Dynarmic& parent) : page_table_lock{parent.page_table_lock} {
+            relock = page_table_lock.owns_lock();
+            if (relock) {
+                page_table_lock.unlock();
+            }
+            core_lock = parent.system.LockCore(parent);
+        }
+
+        ~CoreLock() {
+            if (core_lock.owns_lock()) {
+                core_lock.unlock();
+            }
+            if (relock) {
+                page_table_lock.lock();
+            }
+        }
+
+    private:
+        std::shared_lock<std::shared_mutex>& page_table_lock;
+        std::unique_lock<std::recursive_mutex> core_lock;
+        bool relock;
+    };
+
     std::uint8_t MemoryRead8(VAddr vaddr) override {
+        const CoreLock lock{parent};
         return memory.Read8(vaddr);
     }
     std::uint16_t MemoryRead16(VAddr vaddr) override {
+        const CoreLock lock{parent};
         return memory.Read16(vaddr);
     }
     std::uint32_t MemoryRead32(VAddr vaddr) override {
+        const CoreLock lock{parent};
         return memory.Read32(vaddr);
     }
     std::uint64_t MemoryRead64(VAddr vaddr) override {
+        const CoreLock lock{parent};
         return memory.Read64(vaddr);
     }
 
     void MemoryWrite8(VAddr vaddr, std::uint8_t value) override {
+        const CoreLock lock{parent};
+        parent.idle_probe_wrote_memory = true;
         memory.Write8(vaddr, value);
     }
     void MemoryWrite16(VAddr vaddr, std::uint16_t value) override {
+        const CoreLock lock{parent};
+        parent.idle_probe_wrote_memory = true;
         memory.Write16(vaddr, value);
     }
     void MemoryWrite32(VAddr vaddr, std::uint32_t value) override {
+        const CoreLock lock{parent};
+        parent.idle_probe_wrote_memory = true;
         memory.Write32(vaddr, value);
     }
     void MemoryWrite64(VAddr vaddr, std::uint64_t value) override {
+        const CoreLock lock{parent};
+        parent.idle_probe_wrote_memory = true;
         memory.Write64(vaddr, value);
     }
 
     bool MemoryWriteExclusive8(u32 vaddr, u8 value, u8 expected) override {
+        const CoreLock lock{parent};
+        parent.idle_probe_wrote_memory = true;
         return memory.WriteExclusive8(vaddr, value, expected);
     }
     bool MemoryWriteExclusive16(u32 vaddr, u16 value, u16 expected) override {
+        const CoreLock lock{parent};
+        parent.idle_probe_wrote_memory = true;
         return memory.WriteExclusive16(vaddr, value, expected);
     }
     bool MemoryWriteExclusive32(u32 vaddr, u32 value, u32 expected) override {
+        const CoreLock lock{parent};
+        parent.idle_probe_wrote_memory = true;
         return memory.WriteExclusive32(vaddr, value, expected);
     }
     bool MemoryWriteExclusive64(u32 vaddr, u64 value, u64 expected) override {
+        const CoreLock lock{parent};
+        parent.idle_probe_wrote_memory = true;
         return memory.WriteExclusive64(vaddr, value, expected);
     }
 
@@ -125,6 +199,7 @@ public:
     }
 
     void CallSVC(std::uint32_t swi) override {
+        const CoreLock lock{parent};
         svc_context.CallSVC(swi);
     }
 
@@ -137,6 +212,8 @@ public:
             break;
         case Dynarmic::A32::Exception::Breakpoint:
             if (GDBStub::IsConnected()) {
+                // ServeBreak reads the current thread of the running core
+                const CoreLock lock{parent};
                 parent.jit->HaltExecution();
                 parent.SetPC(pc);
                 parent.ServeBreak();
@@ -153,6 +230,7 @@ public:
         case Dynarmic::A32::Exception::PreloadInstruction:
             return;
         }
+        const CoreLock lock{parent};
         ASSERT_MSG(false, "ExceptionRaised(exception = {}, pc = {:08X}, code = {:08X})", exception,
                    pc, MemoryReadCode(pc).value());
     }
@@ -182,15 +260,47 @@ ARM_Dynarmic::ARM_Dynarmic(Core::System* system_, Memory::MemorySystem& memory_,
     SetPageTable(memory.GetCurrentPageTable());
 }
 
-ARM_Dynarmic::~ARM_Dynarmic() = default;
+ARM_Dynarmic::~ARM_Dynarmic() {
+    LOG_INFO(Core_ARM11, "Core {} created {} JIT instances and evicted {}, code cache {}/{} MiB",
+             GetID(), jit_stats.creations, jit_stats.evictions, jit_stats.code_cache_size >> 20,
+             jit_stats.code_cache_budget >> 20);
+}
 
 MICROPROFILE_DEFINE(ARM_Jit, "ARM JIT", "ARM JIT", MP_RGB(255, 64, 64));
 
 void ARM_Dynarmic::Run() {
-    ASSERT(memory.GetCurrentPageTable() == current_page_table);
+    // With multi-core the current page table follows whichever core holds LockCore
+    ASSERT(system.IsMultiCoreEnabled() || memory.GetCurrentPageTable() == current_page_table);
     MICROPROFILE_SCOPE(ARM_Jit);
 
+    // Dirty page tracking is only toggled while no guest code runs
+    if (jits.front().track_dirty_pages != memory.IsDirtyPageTrackingEnabled()) [[unlikely]] {
+        ResetJits();
+    }
+
+    if (idle_loop_slices >= IDLE_LOOP_MIN_SLICES) {
+        const auto lock = system.LockCore(*this);
+        if (ProbeIdleLoop()) {
+            const s64 skipped_cycles = GetTimer().Idle();
+            if (system.perf_stats) {
+                system.perf_stats->AddSkippedCycles(skipped_cycles);
+            }
+            return;
+        }
+    }
+
+    // Guest code reads the page table and fastmem window directly, so with multi-core it must not
+    // run while another core changes them. Memory callbacks give the lock up, see CoreLock.
+    if (system.IsMultiCoreEnabled()) {
+        page_table_lock = std::shared_lock{memory.GetPageTableMutex()};
+    }
     jit->Run();
+    if (page_table_lock.owns_lock()) {
+        page_table_lock.unlock();
+    }
+
+    const auto lock = system.LockCore(*this);
+    UpdateIdleLoop();
 }
 
 void ARM_Dynarmic::Step() {
@@ -318,13 +428,19 @@ void ARM_Dynarmic::PrepareReschedule() {
 }
 
 void ARM_Dynarmic::ClearInstructionCache() {
-    for (const auto& j : jits) {
-        j.second->ClearCache();
+    for (const auto& entry : jits) {
+        entry.jit->ClearCache();
+    }
+    if (idle_probe_jit) {
+        idle_probe_jit->ClearCache();
     }
 }
 
 void ARM_Dynarmic::InvalidateCacheRange(u32 start_address, std::size_t length) {
     jit->InvalidateCacheRange(start_address, length);
+    if (idle_probe_jit) {
+        idle_probe_jit->InvalidateCacheRange(start_address, length);
+    }
 }
 
 void ARM_Dynarmic::ClearExclusiveState() {
@@ -336,23 +452,153 @@ std::shared_ptr<Memory::PageTable> ARM_Dynarmic::GetPageTable() const {
 }
 
 void ARM_Dynarmic::SetPageTable(const std::shared_ptr<Memory::PageTable>& page_table) {
+    // This is also reached from within JIT callbacks, where the context must be left alone
+    if (jit && page_table == current_page_table) {
+        return;
+    }
+
     current_page_table = page_table;
     auto ctx{NewContext()};
     if (jit) {
         SaveContext(ctx);
     }
 
-    auto iter = jits.find(current_page_table);
+    const auto iter = std::find_if(jits.begin(), jits.end(), [this](const JitEntry& entry) {
+        return entry.page_table == current_page_table;
+    });
     if (iter != jits.end()) {
-        jit = iter->second.get();
+        std::rotate(jits.begin(), iter, iter + 1);
+        jit = jits.front().jit.get();
         LoadContext(ctx);
         return;
     }
 
-    auto new_jit = MakeJit();
-    jit = new_jit.get();
+    EvictJits();
+    jits.insert(jits.begin(),
+                JitEntry{current_page_table, MakeJit(), memory.IsDirtyPageTrackingEnabled()});
+    jit = jits.front().jit.get();
+    LoadContext(ctx);
+
+    jit_stats.creations++;
+    jit_stats.code_cache_size = jits.size() * JIT_CODE_CACHE_SIZE;
+    LOG_DEBUG(Core_ARM11, "Core {} created JIT instance {}, code cache {}/{} MiB", GetID(),
+              jit_stats.creations, jit_stats.code_cache_size >> 20,
+              jit_stats.code_cache_budget >> 20);
+}
+
+void ARM_Dynarmic::EvictJits() {
+    const std::size_t budget = JitCodeCacheBudget();
+    jit_stats.code_cache_budget = budget;
+
+    // An instance can't be destroyed while it is running, which only happens when the page table
+    // is switched from within one of its callbacks.
+    const auto evict = [this](std::vector<JitEntry>::iterator iter) {
+        jit_stats.evictions++;
+        return jits.erase(iter);
+    };
+
+    // Page tables only referenced from here belong to processes that no longer exist
+    for (auto iter = jits.begin(); iter != jits.end();) {
+        if (iter->page_table.use_count() == 1 && !iter->jit->IsExecuting()) {
+            iter = evict(iter);
+        } else {
+            ++iter;
+        }
+    }
+
+    // Then drop the least recently used instances
+    while ((jits.size() + 1) * JIT_CODE_CACHE_SIZE > budget) {
+        const auto iter = std::find_if(jits.rbegin(), jits.rend(), [](const JitEntry& entry) {
+            return !entry.jit->IsExecuting();
+        });
+        if (iter == jits.rend()) {
+            break;
+        }
+        evict(std::next(iter).base());
+    }
+}
+
+void ARM_Dynarmic::ResetJits() {
+    auto ctx{NewContext()};
+    SaveContext(ctx);
+
+    // Only called from Run, so none of the instances of this core is executing
+    jit_stats.evictions += jits.size();
+    jits.clear();
+    jits.insert(jits.begin(),
+                JitEntry{current_page_table, MakeJit(), memory.IsDirtyPageTrackingEnabled()});
+    jit = jits.front().jit.get();
     LoadContext(ctx);
-    jits.emplace(current_page_table, std::move(new_jit));
+
+    jit_stats.creations++;
+    jit_stats.code_cache_size = JIT_CODE_CACHE_SIZE;
+}
+
+bool ARM_Dynarmic::ProbeIdleLoop() {
+    // Guest code writes to memory through the page table and fastmem window without calling back,
+    // so a loop that only updates a counter in memory would look idle. The probe runs on a JIT
+    // instance without either, where every write goes through the callbacks and can be seen.
+    if (!idle_probe_jit) {
+        idle_probe_jit = MakeJit(true);
+    }
+    Dynarmic::A32::Jit* const main_jit = jit;
+    CopyJitState(*main_jit, *idle_probe_jit);
+    jit = idle_probe_jit.get();
+    idle_probe_wrote_memory = false;
+
+    // Go around the loop once so that it sees anything that changed since the last slice. If it
+    // is still waiting it comes back to exactly the same state.
+    bool is_idle = false;
+    for (u32 i = 0; i < IDLE_LOOP_PROBE_STEPS && GetTimer().GetDowncount() > 0; ++i) {
+        jit->Step();
+        if (idle_probe_wrote_memory || jit != idle_probe_jit.get()) {
+            break;
+        }
+        if (IsInIdleLoopState()) {
+            is_idle = true;
+            break;
+        }
+    }
+
+    // A callback that switched page tables already moved the state to another instance
+    if (jit == idle_probe_jit.get()) {
+        jit = main_jit;
+        CopyJitState(*idle_probe_jit, *main_jit);
+    }
+    if (!is_idle) {
+        idle_loop_slices = 0;
+    }
+    return is_idle;
+}
+
+void ARM_Dynarmic::UpdateIdleLoop() {
+    // Consecutive slices that run to completion and end in the same state are most likely spent
+    // spinning on something that only an event can change.
+    if (!Settings::values.skip_idle_loops.GetValue() || GetTimer().GetDowncount() > 0) {
+        idle_loop_slices = 0;
+        return;
+    }
+    if (IsInIdleLoopState()) {
+        ++idle_loop_slices;
+    } else {
+        idle_loop_regs = jit->Regs();
+        idle_loop_ext_regs = jit->ExtRegs();
+        idle_loop_cpsr = jit->Cpsr();
+        idle_loop_fpscr = jit->Fpscr();
+        idle_loop_slices = 0;
+    }
+}
+
+void ARM_Dynarmic::CopyJitState(const Dynarmic::A32::Jit& source, Dynarmic::A32::Jit& dest) {
+    dest.Regs() = source.Regs();
+    dest.ExtRegs() = source.ExtRegs();
+    dest.SetCpsr(source.Cpsr());
+    dest.SetFpscr(source.Fpscr());
+}
+
+bool ARM_Dynarmic::IsInIdleLoopState() const {
+    return jit->Regs() == idle_loop_regs && jit->Cpsr() == idle_loop_cpsr &&
+           jit->ExtRegs() == idle_loop_ext_regs && jit->Fpscr() == idle_loop_fpscr;
 }
 
 void ARM_Dynarmic::ServeBreak() {
@@ -362,10 +608,22 @@ void ARM_Dynarmic::ServeBreak() {
     GDBStub::SendTrap(thread, 5);
 }
 
-std::unique_ptr<Dynarmic::A32::Jit> ARM_Dynarmic::MakeJit() {
+std::unique_ptr<Dynarmic::A32::Jit> ARM_Dynarmic::MakeJit(bool idle_probe) {
     Dynarmic::A32::UserConfig config;
     config.callbacks = cb.get();
-    config.page_table = &current_page_table->GetPointerArray();
+    if (!idle_probe) {
+        // Clean pages are write protected in the fastmem window while dirty pages are tracked.
+        // The page table can't be protected, so writes that don't use fastmem use the callbacks.
+        if (!memory.IsDirtyPageTrackingEnabled()) {
+            config.page_table = &current_page_table->GetPointerArray();
+        }
+        // Pages that can't be accessed directly are inaccessible in the fastmem window, so
+        // accesses to them fault and fall back to the memory callbacks
+        if (current_page_table->fastmem_base) {
+            config.fastmem_pointer = reinterpret_cast<uintptr_t>(current_page_table->fastmem_base);
+        }
+    }
+    config.code_cache_size = idle_probe ? IDLE_PROBE_CODE_CACHE_SIZE : JIT_CODE_CACHE_SIZE;
     config.coprocessors[15] = std::make_shared<DynarmicCP15>(cp15_state);
     config.define_unpredictable_behaviour = true;
 
@@ -4,8 +4,10 @@
 
 #pragma once
 
-#include <map>
+#include <array>
 #include <memory>
+#include <shared_mutex>
+#include <vector>
 #include <dynarmic/interface/A32/a32.h>
 #include "common/common_types.h"
 #include "core/arm/arm_interface.h"
@@ -65,11 +67,27 @@ protected:
 private:
     void ServeBreak();
 
+    /// Returns true if the guest is still spinning in the loop it was last seen in
+    bool ProbeIdleLoop();
+    /// Tracks the guest state at the end of a slice to detect idle loops
+    void UpdateIdleLoop();
+    /// Returns true if the guest state matches the one at the end of the last slice
+    bool IsInIdleLoopState() const;
+    /// Copies the guest registers between JIT instances
+    static void CopyJitState(const Dynarmic::A32::Jit& source, Dynarmic::A32::Jit& dest);
+
+    /// Destroys JIT instances until another one fits in the code cache budget
+    void EvictJits();
+    /// Replaces all JIT instances, keeping the state of the current one
+    void ResetJits();
+
     friend class DynarmicUserCallbacks;
     Core::System& system;
     Memory::MemorySystem& memory;
     std::unique_ptr<DynarmicUserCallbacks> cb;
-    std::unique_ptr<Dynarmic::A32::Jit> MakeJit();
+    /// Creates a JIT instance for the current page table, or one that accesses all guest memory
+    /// through the callbacks for probing idle loops
+    std::unique_ptr<Dynarmic::A32::Jit> MakeJit(bool idle_probe = false);
 
     u32 fpexc = 0;
     CP15State cp15_state;
@@ -77,5 +95,35 @@ private:
 
     Dynarmic::A32::Jit* jit = nullptr;
     std::shared_ptr<Memory::PageTable> current_page_table = nullptr;
-    std::map<std::shared_ptr<Memory::PageTable>, std::unique_ptr<Dynarmic::A32::Jit>> jits;
+    /// Held while guest code runs on its own host thread, see MemorySystem::GetPageTableMutex
+    std::shared_lock<std::shared_mutex> page_table_lock;
+
+    struct JitEntry {
+        std::shared_ptr<Memory::PageTable> page_table;
+        std::unique_ptr<Dynarmic::A32::Jit> jit;
+        /// Whether the instance was made for dirty page tracking, see MakeJit
+        bool track_dirty_pages;
+    };
+
+    /// JIT instances for the page tables this core has run, most recently used first
+    std::vector<JitEntry> jits;
+
+    /// Counters logged when the core is destroyed
+    struct JitStats {
+        u64 creations = 0;                 ///< JIT instances created
+        u64 evictions = 0;                 ///< JIT instances destroyed to stay within the budget
+        std::size_t code_cache_size = 0;   ///< Code cache reserved by live instances, in bytes
+        std::size_t code_cache_budget = 0; ///< Code cache budget of this core, in bytes
+    } jit_stats;
+
+    /// Guest state at the end of the last slice, and the number of slices in a row that ended in it
+    std::array<u32, 16> idle_loop_regs{};
+    std::array<u32, 64> idle_loop_ext_regs{};
+    u32 idle_loop_cpsr = 0;
+    u32 idle_loop_fpscr = 0;
+    u32 idle_loop_slices = 0;
+    /// Runs the idle loop probes, created on the first one
+    std::unique_ptr<Dynarmic::A32::Jit> idle_probe_jit;
+    /// Set by the memory write callbacks, so that probes that write to memory are rejected
+    bool idle_probe_wrote_memory = false;
 };
@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <array>
 #include <exception>
 #include <memory>
 #include <stdexcept>
@@ -30,6 +31,7 @@
 #include "core/hle/kernel/kernel.h"
 #include "core/hle/kernel/process.h"
 #include "core/hle/kernel/thread.h"
+#include "core/hle/lock.h"
 #include "core/hle/service/apt/applet_manager.h"
 #include "core/hle/service/apt/apt.h"
 #include "core/hle/service/cam/cam.h"
@@ -47,6 +49,7 @@
 #include "core/hw/lcd.h"
 #include "core/loader/loader.h"
 #include "core/movie.h"
+#include "core/rewind.h"
 #include "core/rpc/server.h"
 #include "network/network.h"
 #include "video_core/custom_textures/custom_tex_manager.h"
@@ -98,6 +101,16 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
         }
     }
 
+    // Savestates are written in the background, report the failures of earlier saves
+    {
+        std::scoped_lock lock{savestate_error_mutex};
+        if (savestate_error) {
+            status_details = std::move(*savestate_error);
+            savestate_error.reset();
+            return ResultStatus::ErrorSavestate;
+        }
+    }
+
     Signal signal{Signal::None};
     u32 param{};
     {
@@ -133,7 +146,7 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
         LOG_INFO(Core, "Begin save to slot {}", slot);
         try {
             System::SaveState(slot);
-            LOG_INFO(Core, "Save completed");
+            LOG_INFO(Core, "Save captured, writing it in the background");
         } catch (const std::exception& e) {
             LOG_ERROR(Core, "Error saving: {}", e.what());
             status_details = e.what();
@@ -142,10 +155,31 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
         frame_limiter.WaitOnce();
         return ResultStatus::Success;
     }
+    case Signal::Rewind: {
+        const u32 frames = param;
+        LOG_INFO(Core, "Begin rewind by {} frames", frames);
+        try {
+            if (System::Rewind(frames)) {
+                LOG_INFO(Core, "Rewind completed");
+            } else {
+                LOG_WARNING(Core, "No state to rewind to");
+            }
+        } catch (const std::exception& e) {
+            LOG_ERROR(Core, "Error rewinding: {}", e.what());
+            status_details = e.what();
+            return ResultStatus::ErrorSavestate;
+        }
+        frame_limiter.WaitOnce();
+        return ResultStatus::Success;
+    }
     default:
         break;
     }
 
+    if (rewind_buffer) {
+        rewind_buffer->Update();
+    }
+
     // All cores should have executed the same amount of ticks. If this is not the case an event was
     // scheduled with a cycles_into_future smaller then the current downcount.
     // So we have to get those cores to the same global time first
@@ -202,27 +236,31 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
             kernel->GetThreadManager(cpu_core->GetID()).Reschedule();
             max_slice = std::min(max_slice, cpu_core->GetTimer().GetMaxSliceLength());
         }
-        for (auto& cpu_core : cpu_cores) {
-            cpu_core->GetTimer().SetNextSlice(max_slice);
-            auto start_ticks = cpu_core->GetTimer().GetTicks();
-            LOG_TRACE(Core_ARM11, "Core {} running for {} ticks", cpu_core->GetID(),
-                      cpu_core->GetTimer().GetDowncount());
-            running_core = cpu_core.get();
-            kernel->SetRunningCPU(running_core);
-            // If we don't have a currently active thread then don't execute instructions,
-            // instead advance to the next event and try to yield to the next thread
-            if (kernel->GetCurrentThreadManager().GetCurrentThread() == nullptr) {
-                LOG_TRACE(Core_ARM11, "Core {} idling", cpu_core->GetID());
-                cpu_core->GetTimer().Idle();
-                PrepareReschedule();
-            } else {
-                if (tight_loop) {
-                    cpu_core->Run();
+        if (core_workers && tight_loop && !GDBStub::IsServerEnabled()) {
+            RunCoresParallel(max_slice);
+        } else {
+            for (auto& cpu_core : cpu_cores) {
+                cpu_core->GetTimer().SetNextSlice(max_slice);
+                auto start_ticks = cpu_core->GetTimer().GetTicks();
+                LOG_TRACE(Core_ARM11, "Core {} running for {} ticks", cpu_core->GetID(),
+                          cpu_core->GetTimer().GetDowncount());
+                running_core = cpu_core.get();
+                kernel->SetRunningCPU(running_core);
+                // If we don't have a currently active thread then don't execute instructions,
+                // instead advance to the next event and try to yield to the next thread
+                if (kernel->GetCurrentThreadManager().GetCurrentThread() == nullptr) {
+                    LOG_TRACE(Core_ARM11, "Core {} idling", cpu_core->GetID());
+                    cpu_core->GetTimer().Idle();
+                    PrepareReschedule();
                 } else {
-                    cpu_core->Step();
+                    if (tight_loop) {
+                        cpu_core->Run();
+                    } else {
+                        cpu_core->Step();
+                    }
                 }
+                max_slice = cpu_core->GetTimer().GetTicks() - start_ticks;
             }
-            max_slice = cpu_core->GetTimer().GetTicks() - start_ticks;
         }
     }
 
@@ -320,6 +358,10 @@ System::ResultStatus System::Load(Frontend::EmuWindow& emu_window, const std::st
     }
     cheat_engine = std::make_unique<Cheats::CheatEngine>(title_id, *this);
     perf_stats = std::make_unique<PerfStats>(title_id);
+    if (Settings::values.enable_rewind.GetValue()) {
+        rewind_buffer = std::make_unique<RewindBuffer>(*this);
+    }
+    savestate_worker = std::make_unique<Common::ThreadWorker>(1, "SaveState");
 
     if (Settings::values.custom_textures) {
         custom_tex_manager->FindCustomTextures();
@@ -345,6 +387,54 @@ void System::PrepareReschedule() {
     reschedule_pending = true;
 }
 
+std::unique_lock<std::recursive_mutex> System::LockCore(ARM_Interface& core) {
+    if (!core_workers) {
+        return {};
+    }
+    std::unique_lock lock{HLE::g_hle_lock};
+    if (running_core != &core) {
+        running_core = &core;
+        kernel->SetRunningCPU(running_core);
+    }
+    return lock;
+}
+
+void System::RunCoresParallel(s64 max_slice) {
+    // Idle cores are handled here as they don't execute anything. Every other core runs for the
+    // whole slice, so the cores are never more than one slice apart when they meet again at the
+    // next timing event dispatch. Cores that stopped early are caught up by the next RunLoop.
+    std::array<ARM_Interface*, 4> cores_to_run{};
+    std::size_t num_cores_to_run = 0;
+    ASSERT(cpu_cores.size() <= cores_to_run.size());
+    for (auto& cpu_core : cpu_cores) {
+        cpu_core->GetTimer().SetNextSlice(max_slice);
+        running_core = cpu_core.get();
+        kernel->SetRunningCPU(running_core);
+        if (kernel->GetCurrentThreadManager().GetCurrentThread() == nullptr) {
+            LOG_TRACE(Core_ARM11, "Core {} idling", cpu_core->GetID());
+            cpu_core->GetTimer().Idle();
+            PrepareReschedule();
+        } else {
+            LOG_TRACE(Core_ARM11, "Core {} running for {} ticks", cpu_core->GetID(),
+                      cpu_core->GetTimer().GetDowncount());
+            cores_to_run[num_cores_to_run++] = cpu_core.get();
+        }
+    }
+
+    // From here on the cores only touch shared state while holding LockCore
+    for (std::size_t i = 1; i < num_cores_to_run; ++i) {
+        core_workers->QueueWork([core = cores_to_run[i]] { core->Run(); });
+    }
+    if (num_cores_to_run > 0) {
+        cores_to_run[0]->Run();
+    }
+    core_workers->WaitForRequests();
+
+    // Leave the same core running as the single threaded loop does
+    running_core = cpu_cores.back().get();
+    kernel->SetRunningCPU(running_core);
+}
+
 PerfStats::Results System::GetAndResetPerfStats() {
     return (perf_stats && timing) ? perf_stats->GetAndResetStats(timing->GetGlobalTimeUs())
                                   : PerfStats::Results{};
@@ -397,6 +487,20 @@ System::ResultStatus System::Init(Frontend::EmuWindow& emu_window,
     }
     running_core = cpu_cores[0].get();
 
+    // Only the JIT is safe to run on several host threads, the interpreter accesses memory through
+    // the page table of whichever process is current.
+    const bool use_multi_core = Settings::values.use_multi_core.GetValue() &&
+                                Settings::values.use_cpu_jit.GetValue() && num_cores > 1;
+#if CITRA_ARCH(x86_64) || CITRA_ARCH(arm64)
+    if (use_multi_core) {
+        core_workers = std::make_unique<Common::ThreadWorker>(num_cores - 1, "CPUCore");
+    }
+#else
+    if (use_multi_core) {
+        LOG_WARNING(Core, "Multi-core requested, but Dynarmic not available");
+    }
+#endif
+
     kernel->SetCPUs(cpu_cores);
     kernel->SetRunningCPU(cpu_cores[0].get());
 
@@ -535,11 +639,20 @@ void System::Shutdown(bool is_deserializing) {
     // Shutdown emulation session
     is_powered_on = false;
 
+    // Finish the operations queued to the GPU thread while the renderer still exists
+    GPU::Synchronize();
     VideoCore::Shutdown();
     HW::Shutdown();
     if (!is_deserializing) {
         GDBStub::Shutdown();
         perf_stats.reset();
+        rewind_buffer.reset();
+        // Finish writing any pending savestates, their errors are only logged from here on
+        if (savestate_worker) {
+            savestate_worker->WaitForRequests();
+            savestate_worker.reset();
+        }
+        savestate_error.reset();
         cheat_engine.reset();
         app_loader.reset();
     }
@@ -550,6 +663,7 @@ void System::Shutdown(bool is_deserializing) {
     service_manager.reset();
     dsp_core.reset();
     kernel.reset();
+    core_workers.reset();
     cpu_cores.clear();
     exclusive_monitor.reset();
     timing.reset();
@@ -607,6 +721,8 @@ void System::ApplySettings() {
     VideoCore::g_shader_jit_enabled = Settings::values.use_shader_jit.GetValue();
     VideoCore::g_hw_shader_enabled = Settings::values.use_hw_shader.GetValue();
     VideoCore::g_hw_shader_accurate_mul = Settings::values.shaders_accurate_mul.GetValue();
+    VideoCore::g_vertex_shader_threads = Settings::values.vertex_shader_threads.GetValue();
+    VideoCore::g_vertex_cache_size = Settings::values.vertex_cache_size.GetValue();
 
 #ifndef ANDROID
     if (VideoCore::g_renderer) {
@@ -679,6 +795,10 @@ void System::serialize(Archive& ar, const unsigned int file_version) {
             *m_emu_window, m_secondary_window, *system_mode.first, *n3ds_mode.first, num_cores);
     }
 
+    if (Archive::is_saving::value) {
+        GPU::SynchronizeForSerialization();
+    }
+
     // flush on save, don't flush on load
     bool should_flush = !Archive::is_loading::value;
     Memory::RasterizerClearAll(should_flush);
@@ -7,9 +7,11 @@
 #include <atomic>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <string>
 #include <boost/serialization/version.hpp>
 #include "common/common_types.h"
+#include "common/thread_worker.h"
 #include "core/frontend/applets/mii_selector.h"
 #include "core/frontend/applets/swkbd.h"
 #include "core/loader/loader.h"
@@ -65,6 +67,7 @@ class RendererBase;
 namespace Core {
 
 class ExclusiveMonitor;
+class RewindBuffer;
 class Timing;
 
 class System {
@@ -121,7 +124,7 @@ public:
     /// Shutdown and then load again
     void Reset();
 
-    enum class Signal : u32 { None, Shutdown, Reset, Save, Load };
+    enum class Signal : u32 { None, Shutdown, Reset, Save, Load, Rewind };
 
     bool SendSignal(Signal signal, u32 param = 0);
 
@@ -177,6 +180,26 @@ public:
         return *running_core;
     };
 
+    /// Returns true if there is a running core, which isn't the case before the cores are created
+    [[nodiscard]] bool HasRunningCore() const {
+        return running_core != nullptr;
+    }
+
+    /**
+     * Synchronizes a core with the rest of the emulator. When cores run on their own host
+     * threads, this must be held while a core accesses shared state (kernel calls, memory that
+     * isn't plain RAM, exclusive monitor operations). While held, core is the running core.
+     * Page table changes additionally wait for the other cores to leave guest code, see
+     * Memory::MemorySystem::GetPageTableMutex.
+     * @returns The held lock, or an empty lock if the cores run on a single host thread.
+     */
+    [[nodiscard]] std::unique_lock<std::recursive_mutex> LockCore(ARM_Interface& core);
+
+    /// Returns true if the emulated cores run on their own host threads
+    [[nodiscard]] bool IsMultiCoreEnabled() const {
+        return core_workers != nullptr;
+    }
+
     /**
      * Gets a reference to the emulated CPU.
      * @param core_id The id of the core requested.
@@ -269,6 +292,9 @@ public:
     std::unique_ptr<PerfStats> perf_stats;
     FrameLimiter frame_limiter;
 
+    /// Recent states for rewinding, if enabled
+    std::unique_ptr<RewindBuffer> rewind_buffer;
+
     void SetStatus(ResultStatus new_status, const char* details = nullptr) {
         status = new_status;
         if (details) {
@@ -321,6 +347,13 @@ public:
 
     void LoadState(u32 slot);
 
+    /**
+     * Restores the state from about the given number of frames ago that was kept by the rewind
+     * buffer.
+     * @returns false if rewind is disabled or no state was kept yet.
+     */
+    bool Rewind(u32 frames);
+
     /// Self delete ncch
     bool SetSelfDelete(const std::string& file) {
         if (m_filepath == file) {
@@ -348,6 +381,9 @@ private:
     /// Reschedule the core emulation
     void Reschedule();
 
+    /// Runs all cores that have a thread to run for max_slice ticks, each on its own host thread
+    void RunCoresParallel(s64 max_slice);
+
     /// AppLoader used to load the current executing application
     std::unique_ptr<Loader::AppLoader> app_loader;
 
@@ -355,6 +391,15 @@ private:
     std::vector<std::shared_ptr<ARM_Interface>> cpu_cores;
     ARM_Interface* running_core = nullptr;
 
+    /// Host threads that run the cores other than the first when multi-core is enabled
+    std::unique_ptr<Common::ThreadWorker> core_workers;
+
+    /// Host thread that compresses and writes savestates in the background
+    std::unique_ptr<Common::ThreadWorker> savestate_worker;
+    /// Error of a background savestate write, returned by the next RunLoop
+    mutable std::mutex savestate_error_mutex;
+    mutable std::optional<std::string> savestate_error;
+
     /// DSP core
     std::unique_ptr<AudioCore::DspInterface> dsp_core;
 
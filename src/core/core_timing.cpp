@@ -39,7 +39,10 @@ TimingEventType* Timing::RegisterEvent(const std::string& name, TimedCallback ca
     // we want event type names to remain unique so that we can use them for serialization.
     auto info = event_types.emplace(name, TimingEventType{});
     TimingEventType* event_type = &info.first->second;
-    event_type->name = &info.first->first;
+    if (info.second) {
+        event_type->name = &info.first->first;
+        event_type->index = event_types.size() - 1;
+    }
     if (callback != nullptr) {
         event_type->callback = callback;
     }
@@ -67,12 +70,12 @@ void Timing::ScheduleEvent(s64 cycles_into_future, const TimingEventType* event_
         if (!timer->is_timer_sane)
             timer->ForceExceptionCheck(cycles_into_future);
 
-        timer->event_queue.emplace_back(
-            Event{timeout, timer->event_fifo_id++, user_data, event_type});
-        std::push_heap(timer->event_queue.begin(), timer->event_queue.end(), std::greater<>());
+        timer->PushEvent(Event{timeout, timer->event_fifo_id++, user_data, event_type});
     } else {
-        timer->ts_queue.Push(Event{static_cast<s64>(timer->GetTicks() + cycles_into_future), 0,
-                                   user_data, event_type});
+        timer->ts_queue.Push(Timer::QueuedRequest{
+            Timer::QueuedRequest::Action::Schedule,
+            Event{static_cast<s64>(timer->GetTicks() + cycles_into_future), 0, user_data,
+                  event_type}});
     }
 }
 
@@ -81,17 +84,14 @@ void Timing::UnscheduleEvent(const TimingEventType* event_type, std::uintptr_t u
         return;
     }
     for (auto timer : timers) {
-        auto itr = std::remove_if(
-            timer->event_queue.begin(), timer->event_queue.end(),
-            [&](const Event& e) { return e.type == event_type && e.user_data == user_data; });
-
-        // Removing random items breaks the invariant so we have to re-establish it.
-        if (itr != timer->event_queue.end()) {
-            timer->event_queue.erase(itr, timer->event_queue.end());
-            std::make_heap(timer->event_queue.begin(), timer->event_queue.end(), std::greater<>());
+        timer->EraseEvents(event_type, user_data, false);
+        // Events scheduled from another timer may still be in its thread safe queue, the owner
+        // drops them when it moves them to its event queue.
+        if (timer.get() != current_timer && !timer->ts_queue.Empty()) {
+            timer->ts_queue.Push(Timer::QueuedRequest{Timer::QueuedRequest::Action::Unschedule,
+                                                      Event{0, 0, user_data, event_type}});
         }
     }
-    // TODO:remove events from ts_queue
 }
 
 void Timing::RemoveEvent(const TimingEventType* event_type) {
@@ -99,16 +99,12 @@ void Timing::RemoveEvent(const TimingEventType* event_type) {
         return;
     }
     for (auto timer : timers) {
-        auto itr = std::remove_if(timer->event_queue.begin(), timer->event_queue.end(),
-                                  [&](const Event& e) { return e.type == event_type; });
-
-        // Removing random items breaks the invariant so we have to re-establish it.
-        if (itr != timer->event_queue.end()) {
-            timer->event_queue.erase(itr, timer->event_queue.end());
-            std::make_heap(timer->event_queue.begin(), timer->event_queue.end(), std::greater<>());
+        timer->EraseEvents(event_type, 0, true);
+        if (timer.get() != current_timer && !timer->ts_queue.Empty()) {
+            timer->ts_queue.Push(Timer::QueuedRequest{Timer::QueuedRequest::Action::Remove,
+                                                      Event{0, 0, 0, event_type}});
         }
     }
-    // TODO:remove events from ts_queue
 }
 
 void Timing::SetCurrentTimer(std::size_t core_id) {
@@ -166,10 +162,144 @@ void Timing::Timer::ForceExceptionCheck(s64 cycles) {
 }
 
 void Timing::Timer::MoveEvents() {
-    for (Event ev; ts_queue.Pop(ev);) {
-        ev.fifo_order = event_fifo_id++;
-        event_queue.emplace_back(std::move(ev));
-        std::push_heap(event_queue.begin(), event_queue.end(), std::greater<>());
+    // Unscheduling only drops the events that were queued before it, which are the ones moved
+    // by this call
+    const u64 first_moved = event_fifo_id;
+    for (QueuedRequest request; ts_queue.Pop(request);) {
+        switch (request.action) {
+        case QueuedRequest::Action::Schedule:
+            request.event.fifo_order = event_fifo_id++;
+            PushEvent(std::move(request.event));
+            break;
+        case QueuedRequest::Action::Unschedule:
+            EraseEvents(request.event.type, request.event.user_data, false, first_moved);
+            break;
+        case QueuedRequest::Action::Remove:
+            EraseEvents(request.event.type, 0, true, first_moved);
+            break;
+        }
+    }
+}
+
+void Timing::Timer::PushEvent(Event&& event) {
+    if (free_event_handles.empty()) {
+        event.handle = static_cast<u32>(event_handles.size());
+        event_handles.emplace_back();
+    } else {
+        event.handle = free_event_handles.back();
+        free_event_handles.pop_back();
+    }
+    LinkEvent(event);
+    const std::size_t position = event_queue.size();
+    event_queue.emplace_back();
+    PlaceEvent(position, std::move(event));
+    SiftUp(position);
+}
+
+Timing::Event Timing::Timer::PopEvent() {
+    return EraseEvent(0);
+}
+
+Timing::Event Timing::Timer::EraseEvent(std::size_t position) {
+    Event event = std::move(event_queue[position]);
+
+    // Unlink the event from the list of its type and release its handle
+    const EventHandle& handle = event_handles[event.handle];
+    if (handle.prev != INVALID_HANDLE) {
+        event_handles[handle.prev].next = handle.next;
+    } else {
+        event_type_heads[event.type->index] = handle.next;
+    }
+    if (handle.next != INVALID_HANDLE) {
+        event_handles[handle.next].prev = handle.prev;
+    }
+    free_event_handles.push_back(event.handle);
+
+    // Move the last event into the hole and sift it into place
+    Event last = std::move(event_queue.back());
+    event_queue.pop_back();
+    if (position < event_queue.size()) {
+        const u32 moved = last.handle;
+        PlaceEvent(position, std::move(last));
+        SiftUp(position);
+        SiftDown(event_handles[moved].position);
+    }
+    return event;
+}
+
+void Timing::Timer::EraseEvents(const TimingEventType* type, std::uintptr_t user_data,
+                                bool any_user_data, u64 min_fifo_order) {
+    if (type->index >= event_type_heads.size()) {
+        return;
+    }
+    for (u32 handle = event_type_heads[type->index]; handle != INVALID_HANDLE;) {
+        const EventHandle& event_handle = event_handles[handle];
+        const Event& event = event_queue[event_handle.position];
+        handle = event_handle.next;
+        if ((any_user_data || event.user_data == user_data) &&
+            event.fifo_order >= min_fifo_order) {
+            EraseEvent(event_handle.position);
+        }
+    }
+}
+
+void Timing::Timer::SiftUp(std::size_t position) {
+    Event event = std::move(event_queue[position]);
+    while (position > 0) {
+        const std::size_t parent = (position - 1) / 2;
+        if (!(event < event_queue[parent])) {
+            break;
+        }
+        PlaceEvent(position, std::move(event_queue[parent]));
+        position = parent;
+    }
+    PlaceEvent(position, std::move(event));
+}
+
+void Timing::Timer::SiftDown(std::size_t position) {
+    const std::size_t size = event_queue.size();
+    Event event = std::move(event_queue[position]);
+    for (std::size_t child = 2 * position + 1; child < size; child = 2 * position + 1) {
+        if (child + 1 < size && event_queue[child + 1] < event_queue[child]) {
+            child++;
+        }
+        if (!(event_queue[child] < event)) {
+            break;
+        }
+        PlaceEvent(position, std::move(event_queue[child]));
+        position = child;
+    }
+    PlaceEvent(position, std::move(event));
+}
+
+void Timing::Timer::PlaceEvent(std::size_t position, Event&& event) {
+    event_handles[event.handle].position = position;
+    event_queue[position] = std::move(event);
+}
+
+void Timing::Timer::LinkEvent(const Event& event) {
+    const std::size_t index = event.type->index;
+    if (index >= event_type_heads.size()) {
+        event_type_heads.resize(index + 1, INVALID_HANDLE);
+    }
+    EventHandle& handle = event_handles[event.handle];
+    handle.prev = INVALID_HANDLE;
+    handle.next = event_type_heads[index];
+    if (handle.next != INVALID_HANDLE) {
+        event_handles[handle.next].prev = event.handle;
+    }
+    event_type_heads[index] = event.handle;
+}
+
+void Timing::Timer::RebuildHandles() {
+    event_handles.resize(event_queue.size());
+    free_event_handles.clear();
+    event_type_heads.clear();
+    for (std::size_t position = 0; position < event_queue.size(); ++position) {
+        Event& event = event_queue[position];
+        event.handle = static_cast<u32>(position);
+        event_handles[position].position = position;
+        LinkEvent(event);
     }
 }
 
@@ -194,9 +324,7 @@ void Timing::Timer::Advance() {
     is_timer_sane = true;
 
     while (!event_queue.empty() && event_queue.front().time <= executed_ticks) {
-        Event evt = std::move(event_queue.front());
-        std::pop_heap(event_queue.begin(), event_queue.end(), std::greater<>());
-        event_queue.pop_back();
+        const Event evt = PopEvent();
         if (evt.type->callback != nullptr) {
             evt.type->callback(evt.user_data, static_cast<int>(executed_ticks - evt.time));
         } else {
@@ -219,9 +347,11 @@ void Timing::Timer::SetNextSlice(s64 max_slice_length) {
     downcount = slice_length;
 }
 
-void Timing::Timer::Idle() {
+s64 Timing::Timer::Idle() {
+    const s64 cycles = downcount;
     idled_cycles += downcount;
     downcount = 0;
+    return cycles;
 }
 
 s64 Timing::Timer::GetDowncount() const {
@@ -133,6 +133,8 @@ using TimedCallback = std::function<void(std::uintptr_t user_data, int cycles_la
 struct TimingEventType {
     TimedCallback callback;
     const std::string* name;
+    /// Registration order of the type, used by the timers to find its queued events
+    std::size_t index;
 };
 
 class Timing {
@@ -143,6 +145,8 @@ public:
         u64 fifo_order;
         std::uintptr_t user_data;
         const TimingEventType* type;
+        /// Handle of the event in its timer, not serialized
+        u32 handle = 0;
 
         bool operator>(const Event& right) const;
         bool operator<(const Event& right) const;
@@ -190,7 +194,8 @@ public:
 
         void SetNextSlice(s64 max_slice_length = MAX_SLICE_LENGTH);
 
-        void Idle();
+        /// Skips the rest of the slice, returning the downcount that was skipped
+        s64 Idle();
 
         u64 GetTicks() const;
         u64 GetIdleTicks() const;
@@ -205,15 +210,67 @@ public:
 
     private:
         friend class Timing;
-        // The queue is a min-heap using std::make_heap/push_heap/pop_heap.
+
+        /// Adds an event to the queue
+        void PushEvent(Event&& event);
+
+        /// Removes the next event from the queue
+        Event PopEvent();
+
+        /// Removes the event at a position in the queue, keeping the heap order of the others
+        Event EraseEvent(std::size_t position);
+
+        /**
+         * Removes the queued events of a type with the given user data, or with any user data if
+         * any_user_data is set. Only events with a fifo order of at least min_fifo_order are
+         * removed.
+         */
+        void EraseEvents(const TimingEventType* type, std::uintptr_t user_data, bool any_user_data,
+                         u64 min_fifo_order = 0);
+
+        /// Moves the event at a position towards the root or the leaves until the heap is ordered
+        void SiftUp(std::size_t position);
+        void SiftDown(std::size_t position);
+
+        /// Stores an event at a position in the queue and updates its handle
+        void PlaceEvent(std::size_t position, Event&& event);
+
+        /// Adds the event to the list of queued events of its type
+        void LinkEvent(const Event& event);
+
+        /// Recreates the handles of the queued events after deserialization
+        void RebuildHandles();
+
+        /// Where a queued event is in the heap, and its neighbours among the events of its type
+        struct EventHandle {
+            std::size_t position;
+            u32 prev;
+            u32 next;
+        };
+        static constexpr u32 INVALID_HANDLE = std::numeric_limits<u32>::max();
+
+        /// A request queued from another timer, applied by MoveEvents()
+        struct QueuedRequest {
+            enum class Action : u8 { Schedule, Unschedule, Remove };
+            Action action;
+            Event event;
+        };
+
+        // The queue is a binary min-heap with the same layout as std::make_heap/push_heap/pop_heap.
         // We don't use std::priority_queue because we need to be able to serialize, unserialize and
-        // erase arbitrary events (RemoveEvent()) regardless of the queue order. These aren't
-        // accommodated by the standard adaptor class.
+        // erase arbitrary events (RemoveEvent()) regardless of the queue order. Every queued event
+        // has a handle that tracks its position, and the handles of each event type form a linked
+        // list, so erasing an event never has to search the queue.
         std::vector<Event> event_queue;
+        std::vector<EventHandle> event_handles;
+        std::vector<u32> free_event_handles;
+        // First handle of the queued events of each type, indexed by TimingEventType::index
+        std::vector<u32> event_type_heads;
         u64 event_fifo_id = 0;
         // the queue for storing the events from other threads threadsafe until they will be added
-        // to the event_queue by the emu thread
-        Common::MPSCQueue<Event> ts_queue;
+        // to the event_queue by the emu thread. It also carries the events unscheduled meanwhile,
+        // so that they are dropped when they arrive.
+        Common::MPSCQueue<QueuedRequest> ts_queue;
         // Are we in a function that has been called from Advance()
         // If events are sheduled from a function that gets called from Advance(),
         // don't change slice_length and downcount.
@@ -236,6 +293,9 @@ public:
         void serialize(Archive& ar, const unsigned int) {
             MoveEvents();
             ar& event_queue;
+            if (Archive::is_loading::value) {
+                RebuildHandles();
+            }
             ar& event_fifo_id;
             ar& slice_length;
             ar& downcount;
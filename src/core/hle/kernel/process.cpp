@@ -271,6 +271,8 @@ ResultVal<VAddr> Process::HeapAllocate(VAddr target, u32 size, VMAPermission per
                   interval.upper());
         std::fill(kernel.memory.GetFCRAMPointer(interval.lower()),
                   kernel.memory.GetFCRAMPointer(interval.upper()), 0);
+        kernel.memory.MarkRegionDirty(kernel.memory.GetFCRAMPointer(interval.lower()),
+                                      interval_size);
         auto vma = vm_manager.MapBackingMemory(interval_target,
                                                kernel.memory.GetFCRAMRef(interval.lower()),
                                                interval_size, memory_state);
@@ -349,6 +351,7 @@ ResultVal<VAddr> Process::LinearAllocate(VAddr target, u32 size, VMAPermission p
     auto backing_memory = kernel.memory.GetFCRAMRef(physical_offset);
 
     std::fill(backing_memory.GetPtr(), backing_memory.GetPtr() + size, 0);
+    kernel.memory.MarkRegionDirty(backing_memory.GetPtr(), size);
     auto vma = vm_manager.MapBackingMemory(target, backing_memory, size, MemoryState::Continuous);
     ASSERT(vma.Succeeded());
     vm_manager.Reprotect(vma.Unwrap(), perms);
@@ -52,6 +52,7 @@ ResultVal<std::shared_ptr<SharedMemory>> KernelSystem::CreateSharedMemory(
         ASSERT_MSG(offset, "Not enough space in region to allocate shared memory!");
 
         std::fill(memory.GetFCRAMPointer(*offset), memory.GetFCRAMPointer(*offset + size), 0);
+        memory.MarkRegionDirty(memory.GetFCRAMPointer(*offset), size);
         shared_memory->backing_blocks = {{memory.GetFCRAMRef(*offset), size}};
         shared_memory->holding_memory += MemoryRegionInfo::Interval(*offset, *offset + size);
         shared_memory->linear_heap_phys_offset = *offset;
@@ -100,6 +101,8 @@ std::shared_ptr<SharedMemory> KernelSystem::CreateSharedMemoryForApplet(
                                                    interval.upper() - interval.lower());
         std::fill(memory.GetFCRAMPointer(interval.lower()),
                   memory.GetFCRAMPointer(interval.upper()), 0);
+        memory.MarkRegionDirty(memory.GetFCRAMPointer(interval.lower()),
+                               interval.upper() - interval.lower());
     }
     shared_memory->base_address = Memory::HEAP_VADDR + offset;
 
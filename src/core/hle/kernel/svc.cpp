@@ -8,6 +8,7 @@
 #include "common/logging/log.h"
 #include "common/microprofile.h"
 #include "common/scm_rev.h"
+#include "common/settings.h"
 #include "core/arm/arm_interface.h"
 #include "core/core.h"
 #include "core/core_timing.h"
@@ -364,6 +365,11 @@ private:
     u32 GetReg(std::size_t n);
     void SetReg(std::size_t n, u32 value);
 
+    /// Set when the current call only polled for something that wasn't ready
+    bool idle_poll = false;
+
+    void IdlePoll();
+
     // SVC interfaces
 
     ResultCode ControlMemory(u32* out_addr, u32 addr0, u32 addr1, u32 size, u32 operation,
@@ -780,8 +786,10 @@ ResultCode SVC::WaitSynchronization1(Handle handle, s64 nano_seconds) {
 
     if (object->ShouldWait(thread)) {
 
-        if (nano_seconds == 0)
+        if (nano_seconds == 0) {
+            IdlePoll();
             return RESULT_TIMEOUT;
+        }
 
         thread->wait_objects = {object};
         object->AddWaitingThread(SharedFrom(thread));
@@ -851,8 +859,10 @@ ResultCode SVC::WaitSynchronizationN(s32* out, VAddr handles_address, s32 handle
 
         // If a timeout value of 0 was provided, just return the Timeout error code instead of
         // suspending the thread.
-        if (nano_seconds == 0)
+        if (nano_seconds == 0) {
+            IdlePoll();
             return RESULT_TIMEOUT;
+        }
 
         // Put the thread to sleep
         thread->status = ThreadStatus::WaitSynchAll;
@@ -894,8 +904,10 @@ ResultCode SVC::WaitSynchronizationN(s32* out, VAddr handles_address, s32 handle
 
         // If a timeout value of 0 was provided, just return the Timeout error code instead of
         // suspending the thread.
-        if (nano_seconds == 0)
+        if (nano_seconds == 0) {
+            IdlePoll();
             return RESULT_TIMEOUT;
+        }
 
         // Put the thread to sleep
         thread->status = ThreadStatus::WaitSynchAny;
@@ -1566,8 +1578,10 @@ void SVC::SleepThread(s64 nanoseconds) {
 
     // Don't attempt to yield execution if there are no available threads to run,
     // this way we avoid a useless reschedule to the idle thread.
-    if (nanoseconds == 0 && !thread_manager.HaveReadyThreads())
+    if (nanoseconds == 0 && !thread_manager.HaveReadyThreads()) {
+        IdlePoll();
         return;
+    }
 
     // Sleep current thread and check for next thread to schedule
     thread_manager.WaitCurrentThread_Sleep();
@@ -2308,6 +2322,7 @@ void SVC::CallSVC(u32 immediate) {
 
     const FunctionDef* info = GetSVCInfo(immediate);
     LOG_TRACE(Kernel_SVC, "calling {}", info->name);
+    idle_poll = false;
     if (info) {
         if (info->func) {
             (this->*(info->func))();
@@ -2315,6 +2330,24 @@ void SVC::CallSVC(u32 immediate) {
             LOG_ERROR(Kernel_SVC, "unimplemented SVC function {}(..)", info->name);
         }
     }
+    if (!idle_poll) {
+        kernel.GetCurrentThreadManager().ResetIdlePoll();
+    }
+}
+
+/// Fast-forwards to the next event if the current thread does nothing but make this poll
+void SVC::IdlePoll() {
+    idle_poll = true;
+    if (!Settings::values.skip_idle_loops.GetValue() ||
+        !kernel.GetCurrentThreadManager().RecordIdlePoll()) {
+        return;
+    }
+
+    const s64 skipped_cycles = system.GetRunningCore().GetTimer().Idle();
+    if (system.perf_stats) {
+        system.perf_stats->AddSkippedCycles(skipped_cycles);
+    }
+    system.PrepareReschedule();
 }
 
 SVC::SVC(Core::System& system) : system(system), kernel(system.Kernel()), memory(system.Memory()) {}
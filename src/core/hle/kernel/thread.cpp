@@ -435,6 +435,25 @@ bool ThreadManager::HaveReadyThreads() {
     return ready_queue.get_first() != nullptr;
 }
 
+bool ThreadManager::RecordIdlePoll() {
+    // Polls made from the same place with few cycles in between form a loop that does nothing
+    // but poll. Anything else, including another kernel call, resets the count.
+    constexpr u32 IDLE_POLL_MIN_COUNT = 8;
+    constexpr u64 IDLE_POLL_MAX_INTERVAL = 2000;
+
+    const u32 thread_id = current_thread ? current_thread->GetThreadId() : 0;
+    const u32 pc = cpu->GetPC();
+    const u64 ticks = cpu->GetTimer().GetTicks();
+    if (idle_poll_count == 0 || thread_id != idle_poll_thread_id || pc != idle_poll_pc ||
+        ticks - idle_poll_ticks > IDLE_POLL_MAX_INTERVAL) {
+        idle_poll_thread_id = thread_id;
+        idle_poll_pc = pc;
+        idle_poll_count = 0;
+    }
+    idle_poll_ticks = ticks;
+    return ++idle_poll_count >= IDLE_POLL_MIN_COUNT;
+}
+
 void ThreadManager::Reschedule() {
     Thread* cur = GetCurrentThread();
     Thread* next = PopNextReadyThread();
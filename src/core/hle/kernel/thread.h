@@ -101,6 +101,20 @@ public:
      */
     bool HaveReadyThreads();
 
+    /**
+     * Records a kernel call from the current thread that polled for something that wasn't ready,
+     * such as a wait with a zero timeout. Returns true once the thread has made the same poll
+     * repeatedly in a tight loop, meaning it is spinning until the next event changes something.
+     */
+    bool RecordIdlePoll();
+
+    /**
+     * Records a kernel call from the current thread that wasn't a poll
+     */
+    void ResetIdlePoll() {
+        idle_poll_count = 0;
+    }
+
     /**
      * Waits the current thread on a sleep
      */
@@ -163,6 +177,12 @@ private:
     // Lists all threadsthat aren't deleted.
     std::vector<std::shared_ptr<Thread>> thread_list;
 
+    /// Thread, address and time of the last idle poll, and how many were made in a row
+    u32 idle_poll_thread_id = 0;
+    u32 idle_poll_pc = 0;
+    u64 idle_poll_ticks = 0;
+    u32 idle_poll_count = 0;
+
     friend class Thread;
     friend class KernelSystem;
 
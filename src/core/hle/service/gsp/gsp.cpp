@@ -7,12 +7,17 @@
 #include "core/hle/kernel/event.h"
 #include "core/hle/kernel/shared_memory.h"
 #include "core/hle/service/gsp/gsp.h"
+#include "core/hw/gpu_thread.h"
 
 namespace Service::GSP {
 
 static std::weak_ptr<GSP_GPU> gsp_gpu;
 
 void SignalInterrupt(InterruptId interrupt_id) {
+    // Interrupts raised on the GPU thread are signalled once the emulation thread synchronizes
+    if (GPU::GpuThread::DeferInterrupt(interrupt_id)) {
+        return;
+    }
     auto gpu = gsp_gpu.lock();
     ASSERT(gpu != nullptr);
     return gpu->SignalInterrupt(interrupt_id);
@@ -2,19 +2,26 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <array>
 #include <cstring>
+#include <functional>
+#include <memory>
 #include <numeric>
 #include <type_traits>
 #include "common/alignment.h"
-#include "common/color.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
 #include "common/microprofile.h"
-#include "common/vector_math.h"
+#include "common/settings.h"
 #include "core/core.h"
 #include "core/core_timing.h"
+#include "core/hle/kernel/kernel.h"
+#include "core/hle/kernel/thread.h"
 #include "core/hle/service/gsp/gsp.h"
 #include "core/hw/gpu.h"
+#include "core/hw/gpu_thread.h"
+#include "core/hw/gpu_transfer.h"
 #include "core/hw/hw.h"
 #include "core/memory.h"
 #include "core/tracer/recorder.h"
@@ -22,7 +29,6 @@
 #include "video_core/debug_utils/debug_utils.h"
 #include "video_core/rasterizer_interface.h"
 #include "video_core/renderer_base.h"
-#include "video_core/utils.h"
 #include "video_core/video_core.h"
 
 namespace GPU {
@@ -32,9 +38,66 @@ Memory::MemorySystem* g_memory;
 
 /// Event id for CoreTiming
 static Core::TimingEventType* vblank_event;
+/// Event id for CoreTiming, used to synchronize with operations queued to the GPU thread
+static Core::TimingEventType* gpu_thread_event;
+
+/// Runs memory fills, display transfers and command lists when enabled
+static std::unique_ptr<GpuThread> gpu_thread;
+
+/// Emulated time between checks on whether an operation queued to the GPU thread has finished
+constexpr u64 GPU_THREAD_POLL_TICKS = BASE_CLOCK_RATE_ARM11 / 10000;
+
+/**
+ * Runs a GPU operation, on the GPU thread if there is one. Interrupts the operation signals are
+ * held back until the emulation thread synchronizes with it.
+ */
+static void RunOperation(std::function<void()> work) {
+    // The graphics debugger inspects the GPU state as each operation runs
+    if (!gpu_thread || Pica::g_debug_context) {
+        Synchronize();
+        work();
+        return;
+    }
+
+    const u64 fence = gpu_thread->QueueWork(std::move(work));
+    Core::System::GetInstance().CoreTiming().ScheduleEvent(GPU_THREAD_POLL_TICKS, gpu_thread_event,
+                                                           fence);
+}
+
+static void GpuThreadCallback(std::uintptr_t fence, s64 cycles_late) {
+    if (!gpu_thread) {
+        return;
+    }
+
+    // Let the emulated CPU keep running alongside the operation, unless it is idle and so most
+    // likely waiting for the operation's interrupt.
+    auto& system = Core::System::GetInstance();
+    const bool cpu_idle = system.Kernel().GetCurrentThreadManager().GetCurrentThread() == nullptr;
+    if (!gpu_thread->IsFinished(fence) && !cpu_idle) {
+        system.CoreTiming().ScheduleEvent(GPU_THREAD_POLL_TICKS - cycles_late, gpu_thread_event,
+                                          fence);
+        return;
+    }
+    gpu_thread->SyncFence(fence);
+}
+
+void Synchronize() {
+    if (gpu_thread && !GpuThread::IsGpuThread()) {
+        gpu_thread->Synchronize();
+    }
+}
+
+void SynchronizeForSerialization() {
+    Synchronize();
+    // The fences the events refer to mean nothing to the GPU thread of a loaded state
+    Core::System::GetInstance().CoreTiming().RemoveEvent(gpu_thread_event);
+}
 
 template <typename T>
 inline void Read(T& var, const u32 raw_addr) {
+    // Registers may reflect the results of queued operations
+    Synchronize();
+
     u32 addr = raw_addr - HW::VADDR_GPU;
     u32 index = addr / 4;
 
@@ -47,32 +110,19 @@ inline void Read(T& var, const u32 raw_addr) {
     var = g_regs[addr / 4];
 }
 
-static Common::Vec4<u8> DecodePixel(Regs::PixelFormat input_format, const u8* src_pixel) {
-    switch (input_format) {
-    case Regs::PixelFormat::RGBA8:
-        return Common::Color::DecodeRGBA8(src_pixel);
-
-    case Regs::PixelFormat::RGB8:
-        return Common::Color::DecodeRGB8(src_pixel);
-
-    case Regs::PixelFormat::RGB565:
-        return Common::Color::DecodeRGB565(src_pixel);
-
-    case Regs::PixelFormat::RGB5A1:
-        return Common::Color::DecodeRGB5A1(src_pixel);
-
-    case Regs::PixelFormat::RGBA4:
-        return Common::Color::DecodeRGBA4(src_pixel);
+MICROPROFILE_DEFINE(GPU_DisplayTransfer, "GPU", "DisplayTransfer", MP_RGB(100, 100, 255));
+MICROPROFILE_DEFINE(GPU_CmdlistProcessing, "GPU", "Cmdlist Processing", MP_RGB(100, 255, 100));
 
-    default:
-        LOG_ERROR(HW_GPU, "Unknown source framebuffer format {:x}", input_format);
-        return {0, 0, 0, 0};
+/// Repeats the pattern over size bytes, copying ever larger runs of what was already filled
+static void FillPattern(u8* dest, std::size_t size, const void* pattern,
+                        std::size_t pattern_size) {
+    pattern_size = std::min(pattern_size, size);
+    std::memcpy(dest, pattern, pattern_size);
+    for (std::size_t filled = pattern_size; filled < size; filled *= 2) {
+        std::memcpy(dest + filled, dest, std::min(filled, size - filled));
     }
 }
 
-MICROPROFILE_DEFINE(GPU_DisplayTransfer, "GPU", "DisplayTransfer", MP_RGB(100, 100, 255));
-MICROPROFILE_DEFINE(GPU_CmdlistProcessing, "GPU", "Cmdlist Processing", MP_RGB(100, 255, 100));
-
 static void MemoryFill(const Regs::MemoryFillConfig& config) {
     const PAddr start_addr = config.GetStartAddress();
     const PAddr end_addr = config.GetEndAddress();
@@ -103,26 +153,23 @@ static void MemoryFill(const Regs::MemoryFillConfig& config) {
     Memory::RasterizerInvalidateRegion(config.GetStartAddress(),
                                        config.GetEndAddress() - config.GetStartAddress());
 
+    const std::size_t size = end - start;
+    // The last value may extend past the end
+    g_memory->MarkRegionDirty(start, size + sizeof(u32));
     if (config.fill_24bit) {
-        // fill with 24-bit values
-        for (u8* ptr = start; ptr < end; ptr += 3) {
-            ptr[0] = config.value_24bit_r;
-            ptr[1] = config.value_24bit_g;
-            ptr[2] = config.value_24bit_b;
-        }
+        // fill with 24-bit values, the last one may extend past the end
+        const std::array<u8, 3> value{static_cast<u8>(config.value_24bit_r),
+                                      static_cast<u8>(config.value_24bit_g),
+                                      static_cast<u8>(config.value_24bit_b)};
+        FillPattern(start, Common::AlignUp(size, value.size()), value.data(), value.size());
     } else if (config.fill_32bit) {
         // fill with 32-bit values
-        if (end > start) {
-            u32 value = config.value_32bit;
-            std::size_t len = (end - start) / sizeof(u32);
-            for (std::size_t i = 0; i < len; ++i)
-                std::memcpy(&start[i * sizeof(u32)], &value, sizeof(u32));
-        }
+        const u32 value = config.value_32bit;
+        FillPattern(start, Common::AlignDown(size, sizeof(u32)), &value, sizeof(u32));
     } else {
-        // fill with 16-bit values
-        u16 value_16bit = config.value_16bit.Value();
-        for (u8* ptr = start; ptr < end; ptr += sizeof(u16))
-            std::memcpy(ptr, &value_16bit, sizeof(u16));
+        // fill with 16-bit values, the last one may extend past the end
+        const u16 value_16bit = config.value_16bit.Value();
+        FillPattern(start, Common::AlignUp(size, sizeof(u16)), &value_16bit, sizeof(u16));
     }
 }
 
@@ -192,113 +239,10 @@ static void DisplayTransfer(const Regs::DisplayTransferConfig& config) {
 
     Memory::RasterizerFlushRegion(config.GetPhysicalInputAddress(), input_size);
     Memory::RasterizerInvalidateRegion(config.GetPhysicalOutputAddress(), output_size);
+    g_memory->MarkRegionDirty(dst_pointer, output_size);
 
-    for (u32 y = 0; y < output_height; ++y) {
-        for (u32 x = 0; x < output_width; ++x) {
-            Common::Vec4<u8> src_color;
-
-            // Calculate the [x,y] position of the input image
-            // based on the current output position and the scale
-            u32 input_x = x << horizontal_scale;
-            u32 input_y = y << vertical_scale;
-
-            u32 output_y;
-            if (config.flip_vertically) {
-                // Flip the y value of the output data,
-                // we do this after calculating the [x,y] position of the input image
-                // to account for the scaling options.
-                output_y = output_height - y - 1;
-            } else {
-                output_y = y;
-            }
-
-            u32 dst_bytes_per_pixel = GPU::Regs::BytesPerPixel(config.output_format);
-            u32 src_bytes_per_pixel = GPU::Regs::BytesPerPixel(config.input_format);
-            u32 src_offset;
-            u32 dst_offset;
-
-            if (config.input_linear) {
-                if (!config.dont_swizzle) {
-                    // Interpret the input as linear and the output as tiled
-                    u32 coarse_y = output_y & ~7;
-                    u32 stride = output_width * dst_bytes_per_pixel;
-
-                    src_offset = (input_x + input_y * config.input_width) * src_bytes_per_pixel;
-                    dst_offset = VideoCore::GetMortonOffset(x, output_y, dst_bytes_per_pixel) +
-                                 coarse_y * stride;
-                } else {
-                    // Both input and output are linear
-                    src_offset = (input_x + input_y * config.input_width) * src_bytes_per_pixel;
-                    dst_offset = (x + output_y * output_width) * dst_bytes_per_pixel;
-                }
-            } else {
-                if (!config.dont_swizzle) {
-                    // Interpret the input as tiled and the output as linear
-                    u32 coarse_y = input_y & ~7;
-                    u32 stride = config.input_width * src_bytes_per_pixel;
-
-                    src_offset = VideoCore::GetMortonOffset(input_x, input_y, src_bytes_per_pixel) +
-                                 coarse_y * stride;
-                    dst_offset = (x + output_y * output_width) * dst_bytes_per_pixel;
-                } else {
-                    // Both input and output are tiled
-                    u32 out_coarse_y = output_y & ~7;
-                    u32 out_stride = output_width * dst_bytes_per_pixel;
-
-                    u32 in_coarse_y = input_y & ~7;
-                    u32 in_stride = config.input_width * src_bytes_per_pixel;
-
-                    src_offset = VideoCore::GetMortonOffset(input_x, input_y, src_bytes_per_pixel) +
-                                 in_coarse_y * in_stride;
-                    dst_offset = VideoCore::GetMortonOffset(x, output_y, dst_bytes_per_pixel) +
-                                 out_coarse_y * out_stride;
-                }
-            }
-
-            const u8* src_pixel = src_pointer + src_offset;
-            src_color = DecodePixel(config.input_format, src_pixel);
-            if (config.scaling == config.ScaleX) {
-                Common::Vec4<u8> pixel =
-                    DecodePixel(config.input_format, src_pixel + src_bytes_per_pixel);
-                src_color = ((src_color + pixel) / 2).Cast<u8>();
-            } else if (config.scaling == config.ScaleXY) {
-                Common::Vec4<u8> pixel1 =
-                    DecodePixel(config.input_format, src_pixel + 1 * src_bytes_per_pixel);
-                Common::Vec4<u8> pixel2 =
-                    DecodePixel(config.input_format, src_pixel + 2 * src_bytes_per_pixel);
-                Common::Vec4<u8> pixel3 =
-                    DecodePixel(config.input_format, src_pixel + 3 * src_bytes_per_pixel);
-                src_color = (((src_color + pixel1) + (pixel2 + pixel3)) / 4).Cast<u8>();
-            }
-
-            u8* dst_pixel = dst_pointer + dst_offset;
-            switch (config.output_format) {
-            case Regs::PixelFormat::RGBA8:
-                Common::Color::EncodeRGBA8(src_color, dst_pixel);
-                break;
-
-            case Regs::PixelFormat::RGB8:
-                Common::Color::EncodeRGB8(src_color, dst_pixel);
-                break;
-
-            case Regs::PixelFormat::RGB565:
-                Common::Color::EncodeRGB565(src_color, dst_pixel);
-                break;
-
-            case Regs::PixelFormat::RGB5A1:
-                Common::Color::EncodeRGB5A1(src_color, dst_pixel);
-                break;
-
-            case Regs::PixelFormat::RGBA4:
-                Common::Color::EncodeRGBA4(src_color, dst_pixel);
-                break;
-
-            default:
-                LOG_ERROR(HW_GPU, "Unknown destination framebuffer format {:x}",
-                          static_cast<u32>(config.output_format.Value()));
-                break;
-            }
-        }
+    if (!DisplayTransferRows(config, src_pointer, dst_pointer)) {
+        DisplayTransferPixels(config, src_pointer, dst_pointer);
     }
 }
 
@@ -359,6 +303,7 @@ static void TextureCopy(const Regs::DisplayTransferConfig& config) {
     const auto FlushInvalidate_fn = (output_gap != 0) ? Memory::RasterizerFlushAndInvalidateRegion
                                                       : Memory::RasterizerInvalidateRegion;
     FlushInvalidate_fn(config.GetPhysicalOutputAddress(), static_cast<u32>(contiguous_output_size));
+    g_memory->MarkRegionDirty(dst_pointer, contiguous_output_size);
 
     u32 remaining_input = input_width;
     u32 remaining_output = output_width;
@@ -406,19 +351,21 @@ inline void Write(u32 addr, const T data) {
         auto& config = g_regs.memory_fill_config[is_second_filler];
 
         if (config.trigger) {
-            MemoryFill(config);
-            LOG_TRACE(HW_GPU, "MemoryFill from {:#010X} to {:#010X}", config.GetStartAddress(),
-                      config.GetEndAddress());
-
-            // It seems that it won't signal interrupt if "address_start" is zero.
-            // TODO: hwtest this
-            if (config.GetStartAddress() != 0) {
-                if (!is_second_filler) {
-                    Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PSC0);
-                } else {
-                    Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PSC1);
+            RunOperation([config, is_second_filler] {
+                MemoryFill(config);
+                LOG_TRACE(HW_GPU, "MemoryFill from {:#010X} to {:#010X}",
+                          config.GetStartAddress(), config.GetEndAddress());
+
+                // It seems that it won't signal interrupt if "address_start" is zero.
+                // TODO: hwtest this
+                if (config.GetStartAddress() != 0) {
+                    if (!is_second_filler) {
+                        Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PSC0);
+                    } else {
+                        Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PSC1);
+                    }
                 }
-            }
+            });
 
             // Reset "trigger" flag and set the "finish" flag
             // NOTE: This was confirmed to happen on hardware even if "address_start" is zero.
@@ -429,37 +376,41 @@ inline void Write(u32 addr, const T data) {
     }
 
     case GPU_REG_INDEX(display_transfer_config.trigger): {
-        MICROPROFILE_SCOPE(GPU_DisplayTransfer);
-
         const auto& config = g_regs.display_transfer_config;
         if (config.trigger & 1) {
+            RunOperation([config] {
+                MICROPROFILE_SCOPE(GPU_DisplayTransfer);
+
+                if (Pica::g_debug_context)
+                    Pica::g_debug_context->OnEvent(
+                        Pica::DebugContext::Event::IncomingDisplayTransfer, nullptr);
+
+                if (config.is_texture_copy) {
+                    TextureCopy(config);
+                    LOG_TRACE(HW_GPU,
+                              "TextureCopy: {:#X} bytes from {:#010X}({}+{})-> "
+                              "{:#010X}({}+{}), flags {:#010X}",
+                              config.texture_copy.size, config.GetPhysicalInputAddress(),
+                              config.texture_copy.input_width * 16,
+                              config.texture_copy.input_gap * 16,
+                              config.GetPhysicalOutputAddress(),
+                              config.texture_copy.output_width * 16,
+                              config.texture_copy.output_gap * 16, config.flags);
+                } else {
+                    DisplayTransfer(config);
+                    LOG_TRACE(HW_GPU,
+                              "DisplayTransfer: {:#010X}({}x{})-> "
+                              "{:#010X}({}x{}), dst format {:x}, flags {:#010X}",
+                              config.GetPhysicalInputAddress(), config.input_width.Value(),
+                              config.input_height.Value(), config.GetPhysicalOutputAddress(),
+                              config.output_width.Value(), config.output_height.Value(),
+                              static_cast<u32>(config.output_format.Value()), config.flags);
+                }
 
-            if (Pica::g_debug_context)
-                Pica::g_debug_context->OnEvent(Pica::DebugContext::Event::IncomingDisplayTransfer,
-                                               nullptr);
-
-            if (config.is_texture_copy) {
-                TextureCopy(config);
-                LOG_TRACE(HW_GPU,
-                          "TextureCopy: {:#X} bytes from {:#010X}({}+{})-> "
-                          "{:#010X}({}+{}), flags {:#010X}",
-                          config.texture_copy.size, config.GetPhysicalInputAddress(),
-                          config.texture_copy.input_width * 16, config.texture_copy.input_gap * 16,
-                          config.GetPhysicalOutputAddress(), config.texture_copy.output_width * 16,
-                          config.texture_copy.output_gap * 16, config.flags);
-            } else {
-                DisplayTransfer(config);
-                LOG_TRACE(HW_GPU,
-                          "DisplayTransfer: {:#010X}({}x{})-> "
-                          "{:#010X}({}x{}), dst format {:x}, flags {:#010X}",
-                          config.GetPhysicalInputAddress(), config.input_width.Value(),
-                          config.input_height.Value(), config.GetPhysicalOutputAddress(),
-                          config.output_width.Value(), config.output_height.Value(),
-                          static_cast<u32>(config.output_format.Value()), config.flags);
-            }
+                Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PPF);
+            });
 
             g_regs.display_transfer_config.trigger = 0;
-            Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PPF);
         }
         break;
     }
@@ -468,9 +419,11 @@ inline void Write(u32 addr, const T data) {
     case GPU_REG_INDEX(command_processor_config.trigger): {
         const auto& config = g_regs.command_processor_config;
         if (config.trigger & 1) {
-            MICROPROFILE_SCOPE(GPU_CmdlistProcessing);
+            RunOperation([address = config.GetPhysicalAddress(), size = config.size] {
+                MICROPROFILE_SCOPE(GPU_CmdlistProcessing);
 
-            Pica::CommandProcessor::ProcessCommandList(config.GetPhysicalAddress(), config.size);
+                Pica::CommandProcessor::ProcessCommandList(address, size);
+            });
 
             g_regs.command_processor_config.trigger = 0;
         }
@@ -504,6 +457,8 @@ template void Write<u8>(u32 addr, const u8 data);
 
 /// Update hardware
 static void VBlankCallback(std::uintptr_t user_data, s64 cycles_late) {
+    // The frame must be complete before it is presented
+    Synchronize();
     VideoCore::g_renderer->SwapBuffers();
 
     // Signal to GSP that GPU interrupt has occurred
@@ -552,12 +507,21 @@ void Init(Memory::MemorySystem& memory) {
     Core::Timing& timing = Core::System::GetInstance().CoreTiming();
     vblank_event = timing.RegisterEvent("GPU::VBlankCallback", VBlankCallback);
     timing.ScheduleEvent(frame_ticks, vblank_event);
+    gpu_thread_event = timing.RegisterEvent("GPU::GpuThreadCallback", GpuThreadCallback);
+
+    // The hardware renderers must issue their commands from the thread owning the graphics
+    // context, so only the software renderer can run on the GPU thread.
+    if (Settings::values.use_gpu_thread.GetValue() &&
+        Settings::values.graphics_api.GetValue() == Settings::GraphicsAPI::Software) {
+        gpu_thread = std::make_unique<GpuThread>();
+    }
 
     LOG_DEBUG(HW_GPU, "initialized OK");
 }
 
 /// Shutdown hardware
 void Shutdown() {
+    gpu_thread.reset();
     LOG_DEBUG(HW_GPU, "shutdown OK");
 }
 
@@ -335,6 +335,18 @@ void Read(T& var, const u32 addr);
 template <typename T>
 void Write(u32 addr, const T data);
 
+/**
+ * Waits for the operations queued to the GPU thread to finish and signals the interrupts they
+ * raised. Does nothing if the GPU thread is disabled.
+ */
+void Synchronize();
+
+/**
+ * Synchronizes with the GPU thread and drops the events polling its operations, so that a saved
+ * state holds neither pending operations nor their interrupts.
+ */
+void SynchronizeForSerialization();
+
 /// Initialize hardware
 void Init(Memory::MemorySystem& memory);
 
@@ -0,0 +1,96 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "common/assert.h"
+#include "core/hle/service/gsp/gsp.h"
+#include "core/hw/gpu_thread.h"
+
+namespace GPU {
+
+namespace {
+/// Interrupts raised by the operation running on this thread, if it is the GPU thread
+thread_local std::vector<Service::GSP::InterruptId>* deferred_interrupts = nullptr;
+thread_local bool is_gpu_thread = false;
+} // Anonymous namespace
+
+GpuThread::GpuThread() = default;
+
+GpuThread::~GpuThread() {
+    // The worker drops pending work when destroyed
+    worker.WaitForRequests();
+}
+
+u64 GpuThread::QueueWork(std::function<void()> work) {
+    const u64 fence = ++last_fence;
+    {
+        std::scoped_lock lock{mutex};
+        operations.push_back({fence, {}});
+    }
+
+    worker.QueueWork([this, fence, work = std::move(work)] {
+        is_gpu_thread = true;
+        std::vector<Service::GSP::InterruptId> interrupts;
+        deferred_interrupts = &interrupts;
+        work();
+        deferred_interrupts = nullptr;
+
+        {
+            std::scoped_lock lock{mutex};
+            const auto it =
+                std::find_if(operations.begin(), operations.end(),
+                             [fence](const Operation& op) { return op.fence == fence; });
+            ASSERT(it != operations.end());
+            it->interrupts = std::move(interrupts);
+            finished_fence.store(fence, std::memory_order_release);
+        }
+        finished_cv.notify_all();
+    });
+    return fence;
+}
+
+bool GpuThread::IsFinished(u64 fence) const {
+    return fence > last_fence || finished_fence.load(std::memory_order_acquire) >= fence;
+}
+
+void GpuThread::SyncFence(u64 fence) {
+    ASSERT_MSG(!is_gpu_thread, "Synchronizing with the GPU thread from itself");
+    if (fence > last_fence) {
+        return;
+    }
+
+    std::vector<Service::GSP::InterruptId> interrupts;
+    {
+        std::unique_lock lock{mutex};
+        finished_cv.wait(lock, [this, fence] { return IsFinished(fence); });
+        while (!operations.empty() && operations.front().fence <= fence) {
+            auto& op_interrupts = operations.front().interrupts;
+            interrupts.insert(interrupts.end(), op_interrupts.begin(), op_interrupts.end());
+            operations.pop_front();
+        }
+    }
+
+    // Signalled outside the lock, in the order they were raised
+    for (const auto interrupt_id : interrupts) {
+        Service::GSP::SignalInterrupt(interrupt_id);
+    }
+}
+
+void GpuThread::Synchronize() {
+    SyncFence(last_fence);
+}
+
+bool GpuThread::DeferInterrupt(Service::GSP::InterruptId interrupt_id) {
+    if (!deferred_interrupts) {
+        return false;
+    }
+    deferred_interrupts->push_back(interrupt_id);
+    return true;
+}
+
+bool GpuThread::IsGpuThread() {
+    return is_gpu_thread;
+}
+
+} // namespace GPU
@@ -0,0 +1,80 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+#include "common/common_types.h"
+#include "common/thread_worker.h"
+
+namespace Service::GSP {
+enum class InterruptId : u8;
+}
+
+namespace GPU {
+
+/**
+ * Runs GPU operations queued by the emulation thread in order on a separate host thread. The
+ * interrupts raised by an operation are held back until the emulation thread synchronizes with
+ * it, so the emulated application can't observe its results early.
+ */
+class GpuThread {
+public:
+    GpuThread();
+    ~GpuThread();
+
+    /**
+     * Queues an operation to run on the GPU thread.
+     * @returns The fence to synchronize with the operation
+     */
+    u64 QueueWork(std::function<void()> work);
+
+    /**
+     * Returns true if the operations up to the fence have finished running. Fences this thread
+     * never handed out, such as ones restored from a saved state, count as finished.
+     */
+    bool IsFinished(u64 fence) const;
+
+    /**
+     * Waits for the operations up to the fence to finish and signals the interrupts they raised.
+     * Does nothing for fences this thread never handed out. Must be called from the emulation
+     * thread.
+     */
+    void SyncFence(u64 fence);
+
+    /// Waits for every queued operation to finish and signals the interrupts they raised
+    void Synchronize();
+
+    /**
+     * Holds the interrupt back until the operation raising it is synchronized with, if called
+     * from an operation on the GPU thread.
+     * @returns true if the interrupt was deferred, false if it should be signalled right away
+     */
+    static bool DeferInterrupt(Service::GSP::InterruptId interrupt_id);
+
+    /// Returns true if called from the GPU thread
+    static bool IsGpuThread();
+
+private:
+    struct Operation {
+        u64 fence;
+        std::vector<Service::GSP::InterruptId> interrupts;
+    };
+
+    /// Operations that haven't been synchronized with yet, oldest first
+    std::deque<Operation> operations;
+    std::mutex mutex;
+    std::condition_variable finished_cv;
+    std::atomic<u64> finished_fence{0};
+    u64 last_fence{0};
+
+    Common::ThreadWorker worker{1, "GPU"};
+};
+
+} // namespace GPU
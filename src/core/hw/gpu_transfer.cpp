@@ -0,0 +1,577 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "common/alignment.h"
+#include "common/arch.h"
+#include "common/color.h"
+#include "common/logging/log.h"
+#include "common/vector_math.h"
+#include "core/hw/gpu_transfer.h"
+#include "video_core/simd_utils.h"
+#include "video_core/utils.h"
+
+#if CITRA_ARCH(x86_64)
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#include "common/x64/cpu_detect.h"
+#elif CITRA_ARCH(arm64)
+#include <arm_neon.h>
+#endif
+
+namespace GPU {
+
+namespace {
+
+using PixelFormat = Regs::PixelFormat;
+
+Common::Vec4<u8> DecodePixel(PixelFormat input_format, const u8* src_pixel) {
+    switch (input_format) {
+    case PixelFormat::RGBA8:
+        return Common::Color::DecodeRGBA8(src_pixel);
+
+    case PixelFormat::RGB8:
+        return Common::Color::DecodeRGB8(src_pixel);
+
+    case PixelFormat::RGB565:
+        return Common::Color::DecodeRGB565(src_pixel);
+
+    case PixelFormat::RGB5A1:
+        return Common::Color::DecodeRGB5A1(src_pixel);
+
+    case PixelFormat::RGBA4:
+        return Common::Color::DecodeRGBA4(src_pixel);
+
+    default:
+        LOG_ERROR(HW_GPU, "Unknown source framebuffer format {:x}", input_format);
+        return {0, 0, 0, 0};
+    }
+}
+
+void EncodePixel(PixelFormat output_format, const Common::Vec4<u8>& color, u8* dst_pixel) {
+    switch (output_format) {
+    case PixelFormat::RGBA8:
+        Common::Color::EncodeRGBA8(color, dst_pixel);
+        break;
+
+    case PixelFormat::RGB8:
+        Common::Color::EncodeRGB8(color, dst_pixel);
+        break;
+
+    case PixelFormat::RGB565:
+        Common::Color::EncodeRGB565(color, dst_pixel);
+        break;
+
+    case PixelFormat::RGB5A1:
+        Common::Color::EncodeRGB5A1(color, dst_pixel);
+        break;
+
+    case PixelFormat::RGBA4:
+        Common::Color::EncodeRGBA4(color, dst_pixel);
+        break;
+
+    default:
+        LOG_ERROR(HW_GPU, "Unknown destination framebuffer format {:x}",
+                  static_cast<u32>(output_format));
+        break;
+    }
+}
+
+/**
+ * Converts a row of pixels from a framebuffer format to RGBA8 with the components in memory order
+ * (the layout of Common::Vec4<u8>), or back.
+ */
+using RowFunc = void (*)(const u8* source, u8* dest, u32 count);
+
+template <PixelFormat format>
+void DecodeRowScalar(const u8* source, u8* dest, u32 count) {
+    const u32 bytes_per_pixel = Regs::BytesPerPixel(format);
+    for (u32 i = 0; i < count; ++i) {
+        const Common::Vec4<u8> color = DecodePixel(format, source + i * bytes_per_pixel);
+        std::memcpy(dest + i * 4, color.AsArray(), 4);
+    }
+}
+
+template <PixelFormat format>
+void EncodeRowScalar(const u8* source, u8* dest, u32 count) {
+    const u32 bytes_per_pixel = Regs::BytesPerPixel(format);
+    for (u32 i = 0; i < count; ++i) {
+        Common::Vec4<u8> color;
+        std::memcpy(color.AsArray(), source + i * 4, 4);
+        EncodePixel(format, color, dest + i * bytes_per_pixel);
+    }
+}
+
+/// RGBA8 framebuffers store the components in reverse, so decoding and encoding are the same swap
+void SwapRowRGBA8(const u8* source, u8* dest, u32 count) {
+    u32 i = 0;
+#if CITRA_ARCH(x86_64)
+    for (; i + 4 <= count; i += 4) {
+        __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 4));
+        value = _mm_or_si128(_mm_slli_epi16(value, 8), _mm_srli_epi16(value, 8));
+        value = _mm_shufflelo_epi16(value, _MM_SHUFFLE(2, 3, 0, 1));
+        value = _mm_shufflehi_epi16(value, _MM_SHUFFLE(2, 3, 0, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i * 4), value);
+    }
+#elif CITRA_ARCH(arm64)
+    for (; i + 4 <= count; i += 4) {
+        vst1q_u8(dest + i * 4, vrev32q_u8(vld1q_u8(source + i * 4)));
+    }
+#endif
+    DecodeRowScalar<PixelFormat::RGBA8>(source + i * 4, dest + i * 4, count - i);
+}
+
+TARGET_SSSE3 void DecodeRowRGB8(const u8* source, u8* dest, u32 count) {
+    u32 i = 0;
+#if CITRA_ARCH(x86_64)
+    // Each load reads 16 bytes for 4 pixels, stay clear of the end of the row
+    const __m128i indices =
+        _mm_load_si128(reinterpret_cast<const __m128i*>(VideoCore::RGB8_TO_RGBA8));
+    const __m128i alpha = _mm_set1_epi32(static_cast<s32>(0xFF000000));
+    for (; i + 6 <= count; i += 4) {
+        const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 3));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i * 4),
+                         _mm_or_si128(_mm_shuffle_epi8(value, indices), alpha));
+    }
+#elif CITRA_ARCH(arm64)
+    for (; i + 16 <= count; i += 16) {
+        const uint8x16x3_t bgr = vld3q_u8(source + i * 3);
+        const uint8x16x4_t rgba{{bgr.val[2], bgr.val[1], bgr.val[0], vdupq_n_u8(0xFF)}};
+        vst4q_u8(dest + i * 4, rgba);
+    }
+#endif
+    DecodeRowScalar<PixelFormat::RGB8>(source + i * 3, dest + i * 4, count - i);
+}
+
+TARGET_SSSE3 void EncodeRowRGB8(const u8* source, u8* dest, u32 count) {
+    u32 i = 0;
+#if CITRA_ARCH(x86_64)
+    // Each store writes 16 bytes for 4 pixels, stay clear of the end of the row
+    const __m128i indices =
+        _mm_load_si128(reinterpret_cast<const __m128i*>(VideoCore::RGBA8_TO_RGB8));
+    for (; i + 6 <= count; i += 4) {
+        const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i * 3),
+                         _mm_shuffle_epi8(value, indices));
+    }
+#elif CITRA_ARCH(arm64)
+    for (; i + 16 <= count; i += 16) {
+        const uint8x16x4_t rgba = vld4q_u8(source + i * 4);
+        vst3q_u8(dest + i * 3, uint8x16x3_t{{rgba.val[2], rgba.val[1], rgba.val[0]}});
+    }
+#endif
+    EncodeRowScalar<PixelFormat::RGB8>(source + i * 4, dest + i * 3, count - i);
+}
+
+void DecodeRowRGB565(const u8* source, u8* dest, u32 count) {
+    u32 i = 0;
+#if CITRA_ARCH(x86_64)
+    const __m128i mask5 = _mm_set1_epi16(0x1F);
+    const __m128i mask6 = _mm_set1_epi16(0x3F);
+    const __m128i alpha = _mm_set1_epi16(static_cast<s16>(0xFF00));
+    for (; i + 8 <= count; i += 8) {
+        const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 2));
+        const __m128i r = _mm_srli_epi16(value, 11);
+        const __m128i g = _mm_and_si128(_mm_srli_epi16(value, 5), mask6);
+        const __m128i b = _mm_and_si128(value, mask5);
+        const __m128i r8 = _mm_or_si128(_mm_slli_epi16(r, 3), _mm_srli_epi16(r, 2));
+        const __m128i g8 = _mm_or_si128(_mm_slli_epi16(g, 2), _mm_srli_epi16(g, 4));
+        const __m128i b8 = _mm_or_si128(_mm_slli_epi16(b, 3), _mm_srli_epi16(b, 2));
+        const __m128i rg = _mm_or_si128(r8, _mm_slli_epi16(g8, 8));
+        const __m128i ba = _mm_or_si128(b8, alpha);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i * 4), _mm_unpacklo_epi16(rg, ba));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i * 4 + 16),
+                         _mm_unpackhi_epi16(rg, ba));
+    }
+#elif CITRA_ARCH(arm64)
+    for (; i + 8 <= count; i += 8) {
+        const uint16x8_t value = vld1q_u16(reinterpret_cast<const u16*>(source + i * 2));
+        const uint16x8_t r = vshrq_n_u16(value, 11);
+        const uint16x8_t g = vandq_u16(vshrq_n_u16(value, 5), vdupq_n_u16(0x3F));
+        const uint16x8_t b = vandq_u16(value, vdupq_n_u16(0x1F));
+        const uint8x8x4_t rgba{{
+            vmovn_u16(vorrq_u16(vshlq_n_u16(r, 3), vshrq_n_u16(r, 2))),
+            vmovn_u16(vorrq_u16(vshlq_n_u16(g, 2), vshrq_n_u16(g, 4))),
+            vmovn_u16(vorrq_u16(vshlq_n_u16(b, 3), vshrq_n_u16(b, 2))),
+            vdup_n_u8(0xFF),
+        }};
+        vst4_u8(dest + i * 4, rgba);
+    }
+#endif
+    DecodeRowScalar<PixelFormat::RGB565>(source + i * 2, dest + i * 4, count - i);
+}
+
+void EncodeRowRGB565(const u8* source, u8* dest, u32 count) {
+    u32 i = 0;
+#if CITRA_ARCH(x86_64)
+    const __m128i mask = _mm_set1_epi32(0xFF);
+    const auto pack = [&mask](__m128i value) {
+        const __m128i r = _mm_srli_epi32(_mm_and_si128(value, mask), 3);
+        const __m128i g = _mm_srli_epi32(_mm_and_si128(_mm_srli_epi32(value, 8), mask), 2);
+        const __m128i b = _mm_srli_epi32(_mm_and_si128(_mm_srli_epi32(value, 16), mask), 3);
+        const __m128i packed =
+            _mm_or_si128(_mm_or_si128(_mm_slli_epi32(r, 11), _mm_slli_epi32(g, 5)), b);
+        // Sign extend so that the saturating pack keeps all 16 bits
+        return _mm_srai_epi32(_mm_slli_epi32(packed, 16), 16);
+    };
+    for (; i + 8 <= count; i += 8) {
+        const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 4));
+        const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 4 + 16));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i * 2),
+                         _mm_packs_epi32(pack(lo), pack(hi)));
+    }
+#elif CITRA_ARCH(arm64)
+    for (; i + 8 <= count; i += 8) {
+        const uint8x8x4_t rgba = vld4_u8(source + i * 4);
+        const uint16x8_t r = vshlq_n_u16(vmovl_u8(vshr_n_u8(rgba.val[0], 3)), 11);
+        const uint16x8_t g = vshlq_n_u16(vmovl_u8(vshr_n_u8(rgba.val[1], 2)), 5);
+        const uint16x8_t b = vmovl_u8(vshr_n_u8(rgba.val[2], 3));
+        vst1q_u16(reinterpret_cast<u16*>(dest + i * 2), vorrq_u16(vorrq_u16(r, g), b));
+    }
+#endif
+    EncodeRowScalar<PixelFormat::RGB565>(source + i * 4, dest + i * 2, count - i);
+}
+
+RowFunc GetDecodeRowFunc(PixelFormat format) {
+    switch (format) {
+    case PixelFormat::RGBA8:
+        return &SwapRowRGBA8;
+    case PixelFormat::RGB8:
+#if CITRA_ARCH(x86_64)
+        if (!Common::GetCPUCaps().ssse3) {
+            return &DecodeRowScalar<PixelFormat::RGB8>;
+        }
+#endif
+        return &DecodeRowRGB8;
+    case PixelFormat::RGB565:
+        return &DecodeRowRGB565;
+    case PixelFormat::RGB5A1:
+        return &DecodeRowScalar<PixelFormat::RGB5A1>;
+    case PixelFormat::RGBA4:
+        return &DecodeRowScalar<PixelFormat::RGBA4>;
+    default:
+        return nullptr;
+    }
+}
+
+RowFunc GetEncodeRowFunc(PixelFormat format) {
+    switch (format) {
+    case PixelFormat::RGBA8:
+        return &SwapRowRGBA8;
+    case PixelFormat::RGB8:
+#if CITRA_ARCH(x86_64)
+        if (!Common::GetCPUCaps().ssse3) {
+            return &EncodeRowScalar<PixelFormat::RGB8>;
+        }
+#endif
+        return &EncodeRowRGB8;
+    case PixelFormat::RGB565:
+        return &EncodeRowRGB565;
+    case PixelFormat::RGB5A1:
+        return &EncodeRowScalar<PixelFormat::RGB5A1>;
+    case PixelFormat::RGBA4:
+        return &EncodeRowScalar<PixelFormat::RGBA4>;
+    default:
+        return nullptr;
+    }
+}
+
+/**
+ * Averages each pair of adjacent RGBA8 pixels of row0, and with vertical set also the pixels below
+ * them in row1, rounding down like the hardware box filter.
+ * @param count The number of output pixels
+ */
+template <bool vertical>
+void BoxFilterRow(const u8* row0, const u8* row1, u8* dest, u32 count) {
+    constexpr int shift = vertical ? 2 : 1;
+    u32 i = 0;
+#if CITRA_ARCH(x86_64)
+    const __m128i zero = _mm_setzero_si128();
+    // Returns the 16-bit sums of the pixel pairs [0, 1] and [2, 3]
+    const auto sum_pairs = [&zero](const u8* pixels) {
+        const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels));
+        const __m128i lo = _mm_unpacklo_epi8(value, zero);
+        const __m128i hi = _mm_unpackhi_epi8(value, zero);
+        return _mm_add_epi16(_mm_unpacklo_epi64(lo, hi), _mm_unpackhi_epi64(lo, hi));
+    };
+    for (; i + 4 <= count; i += 4) {
+        __m128i sum_lo = sum_pairs(row0 + i * 8);
+        __m128i sum_hi = sum_pairs(row0 + i * 8 + 16);
+        if constexpr (vertical) {
+            sum_lo = _mm_add_epi16(sum_lo, sum_pairs(row1 + i * 8));
+            sum_hi = _mm_add_epi16(sum_hi, sum_pairs(row1 + i * 8 + 16));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i * 4),
+                         _mm_packus_epi16(_mm_srli_epi16(sum_lo, shift),
+                                          _mm_srli_epi16(sum_hi, shift)));
+    }
+#elif CITRA_ARCH(arm64)
+    for (; i + 4 <= count; i += 4) {
+        // Deinterleaving 32-bit lanes splits the even and odd pixels
+        const uint32x4x2_t pairs0 = vld2q_u32(reinterpret_cast<const u32*>(row0 + i * 8));
+        const uint8x16_t even0 = vreinterpretq_u8_u32(pairs0.val[0]);
+        const uint8x16_t odd0 = vreinterpretq_u8_u32(pairs0.val[1]);
+        uint16x8_t sum_lo = vaddl_u8(vget_low_u8(even0), vget_low_u8(odd0));
+        uint16x8_t sum_hi = vaddl_high_u8(even0, odd0);
+        if constexpr (vertical) {
+            const uint32x4x2_t pairs1 = vld2q_u32(reinterpret_cast<const u32*>(row1 + i * 8));
+            const uint8x16_t even1 = vreinterpretq_u8_u32(pairs1.val[0]);
+            const uint8x16_t odd1 = vreinterpretq_u8_u32(pairs1.val[1]);
+            sum_lo = vaddq_u16(sum_lo, vaddl_u8(vget_low_u8(even1), vget_low_u8(odd1)));
+            sum_hi = vaddq_u16(sum_hi, vaddl_high_u8(even1, odd1));
+        }
+        vst1q_u8(dest + i * 4, vcombine_u8(vshrn_n_u16(sum_lo, shift), vshrn_n_u16(sum_hi, shift)));
+    }
+#endif
+    for (; i < count; ++i) {
+        for (u32 component = 0; component < 4; ++component) {
+            u32 sum = row0[i * 8 + component] + row0[i * 8 + 4 + component];
+            if constexpr (vertical) {
+                sum += row1[i * 8 + component] + row1[i * 8 + 4 + component];
+            }
+            dest[i * 4 + component] = static_cast<u8>(sum >> shift);
+        }
+    }
+}
+
+/// Offsets of the pixel pairs making up a row of a tile, relative to the first pixel of the row.
+/// The two pixels of a pair are adjacent in memory.
+constexpr std::array<u32, 4> TILE_ROW_PAIRS{
+    VideoCore::MortonInterleave(0, 0),
+    VideoCore::MortonInterleave(2, 0),
+    VideoCore::MortonInterleave(4, 0),
+    VideoCore::MortonInterleave(6, 0),
+};
+
+/**
+ * Returns row y of an image that is stride pixels wide as linear pixels. Rows of tiled images are
+ * gathered into scratch first.
+ */
+const u8* GatherRow(const u8* image, bool tiled, u32 stride, u32 y, u32 width, u32 bytes_per_pixel,
+                    u8* scratch) {
+    if (!tiled) {
+        return image + y * stride * bytes_per_pixel;
+    }
+    const u8* tile_row =
+        image + ((y & ~7) * stride + VideoCore::MortonInterleave(0, y)) * bytes_per_pixel;
+    for (u32 x = 0; x < width; x += 8) {
+        const u8* tile = tile_row + x * 8 * bytes_per_pixel;
+        for (u32 pair = 0; pair < TILE_ROW_PAIRS.size(); ++pair) {
+            std::memcpy(scratch + (x + pair * 2) * bytes_per_pixel,
+                        tile + TILE_ROW_PAIRS[pair] * bytes_per_pixel, 2 * bytes_per_pixel);
+        }
+    }
+    return scratch;
+}
+
+/// Writes linear pixels to row y of a tiled image that is stride pixels wide
+void ScatterRow(u8* image, u32 stride, u32 y, u32 width, u32 bytes_per_pixel, const u8* row) {
+    u8* tile_row =
+        image + ((y & ~7) * stride + VideoCore::MortonInterleave(0, y)) * bytes_per_pixel;
+    for (u32 x = 0; x < width; x += 8) {
+        u8* tile = tile_row + x * 8 * bytes_per_pixel;
+        for (u32 pair = 0; pair < TILE_ROW_PAIRS.size(); ++pair) {
+            std::memcpy(tile + TILE_ROW_PAIRS[pair] * bytes_per_pixel,
+                        row + (x + pair * 2) * bytes_per_pixel, 2 * bytes_per_pixel);
+        }
+    }
+}
+
+bool IsValidFormat(PixelFormat format) {
+    return static_cast<u32>(format) <= static_cast<u32>(PixelFormat::RGBA4);
+}
+
+} // Anonymous namespace
+
+void DisplayTransferPixels(const Regs::DisplayTransferConfig& config, const u8* src_pointer,
+                           u8* dst_pointer) {
+    int horizontal_scale = config.scaling != config.NoScale ? 1 : 0;
+    int vertical_scale = config.scaling == config.ScaleXY ? 1 : 0;
+
+    u32 output_width = config.output_width >> horizontal_scale;
+    u32 output_height = config.output_height >> vertical_scale;
+
+    for (u32 y = 0; y < output_height; ++y) {
+        for (u32 x = 0; x < output_width; ++x) {
+            Common::Vec4<u8> src_color;
+
+            // Calculate the [x,y] position of the input image
+            // based on the current output position and the scale
+            u32 input_x = x << horizontal_scale;
+            u32 input_y = y << vertical_scale;
+
+            u32 output_y;
+            if (config.flip_vertically) {
+                // Flip the y value of the output data,
+                // we do this after calculating the [x,y] position of the input image
+                // to account for the scaling options.
+                output_y = output_height - y - 1;
+            } else {
+                output_y = y;
+            }
+
+            u32 dst_bytes_per_pixel = GPU::Regs::BytesPerPixel(config.output_format);
+            u32 src_bytes_per_pixel = GPU::Regs::BytesPerPixel(config.input_format);
+            u32 src_offset;
+            u32 dst_offset;
+
+            if (config.input_linear) {
+                if (!config.dont_swizzle) {
+                    // Interpret the input as linear and the output as tiled
+                    u32 coarse_y = output_y & ~7;
+                    u32 stride = output_width * dst_bytes_per_pixel;
+
+                    src_offset = (input_x + input_y * config.input_width) * src_bytes_per_pixel;
+                    dst_offset = VideoCore::GetMortonOffset(x, output_y, dst_bytes_per_pixel) +
+                                 coarse_y * stride;
+                } else {
+                    // Both input and output are linear
+                    src_offset = (input_x + input_y * config.input_width) * src_bytes_per_pixel;
+                    dst_offset = (x + output_y * output_width) * dst_bytes_per_pixel;
+                }
+            } else {
+                if (!config.dont_swizzle) {
+                    // Interpret the input as tiled and the output as linear
+                    u32 coarse_y = input_y & ~7;
+                    u32 stride = config.input_width * src_bytes_per_pixel;
+
+                    src_offset = VideoCore::GetMortonOffset(input_x, input_y, src_bytes_per_pixel) +
+                                 coarse_y * stride;
+                    dst_offset = (x + output_y * output_width) * dst_bytes_per_pixel;
+                } else {
+                    // Both input and output are tiled
+                    u32 out_coarse_y = output_y & ~7;
+                    u32 out_stride = output_width * dst_bytes_per_pixel;
+
+                    u32 in_coarse_y = input_y & ~7;
+                    u32 in_stride = config.input_width * src_bytes_per_pixel;
+
+                    src_offset = VideoCore::GetMortonOffset(input_x, input_y, src_bytes_per_pixel) +
+                                 in_coarse_y * in_stride;
+                    dst_offset = VideoCore::GetMortonOffset(x, output_y, dst_bytes_per_pixel) +
+                                 out_coarse_y * out_stride;
+                }
+            }
+
+            const u8* src_pixel = src_pointer + src_offset;
+            src_color = DecodePixel(config.input_format, src_pixel);
+            if (config.scaling == config.ScaleX) {
+                Common::Vec4<u8> pixel =
+                    DecodePixel(config.input_format, src_pixel + src_bytes_per_pixel);
+                src_color = ((src_color + pixel) / 2).Cast<u8>();
+            } else if (config.scaling == config.ScaleXY) {
+                Common::Vec4<u8> pixel1 =
+                    DecodePixel(config.input_format, src_pixel + 1 * src_bytes_per_pixel);
+                Common::Vec4<u8> pixel2 =
+                    DecodePixel(config.input_format, src_pixel + 2 * src_bytes_per_pixel);
+                Common::Vec4<u8> pixel3 =
+                    DecodePixel(config.input_format, src_pixel + 3 * src_bytes_per_pixel);
+                src_color = (((src_color + pixel1) + (pixel2 + pixel3)) / 4).Cast<u8>();
+            }
+
+            EncodePixel(config.output_format, src_color, dst_pointer + dst_offset);
+        }
+    }
+}
+
+bool DisplayTransferRows(const Regs::DisplayTransferConfig& config, const u8* src_pointer,
+                         u8* dst_pointer) {
+    const PixelFormat input_format = config.input_format;
+    const PixelFormat output_format = config.output_format;
+    if (!IsValidFormat(input_format) || !IsValidFormat(output_format) ||
+        config.scaling > config.ScaleXY) {
+        return false;
+    }
+
+    // Scaling reads the pixels that follow in memory, which are only the neighbours in tiles
+    const bool input_tiled = !config.input_linear;
+    const bool output_tiled = config.input_linear != config.dont_swizzle;
+    if (!input_tiled && config.scaling != config.NoScale) {
+        return false;
+    }
+
+    const u32 horizontal_scale = config.scaling != config.NoScale ? 1 : 0;
+    const u32 vertical_scale = config.scaling == config.ScaleXY ? 1 : 0;
+    const u32 output_width = config.output_width >> horizontal_scale;
+    const u32 output_height = config.output_height >> vertical_scale;
+    const u32 input_row_width = output_width << horizontal_scale;
+    const u32 input_stride = config.input_width;
+
+    // Rows are copied a tile row at a time
+    if ((input_tiled && input_row_width % 8 != 0) || (output_tiled && output_width % 8 != 0)) {
+        return false;
+    }
+
+    const u32 src_bytes_per_pixel = Regs::BytesPerPixel(input_format);
+    const u32 dst_bytes_per_pixel = Regs::BytesPerPixel(output_format);
+
+    // Rows are read before they are written, which only matches the pixel order of the hardware
+    // if the buffers don't overlap
+    const std::size_t input_rows = Common::AlignUp(output_height << vertical_scale, 8);
+    const std::size_t output_rows = Common::AlignUp(output_height, 8);
+    const std::size_t input_extent =
+        input_rows * std::max(input_stride, input_row_width) * src_bytes_per_pixel;
+    const std::size_t output_extent = output_rows * output_width * dst_bytes_per_pixel;
+    const auto src_address = reinterpret_cast<uintptr_t>(src_pointer);
+    const auto dst_address = reinterpret_cast<uintptr_t>(dst_pointer);
+    if (src_address < dst_address + output_extent && dst_address < src_address + input_extent) {
+        return false;
+    }
+
+    std::vector<u8> src_scratch(input_row_width * src_bytes_per_pixel);
+    std::vector<u8> dst_scratch(output_tiled ? output_width * dst_bytes_per_pixel : 0);
+
+    const bool convert = input_format != output_format || config.scaling != config.NoScale;
+    const RowFunc decode_row = GetDecodeRowFunc(input_format);
+    const RowFunc encode_row = GetEncodeRowFunc(output_format);
+    std::vector<u8> rgba0(convert ? input_row_width * 4 : 0);
+    std::vector<u8> rgba1(config.scaling == config.ScaleXY ? input_row_width * 4 : 0);
+    std::vector<u8> filtered(config.scaling != config.NoScale ? output_width * 4 : 0);
+
+    for (u32 y = 0; y < output_height; ++y) {
+        const u32 input_y = y << vertical_scale;
+        const u32 output_y = config.flip_vertically ? output_height - y - 1 : y;
+        u8* dst_row = output_tiled ? dst_scratch.data()
+                                   : dst_pointer + output_y * output_width * dst_bytes_per_pixel;
+        const u8* out_row = dst_row;
+
+        if (!convert) {
+            // Decoding and encoding the same format is lossless, copy the pixels as they are
+            out_row = GatherRow(src_pointer, input_tiled, input_stride, input_y, input_row_width,
+                                src_bytes_per_pixel, dst_row);
+            if (!output_tiled && out_row != dst_row) {
+                std::memcpy(dst_row, out_row, output_width * dst_bytes_per_pixel);
+            }
+        } else {
+            decode_row(GatherRow(src_pointer, input_tiled, input_stride, input_y, input_row_width,
+                                 src_bytes_per_pixel, src_scratch.data()),
+                       rgba0.data(), input_row_width);
+
+            const u8* rgba = rgba0.data();
+            if (config.scaling == config.ScaleX) {
+                BoxFilterRow<false>(rgba0.data(), nullptr, filtered.data(), output_width);
+                rgba = filtered.data();
+            } else if (config.scaling == config.ScaleXY) {
+                decode_row(GatherRow(src_pointer, input_tiled, input_stride, input_y + 1,
+                                     input_row_width, src_bytes_per_pixel, src_scratch.data()),
+                           rgba1.data(), input_row_width);
+                BoxFilterRow<true>(rgba0.data(), rgba1.data(), filtered.data(), output_width);
+                rgba = filtered.data();
+            }
+            encode_row(rgba, dst_row, output_width);
+        }
+
+        if (output_tiled) {
+            ScatterRow(dst_pointer, output_width, output_y, output_width, dst_bytes_per_pixel,
+                       out_row);
+        }
+    }
+    return true;
+}
+
+} // namespace GPU
@@ -0,0 +1,27 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "common/common_types.h"
+#include "core/hw/gpu.h"
+
+namespace GPU {
+
+/**
+ * Performs a display transfer between host buffers one pixel at a time. This handles every
+ * configuration and is the reference DisplayTransferRows is tested against.
+ */
+void DisplayTransferPixels(const Regs::DisplayTransferConfig& config, const u8* src_pointer,
+                           u8* dst_pointer);
+
+/**
+ * Performs a display transfer between host buffers a whole row at a time, converting formats and
+ * downscaling with SIMD kernels where there is one for the host.
+ * @returns false if the configuration isn't supported, in which case nothing was written.
+ */
+bool DisplayTransferRows(const Regs::DisplayTransferConfig& config, const u8* src_pointer,
+                         u8* dst_pointer);
+
+} // namespace GPU
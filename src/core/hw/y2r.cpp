@@ -5,15 +5,18 @@
 #include <algorithm>
 #include <array>
 #include <cstddef>
+#include <cstring>
 #include <memory>
+#include <span>
+#include <vector>
 #include "common/assert.h"
-#include "common/color.h"
 #include "common/common_types.h"
 #include "common/microprofileui.h"
-#include "common/vector_math.h"
+#include "common/thread_worker.h"
 #include "core/core.h"
 #include "core/hle/service/y2r_u.h"
 #include "core/hw/y2r.h"
+#include "core/hw/y2r_convert.h"
 #include "core/memory.h"
 
 namespace HW::Y2R {
@@ -21,61 +24,9 @@ namespace HW::Y2R {
 using namespace Service::Y2R;
 
 static const std::size_t MAX_TILES = 1024 / 8;
-static const std::size_t TILE_SIZE = 8 * 8;
-using ImageTile = std::array<u32, TILE_SIZE>;
-
-/// Converts a image strip from the source YUV format into individual 8x8 RGB32 tiles.
-template <InputFormat input_format>
-static void ConvertYUVToRGB(const u8* input_Y, const u8* input_U, const u8* input_V,
-                            ImageTile output[], unsigned int width, unsigned int height,
-                            const CoefficientSet& coefficients) {
-
-    for (unsigned int y = 0; y < height; ++y) {
-        for (unsigned int x = 0; x < width; ++x) {
-            s32 Y;
-            s32 U;
-            s32 V;
-            if constexpr (input_format == InputFormat::YUV422_Indiv8 ||
-                          input_format == InputFormat::YUV422_Indiv16) {
-                Y = input_Y[y * width + x];
-                U = input_U[(y * width + x) / 2];
-                V = input_V[(y * width + x) / 2];
-            } else if constexpr (input_format == InputFormat::YUV420_Indiv8 ||
-                                 input_format == InputFormat::YUV420_Indiv16) {
-                Y = input_Y[y * width + x];
-                U = input_U[((y / 2) * width + x) / 2];
-                V = input_V[((y / 2) * width + x) / 2];
-            } else if constexpr (input_format == InputFormat::YUYV422_Interleaved) {
-                Y = input_Y[(y * width + x) * 2];
-                U = input_Y[(y * width + (x / 2) * 2) * 2 + 1];
-                V = input_Y[(y * width + (x / 2) * 2) * 2 + 3];
-            } else {
-                UNREACHABLE_MSG("Unknown Y2R input format {}", input_format);
-                return;
-            }
 
-            // This conversion process is bit-exact with hardware, as far as could be tested.
-            auto& c = coefficients;
-            s32 cY = c[0] * Y;
-
-            s32 r = cY + c[1] * V;
-            s32 g = cY - c[2] * V - c[3] * U;
-            s32 b = cY + c[4] * U;
-
-            const s32 rounding_offset = 0x18;
-            r = (r >> 3) + c[5] + rounding_offset;
-            g = (g >> 3) + c[6] + rounding_offset;
-            b = (b >> 3) + c[7] + rounding_offset;
-
-            unsigned int tile = x / 8;
-            unsigned int tile_x = x % 8;
-            u32* out = &output[tile][y * 8 + tile_x];
-            *out = ((u32)std::clamp(r >> 5, 0, 0xFF) << 24) |
-                   ((u32)std::clamp(g >> 5, 0, 0xFF) << 16) |
-                   ((u32)std::clamp(b >> 5, 0, 0xFF) << 8);
-        }
-    }
-}
+/// Conversions with at least this many pixels have their strips converted on several threads.
+constexpr std::size_t PARALLEL_CONVERSION_MIN_PIXELS = 256 * 256;
 
 /// Simulates an incoming CDMA transfer. The N parameter is used to automatically convert 16-bit
 /// formats to 8-bit.
@@ -88,8 +39,12 @@ static void ReceiveData(Memory::MemorySystem& memory, u8* output, ConversionBuff
     ASSERT(amount_of_data % output_unit == 0);
 
     while (amount_of_data > 0) {
-        for (std::size_t i = 0; i < output_unit; ++i) {
-            output[i] = input[i * N];
+        if constexpr (N == 1) {
+            std::memcpy(output, input, output_unit);
+        } else {
+            for (std::size_t i = 0; i < output_unit; ++i) {
+                output[i] = input[i * N];
+            }
         }
 
         output += output_unit;
@@ -103,112 +58,210 @@ static void ReceiveData(Memory::MemorySystem& memory, u8* output, ConversionBuff
 
 /// Convert intermediate RGB32 format to the final output format while simulating an outgoing CDMA
 /// transfer.
-template <OutputFormat output_format>
-static void SendData(Memory::MemorySystem& memory, const u32* input, ConversionBuffer& buf,
-                     int amount_of_data, u8 alpha) {
+static void SendData(Memory::MemorySystem& memory, OutputFormat output_format, const u32* input,
+                     ConversionBuffer& buf, int amount_of_data, u8 alpha) {
+    const u32 bytes_per_pixel = OutputBytesPerPixel(output_format);
+    // Every transfer writes whole pixels, so the last one may run past the end of the unit
+    const u32 unit_pixels = (buf.transfer_unit + bytes_per_pixel - 1) / bytes_per_pixel;
 
     u8* output = memory.GetPointer(buf.address);
 
     while (amount_of_data > 0) {
-        u8* unit_end = output + buf.transfer_unit;
-        while (output < unit_end) {
-            u32 color = *input++;
-            Common::Vec4<u8> col_vec{(u8)(color >> 24), (u8)(color >> 16), (u8)(color >> 8), alpha};
-
-            if constexpr (output_format == OutputFormat::RGBA8) {
-                Common::Color::EncodeRGBA8(col_vec, output);
-                output += 4;
-            } else if constexpr (output_format == OutputFormat::RGB8) {
-                Common::Color::EncodeRGB8(col_vec, output);
-                output += 3;
-            } else if constexpr (output_format == OutputFormat::RGB5A1) {
-                Common::Color::EncodeRGB5A1(col_vec, output);
-                output += 2;
-            } else if constexpr (output_format == OutputFormat::RGB565) {
-                Common::Color::EncodeRGB565(col_vec, output);
-                output += 2;
-            } else {
-                UNREACHABLE_MSG("Unknown Y2R output format {}", output_format);
-            }
-
-            amount_of_data -= 1;
-        }
-
-        output += buf.gap;
+        // The final unit may ask for more pixels than are left in the input
+        const u32 num_pixels = std::min(unit_pixels, static_cast<u32>(amount_of_data));
+        EncodePixels(output_format, input, output, num_pixels, alpha);
+        memory.MarkRegionDirty(output, num_pixels * bytes_per_pixel);
+        input += num_pixels;
+        amount_of_data -= num_pixels;
+
+        output += unit_pixels * bytes_per_pixel + buf.gap;
         buf.address += buf.transfer_unit + buf.gap;
         buf.image_size -= buf.transfer_unit;
     }
 }
 
-static const u8 linear_lut[TILE_SIZE] = {
-    // clang-format off
-     0,  1,  2,  3,  4,  5,  6,  7,
-     8,  9, 10, 11, 12, 13, 14, 15,
-    16, 17, 18, 19, 20, 21, 22, 23,
-    24, 25, 26, 27, 28, 29, 30, 31,
-    32, 33, 34, 35, 36, 37, 38, 39,
-    40, 41, 42, 43, 44, 45, 46, 47,
-    48, 49, 50, 51, 52, 53, 54, 55,
-    56, 57, 58, 59, 60, 61, 62, 63,
-    // clang-format on
-};
+static void WriteTileToOutput(u32* output, const ImageTile& tile, int height, int line_stride) {
+    for (int y = 0; y < height; ++y) {
+        std::memcpy(output + y * line_stride, &tile[y * 8], 8 * sizeof(u32));
+    }
+}
+
+namespace {
+
+/// An 8-line strip of the image, with the buffers needed to convert it independently of others.
+struct ImageStrip {
+    explicit ImageStrip(u32 width) : data(width * 8 * 4), tiles(width / 8) {}
 
-static const u8 morton_lut[TILE_SIZE] = {
-    // clang-format off
-     0,  1,  4,  5, 16, 17, 20, 21,
-     2,  3,  6,  7, 18, 19, 22, 23,
-     8,  9, 12, 13, 24, 25, 28, 29,
-    10, 11, 14, 15, 26, 27, 30, 31,
-    32, 33, 36, 37, 48, 49, 52, 53,
-    34, 35, 38, 39, 50, 51, 54, 55,
-    40, 41, 44, 45, 56, 57, 60, 61,
-    42, 43, 46, 47, 58, 59, 62, 63,
-    // clang-format on
+    /// Buffer used as a CDMA source/target.
+    std::vector<u8> data;
+    /// Intermediate storage for decoded 8x8 image tiles. Always stored as RGB32.
+    std::vector<ImageTile> tiles;
+    u32 height = 0;
 };
 
-static void RotateTile0(const ImageTile& input, ImageTile& output, int height,
-                        const u8 out_map[64]) {
-    for (int i = 0; i < height * 8; ++i) {
-        output[out_map[i]] = input[i];
+/**
+ * Returns the host memory range a CDMA transfer of the given amount of data would touch, or an
+ * empty span if it can't be determined.
+ * @param unit_amount The amount of data moved by each transfer unit
+ * @param unit_size The number of bytes each transfer unit spans, not including the gap
+ */
+std::span<u8> GetTransferRange(Memory::MemorySystem& memory, const ConversionBuffer& buf,
+                               std::size_t amount_of_data, std::size_t unit_amount,
+                               std::size_t unit_size) {
+    u8* const start = memory.GetPointer(buf.address);
+    if (!start || unit_amount == 0) {
+        return {};
     }
+    const std::size_t num_units = (amount_of_data + unit_amount - 1) / unit_amount;
+    return {start, num_units * (unit_size + buf.gap)};
 }
 
-static void RotateTile90(const ImageTile& input, ImageTile& output, int height,
-                         const u8 out_map[64]) {
-    int out_i = 0;
-    for (int x = 0; x < 8; ++x) {
-        for (int y = height - 1; y >= 0; --y) {
-            output[out_map[out_i++]] = input[y * 8 + x];
-        }
-    }
+bool RangesOverlap(std::span<u8> a, std::span<u8> b) {
+    return a.data() < b.data() + b.size() && b.data() < a.data() + a.size();
 }
 
-static void RotateTile180(const ImageTile& input, ImageTile& output, int height,
-                          const u8 out_map[64]) {
-    int out_i = 0;
-    for (int i = height * 8 - 1; i >= 0; --i) {
-        output[out_map[out_i++]] = input[i];
+/**
+ * Checks whether the strips of the conversion can be received and sent in any order, which is the
+ * case when no input is read from memory that is written with the output.
+ */
+bool CanReorderStrips(Memory::MemorySystem& memory, const ConversionConfiguration& cvt) {
+    const std::size_t num_pixels = std::size_t{cvt.input_line_width} * cvt.input_lines;
+    const u32 bytes_per_pixel = OutputBytesPerPixel(cvt.output_format);
+    const std::size_t unit_pixels =
+        (cvt.dst.transfer_unit + bytes_per_pixel - 1) / bytes_per_pixel;
+    // Each strip is sent separately, so the unit count is rounded up for every strip
+    const std::size_t num_strips = (cvt.input_lines + 7) / 8;
+    const std::size_t dst_amount = num_pixels + num_strips * unit_pixels;
+    const std::size_t unit_size =
+        std::max<std::size_t>(cvt.dst.transfer_unit, unit_pixels * bytes_per_pixel);
+    const std::span<u8> dst = GetTransferRange(memory, cvt.dst, dst_amount, unit_pixels, unit_size);
+    if (dst.empty()) {
+        return false;
+    }
+
+    const auto check = [&](const ConversionBuffer& buf, std::size_t amount, std::size_t n) {
+        const std::span<u8> src =
+            GetTransferRange(memory, buf, amount, buf.transfer_unit / n, buf.transfer_unit);
+        return !src.empty() && !RangesOverlap(src, dst);
+    };
+    switch (cvt.input_format) {
+    case InputFormat::YUV422_Indiv8:
+        return check(cvt.src_Y, num_pixels, 1) && check(cvt.src_U, num_pixels / 2, 1) &&
+               check(cvt.src_V, num_pixels / 2, 1);
+    case InputFormat::YUV420_Indiv8:
+        return check(cvt.src_Y, num_pixels, 1) && check(cvt.src_U, num_pixels / 4, 1) &&
+               check(cvt.src_V, num_pixels / 4, 1);
+    case InputFormat::YUV422_Indiv16:
+        return check(cvt.src_Y, num_pixels, 2) && check(cvt.src_U, num_pixels / 2, 2) &&
+               check(cvt.src_V, num_pixels / 2, 2);
+    case InputFormat::YUV420_Indiv16:
+        return check(cvt.src_Y, num_pixels, 2) && check(cvt.src_U, num_pixels / 4, 2) &&
+               check(cvt.src_V, num_pixels / 4, 2);
+    case InputFormat::YUYV422_Interleaved:
+        return check(cvt.src_YUYV, num_pixels * 2, 1);
+    default:
+        return false;
     }
 }
 
-static void RotateTile270(const ImageTile& input, ImageTile& output, int height,
-                          const u8 out_map[64]) {
-    int out_i = 0;
-    for (int x = 8 - 1; x >= 0; --x) {
-        for (int y = 0; y < height; ++y) {
-            output[out_map[out_i++]] = input[y * 8 + x];
-        }
+/// Reads the input of the next strip of the conversion from memory.
+void ReceiveStrip(Memory::MemorySystem& memory, ConversionConfiguration& cvt, ImageStrip& strip) {
+    // Total size in pixels of incoming data required for this strip.
+    const std::size_t row_data_size = strip.height * cvt.input_line_width;
+
+    u8* input_Y = strip.data.data();
+    u8* input_U = input_Y + 8 * cvt.input_line_width;
+    u8* input_V = input_U + 8 * cvt.input_line_width / 2;
+
+    switch (cvt.input_format) {
+    case InputFormat::YUV422_Indiv8:
+        ReceiveData<1>(memory, input_Y, cvt.src_Y, row_data_size);
+        ReceiveData<1>(memory, input_U, cvt.src_U, row_data_size / 2);
+        ReceiveData<1>(memory, input_V, cvt.src_V, row_data_size / 2);
+        break;
+    case InputFormat::YUV420_Indiv8:
+        ReceiveData<1>(memory, input_Y, cvt.src_Y, row_data_size);
+        ReceiveData<1>(memory, input_U, cvt.src_U, row_data_size / 4);
+        ReceiveData<1>(memory, input_V, cvt.src_V, row_data_size / 4);
+        break;
+    case InputFormat::YUV422_Indiv16:
+        ReceiveData<2>(memory, input_Y, cvt.src_Y, row_data_size);
+        ReceiveData<2>(memory, input_U, cvt.src_U, row_data_size / 2);
+        ReceiveData<2>(memory, input_V, cvt.src_V, row_data_size / 2);
+        break;
+    case InputFormat::YUV420_Indiv16:
+        ReceiveData<2>(memory, input_Y, cvt.src_Y, row_data_size);
+        ReceiveData<2>(memory, input_U, cvt.src_U, row_data_size / 4);
+        ReceiveData<2>(memory, input_V, cvt.src_V, row_data_size / 4);
+        break;
+    case InputFormat::YUYV422_Interleaved:
+        ReceiveData<1>(memory, input_Y, cvt.src_YUYV, row_data_size * 2);
+        break;
+    default:
+        UNREACHABLE_MSG("Unknown Y2R input format {}", cvt.input_format);
     }
 }
 
-static void WriteTileToOutput(u32* output, const ImageTile& tile, int height, int line_stride) {
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < 8; ++x) {
-            output[y * line_stride + x] = tile[y * 8 + x];
+/// Converts the received input of a strip to rotated RGB32 pixels, in place.
+void ConvertStrip(const ConversionConfiguration& cvt, ImageStrip& strip) {
+    const u32 width = cvt.input_line_width;
+    const std::size_t num_tiles = strip.tiles.size();
+    const int row_height = static_cast<int>(strip.height);
+
+    const u8* input_Y = strip.data.data();
+    const u8* input_U = input_Y + 8 * width;
+    const u8* input_V = input_U + 8 * width / 2;
+    if (cvt.input_format == InputFormat::YUYV422_Interleaved) {
+        input_U = nullptr;
+        input_V = nullptr;
+    }
+    ConvertYUVToRGB(cvt.input_format, input_Y, input_U, input_V, strip.tiles.data(), width,
+                    strip.height, cvt.coefficients);
+
+    u32* output_buffer = reinterpret_cast<u32*>(strip.data.data());
+    ImageTile tmp_tile;
+
+    for (std::size_t i = 0; i < num_tiles; ++i) {
+        int image_strip_width = 0;
+        int output_stride = 0;
+
+        switch (cvt.rotation) {
+        case Rotation::None:
+            RotateTile(cvt.rotation, cvt.block_alignment, strip.tiles[i], tmp_tile, strip.height);
+            image_strip_width = width;
+            output_stride = 8;
+            break;
+        case Rotation::Clockwise_90:
+            RotateTile(cvt.rotation, cvt.block_alignment, strip.tiles[i], tmp_tile, strip.height);
+            image_strip_width = 8;
+            output_stride = 8 * row_height;
+            break;
+        case Rotation::Clockwise_180:
+        case Rotation::Clockwise_270:
+            // For 180 and 270 degree rotations we also invert the order of tiles in the strip,
+            // since the rotates are done individually on each tile.
+            RotateTile(cvt.rotation, cvt.block_alignment, strip.tiles[num_tiles - i - 1],
+                       tmp_tile, strip.height);
+            image_strip_width = cvt.rotation == Rotation::Clockwise_180 ? width : 8;
+            output_stride = cvt.rotation == Rotation::Clockwise_180 ? 8 : 8 * row_height;
+            break;
+        }
+
+        switch (cvt.block_alignment) {
+        case BlockAlignment::Linear:
+            WriteTileToOutput(output_buffer, tmp_tile, row_height, image_strip_width);
+            output_buffer += output_stride;
+            break;
+        case BlockAlignment::Block8x8:
+            WriteTileToOutput(output_buffer, tmp_tile, 8, 8);
+            output_buffer += TILE_SIZE;
+            break;
         }
     }
 }
 
+} // Anonymous namespace
+
 MICROPROFILE_DEFINE(Y2R_PerformConversion, "Y2R", "PerformConversion", MP_RGB(185, 66, 245));
 
 /**
@@ -270,147 +323,62 @@ void PerformConversion(Memory::MemorySystem& memory, ConversionConfiguration cvt
     std::size_t num_tiles = cvt.input_line_width / 8;
     ASSERT(num_tiles <= MAX_TILES);
 
-    // Buffer used as a CDMA source/target.
-    std::unique_ptr<u8[]> data_buffer(new u8[cvt.input_line_width * 8 * 4]);
-    // Intermediate storage for decoded 8x8 image tiles. Always stored as RGB32.
-    std::unique_ptr<ImageTile[]> tiles(new ImageTile[num_tiles]);
-    ImageTile tmp_tile;
-
-    // LUT used to remap writes to a tile. Used to allow linear or swizzled output without
-    // requiring two different code paths.
-    const u8* tile_remap = nullptr;
-    switch (cvt.block_alignment) {
-    case BlockAlignment::Linear:
-        tile_remap = linear_lut;
+    switch (cvt.input_format) {
+    case InputFormat::YUV422_Indiv8:
+    case InputFormat::YUV420_Indiv8:
+    case InputFormat::YUV422_Indiv16:
+    case InputFormat::YUV420_Indiv16:
+    case InputFormat::YUYV422_Interleaved:
         break;
-    case BlockAlignment::Block8x8:
-        tile_remap = morton_lut;
+    default:
+        UNREACHABLE_MSG("Unknown Y2R input format {}", cvt.input_format);
+        return;
+    }
+    switch (cvt.output_format) {
+    case OutputFormat::RGBA8:
+    case OutputFormat::RGB8:
+    case OutputFormat::RGB5A1:
+    case OutputFormat::RGB565:
         break;
+    default:
+        UNREACHABLE_MSG("Unknown Y2R output format {}", cvt.output_format);
+        return;
     }
 
-    for (unsigned int y = 0; y < cvt.input_lines; y += 8) {
-        unsigned int row_height = std::min(cvt.input_lines - y, 8u);
-
-        // Total size in pixels of incoming data required for this strip.
-        const std::size_t row_data_size = row_height * cvt.input_line_width;
+    // Strips are converted independently of each other, so when the input isn't overwritten by
+    // the output several can be received up front and converted in parallel before being sent.
+    const std::size_t num_strips = (cvt.input_lines + 7) / 8;
+    Common::ThreadWorker* workers = Common::GetSharedThreadWorker();
+    std::size_t strips_per_batch = 1;
+    if (workers && num_strips > 1 &&
+        std::size_t{cvt.input_line_width} * cvt.input_lines >= PARALLEL_CONVERSION_MIN_PIXELS &&
+        CanReorderStrips(memory, cvt)) {
+        strips_per_batch = std::min(num_strips, workers->NumWorkers() * 2);
+    }
 
-        u8* input_Y = data_buffer.get();
-        u8* input_U = input_Y + 8 * cvt.input_line_width;
-        u8* input_V = input_U + 8 * cvt.input_line_width / 2;
+    std::vector<ImageStrip> strips(strips_per_batch, ImageStrip{cvt.input_line_width});
+    for (unsigned int y = 0; y < cvt.input_lines; y += 8 * strips_per_batch) {
+        const std::size_t batch_size =
+            std::min(strips_per_batch, (cvt.input_lines - y + 7) / std::size_t{8});
 
-        switch (cvt.input_format) {
-        case InputFormat::YUV422_Indiv8:
-            ReceiveData<1>(memory, input_Y, cvt.src_Y, row_data_size);
-            ReceiveData<1>(memory, input_U, cvt.src_U, row_data_size / 2);
-            ReceiveData<1>(memory, input_V, cvt.src_V, row_data_size / 2);
-            ConvertYUVToRGB<InputFormat::YUV422_Indiv8>(input_Y, input_U, input_V, tiles.get(),
-                                                        cvt.input_line_width, row_height,
-                                                        cvt.coefficients);
-            break;
-        case InputFormat::YUV420_Indiv8:
-            ReceiveData<1>(memory, input_Y, cvt.src_Y, row_data_size);
-            ReceiveData<1>(memory, input_U, cvt.src_U, row_data_size / 4);
-            ReceiveData<1>(memory, input_V, cvt.src_V, row_data_size / 4);
-            ConvertYUVToRGB<InputFormat::YUV420_Indiv8>(input_Y, input_U, input_V, tiles.get(),
-                                                        cvt.input_line_width, row_height,
-                                                        cvt.coefficients);
-            break;
-        case InputFormat::YUV422_Indiv16:
-            ReceiveData<2>(memory, input_Y, cvt.src_Y, row_data_size);
-            ReceiveData<2>(memory, input_U, cvt.src_U, row_data_size / 2);
-            ReceiveData<2>(memory, input_V, cvt.src_V, row_data_size / 2);
-            ConvertYUVToRGB<InputFormat::YUV422_Indiv16>(input_Y, input_U, input_V, tiles.get(),
-                                                         cvt.input_line_width, row_height,
-                                                         cvt.coefficients);
-            break;
-        case InputFormat::YUV420_Indiv16:
-            ReceiveData<2>(memory, input_Y, cvt.src_Y, row_data_size);
-            ReceiveData<2>(memory, input_U, cvt.src_U, row_data_size / 4);
-            ReceiveData<2>(memory, input_V, cvt.src_V, row_data_size / 4);
-            ConvertYUVToRGB<InputFormat::YUV420_Indiv16>(input_Y, input_U, input_V, tiles.get(),
-                                                         cvt.input_line_width, row_height,
-                                                         cvt.coefficients);
-            break;
-        case InputFormat::YUYV422_Interleaved:
-            input_U = nullptr;
-            input_V = nullptr;
-            ReceiveData<1>(memory, input_Y, cvt.src_YUYV, row_data_size * 2);
-            ConvertYUVToRGB<InputFormat::YUYV422_Interleaved>(input_Y, input_U, input_V,
-                                                              tiles.get(), cvt.input_line_width,
-                                                              row_height, cvt.coefficients);
-            break;
-        default:
-            UNREACHABLE_MSG("Unknown Y2R input format {}", cvt.input_format);
-            return;
+        for (std::size_t i = 0; i < batch_size; ++i) {
+            strips[i].height = std::min(cvt.input_lines - y - 8 * static_cast<u32>(i), 8u);
+            ReceiveStrip(memory, cvt, strips[i]);
         }
 
-        u32* output_buffer = reinterpret_cast<u32*>(data_buffer.get());
-
-        for (std::size_t i = 0; i < num_tiles; ++i) {
-            int image_strip_width = 0;
-            int output_stride = 0;
-
-            switch (cvt.rotation) {
-            case Rotation::None:
-                RotateTile0(tiles[i], tmp_tile, row_height, tile_remap);
-                image_strip_width = cvt.input_line_width;
-                output_stride = 8;
-                break;
-            case Rotation::Clockwise_90:
-                RotateTile90(tiles[i], tmp_tile, row_height, tile_remap);
-                image_strip_width = 8;
-                output_stride = 8 * row_height;
-                break;
-            case Rotation::Clockwise_180:
-                // For 180 and 270 degree rotations we also invert the order of tiles in the strip,
-                // since the rotates are done individually on each tile.
-                RotateTile180(tiles[num_tiles - i - 1], tmp_tile, row_height, tile_remap);
-                image_strip_width = cvt.input_line_width;
-                output_stride = 8;
-                break;
-            case Rotation::Clockwise_270:
-                RotateTile270(tiles[num_tiles - i - 1], tmp_tile, row_height, tile_remap);
-                image_strip_width = 8;
-                output_stride = 8 * row_height;
-                break;
-            }
-
-            switch (cvt.block_alignment) {
-            case BlockAlignment::Linear:
-                WriteTileToOutput(output_buffer, tmp_tile, row_height, image_strip_width);
-                output_buffer += output_stride;
-                break;
-            case BlockAlignment::Block8x8:
-                WriteTileToOutput(output_buffer, tmp_tile, 8, 8);
-                output_buffer += TILE_SIZE;
-                break;
+        if (batch_size > 1) {
+            for (std::size_t i = 0; i < batch_size; ++i) {
+                workers->QueueWork([&cvt, &strip = strips[i]] { ConvertStrip(cvt, strip); });
             }
+            workers->WaitForRequests();
+        } else {
+            ConvertStrip(cvt, strips[0]);
         }
 
-        switch (cvt.output_format) {
-        case OutputFormat::RGBA8:
-            SendData<OutputFormat::RGBA8>(memory, reinterpret_cast<u32*>(data_buffer.get()),
-                                          cvt.dst, static_cast<int>(row_data_size),
-                                          static_cast<u8>(cvt.alpha));
-            break;
-        case OutputFormat::RGB8:
-            SendData<OutputFormat::RGB8>(memory, reinterpret_cast<u32*>(data_buffer.get()), cvt.dst,
-                                         static_cast<int>(row_data_size),
-                                         static_cast<u8>(cvt.alpha));
-            break;
-        case OutputFormat::RGB5A1:
-            SendData<OutputFormat::RGB5A1>(memory, reinterpret_cast<u32*>(data_buffer.get()),
-                                           cvt.dst, static_cast<int>(row_data_size),
-                                           static_cast<u8>(cvt.alpha));
-            break;
-        case OutputFormat::RGB565:
-            SendData<OutputFormat::RGB565>(memory, reinterpret_cast<u32*>(data_buffer.get()),
-                                           cvt.dst, static_cast<int>(row_data_size),
-                                           static_cast<u8>(cvt.alpha));
-            break;
-        default:
-            UNREACHABLE_MSG("Unknown Y2R output format {}", cvt.output_format);
-            return;
+        for (std::size_t i = 0; i < batch_size; ++i) {
+            const std::size_t row_data_size = strips[i].height * cvt.input_line_width;
+            SendData(memory, cvt.output_format, reinterpret_cast<u32*>(strips[i].data.data()),
+                     cvt.dst, static_cast<int>(row_data_size), static_cast<u8>(cvt.alpha));
         }
     }
 }
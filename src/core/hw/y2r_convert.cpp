@@ -0,0 +1,661 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include "common/arch.h"
+#include "common/assert.h"
+#include "common/color.h"
+#include "common/vector_math.h"
+#include "core/hw/y2r_convert.h"
+
+#if CITRA_ARCH(x86_64)
+#include <emmintrin.h>
+#elif CITRA_ARCH(arm64)
+#include <arm_neon.h>
+#endif
+
+namespace HW::Y2R {
+
+using namespace Service::Y2R;
+
+namespace {
+
+template <InputFormat input_format>
+void ConvertYUVToRGBScalarImpl(const u8* input_Y, const u8* input_U, const u8* input_V,
+                               ImageTile output[], unsigned int width, unsigned int height,
+                               const CoefficientSet& coefficients) {
+
+    for (unsigned int y = 0; y < height; ++y) {
+        for (unsigned int x = 0; x < width; ++x) {
+            s32 Y;
+            s32 U;
+            s32 V;
+            if constexpr (input_format == InputFormat::YUV422_Indiv8 ||
+                          input_format == InputFormat::YUV422_Indiv16) {
+                Y = input_Y[y * width + x];
+                U = input_U[(y * width + x) / 2];
+                V = input_V[(y * width + x) / 2];
+            } else if constexpr (input_format == InputFormat::YUV420_Indiv8 ||
+                                 input_format == InputFormat::YUV420_Indiv16) {
+                Y = input_Y[y * width + x];
+                U = input_U[((y / 2) * width + x) / 2];
+                V = input_V[((y / 2) * width + x) / 2];
+            } else if constexpr (input_format == InputFormat::YUYV422_Interleaved) {
+                Y = input_Y[(y * width + x) * 2];
+                U = input_Y[(y * width + (x / 2) * 2) * 2 + 1];
+                V = input_Y[(y * width + (x / 2) * 2) * 2 + 3];
+            } else {
+                UNREACHABLE_MSG("Unknown Y2R input format {}", input_format);
+                return;
+            }
+
+            // This conversion process is bit-exact with hardware, as far as could be tested.
+            auto& c = coefficients;
+            s32 cY = c[0] * Y;
+
+            s32 r = cY + c[1] * V;
+            s32 g = cY - c[2] * V - c[3] * U;
+            s32 b = cY + c[4] * U;
+
+            const s32 rounding_offset = 0x18;
+            r = (r >> 3) + c[5] + rounding_offset;
+            g = (g >> 3) + c[6] + rounding_offset;
+            b = (b >> 3) + c[7] + rounding_offset;
+
+            unsigned int tile = x / 8;
+            unsigned int tile_x = x % 8;
+            u32* out = &output[tile][y * 8 + tile_x];
+            *out = ((u32)std::clamp(r >> 5, 0, 0xFF) << 24) |
+                   ((u32)std::clamp(g >> 5, 0, 0xFF) << 16) |
+                   ((u32)std::clamp(b >> 5, 0, 0xFF) << 8);
+        }
+    }
+}
+
+#if CITRA_ARCH(x86_64)
+
+/**
+ * Converts the eight pixels of a tile row. The products of the s16 coefficients and the 8-bit
+ * components are summed in 32 bits by pmaddwd, so the results match the scalar conversion exactly.
+ */
+class RowConverter {
+public:
+    explicit RowConverter(const CoefficientSet& c)
+        : coeff_y(Pair(c[0], 0)), coeff_r(Pair(0, c[1])), coeff_g(Pair(c[3], c[2])),
+          coeff_b(Pair(c[4], 0)), offset_r(_mm_set1_epi32(c[5] + ROUNDING_OFFSET)),
+          offset_g(_mm_set1_epi32(c[6] + ROUNDING_OFFSET)),
+          offset_b(_mm_set1_epi32(c[7] + ROUNDING_OFFSET)) {}
+
+    /**
+     * @param luma The Y component of each pixel in 16-bit lanes
+     * @param chroma The U and V components shared by each pixel pair, interleaved in 16-bit lanes
+     */
+    void Convert(__m128i luma, __m128i chroma, u32* output) const {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i y_lo = _mm_madd_epi16(_mm_unpacklo_epi16(luma, zero), coeff_y);
+        const __m128i y_hi = _mm_madd_epi16(_mm_unpackhi_epi16(luma, zero), coeff_y);
+        const __m128i r = _mm_madd_epi16(chroma, coeff_r);
+        const __m128i g = _mm_madd_epi16(chroma, coeff_g);
+        const __m128i b = _mm_madd_epi16(chroma, coeff_b);
+
+        // Each chroma result is shared by two adjacent pixels
+        const __m128i r16 = Finish(_mm_add_epi32(y_lo, _mm_unpacklo_epi32(r, r)),
+                                   _mm_add_epi32(y_hi, _mm_unpackhi_epi32(r, r)), offset_r);
+        const __m128i g16 = Finish(_mm_sub_epi32(y_lo, _mm_unpacklo_epi32(g, g)),
+                                   _mm_sub_epi32(y_hi, _mm_unpackhi_epi32(g, g)), offset_g);
+        const __m128i b16 = Finish(_mm_add_epi32(y_lo, _mm_unpacklo_epi32(b, b)),
+                                   _mm_add_epi32(y_hi, _mm_unpackhi_epi32(b, b)), offset_b);
+
+        const __m128i low = _mm_slli_epi16(b16, 8);
+        const __m128i high = _mm_or_si128(_mm_slli_epi16(r16, 8), g16);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output), _mm_unpacklo_epi16(low, high));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + 4), _mm_unpackhi_epi16(low, high));
+    }
+
+    /// Widens 8 bytes to 16-bit lanes
+    static __m128i Load8(const u8* source) {
+        return _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(source)),
+                                 _mm_setzero_si128());
+    }
+
+    /// Interleaves 4 U and 4 V components in 16-bit lanes
+    static __m128i LoadChroma(const u8* input_U, const u8* input_V) {
+        u32 u;
+        u32 v;
+        std::memcpy(&u, input_U, sizeof(u));
+        std::memcpy(&v, input_V, sizeof(v));
+        const __m128i uv = _mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<s32>(u)),
+                                             _mm_cvtsi32_si128(static_cast<s32>(v)));
+        return _mm_unpacklo_epi8(uv, _mm_setzero_si128());
+    }
+
+private:
+    static constexpr s32 ROUNDING_OFFSET = 0x18;
+
+    static __m128i Pair(s16 low, s16 high) {
+        return _mm_set1_epi32(static_cast<s32>(static_cast<u16>(low) |
+                                               (static_cast<u32>(static_cast<u16>(high)) << 16)));
+    }
+
+    /// Applies the final shifts and offset, and clamps the results to 0-255 in 16-bit lanes
+    static __m128i Finish(__m128i lo, __m128i hi, __m128i offset) {
+        lo = _mm_srai_epi32(_mm_add_epi32(_mm_srai_epi32(lo, 3), offset), 5);
+        hi = _mm_srai_epi32(_mm_add_epi32(_mm_srai_epi32(hi, 3), offset), 5);
+        const __m128i packed = _mm_packs_epi32(lo, hi);
+        return _mm_min_epi16(_mm_max_epi16(packed, _mm_setzero_si128()), _mm_set1_epi16(0xFF));
+    }
+
+    __m128i coeff_y;
+    __m128i coeff_r;
+    __m128i coeff_g;
+    __m128i coeff_b;
+    __m128i offset_r;
+    __m128i offset_g;
+    __m128i offset_b;
+};
+
+template <InputFormat input_format>
+void ConvertYUVToRGBSimd(const u8* input_Y, const u8* input_U, const u8* input_V,
+                         ImageTile output[], u32 width, u32 height,
+                         const CoefficientSet& coefficients) {
+    const RowConverter converter{coefficients};
+    for (u32 y = 0; y < height; ++y) {
+        for (u32 x = 0; x < width; x += 8) {
+            __m128i luma;
+            __m128i chroma;
+            if constexpr (input_format == InputFormat::YUV422_Indiv8 ||
+                          input_format == InputFormat::YUV422_Indiv16) {
+                luma = RowConverter::Load8(input_Y + y * width + x);
+                chroma = RowConverter::LoadChroma(input_U + (y * width + x) / 2,
+                                                  input_V + (y * width + x) / 2);
+            } else if constexpr (input_format == InputFormat::YUV420_Indiv8 ||
+                                 input_format == InputFormat::YUV420_Indiv16) {
+                luma = RowConverter::Load8(input_Y + y * width + x);
+                chroma = RowConverter::LoadChroma(input_U + ((y / 2) * width + x) / 2,
+                                                  input_V + ((y / 2) * width + x) / 2);
+            } else {
+                // Y0 U0 Y1 V0 Y2 U1 Y3 V1...
+                const __m128i yuyv = _mm_loadu_si128(
+                    reinterpret_cast<const __m128i*>(input_Y + (y * width + x) * 2));
+                luma = _mm_and_si128(yuyv, _mm_set1_epi16(0xFF));
+                chroma = _mm_srli_epi16(yuyv, 8);
+            }
+            converter.Convert(luma, chroma, &output[x / 8][y * 8]);
+        }
+    }
+}
+
+#elif CITRA_ARCH(arm64)
+
+/**
+ * Converts the eight pixels of a tile row. The products of the s16 coefficients and the 8-bit
+ * components are accumulated in 32 bits, so the results match the scalar conversion exactly.
+ */
+class RowConverter {
+public:
+    explicit RowConverter(const CoefficientSet& c) : coefficients(c) {}
+
+    /// @param luma, u, v The components of each pixel
+    void Convert(uint8x8_t luma, uint8x8_t u, uint8x8_t v, u32* output) const {
+        const int16x8_t y16 = vreinterpretq_s16_u16(vmovl_u8(luma));
+        const int16x8_t u16 = vreinterpretq_s16_u16(vmovl_u8(u));
+        const int16x8_t v16 = vreinterpretq_s16_u16(vmovl_u8(v));
+        const auto& c = coefficients;
+
+        const auto convert_half = [&c](int16x4_t y_half, int16x4_t u_half, int16x4_t v_half,
+                                       int32x4_t results[3]) {
+            const int32x4_t cy = vmull_n_s16(y_half, c[0]);
+            results[0] = vmlal_n_s16(cy, v_half, c[1]);
+            results[1] = vmlsl_n_s16(vmlsl_n_s16(cy, v_half, c[2]), u_half, c[3]);
+            results[2] = vmlal_n_s16(cy, u_half, c[4]);
+        };
+        int32x4_t lo[3];
+        int32x4_t hi[3];
+        convert_half(vget_low_s16(y16), vget_low_s16(u16), vget_low_s16(v16), lo);
+        convert_half(vget_high_s16(y16), vget_high_s16(u16), vget_high_s16(v16), hi);
+
+        uint8x8x4_t pixels;
+        pixels.val[0] = vdup_n_u8(0);
+        for (int i = 0; i < 3; ++i) {
+            const int32x4_t offset = vdupq_n_s32(c[5 + i] + ROUNDING_OFFSET);
+            const int32x4_t final_lo = vshrq_n_s32(vaddq_s32(vshrq_n_s32(lo[i], 3), offset), 5);
+            const int32x4_t final_hi = vshrq_n_s32(vaddq_s32(vshrq_n_s32(hi[i], 3), offset), 5);
+            // Saturating narrows clamp to 0-255
+            pixels.val[3 - i] =
+                vqmovun_s16(vcombine_s16(vqmovn_s32(final_lo), vqmovn_s32(final_hi)));
+        }
+        vst4_u8(reinterpret_cast<u8*>(output), pixels);
+    }
+
+    /// Duplicates 4 components for the pixel pairs sharing them
+    static uint8x8_t LoadChroma(const u8* source) {
+        u32 value;
+        std::memcpy(&value, source, sizeof(value));
+        const uint8x8_t components = vreinterpret_u8_u32(vdup_n_u32(value));
+        return vzip1_u8(components, components);
+    }
+
+private:
+    static constexpr s32 ROUNDING_OFFSET = 0x18;
+
+    CoefficientSet coefficients;
+};
+
+template <InputFormat input_format>
+void ConvertYUVToRGBSimd(const u8* input_Y, const u8* input_U, const u8* input_V,
+                         ImageTile output[], u32 width, u32 height,
+                         const CoefficientSet& coefficients) {
+    const RowConverter converter{coefficients};
+    for (u32 y = 0; y < height; ++y) {
+        for (u32 x = 0; x < width; x += 8) {
+            u32* out = &output[x / 8][y * 8];
+            if constexpr (input_format == InputFormat::YUV422_Indiv8 ||
+                          input_format == InputFormat::YUV422_Indiv16) {
+                converter.Convert(vld1_u8(input_Y + y * width + x),
+                                  RowConverter::LoadChroma(input_U + (y * width + x) / 2),
+                                  RowConverter::LoadChroma(input_V + (y * width + x) / 2), out);
+            } else if constexpr (input_format == InputFormat::YUV420_Indiv8 ||
+                                 input_format == InputFormat::YUV420_Indiv16) {
+                const u32 chroma_offset = ((y / 2) * width + x) / 2;
+                converter.Convert(vld1_u8(input_Y + y * width + x),
+                                  RowConverter::LoadChroma(input_U + chroma_offset),
+                                  RowConverter::LoadChroma(input_V + chroma_offset), out);
+            } else {
+                // Y0 U0 Y1 V0 Y2 U1 Y3 V1...
+                const uint8x8x2_t yuyv = vld2_u8(input_Y + (y * width + x) * 2);
+                const uint8x8_t u = vuzp1_u8(yuyv.val[1], yuyv.val[1]);
+                const uint8x8_t v = vuzp2_u8(yuyv.val[1], yuyv.val[1]);
+                converter.Convert(yuyv.val[0], vzip1_u8(u, u), vzip1_u8(v, v), out);
+            }
+        }
+    }
+}
+
+#endif
+
+const u8 linear_lut[TILE_SIZE] = {
+    // clang-format off
+     0,  1,  2,  3,  4,  5,  6,  7,
+     8,  9, 10, 11, 12, 13, 14, 15,
+    16, 17, 18, 19, 20, 21, 22, 23,
+    24, 25, 26, 27, 28, 29, 30, 31,
+    32, 33, 34, 35, 36, 37, 38, 39,
+    40, 41, 42, 43, 44, 45, 46, 47,
+    48, 49, 50, 51, 52, 53, 54, 55,
+    56, 57, 58, 59, 60, 61, 62, 63,
+    // clang-format on
+};
+
+const u8 morton_lut[TILE_SIZE] = {
+    // clang-format off
+     0,  1,  4,  5, 16, 17, 20, 21,
+     2,  3,  6,  7, 18, 19, 22, 23,
+     8,  9, 12, 13, 24, 25, 28, 29,
+    10, 11, 14, 15, 26, 27, 30, 31,
+    32, 33, 36, 37, 48, 49, 52, 53,
+    34, 35, 38, 39, 50, 51, 54, 55,
+    40, 41, 44, 45, 56, 57, 60, 61,
+    42, 43, 46, 47, 58, 59, 62, 63,
+    // clang-format on
+};
+
+void RotateTile0(const ImageTile& input, ImageTile& output, int height, const u8 out_map[64]) {
+    for (int i = 0; i < height * 8; ++i) {
+        output[out_map[i]] = input[i];
+    }
+}
+
+void RotateTile90(const ImageTile& input, ImageTile& output, int height, const u8 out_map[64]) {
+    int out_i = 0;
+    for (int x = 0; x < 8; ++x) {
+        for (int y = height - 1; y >= 0; --y) {
+            output[out_map[out_i++]] = input[y * 8 + x];
+        }
+    }
+}
+
+void RotateTile180(const ImageTile& input, ImageTile& output, int height, const u8 out_map[64]) {
+    int out_i = 0;
+    for (int i = height * 8 - 1; i >= 0; --i) {
+        output[out_map[out_i++]] = input[i];
+    }
+}
+
+void RotateTile270(const ImageTile& input, ImageTile& output, int height, const u8 out_map[64]) {
+    int out_i = 0;
+    for (int x = 8 - 1; x >= 0; --x) {
+        for (int y = 0; y < height; ++y) {
+            output[out_map[out_i++]] = input[y * 8 + x];
+        }
+    }
+}
+
+#if CITRA_ARCH(x86_64) || CITRA_ARCH(arm64)
+
+#if CITRA_ARCH(x86_64)
+using Vec = __m128i;
+
+Vec Load(const u32* source) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(source));
+}
+
+void Store(u32* dest, Vec value) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), value);
+}
+
+Vec Reverse(Vec value) {
+    return _mm_shuffle_epi32(value, _MM_SHUFFLE(0, 1, 2, 3));
+}
+
+void Transpose(Vec& a, Vec& b, Vec& c, Vec& d) {
+    const Vec ab_lo = _mm_unpacklo_epi32(a, b);
+    const Vec ab_hi = _mm_unpackhi_epi32(a, b);
+    const Vec cd_lo = _mm_unpacklo_epi32(c, d);
+    const Vec cd_hi = _mm_unpackhi_epi32(c, d);
+    a = _mm_unpacklo_epi64(ab_lo, cd_lo);
+    b = _mm_unpackhi_epi64(ab_lo, cd_lo);
+    c = _mm_unpacklo_epi64(ab_hi, cd_hi);
+    d = _mm_unpackhi_epi64(ab_hi, cd_hi);
+}
+#elif CITRA_ARCH(arm64)
+using Vec = uint32x4_t;
+
+Vec Load(const u32* source) {
+    return vld1q_u32(source);
+}
+
+void Store(u32* dest, Vec value) {
+    vst1q_u32(dest, value);
+}
+
+Vec Reverse(Vec value) {
+    const Vec swapped = vrev64q_u32(value);
+    return vextq_u32(swapped, swapped, 2);
+}
+
+void Transpose(Vec& a, Vec& b, Vec& c, Vec& d) {
+    const uint64x2_t ab_lo = vreinterpretq_u64_u32(vzip1q_u32(a, b));
+    const uint64x2_t ab_hi = vreinterpretq_u64_u32(vzip2q_u32(a, b));
+    const uint64x2_t cd_lo = vreinterpretq_u64_u32(vzip1q_u32(c, d));
+    const uint64x2_t cd_hi = vreinterpretq_u64_u32(vzip2q_u32(c, d));
+    a = vreinterpretq_u32_u64(vzip1q_u64(ab_lo, cd_lo));
+    b = vreinterpretq_u32_u64(vzip2q_u64(ab_lo, cd_lo));
+    c = vreinterpretq_u32_u64(vzip1q_u64(ab_hi, cd_hi));
+    d = vreinterpretq_u32_u64(vzip2q_u64(ab_hi, cd_hi));
+}
+#endif
+
+/// Rotates a full tile with linear layout, moving 4x4 blocks of pixels at a time
+void RotateTileLinear(Rotation rotation, const ImageTile& input, ImageTile& output) {
+    switch (rotation) {
+    case Rotation::None:
+        output = input;
+        break;
+    case Rotation::Clockwise_180:
+        for (u32 y = 0; y < 8; ++y) {
+            const u32* row = &input[(7 - y) * 8];
+            Store(&output[y * 8], Reverse(Load(row + 4)));
+            Store(&output[y * 8 + 4], Reverse(Load(row)));
+        }
+        break;
+    case Rotation::Clockwise_90:
+    case Rotation::Clockwise_270:
+        for (u32 block_y = 0; block_y < 8; block_y += 4) {
+            for (u32 block_x = 0; block_x < 8; block_x += 4) {
+                const u32* block = &input[block_y * 8 + block_x];
+                Vec columns[4]{Load(block), Load(block + 8), Load(block + 16), Load(block + 24)};
+                Transpose(columns[0], columns[1], columns[2], columns[3]);
+                for (u32 i = 0; i < 4; ++i) {
+                    const u32 x = block_x + i;
+                    // Column x becomes output row x read bottom to top, or row 7 - x top to bottom
+                    if (rotation == Rotation::Clockwise_90) {
+                        Store(&output[x * 8 + 4 - block_y], Reverse(columns[i]));
+                    } else {
+                        Store(&output[(7 - x) * 8 + block_y], columns[i]);
+                    }
+                }
+            }
+        }
+        break;
+    }
+}
+
+#endif
+
+/// Red in the top byte, then green and blue
+u32 ComponentR(u32 color) {
+    return color >> 24;
+}
+u32 ComponentG(u32 color) {
+    return (color >> 16) & 0xFF;
+}
+u32 ComponentB(u32 color) {
+    return (color >> 8) & 0xFF;
+}
+
+} // Anonymous namespace
+
+void ConvertYUVToRGBScalar(InputFormat input_format, const u8* input_Y, const u8* input_U,
+                           const u8* input_V, ImageTile output[], u32 width, u32 height,
+                           const CoefficientSet& coefficients) {
+    switch (input_format) {
+    case InputFormat::YUV422_Indiv8:
+        return ConvertYUVToRGBScalarImpl<InputFormat::YUV422_Indiv8>(
+            input_Y, input_U, input_V, output, width, height, coefficients);
+    case InputFormat::YUV420_Indiv8:
+        return ConvertYUVToRGBScalarImpl<InputFormat::YUV420_Indiv8>(
+            input_Y, input_U, input_V, output, width, height, coefficients);
+    case InputFormat::YUV422_Indiv16:
+        return ConvertYUVToRGBScalarImpl<InputFormat::YUV422_Indiv16>(
+            input_Y, input_U, input_V, output, width, height, coefficients);
+    case InputFormat::YUV420_Indiv16:
+        return ConvertYUVToRGBScalarImpl<InputFormat::YUV420_Indiv16>(
+            input_Y, input_U, input_V, output, width, height, coefficients);
+    case InputFormat::YUYV422_Interleaved:
+        return ConvertYUVToRGBScalarImpl<InputFormat::YUYV422_Interleaved>(
+            input_Y, input_U, input_V, output, width, height, coefficients);
+    default:
+        UNREACHABLE_MSG("Unknown Y2R input format {}", input_format);
+    }
+}
+
+void ConvertYUVToRGB(InputFormat input_format, const u8* input_Y, const u8* input_U,
+                     const u8* input_V, ImageTile output[], u32 width, u32 height,
+                     const CoefficientSet& coefficients) {
+#if CITRA_ARCH(x86_64) || CITRA_ARCH(arm64)
+    if (width % 8 == 0) {
+        switch (input_format) {
+        case InputFormat::YUV422_Indiv8:
+        case InputFormat::YUV422_Indiv16:
+            return ConvertYUVToRGBSimd<InputFormat::YUV422_Indiv8>(
+                input_Y, input_U, input_V, output, width, height, coefficients);
+        case InputFormat::YUV420_Indiv8:
+        case InputFormat::YUV420_Indiv16:
+            return ConvertYUVToRGBSimd<InputFormat::YUV420_Indiv8>(
+                input_Y, input_U, input_V, output, width, height, coefficients);
+        case InputFormat::YUYV422_Interleaved:
+            return ConvertYUVToRGBSimd<InputFormat::YUYV422_Interleaved>(
+                input_Y, input_U, input_V, output, width, height, coefficients);
+        default:
+            break;
+        }
+    }
+#endif
+    ConvertYUVToRGBScalar(input_format, input_Y, input_U, input_V, output, width, height,
+                          coefficients);
+}
+
+void RotateTileScalar(Rotation rotation, BlockAlignment alignment, const ImageTile& input,
+                      ImageTile& output, u32 height) {
+    // LUT used to remap writes to a tile. Used to allow linear or swizzled output without
+    // requiring two different code paths.
+    const u8* tile_remap = alignment == BlockAlignment::Block8x8 ? morton_lut : linear_lut;
+    const int row_height = static_cast<int>(height);
+
+    switch (rotation) {
+    case Rotation::None:
+        RotateTile0(input, output, row_height, tile_remap);
+        break;
+    case Rotation::Clockwise_90:
+        RotateTile90(input, output, row_height, tile_remap);
+        break;
+    case Rotation::Clockwise_180:
+        RotateTile180(input, output, row_height, tile_remap);
+        break;
+    case Rotation::Clockwise_270:
+        RotateTile270(input, output, row_height, tile_remap);
+        break;
+    }
+}
+
+void RotateTile(Rotation rotation, BlockAlignment alignment, const ImageTile& input,
+                ImageTile& output, u32 height) {
+#if CITRA_ARCH(x86_64) || CITRA_ARCH(arm64)
+    if (alignment == BlockAlignment::Linear && height == 8) {
+        RotateTileLinear(rotation, input, output);
+        return;
+    }
+#endif
+    RotateTileScalar(rotation, alignment, input, output, height);
+}
+
+void EncodePixelsScalar(OutputFormat output_format, const u32* input, u8* output,
+                        std::size_t count, u8 alpha) {
+    const u32 bytes_per_pixel = OutputBytesPerPixel(output_format);
+    for (std::size_t i = 0; i < count; ++i) {
+        const u32 color = input[i];
+        const Common::Vec4<u8> col_vec{(u8)(color >> 24), (u8)(color >> 16), (u8)(color >> 8),
+                                       alpha};
+        u8* pixel = output + i * bytes_per_pixel;
+
+        switch (output_format) {
+        case OutputFormat::RGBA8:
+            Common::Color::EncodeRGBA8(col_vec, pixel);
+            break;
+        case OutputFormat::RGB8:
+            Common::Color::EncodeRGB8(col_vec, pixel);
+            break;
+        case OutputFormat::RGB5A1:
+            Common::Color::EncodeRGB5A1(col_vec, pixel);
+            break;
+        case OutputFormat::RGB565:
+            Common::Color::EncodeRGB565(col_vec, pixel);
+            break;
+        default:
+            UNREACHABLE_MSG("Unknown Y2R output format {}", output_format);
+        }
+    }
+}
+
+void EncodePixels(OutputFormat output_format, const u32* input, u8* output, std::size_t count,
+                  u8 alpha) {
+    std::size_t i = 0;
+    switch (output_format) {
+    case OutputFormat::RGBA8: {
+        // The RGB32 layout already matches RGBA8 apart from the alpha in the bottom byte
+#if CITRA_ARCH(x86_64)
+        const __m128i alpha_vec = _mm_set1_epi32(alpha);
+        for (; i + 4 <= count; i += 4) {
+            const __m128i color = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i * 4),
+                             _mm_or_si128(color, alpha_vec));
+        }
+#elif CITRA_ARCH(arm64)
+        const uint32x4_t alpha_vec = vdupq_n_u32(alpha);
+        for (; i + 4 <= count; i += 4) {
+            vst1q_u8(output + i * 4,
+                     vreinterpretq_u8_u32(vorrq_u32(vld1q_u32(input + i), alpha_vec)));
+        }
+#endif
+        break;
+    }
+    case OutputFormat::RGB8:
+#if CITRA_ARCH(arm64)
+        for (; i + 16 <= count; i += 16) {
+            const uint8x16x4_t color = vld4q_u8(reinterpret_cast<const u8*>(input + i));
+            const uint8x16x3_t bgr{{color.val[1], color.val[2], color.val[3]}};
+            vst3q_u8(output + i * 3, bgr);
+        }
+#endif
+        for (; i < count; ++i) {
+            output[i * 3] = static_cast<u8>(ComponentB(input[i]));
+            output[i * 3 + 1] = static_cast<u8>(ComponentG(input[i]));
+            output[i * 3 + 2] = static_cast<u8>(ComponentR(input[i]));
+        }
+        break;
+    case OutputFormat::RGB5A1:
+    case OutputFormat::RGB565: {
+        const bool has_alpha = output_format == OutputFormat::RGB5A1;
+        const u32 alpha_bit = has_alpha ? Common::Color::Convert8To1(alpha) : 0;
+#if CITRA_ARCH(x86_64)
+        const __m128i mask5 = _mm_set1_epi32(0x1F);
+        const __m128i mask6 = _mm_set1_epi32(0x3F);
+        const __m128i alpha_vec = _mm_set1_epi32(static_cast<s32>(alpha_bit));
+        const auto encode = [&](__m128i color) {
+            const __m128i r = _mm_slli_epi32(_mm_srli_epi32(color, 27), 11);
+            __m128i packed;
+            if (has_alpha) {
+                const __m128i g = _mm_and_si128(_mm_srli_epi32(color, 19), mask5);
+                const __m128i b = _mm_and_si128(_mm_srli_epi32(color, 11), mask5);
+                packed = _mm_or_si128(_mm_or_si128(r, _mm_slli_epi32(g, 6)),
+                                      _mm_or_si128(_mm_slli_epi32(b, 1), alpha_vec));
+            } else {
+                const __m128i g = _mm_and_si128(_mm_srli_epi32(color, 18), mask6);
+                const __m128i b = _mm_and_si128(_mm_srli_epi32(color, 11), mask5);
+                packed = _mm_or_si128(_mm_or_si128(r, _mm_slli_epi32(g, 5)), b);
+            }
+            // Sign extend so that the saturating pack keeps all 16 bits
+            return _mm_srai_epi32(_mm_slli_epi32(packed, 16), 16);
+        };
+        for (; i + 8 <= count; i += 8) {
+            const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+            const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i + 4));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i * 2),
+                             _mm_packs_epi32(encode(lo), encode(hi)));
+        }
+#elif CITRA_ARCH(arm64)
+        for (; i + 8 <= count; i += 8) {
+            const uint8x8x4_t color = vld4_u8(reinterpret_cast<const u8*>(input + i));
+            const uint16x8_t r = vshlq_n_u16(vmovl_u8(vshr_n_u8(color.val[3], 3)), 11);
+            const uint16x8_t b5 = vmovl_u8(vshr_n_u8(color.val[1], 3));
+            uint16x8_t packed;
+            if (has_alpha) {
+                const uint16x8_t g = vshlq_n_u16(vmovl_u8(vshr_n_u8(color.val[2], 3)), 6);
+                packed = vorrq_u16(vorrq_u16(r, g), vorrq_u16(vshlq_n_u16(b5, 1),
+                                                              vdupq_n_u16(alpha_bit)));
+            } else {
+                const uint16x8_t g = vshlq_n_u16(vmovl_u8(vshr_n_u8(color.val[2], 2)), 5);
+                packed = vorrq_u16(vorrq_u16(r, g), b5);
+            }
+            vst1q_u8(output + i * 2, vreinterpretq_u8_u16(packed));
+        }
+#endif
+        break;
+    }
+    default:
+        UNREACHABLE_MSG("Unknown Y2R output format {}", output_format);
+        return;
+    }
+
+    const u32 bytes_per_pixel = OutputBytesPerPixel(output_format);
+    EncodePixelsScalar(output_format, input + i, output + i * bytes_per_pixel, count - i, alpha);
+}
+
+u32 OutputBytesPerPixel(OutputFormat output_format) {
+    switch (output_format) {
+    case OutputFormat::RGBA8:
+        return 4;
+    case OutputFormat::RGB8:
+        return 3;
+    case OutputFormat::RGB5A1:
+    case OutputFormat::RGB565:
+        return 2;
+    default:
+        UNREACHABLE_MSG("Unknown Y2R output format {}", output_format);
+        return 0;
+    }
+}
+
+} // namespace HW::Y2R
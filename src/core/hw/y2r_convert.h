@@ -0,0 +1,57 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include "common/common_types.h"
+#include "core/hle/service/y2r_u.h"
+
+namespace HW::Y2R {
+
+constexpr std::size_t TILE_SIZE = 8 * 8;
+
+/// An 8x8 tile of RGB32 pixels, with red in the top byte and the bottom byte left zero
+using ImageTile = std::array<u32, TILE_SIZE>;
+
+/**
+ * Converts an image strip of up to 8 lines from the source YUV format into individual 8x8 RGB32
+ * tiles one pixel at a time. This is the reference ConvertYUVToRGB is tested against.
+ */
+void ConvertYUVToRGBScalar(Service::Y2R::InputFormat input_format, const u8* input_Y,
+                           const u8* input_U, const u8* input_V, ImageTile output[], u32 width,
+                           u32 height, const Service::Y2R::CoefficientSet& coefficients);
+
+/// Converts an image strip like ConvertYUVToRGBScalar, eight pixels at a time where possible
+void ConvertYUVToRGB(Service::Y2R::InputFormat input_format, const u8* input_Y, const u8* input_U,
+                     const u8* input_V, ImageTile output[], u32 width, u32 height,
+                     const Service::Y2R::CoefficientSet& coefficients);
+
+/**
+ * Rotates the first height lines of a tile and lays the result out for the block alignment, one
+ * pixel at a time. This is the reference RotateTile is tested against.
+ */
+void RotateTileScalar(Service::Y2R::Rotation rotation, Service::Y2R::BlockAlignment alignment,
+                      const ImageTile& input, ImageTile& output, u32 height);
+
+/// Rotates a tile like RotateTileScalar, a row at a time for full tiles with linear alignment
+void RotateTile(Service::Y2R::Rotation rotation, Service::Y2R::BlockAlignment alignment,
+                const ImageTile& input, ImageTile& output, u32 height);
+
+/**
+ * Encodes RGB32 pixels in the output format with the given alpha, one pixel at a time. This is the
+ * reference EncodePixels is tested against.
+ */
+void EncodePixelsScalar(Service::Y2R::OutputFormat output_format, const u32* input, u8* output,
+                        std::size_t count, u8 alpha);
+
+/// Encodes RGB32 pixels like EncodePixelsScalar, several at a time where possible
+void EncodePixels(Service::Y2R::OutputFormat output_format, const u32* input, u8* output,
+                  std::size_t count, u8 alpha);
+
+/// Returns the size of a pixel in the output format, in bytes
+u32 OutputBytesPerPixel(Service::Y2R::OutputFormat output_format);
+
+} // namespace HW::Y2R
@@ -2,8 +2,14 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <cstring>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <unordered_map>
 #include <boost/serialization/array.hpp>
 #include <boost/serialization/binary_object.hpp>
 #include "audio_core/dsp_interface.h"
@@ -11,9 +17,11 @@
 #include "common/assert.h"
 #include "common/atomic_ops.h"
 #include "common/common_types.h"
+#include "common/hash.h"
 #include "common/logging/log.h"
 #include "common/settings.h"
 #include "common/swap.h"
+#include "common/thread_worker.h"
 #include "core/arm/arm_interface.h"
 #include "core/core.h"
 #include "core/global.h"
@@ -21,6 +29,7 @@
 #include "core/hle/kernel/process.h"
 #include "core/hle/lock.h"
 #include "core/hle/service/plgldr/plgldr.h"
+#include "core/hw/gpu.h"
 #include "core/hw/hw.h"
 #include "core/memory.h"
 #include "video_core/renderer_base.h"
@@ -33,10 +42,58 @@ SERIALIZE_EXPORT_IMPL(Memory::MemorySystem::BackingMemImpl<Memory::Region::N3DS>
 
 namespace Memory {
 
+/// Size of the fastmem window of a page table, covering the whole 32-bit address space
+constexpr u64 FASTMEM_WINDOW_SIZE = 1ULL << 32;
+
+namespace {
+
+/// Returns the PC of the running core for log messages, or 0 if no core is running
+u32 GetRunningCorePC() {
+    Core::System& system = Core::System::GetInstance();
+    return system.HasRunningCore() ? system.GetRunningCore().GetPC() : 0;
+}
+
+/// Contents of a page of memory that was never written to
+constexpr std::array<u8, CITRA_PAGE_SIZE> ZERO_PAGE{};
+
+} // Anonymous namespace
+
+std::vector<u64> HashPages(const std::vector<u8*>& pages) {
+    std::vector<u64> hashes(pages.size());
+    const auto hash_range = [&pages, &hashes](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            hashes[i] = Common::ComputeHash64(pages[i], CITRA_PAGE_SIZE);
+        }
+    };
+
+    Common::ThreadWorker* workers = Common::GetSharedThreadWorker();
+    if (!workers) {
+        hash_range(0, pages.size());
+        return hashes;
+    }
+
+    const std::size_t pages_per_task =
+        (pages.size() + workers->NumWorkers() - 1) / workers->NumWorkers();
+    for (std::size_t begin = 0; begin < pages.size(); begin += pages_per_task) {
+        const std::size_t end = std::min(begin + pages_per_task, pages.size());
+        workers->QueueWork([&hash_range, begin, end] { hash_range(begin, end); });
+    }
+    workers->WaitForRequests();
+    return hashes;
+}
+
+u64 GetZeroPageHash() {
+    static const u64 zero_page_hash = Common::ComputeHash64(ZERO_PAGE.data(), ZERO_PAGE.size());
+    return zero_page_hash;
+}
+
 void PageTable::Clear() {
     pointers.raw.fill(nullptr);
     pointers.refs.fill(MemoryRef());
     attributes.fill(PageType::Unmapped);
+    if (fastmem_window) {
+        fastmem_window->Unmap(0, FASTMEM_WINDOW_SIZE);
+    }
 }
 
 class RasterizerCacheMarker {
@@ -89,14 +146,35 @@ private:
 
 class MemorySystem::Impl {
 public:
-    // Visual Studio would try to allocate these on compile time if they are std::array, which would
-    // exceed the memory limit.
-    std::unique_ptr<u8[]> fcram = std::make_unique<u8[]>(Memory::FCRAM_N3DS_SIZE);
-    std::unique_ptr<u8[]> vram = std::make_unique<u8[]>(Memory::VRAM_SIZE);
-    std::unique_ptr<u8[]> n3ds_extra_ram = std::make_unique<u8[]>(Memory::N3DS_EXTRA_RAM_SIZE);
+    // FCRAM, VRAM and the New 3DS extra memory share a single host allocation, so that it can be
+    // aliased into the fastmem windows of the page tables.
+    Common::HostMemory host_memory{Memory::FCRAM_N3DS_SIZE + Memory::VRAM_SIZE +
+                                   Memory::N3DS_EXTRA_RAM_SIZE};
+    u8* const fcram = host_memory.BackingBasePointer();
+    u8* const vram = fcram + Memory::FCRAM_N3DS_SIZE;
+    u8* const n3ds_extra_ram = vram + Memory::VRAM_SIZE;
+
+    /// Fastmem is only used by the JIT and needs a 64-bit host address space for the windows
+    const bool use_fastmem = sizeof(void*) == 8 && Settings::values.use_cpu_jit.GetValue() &&
+                             Settings::values.use_fastmem.GetValue();
 
     std::shared_ptr<PageTable> current_page_table = nullptr;
+    std::shared_mutex page_table_mutex;
     RasterizerCacheMarker cache_marker;
+
+    static constexpr std::size_t NUM_HOST_PAGES =
+        (Memory::FCRAM_N3DS_SIZE + Memory::VRAM_SIZE + Memory::N3DS_EXTRA_RAM_SIZE) /
+        CITRA_PAGE_SIZE;
+    static_assert(NUM_HOST_PAGES % 64 == 0 && Memory::VRAM_SIZE / CITRA_PAGE_SIZE % 64 == 0,
+                  "Every region must start at a word of the dirty page bitmap");
+
+    /// One bit per page of host_memory, set when the page is written while tracking is enabled.
+    /// Cores running on their own host threads can mark pages at the same time.
+    std::array<std::atomic<u64>, NUM_HOST_PAGES / 64> dirty_pages{};
+    bool track_dirty_pages = false;
+
+    /// Whether saved states include FCRAM, VRAM and the New 3DS extra memory
+    bool serialize_ram = true;
     std::vector<std::shared_ptr<PageTable>> page_table_list;
 
     AudioCore::DspInterface* dsp = nullptr;
@@ -111,13 +189,13 @@ public:
     const u8* GetPtr(Region r) const {
         switch (r) {
         case Region::VRAM:
-            return vram.get();
+            return vram;
         case Region::DSP:
             return dsp->GetDspMemory().data();
         case Region::FCRAM:
-            return fcram.get();
+            return fcram;
         case Region::N3DS:
-            return n3ds_extra_ram.get();
+            return n3ds_extra_ram;
         default:
             UNREACHABLE();
         }
@@ -126,13 +204,13 @@ public:
     u8* GetPtr(Region r) {
         switch (r) {
         case Region::VRAM:
-            return vram.get();
+            return vram;
         case Region::DSP:
             return dsp->GetDspMemory().data();
         case Region::FCRAM:
-            return fcram.get();
+            return fcram;
         case Region::N3DS:
-            return n3ds_extra_ram.get();
+            return n3ds_extra_ram;
         default:
             UNREACHABLE();
         }
@@ -153,6 +231,155 @@ public:
         }
     }
 
+    /// Reserves the fastmem window of page_table and maps its current pages into it
+    void InitFastmem(PageTable& page_table) {
+        if (!use_fastmem || page_table.fastmem_window) {
+            return;
+        }
+        page_table.fastmem_window =
+            host_memory.ReserveWindow(static_cast<std::size_t>(FASTMEM_WINDOW_SIZE));
+        if (!page_table.fastmem_window) {
+            return;
+        }
+        page_table.fastmem_base = page_table.fastmem_window->BasePointer();
+        UpdateFastmem(page_table, 0, PAGE_TABLE_NUM_ENTRIES);
+    }
+
+    /// Returns the offset into host_memory of a page that is aliased in the fastmem windows
+    std::optional<std::size_t> FastmemOffset(PageTable& page_table, u32 index) const {
+        const u8* pointer = page_table.GetPointerArray()[index];
+        if (page_table.attributes[index] != PageType::Memory || pointer < fcram ||
+            pointer >= fcram + host_memory.BackingSize()) {
+            return std::nullopt;
+        }
+        return static_cast<std::size_t>(pointer - fcram);
+    }
+
+    /**
+     * Updates the fastmem window of page_table for the given pages, aliasing the ones of type
+     * `Memory` that are backed by host_memory and making all other ones inaccessible.
+     */
+    void UpdateFastmem(PageTable& page_table, u32 page, u32 num_pages) {
+        if (!page_table.fastmem_window) {
+            return;
+        }
+
+        const auto host_offset = [&](u32 index) { return FastmemOffset(page_table, index); };
+
+        // Coalesce contiguous pages to keep the number of host mappings low
+        const u32 first_page = page;
+        const u32 end = page + num_pages;
+        while (page < end) {
+            const std::optional<std::size_t> offset = host_offset(page);
+            u32 run_end = page + 1;
+            if (offset) {
+                while (run_end < end &&
+                       host_offset(run_end) == *offset + (run_end - page) * CITRA_PAGE_SIZE) {
+                    run_end++;
+                }
+                page_table.fastmem_window->Map(static_cast<std::size_t>(page) * CITRA_PAGE_SIZE,
+                                               *offset, (run_end - page) * CITRA_PAGE_SIZE);
+            } else {
+                while (run_end < end && !host_offset(run_end)) {
+                    run_end++;
+                }
+                page_table.fastmem_window->Unmap(static_cast<std::size_t>(page) * CITRA_PAGE_SIZE,
+                                                 static_cast<std::size_t>(run_end - page) *
+                                                     CITRA_PAGE_SIZE);
+            }
+            page = run_end;
+        }
+
+        if (track_dirty_pages) {
+            ProtectFastmem(page_table, first_page, num_pages, false,
+                           [this](std::size_t offset) { return !IsDirty(offset); });
+        }
+    }
+
+    /**
+     * Changes the write protection of the pages in [page, page + num_pages) that are aliased in
+     * the fastmem window of page_table, for the ones whose host_memory offset matches predicate.
+     */
+    template <typename Predicate>
+    void ProtectFastmem(PageTable& page_table, u32 page, u32 num_pages, bool writable,
+                        Predicate&& predicate) {
+        if (!page_table.fastmem_window) {
+            return;
+        }
+
+        const auto matches = [&](u32 index) {
+            const std::optional<std::size_t> offset = FastmemOffset(page_table, index);
+            return offset && predicate(*offset);
+        };
+
+        const u32 end = page + num_pages;
+        while (page < end) {
+            if (!matches(page)) {
+                page++;
+                continue;
+            }
+            u32 run_end = page + 1;
+            while (run_end < end && matches(run_end)) {
+                run_end++;
+            }
+            page_table.fastmem_window->Protect(static_cast<std::size_t>(page) * CITRA_PAGE_SIZE,
+                                               static_cast<std::size_t>(run_end - page) *
+                                                   CITRA_PAGE_SIZE,
+                                               writable);
+            page = run_end;
+        }
+    }
+
+    /// Returns true if the page of host_memory at the given offset is dirty
+    bool IsDirty(std::size_t offset) const {
+        const std::size_t page = offset >> CITRA_PAGE_BITS;
+        return dirty_pages[page / 64].load(std::memory_order_relaxed) & (1ULL << (page % 64));
+    }
+
+    /**
+     * Marks the pages of host_memory overlapping [pointer, pointer + size) as dirty.
+     * @returns True if any of the pages was clean before.
+     */
+    bool MarkDirty(const u8* pointer, std::size_t size) {
+        if (!track_dirty_pages || size == 0 || pointer < fcram ||
+            pointer >= fcram + host_memory.BackingSize()) {
+            return false;
+        }
+        const std::size_t offset = static_cast<std::size_t>(pointer - fcram);
+        const std::size_t last = std::min(offset + size, host_memory.BackingSize()) - 1;
+        bool was_clean = false;
+        for (std::size_t page = offset >> CITRA_PAGE_BITS; page <= last >> CITRA_PAGE_BITS;
+             ++page) {
+            std::atomic<u64>& word = dirty_pages[page / 64];
+            const u64 bit = 1ULL << (page % 64);
+            // Pages are usually written many times between snapshots, only the first write of
+            // each one pays for the atomic update
+            if ((word.load(std::memory_order_relaxed) & bit) == 0) {
+                word.fetch_or(bit, std::memory_order_relaxed);
+                was_clean = true;
+            }
+        }
+        return was_clean;
+    }
+
+    /**
+     * Marks the page written by a guest access to vaddr through page_table as dirty. The first
+     * write to a clean page also lifts its write protection in the fastmem window of page_table,
+     * so that guest code can write it directly again. Pages dirtied by a raw pointer writer stay
+     * protected until the next snapshot, which only costs the JIT one fault per instruction.
+     */
+    void MarkWritten(PageTable& page_table, VAddr vaddr, const u8* pointer, std::size_t size) {
+        if (MarkDirty(pointer, size) && page_table.fastmem_window) {
+            page_table.fastmem_window->Protect(vaddr & ~CITRA_PAGE_MASK, CITRA_PAGE_SIZE, true);
+        }
+    }
+
+    void MarkAllDirty() {
+        for (std::atomic<u64>& word : dirty_pages) {
+            word.store(~0ULL, std::memory_order_relaxed);
+        }
+    }
+
     /**
      * This function should only be called for virtual addreses with attribute `PageType::Special`.
      */
@@ -167,114 +394,142 @@ public:
         return nullptr; // Should never happen
     }
 
-    template <bool UNSAFE>
-    void ReadBlockImpl(const Kernel::Process& process, const VAddr src_addr, void* dest_buffer,
-                       const std::size_t size) {
-        auto& page_table = *process.vm_manager.page_table;
-
-        std::size_t remaining_size = size;
-        std::size_t page_index = src_addr >> CITRA_PAGE_BITS;
-        std::size_t page_offset = src_addr & CITRA_PAGE_MASK;
-
-        while (remaining_size > 0) {
-            const std::size_t copy_amount = std::min(CITRA_PAGE_SIZE - page_offset, remaining_size);
-            const VAddr current_vaddr =
-                static_cast<VAddr>((page_index << CITRA_PAGE_BITS) + page_offset);
+    /**
+     * Splits [addr, addr + size) into runs of pages that can be handled at once and calls the
+     * handler for the page type of each run with the run's offset into the block and length.
+     * Memory and rasterizer cached runs are contiguous in host memory, so they can be copied with
+     * a single memcpy and flushed with a single rasterizer call. Special pages are handled one
+     * page at a time as each may belong to a different MMIO handler.
+     */
+    template <typename OnUnmapped, typename OnMemory, typename OnSpecial, typename OnCached>
+    void WalkBlock(PageTable& page_table, const VAddr addr, const std::size_t size,
+                   OnUnmapped&& on_unmapped, OnMemory&& on_memory, OnSpecial&& on_special,
+                   OnCached&& on_cached) {
+        // The software renderer doesn't mark the pages it uses as cached, so wait for the
+        // operations on the GPU thread before any block access
+        GPU::Synchronize();
+
+        std::size_t page_index = addr >> CITRA_PAGE_BITS;
+        std::size_t page_offset = addr & CITRA_PAGE_MASK;
+        std::size_t offset = 0;
+
+        while (offset < size) {
+            const PageType type = page_table.attributes[page_index];
+            const VAddr current_vaddr = static_cast<VAddr>(addr + offset);
+            const auto host_page = [&](std::size_t index) -> u8* {
+                if (type == PageType::Memory) {
+                    return page_table.pointers[index];
+                }
+                if (type == PageType::RasterizerCachedMemory) {
+                    return GetPointerForRasterizerCache(
+                               static_cast<VAddr>(index << CITRA_PAGE_BITS))
+                        .GetPtr();
+                }
+                return nullptr;
+            };
 
-            switch (page_table.attributes[page_index]) {
-            case PageType::Unmapped: {
-                LOG_ERROR(
-                    HW_Memory,
-                    "unmapped ReadBlock @ 0x{:08X} (start address = 0x{:08X}, size = {}) at PC "
-                    "0x{:08X}",
-                    current_vaddr, src_addr, size, Core::GetRunningCore().GetPC());
-                std::memset(dest_buffer, 0, copy_amount);
-                break;
+            u8* const run_start = host_page(page_index);
+            const auto continues_run = [&](std::size_t index) {
+                if (page_table.attributes[index] != type) {
+                    return false;
+                }
+                return type == PageType::Unmapped ||
+                       host_page(index) ==
+                           run_start + ((index - page_index) << CITRA_PAGE_BITS);
+            };
+
+            std::size_t length =
+                std::min<std::size_t>(CITRA_PAGE_SIZE - page_offset, size - offset);
+            std::size_t next_index = page_index + 1;
+            if (type != PageType::Special) {
+                while (offset + length < size && continues_run(next_index)) {
+                    length += std::min<std::size_t>(CITRA_PAGE_SIZE, size - offset - length);
+                    next_index++;
+                }
             }
-            case PageType::Memory: {
-                DEBUG_ASSERT(page_table.pointers[page_index]);
 
-                const u8* src_ptr = page_table.pointers[page_index] + page_offset;
-                std::memcpy(dest_buffer, src_ptr, copy_amount);
+            switch (type) {
+            case PageType::Unmapped:
+                on_unmapped(current_vaddr, offset, length);
+                break;
+            case PageType::Memory:
+                DEBUG_ASSERT(run_start);
+                on_memory(run_start + page_offset, offset, length);
                 break;
-            }
             case PageType::Special: {
                 MMIORegionPointer handler = GetMMIOHandler(page_table, current_vaddr);
                 DEBUG_ASSERT(handler);
-                handler->ReadBlock(current_vaddr, dest_buffer, copy_amount);
+                on_special(handler, current_vaddr, offset, length);
                 break;
             }
-            case PageType::RasterizerCachedMemory: {
-                if constexpr (!UNSAFE) {
-                    RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(copy_amount),
-                                                 FlushMode::Flush);
-                }
-                std::memcpy(dest_buffer, GetPointerForRasterizerCache(current_vaddr), copy_amount);
+            case PageType::RasterizerCachedMemory:
+                on_cached(current_vaddr, run_start + page_offset, offset, length);
                 break;
-            }
             default:
                 UNREACHABLE();
             }
 
-            page_index++;
+            offset += length;
+            page_index = next_index;
             page_offset = 0;
-            dest_buffer = static_cast<u8*>(dest_buffer) + copy_amount;
-            remaining_size -= copy_amount;
         }
     }
 
+    template <bool UNSAFE>
+    void ReadBlockImpl(const Kernel::Process& process, const VAddr src_addr, void* dest_buffer,
+                       const std::size_t size) {
+        u8* const dest = static_cast<u8*>(dest_buffer);
+        WalkBlock(
+            *process.vm_manager.page_table, src_addr, size,
+            [&](VAddr current_vaddr, std::size_t offset, std::size_t length) {
+                LOG_ERROR(
+                    HW_Memory,
+                    "unmapped ReadBlock @ 0x{:08X} (start address = 0x{:08X}, size = {}) at PC "
+                    "0x{:08X}",
+                    current_vaddr, src_addr, size, GetRunningCorePC());
+                std::memset(dest + offset, 0, length);
+            },
+            [&](const u8* src_ptr, std::size_t offset, std::size_t length) {
+                std::memcpy(dest + offset, src_ptr, length);
+            },
+            [&](MMIORegionPointer handler, VAddr current_vaddr, std::size_t offset,
+                std::size_t length) { handler->ReadBlock(current_vaddr, dest + offset, length); },
+            [&](VAddr current_vaddr, const u8* src_ptr, std::size_t offset, std::size_t length) {
+                if constexpr (!UNSAFE) {
+                    RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(length),
+                                                 FlushMode::Flush);
+                }
+                std::memcpy(dest + offset, src_ptr, length);
+            });
+    }
+
     template <bool UNSAFE>
     void WriteBlockImpl(const Kernel::Process& process, const VAddr dest_addr,
                         const void* src_buffer, const std::size_t size) {
-        auto& page_table = *process.vm_manager.page_table;
-        std::size_t remaining_size = size;
-        std::size_t page_index = dest_addr >> CITRA_PAGE_BITS;
-        std::size_t page_offset = dest_addr & CITRA_PAGE_MASK;
-
-        while (remaining_size > 0) {
-            const std::size_t copy_amount = std::min(CITRA_PAGE_SIZE - page_offset, remaining_size);
-            const VAddr current_vaddr =
-                static_cast<VAddr>((page_index << CITRA_PAGE_BITS) + page_offset);
-
-            switch (page_table.attributes[page_index]) {
-            case PageType::Unmapped: {
+        const u8* const src = static_cast<const u8*>(src_buffer);
+        WalkBlock(
+            *process.vm_manager.page_table, dest_addr, size,
+            [&](VAddr current_vaddr, std::size_t, std::size_t) {
                 LOG_ERROR(
                     HW_Memory,
                     "unmapped WriteBlock @ 0x{:08X} (start address = 0x{:08X}, size = {}) at PC "
                     "0x{:08X}",
-                    current_vaddr, dest_addr, size, Core::GetRunningCore().GetPC());
-                break;
-            }
-            case PageType::Memory: {
-                DEBUG_ASSERT(page_table.pointers[page_index]);
-
-                u8* dest_ptr = page_table.pointers[page_index] + page_offset;
-                std::memcpy(dest_ptr, src_buffer, copy_amount);
-                break;
-            }
-            case PageType::Special: {
-                MMIORegionPointer handler = GetMMIOHandler(page_table, current_vaddr);
-                DEBUG_ASSERT(handler);
-                handler->WriteBlock(current_vaddr, src_buffer, copy_amount);
-                break;
-            }
-            case PageType::RasterizerCachedMemory: {
+                    current_vaddr, dest_addr, size, GetRunningCorePC());
+            },
+            [&](u8* dest_ptr, std::size_t offset, std::size_t length) {
+                std::memcpy(dest_ptr, src + offset, length);
+                MarkDirty(dest_ptr, length);
+            },
+            [&](MMIORegionPointer handler, VAddr current_vaddr, std::size_t offset,
+                std::size_t length) { handler->WriteBlock(current_vaddr, src + offset, length); },
+            [&](VAddr current_vaddr, u8* dest_ptr, std::size_t offset, std::size_t length) {
                 if constexpr (!UNSAFE) {
-                    RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(copy_amount),
+                    RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(length),
                                                  FlushMode::Invalidate);
                 }
-                std::memcpy(GetPointerForRasterizerCache(current_vaddr), src_buffer, copy_amount);
-                break;
-            }
-            default:
-                UNREACHABLE();
-            }
-
-            page_index++;
-            page_offset = 0;
-            src_buffer = static_cast<const u8*>(src_buffer) + copy_amount;
-            remaining_size -= copy_amount;
-        }
+                std::memcpy(dest_ptr, src + offset, length);
+                MarkDirty(dest_ptr, length);
+            });
     }
 
     MemoryRef GetPointerForRasterizerCache(VAddr addr) const {
@@ -296,19 +551,100 @@ public:
         return MemoryRef{};
     }
 
+    /// Returns pointers to the pages of VRAM, FCRAM and the New 3DS extra memory, in that order
+    std::vector<u8*> GetRamPages(bool include_n3ds_ram) const {
+        const std::array<std::pair<u8*, u32>, 3> regions{{
+            {vram, Memory::VRAM_SIZE},
+            {fcram, include_n3ds_ram ? Memory::FCRAM_N3DS_SIZE : Memory::FCRAM_SIZE},
+            {n3ds_extra_ram, include_n3ds_ram ? Memory::N3DS_EXTRA_RAM_SIZE : 0},
+        }};
+        std::vector<u8*> pages;
+        for (const auto& [base, size] : regions) {
+            for (u32 offset = 0; offset < size; offset += CITRA_PAGE_SIZE) {
+                pages.push_back(base + offset);
+            }
+        }
+        return pages;
+    }
+
 private:
+    /**
+     * Stores the emulated RAM as a page map followed by the contents of the unique pages. Zero
+     * pages only appear in the map and pages with identical contents are stored once. Loading
+     * writes the pages straight into the backing memory.
+     */
+    template <class Archive>
+    void SerializeRam(Archive& ar, bool save_n3ds_ram) {
+        const std::vector<u8*> pages = GetRamPages(save_n3ds_ram);
+
+        // Zero for zero pages, otherwise one plus the index of the unique page with the contents.
+        // Unique pages are numbered in the order they first appear in.
+        std::vector<u32> page_map(pages.size());
+        if constexpr (Archive::is_saving::value) {
+            const u64 zero_page_hash = GetZeroPageHash();
+            const std::vector<u64> hashes = HashPages(pages);
+            std::unordered_map<u64, std::size_t> first_page_with_hash;
+            u32 num_unique = 0;
+            for (std::size_t i = 0; i < pages.size(); ++i) {
+                if (hashes[i] == zero_page_hash &&
+                    std::memcmp(pages[i], ZERO_PAGE.data(), CITRA_PAGE_SIZE) == 0) {
+                    continue;
+                }
+                const auto [it, inserted] = first_page_with_hash.try_emplace(hashes[i], i);
+                if (!inserted && std::memcmp(pages[i], pages[it->second], CITRA_PAGE_SIZE) == 0) {
+                    page_map[i] = page_map[it->second];
+                    continue;
+                }
+                page_map[i] = ++num_unique;
+            }
+        }
+        ar& boost::serialization::make_binary_object(page_map.data(),
+                                                     page_map.size() * sizeof(u32));
+
+        std::vector<const u8*> unique_pages;
+        for (std::size_t i = 0; i < pages.size(); ++i) {
+            const u32 entry = page_map[i];
+            if (entry == unique_pages.size() + 1) {
+                ar& boost::serialization::make_binary_object(pages[i], CITRA_PAGE_SIZE);
+                unique_pages.push_back(pages[i]);
+            } else if constexpr (Archive::is_loading::value) {
+                if (entry == 0) {
+                    std::memset(pages[i], 0, CITRA_PAGE_SIZE);
+                } else if (entry <= unique_pages.size()) {
+                    std::memcpy(pages[i], unique_pages[entry - 1], CITRA_PAGE_SIZE);
+                } else {
+                    throw std::runtime_error("Invalid memory page map");
+                }
+            }
+        }
+    }
+
     friend class boost::serialization::access;
     template <class Archive>
     void serialize(Archive& ar, const unsigned int file_version) {
+        if (file_version < 1) {
+            // Older states always stored the RAM, as plain binary blobs instead of deduplicated
+            // pages
+            throw std::runtime_error("Savestate RAM layout is from an older version");
+        }
         bool save_n3ds_ram = Settings::values.is_new_3ds.GetValue();
         ar& save_n3ds_ram;
-        ar& boost::serialization::make_binary_object(vram.get(), Memory::VRAM_SIZE);
-        ar& boost::serialization::make_binary_object(
-            fcram.get(), save_n3ds_ram ? Memory::FCRAM_N3DS_SIZE : Memory::FCRAM_SIZE);
-        ar& boost::serialization::make_binary_object(
-            n3ds_extra_ram.get(), save_n3ds_ram ? Memory::N3DS_EXTRA_RAM_SIZE : 0);
+        bool save_ram = serialize_ram;
+        ar& save_ram;
+        if (save_ram) {
+            SerializeRam(ar, save_n3ds_ram);
+        }
         ar& cache_marker;
         ar& page_table_list;
+        if constexpr (Archive::is_loading::value) {
+            // The whole memory was replaced
+            if (track_dirty_pages) {
+                MarkAllDirty();
+            }
+            for (const auto& page_table : page_table_list) {
+                InitFastmem(*page_table);
+            }
+        }
         // dsp is set from Core::System at startup
         ar& current_page_table;
         ar& fcram_mem;
@@ -369,14 +705,23 @@ std::shared_ptr<PageTable> MemorySystem::GetCurrentPageTable() const {
     return impl->current_page_table;
 }
 
+std::shared_mutex& MemorySystem::GetPageTableMutex() {
+    return impl->page_table_mutex;
+}
+
 void MemorySystem::MapPages(PageTable& page_table, u32 base, u32 size, MemoryRef memory,
                             PageType type) {
     LOG_DEBUG(HW_Memory, "Mapping {} onto {:08X}-{:08X}", (void*)memory.GetPtr(),
               base * CITRA_PAGE_SIZE, (base + size) * CITRA_PAGE_SIZE);
 
+    const u32 first_page = base;
+
     RasterizerFlushVirtualRegion(base << CITRA_PAGE_BITS, size * CITRA_PAGE_SIZE,
                                  FlushMode::FlushAndInvalidate);
 
+    // The flush above can mark the region uncached, which takes the lock as well
+    std::unique_lock lock{impl->page_table_mutex};
+
     u32 end = base + size;
     while (base != end) {
         ASSERT_MSG(base < PAGE_TABLE_NUM_ENTRIES, "out of range mapping at {:08X}", base);
@@ -394,6 +739,8 @@ void MemorySystem::MapPages(PageTable& page_table, u32 base, u32 size, MemoryRef
         if (memory != nullptr && memory.GetSize() > CITRA_PAGE_SIZE)
             memory += CITRA_PAGE_SIZE;
     }
+
+    impl->UpdateFastmem(page_table, first_page, size);
 }
 
 void MemorySystem::MapMemoryRegion(PageTable& page_table, VAddr base, u32 size, MemoryRef target) {
@@ -424,6 +771,7 @@ MemoryRef MemorySystem::GetPointerForRasterizerCache(VAddr addr) const {
 }
 
 void MemorySystem::RegisterPageTable(std::shared_ptr<PageTable> page_table) {
+    impl->InitFastmem(*page_table);
     impl->page_table_list.push_back(page_table);
 }
 
@@ -467,7 +815,7 @@ T MemorySystem::Read(const VAddr vaddr) {
     switch (type) {
     case PageType::Unmapped:
         LOG_ERROR(HW_Memory, "unmapped Read{} @ 0x{:08X} at PC 0x{:08X}", sizeof(T) * 8, vaddr,
-                  Core::GetRunningCore().GetPC());
+                  GetRunningCorePC());
         return 0;
     case PageType::Memory:
         ASSERT_MSG(false, "Mapped memory page without a pointer @ {:08X}", vaddr);
@@ -497,6 +845,10 @@ void MemorySystem::Write(const VAddr vaddr, const T data) {
     if (page_pointer) {
         // NOTE: Avoid adding any extra logic to this fast-path block
         std::memcpy(&page_pointer[vaddr & CITRA_PAGE_MASK], &data, sizeof(T));
+        if (impl->track_dirty_pages) [[unlikely]] {
+            impl->MarkWritten(*impl->current_page_table, vaddr,
+                              &page_pointer[vaddr & CITRA_PAGE_MASK], sizeof(T));
+        }
         return;
     }
 
@@ -506,6 +858,7 @@ void MemorySystem::Write(const VAddr vaddr, const T data) {
         PAddr paddr = (vaddr & ~(1 << 31));
         if ((paddr & 0xF0000000) == Memory::FCRAM_PADDR) { // Check FCRAM region
             std::memcpy(GetFCRAMPointer(paddr - Memory::FCRAM_PADDR), &data, sizeof(T));
+            impl->MarkDirty(GetFCRAMPointer(paddr - Memory::FCRAM_PADDR), sizeof(T));
             return;
         } else if ((paddr & 0xF0000000) == 0x10000000 &&
                    paddr >= Memory::IO_AREA_PADDR) { // Check MMIO region
@@ -518,14 +871,16 @@ void MemorySystem::Write(const VAddr vaddr, const T data) {
     switch (type) {
     case PageType::Unmapped:
         LOG_ERROR(HW_Memory, "unmapped Write{} 0x{:08X} @ 0x{:08X} at PC 0x{:08X}",
-                  sizeof(data) * 8, (u32)data, vaddr, Core::GetRunningCore().GetPC());
+                  sizeof(data) * 8, (u32)data, vaddr, GetRunningCorePC());
         return;
     case PageType::Memory:
         ASSERT_MSG(false, "Mapped memory page without a pointer @ {:08X}", vaddr);
         break;
     case PageType::RasterizerCachedMemory: {
         RasterizerFlushVirtualRegion(vaddr, sizeof(T), FlushMode::Invalidate);
-        std::memcpy(GetPointerForRasterizerCache(vaddr), &data, sizeof(T));
+        u8* const pointer = GetPointerForRasterizerCache(vaddr);
+        std::memcpy(pointer, &data, sizeof(T));
+        impl->MarkDirty(pointer, sizeof(T));
         break;
     }
     case PageType::Special:
@@ -543,6 +898,10 @@ bool MemorySystem::WriteExclusive(const VAddr vaddr, const T data, const T expec
     if (page_pointer) {
         const auto volatile_pointer =
             reinterpret_cast<volatile T*>(&page_pointer[vaddr & CITRA_PAGE_MASK]);
+        if (impl->track_dirty_pages) [[unlikely]] {
+            impl->MarkWritten(*impl->current_page_table, vaddr,
+                              &page_pointer[vaddr & CITRA_PAGE_MASK], sizeof(T));
+        }
         return Common::AtomicCompareAndSwap(volatile_pointer, data, expected);
     }
 
@@ -550,16 +909,17 @@ bool MemorySystem::WriteExclusive(const VAddr vaddr, const T data, const T expec
     switch (type) {
     case PageType::Unmapped:
         LOG_ERROR(HW_Memory, "unmapped Write{} 0x{:08X} @ 0x{:08X} at PC 0x{:08X}",
-                  sizeof(data) * 8, (u32)data, vaddr, Core::GetRunningCore().GetPC());
+                  sizeof(data) * 8, (u32)data, vaddr, GetRunningCorePC());
         return true;
     case PageType::Memory:
         ASSERT_MSG(false, "Mapped memory page without a pointer @ {:08X}", vaddr);
         return true;
     case PageType::RasterizerCachedMemory: {
         RasterizerFlushVirtualRegion(vaddr, sizeof(T), FlushMode::Invalidate);
-        const auto volatile_pointer =
-            reinterpret_cast<volatile T*>(GetPointerForRasterizerCache(vaddr).GetPtr());
-        return Common::AtomicCompareAndSwap(volatile_pointer, data, expected);
+        u8* const pointer = GetPointerForRasterizerCache(vaddr).GetPtr();
+        impl->MarkDirty(pointer, sizeof(T));
+        return Common::AtomicCompareAndSwap(reinterpret_cast<volatile T*>(pointer), data,
+                                            expected);
     }
     case PageType::Special:
         WriteMMIO<T>(impl->GetMMIOHandler(*impl->current_page_table, vaddr), vaddr, data);
@@ -606,8 +966,7 @@ u8* MemorySystem::GetPointer(const VAddr vaddr) {
         return GetPointerForRasterizerCache(vaddr);
     }
 
-    LOG_ERROR(HW_Memory, "unknown GetPointer @ 0x{:08x} at PC 0x{:08X}", vaddr,
-              Core::GetRunningCore().GetPC());
+    LOG_ERROR(HW_Memory, "unknown GetPointer @ 0x{:08x} at PC 0x{:08X}", vaddr, GetRunningCorePC());
     return nullptr;
 }
 
@@ -663,7 +1022,7 @@ MemoryRef MemorySystem::GetPhysicalRef(PAddr address) const {
 
     if (area == memory_areas.end()) {
         LOG_ERROR(HW_Memory, "Unknown GetPhysicalPointer @ {:#08X} at PC {:#08X}", address,
-                  Core::GetRunningCore().GetPC());
+                  GetRunningCorePC());
         return nullptr;
     }
 
@@ -714,7 +1073,7 @@ static std::vector<VAddr> PhysicalToVirtualAddressForRasterizer(PAddr addr) {
     // parts of the texture.
     LOG_ERROR(HW_Memory,
               "Trying to use invalid physical address for rasterizer: {:08X} at PC 0x{:08X}", addr,
-              Core::GetRunningCore().GetPC());
+              GetRunningCorePC());
     return {};
 }
 
@@ -723,11 +1082,31 @@ void MemorySystem::RasterizerMarkRegionCached(PAddr start, u32 size, bool cached
         return;
     }
 
+    std::unique_lock lock{impl->page_table_mutex};
+
     u32 num_pages = ((start + size - 1) >> CITRA_PAGE_BITS) - (start >> CITRA_PAGE_BITS) + 1;
     PAddr paddr = start;
 
+    // Runs of contiguous virtual pages that changed, to update the fastmem windows with one host
+    // mapping call per run instead of one per page
+    struct PageRun {
+        u32 first_page;
+        u32 num_pages;
+    };
+    std::vector<PageRun> runs;
+
     for (unsigned i = 0; i < num_pages; ++i, paddr += CITRA_PAGE_SIZE) {
         for (VAddr vaddr : PhysicalToVirtualAddressForRasterizer(paddr)) {
+            const u32 page = vaddr >> CITRA_PAGE_BITS;
+            const auto run = std::find_if(runs.begin(), runs.end(), [page](const PageRun& other) {
+                return other.first_page + other.num_pages == page;
+            });
+            if (run != runs.end()) {
+                run->num_pages++;
+            } else {
+                runs.push_back({page, 1});
+            }
+
             impl->cache_marker.Mark(vaddr, cached);
             for (auto page_table : impl->page_table_list) {
                 PageType& page_type = page_table->attributes[vaddr >> CITRA_PAGE_BITS];
@@ -766,6 +1145,12 @@ void MemorySystem::RasterizerMarkRegionCached(PAddr start, u32 size, bool cached
             }
         }
     }
+
+    for (auto page_table : impl->page_table_list) {
+        for (const PageRun& run : runs) {
+            impl->UpdateFastmem(*page_table, run.first_page, run.num_pages);
+        }
+    }
 }
 
 void RasterizerFlushRegion(PAddr start, u32 size) {
@@ -805,6 +1190,9 @@ void RasterizerClearAll(bool flush) {
 }
 
 void RasterizerFlushVirtualRegion(VAddr start, u32 size, FlushMode mode) {
+    // Operations still running on the GPU thread may access the region
+    GPU::Synchronize();
+
     // Since pages are unmapped on shutdown after video core is shutdown, the renderer may be
     // null here
     if (VideoCore::g_renderer == nullptr) {
@@ -917,53 +1305,29 @@ void MemorySystem::WriteBlock(const VAddr dest_addr, const void* src_buffer,
 
 void MemorySystem::ZeroBlock(const Kernel::Process& process, const VAddr dest_addr,
                              const std::size_t size) {
-    auto& page_table = *process.vm_manager.page_table;
-    std::size_t remaining_size = size;
-    std::size_t page_index = dest_addr >> CITRA_PAGE_BITS;
-    std::size_t page_offset = dest_addr & CITRA_PAGE_MASK;
-
     static const std::array<u8, CITRA_PAGE_SIZE> zeros = {};
 
-    while (remaining_size > 0) {
-        const std::size_t copy_amount = std::min(CITRA_PAGE_SIZE - page_offset, remaining_size);
-        const VAddr current_vaddr =
-            static_cast<VAddr>((page_index << CITRA_PAGE_BITS) + page_offset);
-
-        switch (page_table.attributes[page_index]) {
-        case PageType::Unmapped: {
+    impl->WalkBlock(
+        *process.vm_manager.page_table, dest_addr, size,
+        [&](VAddr current_vaddr, std::size_t, std::size_t) {
             LOG_ERROR(HW_Memory,
                       "unmapped ZeroBlock @ 0x{:08X} (start address = 0x{:08X}, size = {}) at PC "
                       "0x{:08X}",
-                      current_vaddr, dest_addr, size, Core::GetRunningCore().GetPC());
-            break;
-        }
-        case PageType::Memory: {
-            DEBUG_ASSERT(page_table.pointers[page_index]);
-
-            u8* dest_ptr = page_table.pointers[page_index] + page_offset;
-            std::memset(dest_ptr, 0, copy_amount);
-            break;
-        }
-        case PageType::Special: {
-            MMIORegionPointer handler = impl->GetMMIOHandler(page_table, current_vaddr);
-            DEBUG_ASSERT(handler);
-            handler->WriteBlock(current_vaddr, zeros.data(), copy_amount);
-            break;
-        }
-        case PageType::RasterizerCachedMemory: {
-            RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(copy_amount),
+                      current_vaddr, dest_addr, size, GetRunningCorePC());
+        },
+        [this](u8* dest_ptr, std::size_t, std::size_t length) {
+            std::memset(dest_ptr, 0, length);
+            impl->MarkDirty(dest_ptr, length);
+        },
+        [&](MMIORegionPointer handler, VAddr current_vaddr, std::size_t, std::size_t length) {
+            handler->WriteBlock(current_vaddr, zeros.data(), length);
+        },
+        [this](VAddr current_vaddr, u8* dest_ptr, std::size_t, std::size_t length) {
+            RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(length),
                                          FlushMode::Invalidate);
-            std::memset(GetPointerForRasterizerCache(current_vaddr), 0, copy_amount);
-            break;
-        }
-        default:
-            UNREACHABLE();
-        }
-
-        page_index++;
-        page_offset = 0;
-        remaining_size -= copy_amount;
-    }
+            std::memset(dest_ptr, 0, length);
+            impl->MarkDirty(dest_ptr, length);
+        });
 }
 
 void MemorySystem::CopyBlock(const Kernel::Process& process, VAddr dest_addr, VAddr src_addr,
@@ -974,56 +1338,30 @@ void MemorySystem::CopyBlock(const Kernel::Process& process, VAddr dest_addr, VA
 void MemorySystem::CopyBlock(const Kernel::Process& dest_process,
                              const Kernel::Process& src_process, VAddr dest_addr, VAddr src_addr,
                              std::size_t size) {
-    auto& page_table = *src_process.vm_manager.page_table;
-    std::size_t remaining_size = size;
-    std::size_t page_index = src_addr >> CITRA_PAGE_BITS;
-    std::size_t page_offset = src_addr & CITRA_PAGE_MASK;
-
-    while (remaining_size > 0) {
-        const std::size_t copy_amount = std::min(CITRA_PAGE_SIZE - page_offset, remaining_size);
-        const VAddr current_vaddr =
-            static_cast<VAddr>((page_index << CITRA_PAGE_BITS) + page_offset);
-
-        switch (page_table.attributes[page_index]) {
-        case PageType::Unmapped: {
+    impl->WalkBlock(
+        *src_process.vm_manager.page_table, src_addr, size,
+        [&](VAddr current_vaddr, std::size_t offset, std::size_t length) {
             LOG_ERROR(HW_Memory,
                       "unmapped CopyBlock @ 0x{:08X} (start address = 0x{:08X}, size = {}) at PC "
                       "0x{:08X}",
-                      current_vaddr, src_addr, size, Core::GetRunningCore().GetPC());
-            ZeroBlock(dest_process, dest_addr, copy_amount);
-            break;
-        }
-        case PageType::Memory: {
-            DEBUG_ASSERT(page_table.pointers[page_index]);
-            const u8* src_ptr = page_table.pointers[page_index] + page_offset;
-            WriteBlock(dest_process, dest_addr, src_ptr, copy_amount);
-            break;
-        }
-        case PageType::Special: {
-            MMIORegionPointer handler = impl->GetMMIOHandler(page_table, current_vaddr);
-            DEBUG_ASSERT(handler);
-            std::vector<u8> buffer(copy_amount);
+                      current_vaddr, src_addr, size, GetRunningCorePC());
+            ZeroBlock(dest_process, static_cast<VAddr>(dest_addr + offset), length);
+        },
+        [&](const u8* src_ptr, std::size_t offset, std::size_t length) {
+            WriteBlock(dest_process, static_cast<VAddr>(dest_addr + offset), src_ptr, length);
+        },
+        [&](MMIORegionPointer handler, VAddr current_vaddr, std::size_t offset,
+            std::size_t length) {
+            std::vector<u8> buffer(length);
             handler->ReadBlock(current_vaddr, buffer.data(), buffer.size());
-            WriteBlock(dest_process, dest_addr, buffer.data(), buffer.size());
-            break;
-        }
-        case PageType::RasterizerCachedMemory: {
-            RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(copy_amount),
+            WriteBlock(dest_process, static_cast<VAddr>(dest_addr + offset), buffer.data(),
+                       buffer.size());
+        },
+        [&](VAddr current_vaddr, const u8* src_ptr, std::size_t offset, std::size_t length) {
+            RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(length),
                                          FlushMode::Flush);
-            WriteBlock(dest_process, dest_addr, GetPointerForRasterizerCache(current_vaddr),
-                       copy_amount);
-            break;
-        }
-        default:
-            UNREACHABLE();
-        }
-
-        page_index++;
-        page_offset = 0;
-        dest_addr += static_cast<VAddr>(copy_amount);
-        src_addr += static_cast<VAddr>(copy_amount);
-        remaining_size -= copy_amount;
-    }
+            WriteBlock(dest_process, static_cast<VAddr>(dest_addr + offset), src_ptr, length);
+        });
 }
 
 template <>
@@ -1067,18 +1405,18 @@ void WriteMMIO<u64>(MMIORegionPointer mmio_handler, VAddr addr, const u64 data)
 }
 
 u32 MemorySystem::GetFCRAMOffset(const u8* pointer) const {
-    ASSERT(pointer >= impl->fcram.get() && pointer <= impl->fcram.get() + Memory::FCRAM_N3DS_SIZE);
-    return static_cast<u32>(pointer - impl->fcram.get());
+    ASSERT(pointer >= impl->fcram && pointer <= impl->fcram + Memory::FCRAM_N3DS_SIZE);
+    return static_cast<u32>(pointer - impl->fcram);
 }
 
 u8* MemorySystem::GetFCRAMPointer(std::size_t offset) {
     ASSERT(offset <= Memory::FCRAM_N3DS_SIZE);
-    return impl->fcram.get() + offset;
+    return impl->fcram + offset;
 }
 
 const u8* MemorySystem::GetFCRAMPointer(std::size_t offset) const {
     ASSERT(offset <= Memory::FCRAM_N3DS_SIZE);
-    return impl->fcram.get() + offset;
+    return impl->fcram + offset;
 }
 
 MemoryRef MemorySystem::GetFCRAMRef(std::size_t offset) const {
@@ -1086,6 +1424,78 @@ MemoryRef MemorySystem::GetFCRAMRef(std::size_t offset) const {
     return MemoryRef(impl->fcram_mem, offset);
 }
 
+void MemorySystem::SetRamSerialization(bool enabled) {
+    impl->serialize_ram = enabled;
+}
+
+std::vector<u8*> MemorySystem::GetRamPages() const {
+    return impl->GetRamPages(Settings::values.is_new_3ds.GetValue());
+}
+
+void MemorySystem::SetDirtyPageTracking(bool enabled) {
+    if (enabled == impl->track_dirty_pages) {
+        return;
+    }
+    std::unique_lock lock{impl->page_table_mutex};
+    impl->track_dirty_pages = enabled;
+    if (enabled) {
+        // Nothing is known about the memory from before tracking started
+        impl->MarkAllDirty();
+        return;
+    }
+    for (const auto& page_table : impl->page_table_list) {
+        impl->ProtectFastmem(*page_table, 0, PAGE_TABLE_NUM_ENTRIES, true,
+                             [](std::size_t) { return true; });
+    }
+}
+
+bool MemorySystem::IsDirtyPageTrackingEnabled() const {
+    return impl->track_dirty_pages;
+}
+
+void MemorySystem::MarkRegionDirty(PAddr start, u32 size) {
+    if (!impl->track_dirty_pages) {
+        return;
+    }
+    if (const u8* pointer = GetPhysicalPointer(start)) {
+        impl->MarkDirty(pointer, size);
+    }
+}
+
+void MemorySystem::MarkRegionDirty(const u8* pointer, std::size_t size) {
+    impl->MarkDirty(pointer, size);
+}
+
+DirtyPageBitmap MemorySystem::SnapshotDirtyPages(Region region) {
+    ASSERT_MSG(region != Region::DSP, "DSP memory is not tracked");
+    if (!impl->track_dirty_pages) {
+        return {};
+    }
+
+    const std::size_t begin = static_cast<std::size_t>(impl->GetPtr(region) - impl->fcram);
+    const std::size_t end = begin + impl->GetSize(region);
+
+    // Write protect the dirty pages again before clearing them. Guest code writing one of them
+    // in between either marks it again or has its write reported by this snapshot.
+    {
+        std::unique_lock lock{impl->page_table_mutex};
+        for (const auto& page_table : impl->page_table_list) {
+            impl->ProtectFastmem(*page_table, 0, PAGE_TABLE_NUM_ENTRIES, false,
+                                 [&](std::size_t offset) {
+                                     return offset >= begin && offset < end &&
+                                            impl->IsDirty(offset);
+                                 });
+        }
+    }
+
+    DirtyPageBitmap bitmap(impl->GetSize(region) / CITRA_PAGE_SIZE / 64);
+    const std::size_t first_word = begin / CITRA_PAGE_SIZE / 64;
+    for (std::size_t i = 0; i < bitmap.size(); ++i) {
+        bitmap[i] = impl->dirty_pages[first_word + i].exchange(0, std::memory_order_relaxed);
+    }
+    return bitmap;
+}
+
 void MemorySystem::SetDSP(AudioCore::DspInterface& dsp) {
     impl->dsp = &dsp;
 }
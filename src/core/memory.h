@@ -5,10 +5,14 @@
 #pragma once
 #include <array>
 #include <cstddef>
+#include <shared_mutex>
 #include <string>
+#include <vector>
 #include <boost/serialization/array.hpp>
 #include <boost/serialization/vector.hpp>
+#include <boost/serialization/version.hpp>
 #include "common/common_types.h"
+#include "common/host_memory.h"
 #include "common/memory_ref.h"
 #include "core/mmio.h"
 
@@ -67,6 +71,13 @@ private:
  * requires an indexed fetch and a check for NULL.
  */
 struct PageTable {
+    PageTable() = default;
+
+    // Page tables own their fastmem window, so they can't be copied. They are only ever shared
+    // through std::shared_ptr (VMManager, the kernel, the CPU cores and the memory system).
+    PageTable(const PageTable&) = delete;
+    PageTable& operator=(const PageTable&) = delete;
+
     /**
      * Array of memory pointers backing each page. An entry can only be non-null if the
      * corresponding entry in the `attributes` array is of type `Memory`.
@@ -118,6 +129,15 @@ struct PageTable {
      */
     std::array<PageType, PAGE_TABLE_NUM_ENTRIES> attributes;
 
+    /**
+     * Host address space window covering the whole emulated address space, in which the pages of
+     * type `Memory` alias their backing memory. All other pages are inaccessible, so the JIT can
+     * access memory directly and fall back to the slow path when it faults. Null if fastmem is
+     * disabled or unsupported by the host.
+     */
+    std::unique_ptr<Common::HostMemory::Window> fastmem_window;
+    u8* fastmem_base = nullptr;
+
     std::array<u8*, PAGE_TABLE_NUM_ENTRIES>& GetPointerArray() {
         return pointers.raw;
     }
@@ -180,6 +200,9 @@ enum : PAddr {
 
 enum class Region { FCRAM, VRAM, DSP, N3DS };
 
+/// Bitmap with one bit per page of a memory region, page i being bit i % 64 of word i / 64
+using DirtyPageBitmap = std::vector<u64>;
+
 /// Virtual user-space memory regions
 enum : VAddr {
     /// Where the application text, data and bss reside.
@@ -285,6 +308,12 @@ void RasterizerClearAll(bool flush);
  */
 void RasterizerFlushVirtualRegion(VAddr start, u32 size, FlushMode mode);
 
+/// Hashes the contents of the given pages, splitting the work across the shared worker threads
+std::vector<u64> HashPages(const std::vector<u8*>& pages);
+
+/// Returns the hash HashPages gives a page filled with zeroes
+u64 GetZeroPageHash();
+
 class MemorySystem {
 public:
     MemorySystem();
@@ -315,6 +344,13 @@ public:
     void SetCurrentPageTable(std::shared_ptr<PageTable> page_table);
     std::shared_ptr<PageTable> GetCurrentPageTable() const;
 
+    /**
+     * Returns the mutex that is held exclusively while page tables and their fastmem windows are
+     * changed. CPU cores that run on their own host threads hold it shared while they execute
+     * guest code, which accesses both directly.
+     */
+    std::shared_mutex& GetPageTableMutex();
+
     /**
      * Gets a pointer to the given address.
      *
@@ -599,6 +635,45 @@ public:
     /// Gets a serializable ref to FCRAM with the given offset
     MemoryRef GetFCRAMRef(std::size_t offset) const;
 
+    /**
+     * Sets whether saved states include FCRAM, VRAM and the New 3DS extra memory. When they
+     * don't, the memory is left zeroed on load and has to be restored by the caller.
+     */
+    void SetRamSerialization(bool enabled);
+
+    /// Returns pointers to the pages of the memory that saved states include, in a fixed order
+    std::vector<u8*> GetRamPages() const;
+
+    /**
+     * Enables or disables tracking of the pages of FCRAM, VRAM and the New 3DS extra memory that
+     * are written to. All pages are dirty right after tracking is enabled. Writes through the
+     * MemorySystem are tracked. Clean pages are write protected in the fastmem windows and the JIT
+     * doesn't use the page table, so the first write of guest code to a clean page goes through
+     * the memory callbacks. Code writing through raw pointers calls MarkRegionDirty itself.
+     * Must not be called while guest code runs.
+     */
+    void SetDirtyPageTracking(bool enabled);
+
+    /// Returns true if dirty page tracking is enabled
+    bool IsDirtyPageTrackingEnabled() const;
+
+    /// Marks the pages overlapping the given physical region as dirty
+    void MarkRegionDirty(PAddr start, u32 size);
+
+    /// Marks the pages overlapping [pointer, pointer + size) as dirty, for a pointer into FCRAM,
+    /// VRAM or the New 3DS extra memory. Other pointers are ignored.
+    void MarkRegionDirty(const u8* pointer, std::size_t size);
+
+    /**
+     * Gets the pages of a memory region written since tracking was enabled or since the last
+     * snapshot of the region, and marks them clean. A write made while the snapshot is taken is
+     * reported by this snapshot or the next one.
+     * @param region The region to query, the DSP region is not tracked.
+     * @returns The bitmap, bit i covering the page at offset i * CITRA_PAGE_SIZE in the region,
+     *          or an empty one if tracking is disabled.
+     */
+    DirtyPageBitmap SnapshotDirtyPages(Region region);
+
     /// Registers page table for rasterizer cache marking
     void RegisterPageTable(std::shared_ptr<PageTable> page_table);
 
@@ -645,3 +720,4 @@ BOOST_CLASS_EXPORT_KEY(Memory::MemorySystem::BackingMemImpl<Memory::Region::FCRA
 BOOST_CLASS_EXPORT_KEY(Memory::MemorySystem::BackingMemImpl<Memory::Region::VRAM>)
 BOOST_CLASS_EXPORT_KEY(Memory::MemorySystem::BackingMemImpl<Memory::Region::DSP>)
 BOOST_CLASS_EXPORT_KEY(Memory::MemorySystem::BackingMemImpl<Memory::Region::N3DS>)
+BOOST_CLASS_VERSION(Memory::MemorySystem::Impl, 1)
@@ -13,6 +13,7 @@
 #include <fmt/format.h>
 #include "common/file_util.h"
 #include "common/settings.h"
+#include "core/core_timing.h"
 #include "core/hw/gpu.h"
 #include "core/perf_stats.h"
 
@@ -74,6 +75,17 @@ void PerfStats::EndGameFrame() {
     game_frames += 1;
 }
 
+void PerfStats::AddSkippedCycles(s64 cycles) {
+    // A core that already ran past the end of its slice had nothing left to skip
+    if (cycles <= 0) {
+        return;
+    }
+
+    std::lock_guard lock{object_mutex};
+
+    skipped_cycles += cycles;
+}
+
 double PerfStats::GetMeanFrametime() const {
     std::lock_guard lock{object_mutex};
 
@@ -101,6 +113,11 @@ PerfStats::Results PerfStats::GetAndResetStats(microseconds current_system_time_
     results.frametime = duration_cast<DoubleSecs>(accumulated_frametime).count() /
                         static_cast<double>(system_frames);
     results.emulation_speed = system_us_per_second.count() / 1'000'000.0;
+    const auto system_us = (current_system_time_us - reset_point_system_us).count();
+    results.idle_skip_ratio =
+        system_us > 0 ? static_cast<double>(skipped_cycles) * 1'000'000.0 /
+                            (static_cast<double>(system_us) * BASE_CLOCK_RATE_ARM11)
+                      : 0.0;
 
     // Reset counters
     reset_point = now;
@@ -108,6 +125,7 @@ PerfStats::Results PerfStats::GetAndResetStats(microseconds current_system_time_
     accumulated_frametime = Clock::duration::zero();
     system_frames = 0;
     game_frames = 0;
+    skipped_cycles = 0;
 
     return results;
 }
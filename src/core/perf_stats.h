@@ -34,12 +34,18 @@ public:
         double frametime;
         /// Ratio of walltime / emulated time elapsed
         double emulation_speed;
+        /// Ratio of CPU cycles skipped by idle loop detection / emulated cycles elapsed, summed
+        /// over all cores
+        double idle_skip_ratio;
     };
 
     void BeginSystemFrame();
     void EndSystemFrame();
     void EndGameFrame();
 
+    /// Records CPU cycles that were fast-forwarded through a guest idle loop
+    void AddSkippedCycles(s64 cycles);
+
     Results GetAndResetStats(std::chrono::microseconds current_system_time_us);
 
     /**
@@ -75,6 +81,8 @@ private:
     u32 system_frames = 0;
     /// Cumulative number of game frames (GSP frame submissions) since last reset
     u32 game_frames = 0;
+    /// Cumulative number of CPU cycles skipped by idle loop detection since last reset
+    u64 skipped_cycles = 0;
 
     /// Point when the previous system frame ended
     Clock::time_point previous_frame_end = reset_point;
@@ -0,0 +1,249 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <sstream>
+#include "common/archives.h"
+#include "common/logging/log.h"
+#include "common/scope_exit.h"
+#include "common/settings.h"
+#include "common/zstd_compression.h"
+#include "core/core.h"
+#include "core/memory.h"
+#include "core/rewind.h"
+#include "video_core/renderer_base.h"
+#include "video_core/video_core.h"
+
+namespace Core {
+
+namespace {
+
+/// Snapshots are taken every few frames, so compression favours speed over size
+constexpr s32 SNAPSHOT_COMPRESSION_LEVEL = 1;
+
+/// Maximum number of snapshots based on the same keyframe
+constexpr u32 MAX_SNAPSHOTS_PER_KEYFRAME = 30;
+
+} // Anonymous namespace
+
+struct RewindBuffer::Snapshot {
+    u64 frame;
+    bool is_keyframe;
+    /// Indices of the pages stored in the snapshot, into the pages returned by GetRamPages
+    std::vector<u32> pages;
+    /// Size of the system state at the start of the uncompressed data
+    std::size_t state_size;
+    /// System state followed by the contents of the pages, compressed on the worker thread
+    std::vector<u8> data;
+
+    std::size_t GetSize() const {
+        return data.size() + pages.size() * sizeof(u32);
+    }
+};
+
+RewindBuffer::RewindBuffer(System& system_)
+    : system(system_), compression_worker(1, "RewindCompression") {}
+
+RewindBuffer::~RewindBuffer() = default;
+
+void RewindBuffer::Update() {
+    const s32 renderer_frame = VideoCore::g_renderer->GetCurrentFrame();
+    if (renderer_frame == last_renderer_frame) {
+        return;
+    }
+    // The renderer starts counting from zero again when the system is loaded from a state
+    frame += renderer_frame > last_renderer_frame ? renderer_frame - last_renderer_frame : 1;
+    last_renderer_frame = renderer_frame;
+
+    const u32 interval = std::max(Settings::values.rewind_interval.GetValue(), 1U);
+    if (frame - last_snapshot_frame < interval) {
+        return;
+    }
+    last_snapshot_frame = frame;
+    TakeSnapshot();
+}
+
+void RewindBuffer::TakeSnapshot() {
+    auto& memory = system.Memory();
+
+    // The emulated memory is stored as pages, leave it out of the system state
+    std::ostringstream stream{std::ios_base::binary};
+    {
+        memory.SetRamSerialization(false);
+        SCOPE_EXIT({ memory.SetRamSerialization(true); });
+        try {
+            oarchive oa{stream};
+            const System& const_system = system;
+            oa& const_system;
+        } catch (const std::exception& e) {
+            LOG_ERROR(Core, "Unable to take rewind snapshot: {}", e.what());
+            return;
+        }
+    }
+    const std::string state = std::move(stream).str();
+
+    const std::vector<u8*> pages = memory.GetRamPages();
+    std::vector<u64> hashes = Memory::HashPages(pages);
+
+    auto snapshot = std::make_shared<Snapshot>();
+    snapshot->frame = frame;
+    snapshot->is_keyframe = force_keyframe || keyframe_hashes.size() != hashes.size() ||
+                            snapshots_since_keyframe >= MAX_SNAPSHOTS_PER_KEYFRAME;
+
+    // Memory starts out zeroed when a state is loaded, so keyframes only need the non-zero pages
+    // and the other snapshots the pages that differ from their keyframe.
+    for (u32 index = 0; index < hashes.size(); ++index) {
+        const u64 base_hash =
+            snapshot->is_keyframe ? Memory::GetZeroPageHash() : keyframe_hashes[index];
+        if (hashes[index] != base_hash) {
+            snapshot->pages.push_back(index);
+        }
+    }
+
+    snapshot->state_size = state.size();
+    snapshot->data.resize(state.size() + snapshot->pages.size() * Memory::CITRA_PAGE_SIZE);
+    std::memcpy(snapshot->data.data(), state.data(), state.size());
+    u8* dest = snapshot->data.data() + state.size();
+    for (const u32 index : snapshot->pages) {
+        std::memcpy(dest, pages[index], Memory::CITRA_PAGE_SIZE);
+        dest += Memory::CITRA_PAGE_SIZE;
+    }
+
+    if (snapshot->is_keyframe) {
+        keyframe_hashes = std::move(hashes);
+        snapshots_since_keyframe = 0;
+        force_keyframe = false;
+    } else {
+        snapshots_since_keyframe++;
+    }
+
+    {
+        std::scoped_lock lock{mutex};
+        snapshots.push_back(snapshot);
+        memory_usage += snapshot->GetSize();
+        Trim();
+    }
+
+    compression_worker.QueueWork([this, snapshot] {
+        std::vector<u8> compressed =
+            Common::Compression::CompressDataZSTD(snapshot->data, SNAPSHOT_COMPRESSION_LEVEL);
+
+        std::scoped_lock lock{mutex};
+        const bool is_buffered =
+            std::find(snapshots.begin(), snapshots.end(), snapshot) != snapshots.end();
+        if (is_buffered) {
+            memory_usage -= snapshot->GetSize();
+        }
+        snapshot->data = std::move(compressed);
+        if (is_buffered) {
+            memory_usage += snapshot->GetSize();
+            Trim();
+        }
+    });
+}
+
+bool RewindBuffer::Rewind(u32 frames) {
+    // Snapshots can only be restored once they are compressed
+    compression_worker.WaitForRequests();
+
+    std::shared_ptr<Snapshot> keyframe;
+    std::shared_ptr<Snapshot> snapshot;
+    {
+        std::scoped_lock lock{mutex};
+        if (snapshots.empty()) {
+            return false;
+        }
+
+        const u64 target_frame = frame > frames ? frame - frames : 0;
+        const auto newest_before = std::find_if(
+            snapshots.rbegin(), snapshots.rend(),
+            [target_frame](const auto& entry) { return entry->frame <= target_frame; });
+        const auto target =
+            newest_before == snapshots.rend() ? snapshots.begin() : std::prev(newest_before.base());
+        snapshot = *target;
+
+        // The oldest snapshot is always a keyframe
+        keyframe = *std::find_if(std::make_reverse_iterator(std::next(target)), snapshots.rend(),
+                                 [](const auto& entry) { return entry->is_keyframe; });
+
+        for (auto iter = std::next(target); iter != snapshots.end(); ++iter) {
+            memory_usage -= (*iter)->GetSize();
+        }
+        snapshots.erase(std::next(target), snapshots.end());
+    }
+
+    Restore(*keyframe, *snapshot);
+
+    frame = snapshot->frame;
+    last_snapshot_frame = frame;
+    last_renderer_frame = VideoCore::g_renderer->GetCurrentFrame();
+    // Newer keyframes may have been discarded
+    force_keyframe = true;
+    return true;
+}
+
+void RewindBuffer::Restore(const Snapshot& keyframe, const Snapshot& snapshot) {
+    const std::vector<u8> keyframe_data = Common::Compression::DecompressDataZSTD(keyframe.data);
+    const std::vector<u8> snapshot_data =
+        &snapshot == &keyframe ? std::vector<u8>{}
+                               : Common::Compression::DecompressDataZSTD(snapshot.data);
+    const std::vector<u8>& state_data = &snapshot == &keyframe ? keyframe_data : snapshot_data;
+
+    std::istringstream stream{
+        std::string{reinterpret_cast<const char*>(state_data.data()), snapshot.state_size},
+        std::ios_base::binary};
+    {
+        iarchive ia{stream};
+        ia& system;
+    }
+
+    const std::vector<u8*> pages = system.Memory().GetRamPages();
+    const auto copy_pages = [&pages](const Snapshot& source, const std::vector<u8>& data) {
+        const u8* page_data = data.data() + source.state_size;
+        for (const u32 index : source.pages) {
+            std::memcpy(pages[index], page_data, Memory::CITRA_PAGE_SIZE);
+            page_data += Memory::CITRA_PAGE_SIZE;
+        }
+    };
+    copy_pages(keyframe, keyframe_data);
+    if (&snapshot != &keyframe) {
+        copy_pages(snapshot, snapshot_data);
+    }
+
+    // Nothing cached by the rasterizer while loading can be trusted with the memory written after
+    Memory::RasterizerClearAll(false);
+}
+
+void RewindBuffer::Trim() {
+    const std::size_t budget = static_cast<std::size_t>(
+                                   Settings::values.rewind_buffer_size.GetValue())
+                               << 20;
+    while (memory_usage > budget && !snapshots.empty()) {
+        // The newest keyframe and the snapshots based on it are always kept
+        const auto next_keyframe =
+            std::find_if(std::next(snapshots.begin()), snapshots.end(),
+                         [](const auto& entry) { return entry->is_keyframe; });
+        if (next_keyframe == snapshots.end()) {
+            break;
+        }
+        for (auto iter = snapshots.begin(); iter != next_keyframe; ++iter) {
+            memory_usage -= (*iter)->GetSize();
+        }
+        snapshots.erase(snapshots.begin(), next_keyframe);
+    }
+}
+
+std::size_t RewindBuffer::GetSnapshotCount() const {
+    std::scoped_lock lock{mutex};
+    return snapshots.size();
+}
+
+std::size_t RewindBuffer::GetMemoryUsage() const {
+    std::scoped_lock lock{mutex};
+    return memory_usage;
+}
+
+} // namespace Core
@@ -0,0 +1,75 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "common/common_types.h"
+#include "common/thread_worker.h"
+
+namespace Core {
+
+class System;
+
+/**
+ * Keeps recent states of the emulated system in memory so that emulation can be rewound.
+ *
+ * Every few frames a snapshot is taken, holding the system state without the emulated memory
+ * plus the memory pages that differ from the last keyframe. Keyframes hold all non-zero pages.
+ * Snapshots are compressed on a worker thread, and the oldest keyframe and the snapshots based on
+ * it are dropped when the buffer grows past its memory budget.
+ */
+class RewindBuffer {
+public:
+    explicit RewindBuffer(System& system);
+    ~RewindBuffer();
+
+    /// Takes a snapshot if enough frames were emulated since the last one. Called between slices.
+    void Update();
+
+    /**
+     * Restores the newest snapshot taken at least the given number of frames ago, or the oldest
+     * snapshot if there is none that old. Newer snapshots are discarded.
+     * @returns false if there is no snapshot to restore.
+     */
+    bool Rewind(u32 frames);
+
+    /// Returns the number of snapshots in the buffer
+    std::size_t GetSnapshotCount() const;
+
+    /// Returns the memory used by the snapshots in the buffer, in bytes
+    std::size_t GetMemoryUsage() const;
+
+private:
+    struct Snapshot;
+
+    void TakeSnapshot();
+    void Restore(const Snapshot& keyframe, const Snapshot& snapshot);
+
+    /// Drops the oldest keyframes and their snapshots until the buffer fits in its budget
+    void Trim();
+
+    System& system;
+
+    /// Frames emulated, following the restored snapshot after a rewind
+    u64 frame = 0;
+    u64 last_snapshot_frame = 0;
+    s32 last_renderer_frame = 0;
+
+    /// Hashes of the pages of the last keyframe, and the number of snapshots taken since
+    std::vector<u64> keyframe_hashes;
+    u32 snapshots_since_keyframe = 0;
+    bool force_keyframe = true;
+
+    mutable std::mutex mutex;
+    std::deque<std::shared_ptr<Snapshot>> snapshots;
+    std::size_t memory_usage = 0;
+
+    Common::ThreadWorker compression_worker;
+};
+
+} // namespace Core
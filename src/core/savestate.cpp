@@ -2,15 +2,21 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <chrono>
+#include <istream>
+#include <memory>
+#include <thread>
 #include <cryptopp/hex.h>
 #include <fmt/format.h>
 #include "common/archives.h"
+#include "common/file_util.h"
 #include "common/logging/log.h"
 #include "common/scm_rev.h"
 #include "common/zstd_compression.h"
 #include "core/core.h"
 #include "core/movie.h"
+#include "core/rewind.h"
 #include "core/savestate.h"
 #include "network/network.h"
 
@@ -30,6 +36,9 @@ static_assert(sizeof(CSTHeader) == 256, "CSTHeader should be 256 bytes");
 
 constexpr std::array<u8, 4> header_magic_bytes{{'C', 'S', 'T', 0x1B}};
 
+/// Zstandard's default compression level
+constexpr s32 SAVESTATE_COMPRESSION_LEVEL = 3;
+
 static std::string GetSaveStatePath(u64 program_id, u32 slot) {
     const u64 movie_id = Movie::GetInstance().GetCurrentMovieID();
     if (movie_id) {
@@ -107,20 +116,11 @@ void System::SaveState(u32 slot) const {
     oarchive oa{sstream};
     oa&* this;
 
-    const std::string& str{sstream.str()};
-    const auto data = std::span<const u8>{reinterpret_cast<const u8*>(str.data()), str.size()};
-    auto buffer = Common::Compression::CompressDataZSTDDefault(data);
-
     const auto path = GetSaveStatePath(title_id, slot);
     if (!FileUtil::CreateFullPath(path)) {
         throw std::runtime_error("Could not create path " + path);
     }
 
-    FileUtil::IOFile file(path, "wb");
-    if (!file) {
-        throw std::runtime_error("Could not open file " + path);
-    }
-
     CSTHeader header{};
     header.filetype = header_magic_bytes;
     header.program_id = title_id;
@@ -132,10 +132,34 @@ void System::SaveState(u32 slot) const {
                       std::chrono::system_clock::now().time_since_epoch())
                       .count();
 
-    if (file.WriteBytes(&header, sizeof(header)) != sizeof(header) ||
-        file.WriteBytes(buffer.data(), buffer.size()) != buffer.size()) {
-        throw std::runtime_error("Could not write to file " + path);
-    }
+    // Compressing and writing the state takes a while, let emulation carry on in the meantime.
+    // Failures are returned by the next RunLoop.
+    auto state = std::make_shared<const std::string>(std::move(sstream).str());
+    savestate_worker->QueueWork([this, state, path, header] {
+        const auto data =
+            std::span<const u8>{reinterpret_cast<const u8*>(state->data()), state->size()};
+        const u32 num_threads = std::max(std::thread::hardware_concurrency() / 2, 1U);
+        const auto buffer = Common::Compression::CompressDataZSTDMultithreaded(
+            data, SAVESTATE_COMPRESSION_LEVEL, num_threads);
+
+        std::string error;
+        if (buffer.empty()) {
+            error = "Could not compress save state " + path;
+        } else if (FileUtil::IOFile file(path, "wb"); !file) {
+            error = "Could not open file " + path;
+        } else if (file.WriteBytes(&header, sizeof(header)) != sizeof(header) ||
+                   file.WriteBytes(buffer.data(), buffer.size()) != buffer.size()) {
+            error = "Could not write to file " + path;
+        }
+
+        if (error.empty()) {
+            LOG_INFO(Core, "Save completed");
+            return;
+        }
+        LOG_ERROR(Core, "Error saving: {}", error);
+        std::scoped_lock lock{savestate_error_mutex};
+        savestate_error = std::move(error);
+    });
 }
 
 void System::LoadState(u32 slot) {
@@ -143,39 +167,44 @@ void System::LoadState(u32 slot) {
         throw std::runtime_error("Unable to load while connected to multiplayer");
     }
 
-    const auto path = GetSaveStatePath(title_id, slot);
-
-    std::vector<u8> decompressed;
-    {
-        std::vector<u8> buffer(FileUtil::GetSize(path) - sizeof(CSTHeader));
+    // The state may still be being written to the slot
+    savestate_worker->WaitForRequests();
 
-        FileUtil::IOFile file(path, "rb");
+    const auto path = GetSaveStatePath(title_id, slot);
 
-        // load header
-        CSTHeader header;
-        if (file.ReadBytes(&header, sizeof(header)) != sizeof(header)) {
-            throw std::runtime_error("Could not read from file at " + path);
-        }
+    const FileUtil::MappedFile file(path);
+    const std::span<const u8> file_data = file.Data();
+    if (!file.IsOpen() || file_data.size() < sizeof(CSTHeader)) {
+        throw std::runtime_error("Could not read from file at " + path);
+    }
 
-        // validate header
-        SaveStateInfo info;
-        if (!ValidateSaveState(header, info, title_id, slot)) {
-            throw std::runtime_error("Invalid savestate");
-        }
+    // load header
+    CSTHeader header;
+    std::memcpy(&header, file_data.data(), sizeof(header));
 
-        if (file.ReadBytes(buffer.data(), buffer.size()) != buffer.size()) {
-            throw std::runtime_error("Could not read from file at " + path);
-        }
-        decompressed = Common::Compression::DecompressDataZSTD(buffer);
+    // validate header
+    SaveStateInfo info;
+    if (!ValidateSaveState(header, info, title_id, slot)) {
+        throw std::runtime_error("Invalid savestate");
     }
-    std::istringstream sstream{
-        std::string{reinterpret_cast<char*>(decompressed.data()), decompressed.size()},
-        std::ios_base::binary};
-    decompressed.clear();
+
+    // Decompress while deserializing instead of holding the whole state in memory
+    Common::Compression::ZSTDDecompressStreamBuffer buffer{file_data.subspan(sizeof(header))};
+    std::istream sstream{&buffer};
 
     // Deserialize
     iarchive ia{sstream};
     ia&* this;
+    if (buffer.HasFailed()) {
+        throw std::runtime_error("Could not decompress savestate at " + path);
+    }
+}
+
+bool System::Rewind(u32 frames) {
+    if (Network::GetRoomMember().lock()->IsConnected()) {
+        throw std::runtime_error("Unable to rewind while connected to multiplayer");
+    }
+    return rewind_buffer && rewind_buffer->Rewind(frames);
 }
 
 } // namespace Core
@@ -0,0 +1,33 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch2/catch_test_macros.hpp>
+#include "common/host_memory.h"
+
+TEST_CASE("HostMemory window aliases the backing memory", "[common]") {
+    Common::HostMemory memory(0x10000);
+    u8* const backing = memory.BackingBasePointer();
+    REQUIRE(backing != nullptr);
+    REQUIRE(backing[0x1234] == 0);
+
+    auto window = memory.ReserveWindow(0x100000);
+    if (!memory.SupportsWindows()) {
+        REQUIRE(window == nullptr);
+        return;
+    }
+    REQUIRE(window != nullptr);
+
+    window->Map(0x40000, 0x2000, 0x2000);
+    u8* const alias = window->BasePointer() + 0x40000;
+
+    backing[0x2010] = 0x5A;
+    REQUIRE(alias[0x10] == 0x5A);
+
+    alias[0x1020] = 0xA5;
+    REQUIRE(backing[0x3020] == 0xA5);
+
+    // Unmapping part of the range keeps the rest of the alias intact
+    window->Unmap(0x40000, 0x1000);
+    REQUIRE(alias[0x1020] == 0xA5);
+}
@@ -2,11 +2,14 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <catch2/benchmark/catch_benchmark.hpp>
 #include <catch2/catch_test_macros.hpp>
 
 #include <array>
 #include <bitset>
 #include <string>
+#include <utility>
+#include <vector>
 #include "common/file_util.h"
 #include "core/core.h"
 #include "core/core_timing.h"
@@ -196,4 +199,110 @@ TEST_CASE("CoreTiming[ChainScheduling]", "[core]") {
     REQUIRE(MAX_SLICE_LENGTH == timing.GetTimer(0)->GetDowncount());
 }
 
+namespace UnscheduleTest {
+constexpr u64 NUM_EVENTS = 4096;
+
+static s64 EventTime(u64 id) {
+    return static_cast<s64>((id * 7919) % 1000 + 1);
+}
+
+static void RunUntilEmpty(Core::Timing& timing, std::size_t core_id) {
+    auto timer = timing.GetTimer(core_id);
+    for (int slice = 0; slice < 2000; ++slice) {
+        timer->AddTicks(timer->GetDowncount());
+        timer->Advance();
+        timer->SetNextSlice();
+        if (timer->GetDowncount() == MAX_SLICE_LENGTH) {
+            break;
+        }
+    }
+}
+} // namespace UnscheduleTest
+
+TEST_CASE("CoreTiming[UnscheduleMany]", "[core]") {
+    using namespace UnscheduleTest;
+
+    Core::Timing timing(1, 100);
+
+    std::vector<std::pair<s64, u64>> fired;
+    Core::TimingEventType* cb = timing.RegisterEvent(
+        "callbackUnschedule", [&](std::uintptr_t user_data, s64 cycles_late) {
+            fired.emplace_back(timing.GetTicks() - cycles_late, user_data);
+        });
+
+    // Enter slice 0
+    timing.GetTimer(0)->Advance();
+    timing.GetTimer(0)->SetNextSlice();
+
+    for (u64 id = 0; id < NUM_EVENTS; ++id) {
+        timing.ScheduleEvent(EventTime(id), cb, id, 0);
+    }
+    // Unschedule every odd event one by one, then schedule a few of them again
+    for (u64 id = 1; id < NUM_EVENTS; id += 2) {
+        timing.UnscheduleEvent(cb, id);
+    }
+    for (u64 id = 1; id < NUM_EVENTS; id += 64) {
+        timing.ScheduleEvent(EventTime(id), cb, id, 0);
+    }
+
+    RunUntilEmpty(timing, 0);
+
+    std::vector<std::pair<s64, u64>> expected;
+    for (u64 id = 0; id < NUM_EVENTS; id += 2) {
+        expected.emplace_back(EventTime(id), id);
+    }
+    for (u64 id = 1; id < NUM_EVENTS; id += 64) {
+        expected.emplace_back(EventTime(id), id);
+    }
+    // Events with the same time fire in the order they were scheduled
+    std::stable_sort(expected.begin(), expected.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    REQUIRE(fired == expected);
+}
+
+TEST_CASE("CoreTiming[UnscheduleOtherTimer]", "[core]") {
+    using namespace UnscheduleTest;
+
+    Core::Timing timing(2, 100);
+
+    std::vector<u64> fired;
+    Core::TimingEventType* cb = timing.RegisterEvent(
+        "callbackOtherTimer", [&](std::uintptr_t user_data, s64) { fired.push_back(user_data); });
+
+    // Events for a timer other than the current one are queued thread safely. Unscheduling drops
+    // the ones queued before it, but not the ones scheduled again afterwards.
+    timing.SetCurrentTimer(0);
+    timing.ScheduleEvent(100, cb, CB_IDS[0], 1);
+    timing.ScheduleEvent(200, cb, CB_IDS[1], 1);
+    timing.ScheduleEvent(300, cb, CB_IDS[2], 1);
+    timing.UnscheduleEvent(cb, CB_IDS[0]);
+    timing.ScheduleEvent(400, cb, CB_IDS[0], 1);
+    timing.RemoveEvent(cb);
+    timing.ScheduleEvent(500, cb, CB_IDS[3], 1);
+
+    timing.SetCurrentTimer(1);
+    RunUntilEmpty(timing, 1);
+    REQUIRE(fired == std::vector<u64>{CB_IDS[3]});
+}
+
+TEST_CASE("CoreTiming benchmark", "[core][!benchmark][.]") {
+    using namespace UnscheduleTest;
+
+    Core::Timing timing(1, 100);
+    Core::TimingEventType* cb =
+        timing.RegisterEvent("callbackBenchmark", [](std::uintptr_t, s64) {});
+
+    BENCHMARK("Schedule and unschedule half") {
+        for (u64 id = 0; id < NUM_EVENTS; ++id) {
+            timing.ScheduleEvent(EventTime(id), cb, id, 0);
+        }
+        for (u64 id = 0; id < NUM_EVENTS; id += 2) {
+            timing.UnscheduleEvent(cb, id);
+        }
+        timing.RemoveEvent(cb);
+        return timing.GetTimer(0)->GetDowncount();
+    };
+}
+
 // TODO: Add tests for multiple timers
@@ -0,0 +1,104 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <random>
+#include <vector>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include "core/hw/gpu.h"
+#include "core/hw/gpu_transfer.h"
+
+using Config = GPU::Regs::DisplayTransferConfig;
+using PixelFormat = GPU::Regs::PixelFormat;
+
+// Scaled rows are 24 pixels wide, which leaves a scalar tail for most kernels
+constexpr u32 TRANSFER_WIDTH = 48;
+constexpr u32 TRANSFER_HEIGHT = 32;
+constexpr u32 BUFFER_SIZE = TRANSFER_WIDTH * TRANSFER_HEIGHT * 4;
+
+static Config MakeConfig(PixelFormat input_format, PixelFormat output_format, bool input_linear,
+                         bool dont_swizzle, Config::ScalingMode scaling, bool flip_vertically) {
+    Config config{};
+    config.input_width.Assign(TRANSFER_WIDTH);
+    config.input_height.Assign(TRANSFER_HEIGHT);
+    config.output_width.Assign(TRANSFER_WIDTH);
+    config.output_height.Assign(TRANSFER_HEIGHT);
+    config.input_format.Assign(input_format);
+    config.output_format.Assign(output_format);
+    config.input_linear.Assign(input_linear);
+    config.dont_swizzle.Assign(dont_swizzle);
+    config.scaling.Assign(scaling);
+    config.flip_vertically.Assign(flip_vertically);
+    return config;
+}
+
+TEST_CASE("DisplayTransferRows matches DisplayTransferPixels", "[core][hw][gpu]") {
+    std::mt19937 rng(TRANSFER_WIDTH);
+    std::vector<u8> source(BUFFER_SIZE);
+    std::vector<u8> initial(BUFFER_SIZE);
+    for (u8& byte : source) {
+        byte = static_cast<u8>(rng());
+    }
+    for (u8& byte : initial) {
+        byte = static_cast<u8>(rng());
+    }
+
+    for (u32 input = 0; input <= static_cast<u32>(PixelFormat::RGBA4); ++input) {
+        for (u32 output = 0; output <= static_cast<u32>(PixelFormat::RGBA4); ++output) {
+            for (u32 layout = 0; layout < 4; ++layout) {
+                for (const auto scaling : {Config::NoScale, Config::ScaleX, Config::ScaleXY}) {
+                    const bool input_linear = (layout & 1) != 0;
+                    const bool dont_swizzle = (layout & 2) != 0;
+                    if (input_linear && scaling != Config::NoScale) {
+                        // Not supported by the hardware
+                        continue;
+                    }
+                    for (const bool flip : {false, true}) {
+                        const Config config = MakeConfig(
+                            static_cast<PixelFormat>(input), static_cast<PixelFormat>(output),
+                            input_linear, dont_swizzle, scaling, flip);
+
+                        std::vector<u8> expected = initial;
+                        std::vector<u8> actual = initial;
+                        GPU::DisplayTransferPixels(config, source.data(), expected.data());
+                        REQUIRE(GPU::DisplayTransferRows(config, source.data(), actual.data()));
+                        INFO("input " << input << " output " << output << " layout " << layout
+                                      << " scaling " << scaling << " flip " << flip);
+                        REQUIRE(expected == actual);
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("DisplayTransferRows rejects overlapping buffers", "[core][hw][gpu]") {
+    std::vector<u8> buffer(BUFFER_SIZE * 2);
+    const Config config = MakeConfig(PixelFormat::RGBA8, PixelFormat::RGB8, false, false,
+                                     Config::NoScale, true);
+    REQUIRE_FALSE(GPU::DisplayTransferRows(config, buffer.data(), buffer.data() + 16));
+    REQUIRE(GPU::DisplayTransferRows(config, buffer.data(), buffer.data() + BUFFER_SIZE));
+}
+
+TEST_CASE("DisplayTransfer benchmark", "[core][hw][gpu][!benchmark][.]") {
+    // The top screen framebuffer, rotated like the 3DS stores it
+    Config config = MakeConfig(PixelFormat::RGBA8, PixelFormat::RGB8, false, false,
+                               Config::NoScale, false);
+    config.input_width.Assign(240);
+    config.input_height.Assign(400);
+    config.output_width.Assign(240);
+    config.output_height.Assign(400);
+
+    std::vector<u8> source(240 * 400 * 4, 0x5A);
+    std::vector<u8> dest(240 * 400 * 3);
+
+    BENCHMARK("Pixels") {
+        GPU::DisplayTransferPixels(config, source.data(), dest.data());
+        return dest[0];
+    };
+    BENCHMARK("Rows") {
+        GPU::DisplayTransferRows(config, source.data(), dest.data());
+        return dest[0];
+    };
+}
@@ -0,0 +1,121 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <random>
+#include <vector>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include "core/hw/y2r_convert.h"
+
+using namespace Service::Y2R;
+using HW::Y2R::ImageTile;
+
+constexpr u32 STRIP_WIDTH = 64;
+constexpr u32 NUM_TILES = STRIP_WIDTH / 8;
+
+static std::vector<u8> RandomBytes(std::mt19937& rng, std::size_t size) {
+    std::vector<u8> bytes(size);
+    for (u8& byte : bytes) {
+        byte = static_cast<u8>(rng());
+    }
+    return bytes;
+}
+
+TEST_CASE("Y2R ConvertYUVToRGB matches ConvertYUVToRGBScalar", "[core][hw][y2r]") {
+    std::mt19937 rng(STRIP_WIDTH);
+    // Enough input for the interleaved format, which reads two bytes per pixel from input_Y
+    const std::vector<u8> input_Y = RandomBytes(rng, STRIP_WIDTH * 8 * 2);
+    const std::vector<u8> input_U = RandomBytes(rng, STRIP_WIDTH * 8 / 2);
+    const std::vector<u8> input_V = RandomBytes(rng, STRIP_WIDTH * 8 / 2);
+
+    for (u32 input = 0; input <= static_cast<u32>(InputFormat::YUYV422_Interleaved); ++input) {
+        for (int i = 0; i < 16; ++i) {
+            // Random coefficients exercise the clamping and the full range of the products
+            CoefficientSet coefficients;
+            for (s16& coefficient : coefficients) {
+                coefficient = static_cast<s16>(rng() % 0x4000) - 0x2000;
+            }
+            for (const u32 height : {8U, 5U}) {
+                std::vector<ImageTile> expected(NUM_TILES, ImageTile{});
+                std::vector<ImageTile> actual(NUM_TILES, ImageTile{});
+                HW::Y2R::ConvertYUVToRGBScalar(static_cast<InputFormat>(input), input_Y.data(),
+                                               input_U.data(), input_V.data(), expected.data(),
+                                               STRIP_WIDTH, height, coefficients);
+                HW::Y2R::ConvertYUVToRGB(static_cast<InputFormat>(input), input_Y.data(),
+                                         input_U.data(), input_V.data(), actual.data(),
+                                         STRIP_WIDTH, height, coefficients);
+                INFO("input " << input << " height " << height);
+                REQUIRE(expected == actual);
+            }
+        }
+    }
+}
+
+TEST_CASE("Y2R RotateTile matches RotateTileScalar", "[core][hw][y2r]") {
+    std::mt19937 rng(NUM_TILES);
+    ImageTile input;
+    for (u32& pixel : input) {
+        pixel = static_cast<u32>(rng());
+    }
+
+    for (const auto rotation : {Rotation::None, Rotation::Clockwise_90, Rotation::Clockwise_180,
+                                Rotation::Clockwise_270}) {
+        for (const auto alignment : {BlockAlignment::Linear, BlockAlignment::Block8x8}) {
+            for (u32 height = 1; height <= 8; ++height) {
+                ImageTile expected{};
+                ImageTile actual{};
+                HW::Y2R::RotateTileScalar(rotation, alignment, input, expected, height);
+                HW::Y2R::RotateTile(rotation, alignment, input, actual, height);
+                INFO("rotation " << static_cast<u32>(rotation) << " alignment "
+                                 << static_cast<u32>(alignment) << " height " << height);
+                REQUIRE(expected == actual);
+            }
+        }
+    }
+}
+
+TEST_CASE("Y2R EncodePixels matches EncodePixelsScalar", "[core][hw][y2r]") {
+    std::mt19937 rng(STRIP_WIDTH * 8);
+    // An odd count leaves a scalar tail for every kernel
+    constexpr std::size_t count = STRIP_WIDTH * 8 - 3;
+    std::vector<u32> input(count);
+    for (u32& pixel : input) {
+        pixel = static_cast<u32>(rng()) & 0xFFFFFF00;
+    }
+
+    for (u32 output = 0; output <= static_cast<u32>(OutputFormat::RGB565); ++output) {
+        for (const u8 alpha : {u8{0x00}, u8{0x7F}, u8{0x80}, u8{0xFF}}) {
+            const auto output_format = static_cast<OutputFormat>(output);
+            std::vector<u8> expected(count * 4);
+            std::vector<u8> actual(count * 4);
+            HW::Y2R::EncodePixelsScalar(output_format, input.data(), expected.data(), count,
+                                        alpha);
+            HW::Y2R::EncodePixels(output_format, input.data(), actual.data(), count, alpha);
+            INFO("output " << output << " alpha " << static_cast<u32>(alpha));
+            REQUIRE(expected == actual);
+        }
+    }
+}
+
+TEST_CASE("Y2R conversion benchmark", "[core][hw][y2r][!benchmark][.]") {
+    // A strip of a 400 pixel wide video frame
+    constexpr u32 width = 400;
+    std::mt19937 rng(width);
+    const std::vector<u8> input_Y = RandomBytes(rng, width * 8);
+    const std::vector<u8> input_U = RandomBytes(rng, width * 8 / 2);
+    const std::vector<u8> input_V = RandomBytes(rng, width * 8 / 2);
+    const CoefficientSet coefficients{0x100, 0x166, 0xB6, 0x58, 0x1C5, -0x166F, 0x10EE, -0x1C5B};
+    std::vector<ImageTile> tiles(width / 8);
+
+    BENCHMARK("Scalar") {
+        HW::Y2R::ConvertYUVToRGBScalar(InputFormat::YUV420_Indiv8, input_Y.data(), input_U.data(),
+                                       input_V.data(), tiles.data(), width, 8, coefficients);
+        return tiles[0][0];
+    };
+    BENCHMARK("SIMD") {
+        HW::Y2R::ConvertYUVToRGB(InputFormat::YUV420_Indiv8, input_Y.data(), input_U.data(),
+                                 input_V.data(), tiles.data(), width, 8, coefficients);
+        return tiles[0][0];
+    };
+}
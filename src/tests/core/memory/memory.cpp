@@ -2,6 +2,11 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <bit>
+#include <numeric>
+#include <vector>
+#include <catch2/benchmark/catch_benchmark.hpp>
 #include <catch2/catch_test_macros.hpp>
 #include "core/core_timing.h"
 #include "core/hle/kernel/process.h"
@@ -52,3 +57,169 @@ TEST_CASE("memory.IsValidVirtualAddress", "[core][memory]") {
         CHECK(memory.IsValidVirtualAddress(*process, Memory::CONFIG_MEMORY_VADDR) == false);
     }
 }
+
+namespace {
+constexpr u32 BLOCK_TEST_SIZE = 0x100000;
+
+std::shared_ptr<Kernel::Process> CreateProcessWithHeap(Kernel::KernelSystem& kernel) {
+    auto process = kernel.CreateProcess(kernel.CreateCodeSet("", 0));
+    MemoryRef block{std::make_shared<BufferMem>(BLOCK_TEST_SIZE)};
+    const auto result = process->vm_manager.MapBackingMemory(
+        Memory::HEAP_VADDR, block, BLOCK_TEST_SIZE, Kernel::MemoryState::Private);
+    REQUIRE(result.Code() == RESULT_SUCCESS);
+    return process;
+}
+} // Anonymous namespace
+
+TEST_CASE("memory.BlockTransfers", "[core][memory]") {
+    Core::Timing timing(1, 100);
+    Memory::MemorySystem memory;
+    Kernel::KernelSystem kernel(
+        memory, timing, [] {}, 0, 1, 0);
+    auto process = CreateProcessWithHeap(kernel);
+
+    std::vector<u8> source(BLOCK_TEST_SIZE / 2);
+    std::iota(source.begin(), source.end(), u8{0});
+
+    SECTION("unaligned blocks spanning many pages round trip") {
+        const VAddr addr = Memory::HEAP_VADDR + 0x123;
+        memory.WriteBlock(*process, addr, source.data(), source.size());
+        std::vector<u8> dest(source.size());
+        memory.ReadBlock(*process, addr, dest.data(), dest.size());
+        CHECK(dest == source);
+    }
+
+    SECTION("copies and zeroes span page boundaries") {
+        const VAddr src_addr = Memory::HEAP_VADDR + 0x10;
+        const VAddr dest_addr = Memory::HEAP_VADDR + BLOCK_TEST_SIZE / 2 + 0x20;
+        memory.WriteBlock(*process, src_addr, source.data(), source.size() - 0x40);
+        memory.CopyBlock(*process, dest_addr, src_addr, source.size() - 0x40);
+        std::vector<u8> dest(source.size() - 0x40);
+        memory.ReadBlock(*process, dest_addr, dest.data(), dest.size());
+        CHECK(std::equal(dest.begin(), dest.end(), source.begin()));
+
+        memory.ZeroBlock(*process, dest_addr, dest.size());
+        memory.ReadBlock(*process, dest_addr, dest.data(), dest.size());
+        CHECK(std::all_of(dest.begin(), dest.end(), [](u8 value) { return value == 0; }));
+    }
+
+    SECTION("reads past the mapping are zero filled") {
+        const VAddr addr = Memory::HEAP_VADDR + BLOCK_TEST_SIZE - 0x800;
+        std::vector<u8> dest(0x2000, 0xFF);
+        memory.ReadBlock(*process, addr, dest.data(), dest.size());
+        CHECK(std::all_of(dest.begin() + 0x800, dest.end(), [](u8 value) { return value == 0; }));
+    }
+}
+
+TEST_CASE("memory.BlockTransfers benchmark", "[core][memory][!benchmark][.]") {
+    Core::Timing timing(1, 100);
+    Memory::MemorySystem memory;
+    Kernel::KernelSystem kernel(
+        memory, timing, [] {}, 0, 1, 0);
+    auto process = CreateProcessWithHeap(kernel);
+
+    std::vector<u8> buffer(BLOCK_TEST_SIZE / 2);
+    const VAddr src_addr = Memory::HEAP_VADDR;
+    const VAddr dest_addr = Memory::HEAP_VADDR + BLOCK_TEST_SIZE / 2;
+
+    BENCHMARK("ReadBlock 512 KiB") {
+        memory.ReadBlock(*process, src_addr, buffer.data(), buffer.size());
+        return buffer[0];
+    };
+    BENCHMARK("WriteBlock 512 KiB") {
+        memory.WriteBlock(*process, dest_addr, buffer.data(), buffer.size());
+    };
+    BENCHMARK("CopyBlock 512 KiB") {
+        memory.CopyBlock(*process, dest_addr, src_addr, buffer.size());
+    };
+}
+
+TEST_CASE("memory.DirtyPageTracking", "[core][memory]") {
+    Core::Timing timing(1, 100);
+    Memory::MemorySystem memory;
+    Kernel::KernelSystem kernel(
+        memory, timing, [] {}, 0, 1, 0);
+    auto process = kernel.CreateProcess(kernel.CreateCodeSet("", 0));
+    constexpr u32 fcram_offset = 4 * Memory::CITRA_PAGE_SIZE;
+    const auto result = process->vm_manager.MapBackingMemory(
+        Memory::HEAP_VADDR, memory.GetFCRAMRef(fcram_offset), BLOCK_TEST_SIZE,
+        Kernel::MemoryState::Private);
+    REQUIRE(result.Code() == RESULT_SUCCESS);
+    memory.SetCurrentPageTable(process->vm_manager.page_table);
+
+    const auto count_dirty = [](const Memory::DirtyPageBitmap& bitmap) {
+        std::size_t count = 0;
+        for (const u64 word : bitmap) {
+            count += std::popcount(word);
+        }
+        return count;
+    };
+    // Bit of the page of FCRAM mapped at HEAP_VADDR + page * CITRA_PAGE_SIZE
+    const auto heap_page_bit = [&](u32 page) {
+        return 1ULL << (fcram_offset / Memory::CITRA_PAGE_SIZE + page);
+    };
+
+    CHECK(memory.SnapshotDirtyPages(Memory::Region::FCRAM).empty());
+
+    memory.SetDirtyPageTracking(true);
+    const auto initial = memory.SnapshotDirtyPages(Memory::Region::FCRAM);
+    CHECK(count_dirty(initial) == Memory::FCRAM_N3DS_SIZE / Memory::CITRA_PAGE_SIZE);
+    CHECK(count_dirty(memory.SnapshotDirtyPages(Memory::Region::FCRAM)) == 0);
+
+    SECTION("block writes mark every page they touch") {
+        const std::vector<u8> data(0x2000, 0xAB);
+        memory.WriteBlock(*process, Memory::HEAP_VADDR + 0x800, data.data(), data.size());
+        const auto dirty = memory.SnapshotDirtyPages(Memory::Region::FCRAM);
+        CHECK(count_dirty(dirty) == 3);
+        CHECK(dirty[0] == (heap_page_bit(0) | heap_page_bit(1) | heap_page_bit(2)));
+        CHECK(count_dirty(memory.SnapshotDirtyPages(Memory::Region::FCRAM)) == 0);
+    }
+
+    SECTION("zeroes and copies mark the destination only") {
+        memory.ZeroBlock(*process, Memory::HEAP_VADDR, Memory::CITRA_PAGE_SIZE);
+        CHECK(memory.SnapshotDirtyPages(Memory::Region::FCRAM)[0] == heap_page_bit(0));
+
+        memory.CopyBlock(*process, Memory::HEAP_VADDR + 5 * Memory::CITRA_PAGE_SIZE,
+                         Memory::HEAP_VADDR, Memory::CITRA_PAGE_SIZE);
+        CHECK(memory.SnapshotDirtyPages(Memory::Region::FCRAM)[0] == heap_page_bit(5));
+    }
+
+    SECTION("single writes mark their page") {
+        memory.Write8(Memory::HEAP_VADDR + 3 * Memory::CITRA_PAGE_SIZE, 1);
+        memory.Write32(Memory::HEAP_VADDR + 7 * Memory::CITRA_PAGE_SIZE + 4, 2);
+        CHECK(memory.WriteExclusive64(Memory::HEAP_VADDR + 9 * Memory::CITRA_PAGE_SIZE, 3, 0));
+        CHECK(memory.SnapshotDirtyPages(Memory::Region::FCRAM)[0] ==
+              (heap_page_bit(3) | heap_page_bit(7) | heap_page_bit(9)));
+
+        // The write lifted the write protection of the page in the fastmem window
+        const auto& page_table = *process->vm_manager.page_table;
+        if (page_table.fastmem_base) {
+            page_table.fastmem_base[Memory::HEAP_VADDR + 3 * Memory::CITRA_PAGE_SIZE] = 4;
+            CHECK(memory.Read8(Memory::HEAP_VADDR + 3 * Memory::CITRA_PAGE_SIZE) == 4);
+        }
+    }
+
+    SECTION("raw pointer writers report their writes") {
+        memory.MarkRegionDirty(Memory::FCRAM_PADDR + fcram_offset + 0xFFF, 2);
+        memory.MarkRegionDirty(memory.GetFCRAMPointer(fcram_offset + 6 * Memory::CITRA_PAGE_SIZE),
+                               Memory::CITRA_PAGE_SIZE);
+        CHECK(memory.SnapshotDirtyPages(Memory::Region::FCRAM)[0] ==
+              (heap_page_bit(0) | heap_page_bit(1) | heap_page_bit(6)));
+
+        memory.SnapshotDirtyPages(Memory::Region::VRAM);
+        memory.MarkRegionDirty(Memory::VRAM_PADDR + Memory::CITRA_PAGE_SIZE, 1);
+        CHECK(memory.SnapshotDirtyPages(Memory::Region::VRAM)[0] == 0b10);
+    }
+
+    SECTION("other regions are not affected") {
+        memory.ZeroBlock(*process, Memory::HEAP_VADDR, Memory::CITRA_PAGE_SIZE);
+        CHECK(count_dirty(memory.SnapshotDirtyPages(Memory::Region::VRAM)) ==
+              Memory::VRAM_SIZE / Memory::CITRA_PAGE_SIZE);
+        CHECK(count_dirty(memory.SnapshotDirtyPages(Memory::Region::FCRAM)) == 1);
+    }
+
+    SECTION("disabling tracking drops the bitmap") {
+        memory.SetDirtyPageTracking(false);
+        CHECK(memory.SnapshotDirtyPages(Memory::Region::FCRAM).empty());
+    }
+}
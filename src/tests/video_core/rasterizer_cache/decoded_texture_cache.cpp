@@ -0,0 +1,45 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include "video_core/rasterizer_cache/decoded_texture_cache.h"
+
+using VideoCore::DecodedTextureCache;
+
+TEST_CASE("DecodedTextureCache evicts least recently used", "[video_core][rasterizer_cache]") {
+    DecodedTextureCache cache{8};
+    const std::vector<u8> a(4, 0xAA);
+    const std::vector<u8> b(4, 0xBB);
+    const std::vector<u8> c(4, 0xCC);
+    std::vector<u8> out(4);
+
+    cache.Insert(1, a);
+    cache.Insert(2, b);
+    REQUIRE(cache.Lookup(1, out));
+    REQUIRE(out == a);
+
+    // Key 2 is now the least recently used entry and makes room for key 3
+    cache.Insert(3, c);
+    REQUIRE(!cache.Lookup(2, out));
+    REQUIRE(cache.Lookup(1, out));
+    REQUIRE(cache.Lookup(3, out));
+    REQUIRE(out == c);
+
+    // Lookups with a different size than the cached data miss
+    std::vector<u8> small(2);
+    REQUIRE(!cache.Lookup(1, small));
+
+    // Data larger than the budget is never cached
+    cache.Insert(4, std::vector<u8>(16));
+    REQUIRE(!cache.Lookup(4, out));
+
+    cache.SetBudget(4);
+    REQUIRE(cache.Lookup(3, out));
+    REQUIRE(!cache.Lookup(1, out));
+
+    cache.SetBudget(0);
+    REQUIRE(!cache.IsEnabled());
+    REQUIRE(!cache.Lookup(3, out));
+}
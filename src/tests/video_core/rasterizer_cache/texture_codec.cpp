@@ -0,0 +1,110 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include "video_core/rasterizer_cache/morton_swizzle.h"
+#include "video_core/rasterizer_cache/texture_codec.h"
+
+using VideoCore::PixelFormat;
+
+// Linear buffers are two tiles wide to check that the stride is honored
+constexpr u32 LINEAR_WIDTH = 16;
+
+template <bool morton_to_linear, PixelFormat format, bool converted>
+static void CheckMortonTileFunc() {
+    const auto copy_tile_simd = VideoCore::GetMortonTileFunc(morton_to_linear, format, converted);
+    if (!copy_tile_simd) {
+        return;
+    }
+
+    constexpr u32 tile_size = VideoCore::GetFormatBpp(format) * 64 / 8;
+    constexpr u32 linear_bytes_per_pixel = converted ? 4 : VideoCore::GetFormatBytesPerPixel(format);
+
+    std::mt19937 rng(static_cast<u32>(format));
+    std::vector<u8> tile(tile_size);
+    std::vector<u8> linear(LINEAR_WIDTH * 8 * linear_bytes_per_pixel);
+    for (u8& byte : tile) {
+        byte = static_cast<u8>(rng());
+    }
+    for (u8& byte : linear) {
+        byte = static_cast<u8>(rng());
+    }
+
+    std::vector<u8> expected_tile = tile;
+    std::vector<u8> expected_linear = linear;
+    VideoCore::MortonCopyTile<morton_to_linear, format, converted>(LINEAR_WIDTH, expected_tile,
+                                                                   expected_linear);
+    copy_tile_simd(LINEAR_WIDTH, tile.data(), linear.data());
+
+    REQUIRE(tile == expected_tile);
+    REQUIRE(linear == expected_linear);
+}
+
+template <PixelFormat format>
+static void CheckMortonTileFuncs() {
+    CheckMortonTileFunc<true, format, false>();
+    CheckMortonTileFunc<false, format, false>();
+    CheckMortonTileFunc<true, format, true>();
+    CheckMortonTileFunc<false, format, true>();
+}
+
+TEST_CASE("MortonTileFunc", "[video_core][rasterizer_cache]") {
+    CheckMortonTileFuncs<PixelFormat::RGBA8>();
+    CheckMortonTileFuncs<PixelFormat::RGB8>();
+    CheckMortonTileFuncs<PixelFormat::RGB5A1>();
+    CheckMortonTileFuncs<PixelFormat::RGB565>();
+    CheckMortonTileFuncs<PixelFormat::RGBA4>();
+    CheckMortonTileFuncs<PixelFormat::D16>();
+    CheckMortonTileFuncs<PixelFormat::D24S8>();
+}
+
+template <bool morton_to_linear, PixelFormat format, bool converted>
+static void BenchmarkMortonTileFunc(const char* name) {
+    const auto copy_tile_simd = VideoCore::GetMortonTileFunc(morton_to_linear, format, converted);
+    if (!copy_tile_simd) {
+        return;
+    }
+
+    constexpr u32 tile_size = VideoCore::GetFormatBpp(format) * 64 / 8;
+    constexpr u32 linear_bytes_per_pixel = converted ? 4 : VideoCore::GetFormatBytesPerPixel(format);
+    constexpr u32 num_tiles = LINEAR_WIDTH / 8;
+
+    std::vector<u8> tiled(tile_size * num_tiles);
+    std::vector<u8> linear(LINEAR_WIDTH * 8 * linear_bytes_per_pixel);
+    const auto linear_tile = [&](u32 tile) {
+        return std::span{linear}.subspan(tile * 8 * linear_bytes_per_pixel);
+    };
+
+    BENCHMARK(std::string(name) + " scalar") {
+        for (u32 tile = 0; tile < num_tiles; ++tile) {
+            VideoCore::MortonCopyTile<morton_to_linear, format, converted>(
+                LINEAR_WIDTH, std::span{tiled}.subspan(tile * tile_size, tile_size),
+                linear_tile(tile));
+        }
+        return linear[0] + tiled[0];
+    };
+    BENCHMARK(std::string(name) + " simd") {
+        for (u32 tile = 0; tile < num_tiles; ++tile) {
+            copy_tile_simd(LINEAR_WIDTH, tiled.data() + tile * tile_size,
+                           linear_tile(tile).data());
+        }
+        return linear[0] + tiled[0];
+    };
+}
+
+TEST_CASE("MortonTileFunc benchmark", "[video_core][rasterizer_cache][!benchmark][.]") {
+    BenchmarkMortonTileFunc<true, PixelFormat::RGBA8, false>("unswizzle RGBA8");
+    BenchmarkMortonTileFunc<true, PixelFormat::RGBA8, true>("unswizzle RGBA8 converted");
+    BenchmarkMortonTileFunc<false, PixelFormat::RGBA8, true>("swizzle RGBA8 converted");
+    BenchmarkMortonTileFunc<true, PixelFormat::RGB8, true>("unswizzle RGB8 converted");
+    BenchmarkMortonTileFunc<true, PixelFormat::RGB565, false>("unswizzle RGB565");
+    BenchmarkMortonTileFunc<false, PixelFormat::RGB565, false>("swizzle RGB565");
+    BenchmarkMortonTileFunc<true, PixelFormat::D24S8, false>("unswizzle D24S8");
+}
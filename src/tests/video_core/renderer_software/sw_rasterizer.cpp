@@ -0,0 +1,151 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include "common/settings.h"
+#include "core/memory.h"
+#include "video_core/pica_state.h"
+#include "video_core/renderer_software/sw_rasterizer.h"
+#include "video_core/shader/shader.h"
+
+using Pica::f24;
+using Pica::FramebufferRegs;
+
+namespace {
+
+constexpr u32 FB_WIDTH = 256;
+constexpr u32 FB_HEIGHT = 256;
+constexpr PAddr COLOR_ADDR = Memory::VRAM_PADDR;
+constexpr PAddr DEPTH_ADDR = COLOR_ADDR + FB_WIDTH * FB_HEIGHT * 4;
+
+/// Converts a normal float to the raw value of the equivalent float24 register.
+u32 ToFloat24Raw(float value) {
+    u32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const u32 sign = bits >> 31;
+    const u32 exponent = ((bits >> 23) & 0xFF) - 127 + 63;
+    const u32 mantissa = (bits >> 7) & 0xFFFF;
+    return value == 0.0f ? 0 : (sign << 23) | (exponent << 16) | mantissa;
+}
+
+/// Configures a RGBA8 color and D24S8 depth stencil target with blending and depth and stencil
+/// tests that depend on the order the pixels are written in.
+void SetupRegs(Pica::Regs& regs) {
+    regs.reg_array.fill(0);
+
+    auto& rasterizer = regs.rasterizer;
+    rasterizer.cull_mode.Assign(Pica::RasterizerRegs::CullMode::KeepAll);
+    rasterizer.viewport_size_x.Assign(ToFloat24Raw(FB_WIDTH / 2.0f));
+    rasterizer.viewport_size_y.Assign(ToFloat24Raw(FB_HEIGHT / 2.0f));
+    rasterizer.viewport_depth_range.Assign(ToFloat24Raw(-1.0f));
+    rasterizer.viewport_depth_near_plane.Assign(0);
+
+    regs.lighting.disable.Assign(1);
+
+    auto& framebuffer = regs.framebuffer.framebuffer;
+    framebuffer.allow_color_write.Assign(0xF);
+    framebuffer.allow_depth_stencil_write.Assign(0x3);
+    framebuffer.color_format.Assign(FramebufferRegs::ColorFormat::RGBA8);
+    framebuffer.depth_format.Assign(FramebufferRegs::DepthFormat::D24S8);
+    framebuffer.color_buffer_address.Assign(COLOR_ADDR / 8);
+    framebuffer.depth_buffer_address.Assign(DEPTH_ADDR / 8);
+    framebuffer.width.Assign(FB_WIDTH);
+    framebuffer.height.Assign(FB_HEIGHT - 1);
+
+    auto& output_merger = regs.framebuffer.output_merger;
+    output_merger.alphablend_enable.Assign(1);
+    auto& blending = output_merger.alpha_blending;
+    blending.factor_source_rgb.Assign(FramebufferRegs::BlendFactor::SourceAlpha);
+    blending.factor_dest_rgb.Assign(FramebufferRegs::BlendFactor::OneMinusSourceAlpha);
+    blending.factor_source_a.Assign(FramebufferRegs::BlendFactor::One);
+    blending.factor_dest_a.Assign(FramebufferRegs::BlendFactor::Zero);
+    output_merger.red_enable.Assign(1);
+    output_merger.green_enable.Assign(1);
+    output_merger.blue_enable.Assign(1);
+    output_merger.alpha_enable.Assign(1);
+    output_merger.depth_test_enable.Assign(1);
+    output_merger.depth_test_func.Assign(FramebufferRegs::CompareFunc::LessThanOrEqual);
+    output_merger.depth_write_enable.Assign(1);
+
+    auto& stencil_test = output_merger.stencil_test;
+    stencil_test.enable.Assign(1);
+    stencil_test.func.Assign(FramebufferRegs::CompareFunc::NotEqual);
+    stencil_test.reference_value.Assign(3);
+    stencil_test.input_mask.Assign(0xFF);
+    stencil_test.write_mask.Assign(0xFF);
+    stencil_test.action_depth_fail.Assign(FramebufferRegs::StencilAction::Invert);
+    stencil_test.action_depth_pass.Assign(FramebufferRegs::StencilAction::IncrementWrap);
+}
+
+/// Random vertex, partly outside of the view volume to exercise clipping.
+Pica::Shader::OutputVertex MakeVertex(std::mt19937& rng) {
+    std::uniform_real_distribution<float> position(-1.2f, 1.2f);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::uniform_real_distribution<float> w_dist(0.5f, 2.0f);
+
+    Pica::Shader::OutputVertex vertex{};
+    const float w = w_dist(rng);
+    vertex.pos = {f24::FromFloat32(position(rng) * w), f24::FromFloat32(position(rng) * w),
+                  f24::FromFloat32(-unit(rng) * w), f24::FromFloat32(w)};
+    vertex.color = {f24::FromFloat32(unit(rng)), f24::FromFloat32(unit(rng)),
+                    f24::FromFloat32(unit(rng)), f24::FromFloat32(unit(rng))};
+    return vertex;
+}
+
+/// Renders the same draws with the given number of rasterizer threads and returns the color and
+/// depth stencil buffers.
+std::vector<u8> RenderDraws(Memory::MemorySystem& memory, u32 num_threads) {
+    constexpr std::size_t buffers_size = FB_WIDTH * FB_HEIGHT * (4 + 4);
+    u8* const buffers = memory.GetPhysicalPointer(COLOR_ADDR);
+    std::memset(buffers, 0, buffers_size);
+
+    Settings::values.sw_rasterizer_threads.SetValue(num_threads);
+    auto& regs = Pica::g_state.regs;
+    SetupRegs(regs);
+    SwRenderer::RasterizerSoftware rasterizer{memory};
+
+    std::mt19937 rng{1234};
+    constexpr std::array depth_funcs = {
+        FramebufferRegs::CompareFunc::LessThanOrEqual,
+        FramebufferRegs::CompareFunc::Always,
+        FramebufferRegs::CompareFunc::GreaterThan,
+    };
+    for (const auto depth_func : depth_funcs) {
+        regs.framebuffer.output_merger.depth_test_func.Assign(depth_func);
+        for (u32 i = 0; i < 200; i++) {
+            rasterizer.AddTriangle(MakeVertex(rng), MakeVertex(rng), MakeVertex(rng));
+        }
+        rasterizer.DrawTriangles();
+    }
+
+    return std::vector<u8>(buffers, buffers + buffers_size);
+}
+
+} // Anonymous namespace
+
+TEST_CASE("RasterizerSoftware threads match the serial output",
+          "[video_core][renderer_software]") {
+    Memory::MemorySystem memory;
+    const u32 previous_threads = Settings::values.sw_rasterizer_threads.GetValue();
+
+    const auto serial = RenderDraws(memory, 1);
+    // Guard against comparing two blank outputs
+    const auto num_zeroes = std::count(serial.begin(), serial.end(), u8{0});
+    REQUIRE(static_cast<std::size_t>(num_zeroes) < serial.size() / 2);
+
+    for (const u32 num_threads : {2U, 4U}) {
+        const auto threaded = RenderDraws(memory, num_threads);
+        constexpr std::size_t color_size = FB_WIDTH * FB_HEIGHT * 4;
+        CHECK(std::equal(serial.begin(), serial.begin() + color_size, threaded.begin()));
+        CHECK(std::equal(serial.begin() + color_size, serial.end(), threaded.begin() + color_size));
+    }
+
+    Settings::values.sw_rasterizer_threads.SetValue(previous_threads);
+    Pica::g_state.regs.reg_array.fill(0);
+}
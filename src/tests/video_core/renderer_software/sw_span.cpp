@@ -0,0 +1,333 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <catch2/catch_test_macros.hpp>
+#include "video_core/renderer_software/sw_clipper.h"
+#include "video_core/renderer_software/sw_span.h"
+
+using Pica::f24;
+using Pica::FramebufferRegs;
+using SwRenderer::Fix12P4;
+using SwRenderer::SPAN_PIXELS;
+
+namespace {
+
+/// Size of a screen tile of the binned rasterizer in 12.4 fixed point (32x32 pixels).
+constexpr u32 TILE_SIZE = 0x200;
+
+/// Triangle in 12.4 fixed point screen coordinates, wound counter-clockwise.
+struct ScreenTriangle {
+    std::array<Common::Vec2<Fix12P4>, 3> pos;
+    std::array<s32, 3> bias;
+};
+
+/// Returns a coordinate on or close to a tile border, or anywhere in the first tiles.
+u16 MakeCoordinate(std::mt19937& rng) {
+    std::uniform_int_distribution<u32> border(1, 3);
+    std::uniform_int_distribution<s32> offset(-0x18, 0x18);
+    std::uniform_int_distribution<u32> anywhere(0, 4 * TILE_SIZE);
+    if (rng() % 2 == 0) {
+        return static_cast<u16>(border(rng) * TILE_SIZE + offset(rng));
+    }
+    return static_cast<u16>(anywhere(rng));
+}
+
+ScreenTriangle MakeTriangle(std::mt19937& rng) {
+    ScreenTriangle triangle;
+    do {
+        for (auto& pos : triangle.pos) {
+            pos = {Fix12P4{MakeCoordinate(rng)}, Fix12P4{MakeCoordinate(rng)}};
+        }
+        if (SwRenderer::SignedArea(triangle.pos[0], triangle.pos[1], triangle.pos[2]) < 0) {
+            std::swap(triangle.pos[1], triangle.pos[2]);
+        }
+    } while (SwRenderer::SignedArea(triangle.pos[0], triangle.pos[1], triangle.pos[2]) == 0);
+
+    for (u32 i = 0; i < 3; i++) {
+        const auto& v0 = triangle.pos[i];
+        const auto& v1 = triangle.pos[(i + 1) % 3];
+        const auto& v2 = triangle.pos[(i + 2) % 3];
+        triangle.bias[i] = SwRenderer::IsRightSideOrFlatBottomEdge(v0, v1, v2) ? -1 : 0;
+    }
+    return triangle;
+}
+
+/// Edge function values of a pixel center, computed like the serial rasterizer does.
+std::array<s32, 3> EdgeValues(const ScreenTriangle& triangle, u32 x, u32 y) {
+    const Common::Vec2<Fix12P4> pixel{static_cast<u16>(x), static_cast<u16>(y)};
+    const auto& pos = triangle.pos;
+    return {
+        triangle.bias[0] + SwRenderer::SignedArea(pos[1], pos[2], pixel),
+        triangle.bias[1] + SwRenderer::SignedArea(pos[2], pos[0], pixel),
+        triangle.bias[2] + SwRenderer::SignedArea(pos[0], pos[1], pixel),
+    };
+}
+
+/// Per pixel increments of the edge functions along the x axis.
+std::array<s32, 3> EdgeSteps(const ScreenTriangle& triangle) {
+    const auto& pos = triangle.pos;
+    const auto step = [](const auto& a, const auto& b) {
+        return (static_cast<s32>(a.y) - static_cast<s32>(b.y)) * 0x10;
+    };
+    return {step(pos[1], pos[2]), step(pos[2], pos[0]), step(pos[0], pos[1])};
+}
+
+f24 RandomF24(std::mt19937& rng, float min, float max) {
+    return f24::FromFloat32(std::uniform_real_distribution<float>(min, max)(rng));
+}
+
+SwRenderer::Vertex MakeVertex(std::mt19937& rng) {
+    Pica::Shader::OutputVertex output{};
+    // Values after the perspective divide, pos.w holds the inverse w.
+    output.pos.w = RandomF24(rng, 0.1f, 4.0f);
+    for (u32 i = 0; i < 4; i++) {
+        output.quat[i] = RandomF24(rng, -2.0f, 2.0f);
+        output.color[i] = RandomF24(rng, -2.0f, 2.0f);
+    }
+    for (u32 i = 0; i < 2; i++) {
+        output.tc0[i] = RandomF24(rng, -2.0f, 2.0f);
+        output.tc1[i] = RandomF24(rng, -2.0f, 2.0f);
+        output.tc2[i] = RandomF24(rng, -2.0f, 2.0f);
+    }
+    output.tc0_w = RandomF24(rng, -2.0f, 2.0f);
+    for (u32 i = 0; i < 3; i++) {
+        output.view[i] = RandomF24(rng, -2.0f, 2.0f);
+    }
+
+    SwRenderer::Vertex vertex{output};
+    vertex.screenpos[2] = RandomF24(rng, -1.0f, 0.0f);
+    return vertex;
+}
+
+/// Depth and attributes of a pixel, computed like the serial rasterizer does.
+SwRenderer::SpanValues InterpolatePixel(const std::array<SwRenderer::Vertex, 3>& vertices,
+                                        const std::array<s32, 3>& w, float depth_scale,
+                                        float depth_offset, bool w_buffer) {
+    const auto& [v0, v1, v2] = vertices;
+    const s32 wsum = w[0] + w[1] + w[2];
+    const auto baricentric_coordinates = Common::MakeVec(f24::FromFloat32(static_cast<f32>(w[0])),
+                                                         f24::FromFloat32(static_cast<f32>(w[1])),
+                                                         f24::FromFloat32(static_cast<f32>(w[2])));
+    const auto w_inverse = Common::MakeVec(v0.pos.w, v1.pos.w, v2.pos.w);
+    const f24 interpolated_w_inverse = f24::One() / Common::Dot(w_inverse, baricentric_coordinates);
+
+    const float interpolated_z_over_w =
+        (v0.screenpos[2].ToFloat32() * w[0] + v1.screenpos[2].ToFloat32() * w[1] +
+         v2.screenpos[2].ToFloat32() * w[2]) /
+        wsum;
+    float depth = interpolated_z_over_w * depth_scale + depth_offset;
+    if (w_buffer) {
+        depth *= interpolated_w_inverse.ToFloat32() * wsum;
+    }
+
+    SwRenderer::SpanValues values{};
+    values.depth[0] = std::clamp(depth, 0.0f, 1.0f);
+
+    const auto interpolate = [&](auto get) {
+        const auto attr_over_w = Common::MakeVec(get(v0), get(v1), get(v2));
+        const f24 interpolated_attr_over_w = Common::Dot(attr_over_w, baricentric_coordinates);
+        return (interpolated_attr_over_w * interpolated_w_inverse).ToFloat32();
+    };
+    const std::array<f24 (*)(const SwRenderer::Vertex&), SwRenderer::NumSpanAttributes> getters = {
+        [](const SwRenderer::Vertex& v) { return v.color.r(); },
+        [](const SwRenderer::Vertex& v) { return v.color.g(); },
+        [](const SwRenderer::Vertex& v) { return v.color.b(); },
+        [](const SwRenderer::Vertex& v) { return v.color.a(); },
+        [](const SwRenderer::Vertex& v) { return v.tc0.u(); },
+        [](const SwRenderer::Vertex& v) { return v.tc0.v(); },
+        [](const SwRenderer::Vertex& v) { return v.tc1.u(); },
+        [](const SwRenderer::Vertex& v) { return v.tc1.v(); },
+        [](const SwRenderer::Vertex& v) { return v.tc2.u(); },
+        [](const SwRenderer::Vertex& v) { return v.tc2.v(); },
+        [](const SwRenderer::Vertex& v) { return v.tc0_w; },
+        [](const SwRenderer::Vertex& v) { return v.quat.x; },
+        [](const SwRenderer::Vertex& v) { return v.quat.y; },
+        [](const SwRenderer::Vertex& v) { return v.quat.z; },
+        [](const SwRenderer::Vertex& v) { return v.quat.w; },
+        [](const SwRenderer::Vertex& v) { return v.view.x; },
+        [](const SwRenderer::Vertex& v) { return v.view.y; },
+        [](const SwRenderer::Vertex& v) { return v.view.z; },
+    };
+    for (u32 attr = 0; attr < SwRenderer::NumSpanAttributes; attr++) {
+        values.attributes[attr][0] = interpolate(getters[attr]);
+    }
+    return values;
+}
+
+bool CompareScalar(FramebufferRegs::CompareFunc func, u32 a, u32 b) {
+    switch (func) {
+    case FramebufferRegs::CompareFunc::Never:
+        return false;
+    case FramebufferRegs::CompareFunc::Always:
+        return true;
+    case FramebufferRegs::CompareFunc::Equal:
+        return a == b;
+    case FramebufferRegs::CompareFunc::NotEqual:
+        return a != b;
+    case FramebufferRegs::CompareFunc::LessThan:
+        return a < b;
+    case FramebufferRegs::CompareFunc::LessThanOrEqual:
+        return a <= b;
+    case FramebufferRegs::CompareFunc::GreaterThan:
+        return a > b;
+    case FramebufferRegs::CompareFunc::GreaterThanOrEqual:
+        return a >= b;
+    }
+    return false;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("EdgeSpan coverage matches the per pixel edge test", "[video_core][renderer_software]") {
+    std::mt19937 rng{1};
+    for (u32 i = 0; i < 500; i++) {
+        const ScreenTriangle triangle = MakeTriangle(rng);
+        const auto& pos = triangle.pos;
+        const u32 min_x = std::min({pos[0].x, pos[1].x, pos[2].x}) & Fix12P4::IntMask();
+        const u32 min_y = std::min({pos[0].y, pos[1].y, pos[2].y}) & Fix12P4::IntMask();
+        const u32 max_x =
+            (std::max({pos[0].x, pos[1].x, pos[2].x}) + Fix12P4::FracMask()) & Fix12P4::IntMask();
+        const u32 max_y =
+            (std::max({pos[0].y, pos[1].y, pos[2].y}) + Fix12P4::FracMask()) & Fix12P4::IntMask();
+        const auto w_step = EdgeSteps(triangle);
+
+        // Walk the triangle tile by tile like the binned rasterizer, so that spans start at the
+        // tile borders and get cut by them.
+        for (u32 tile_y = min_y / TILE_SIZE * TILE_SIZE; tile_y < max_y; tile_y += TILE_SIZE) {
+            for (u32 tile_x = min_x / TILE_SIZE * TILE_SIZE; tile_x < max_x; tile_x += TILE_SIZE) {
+                const u32 x0 = std::max(min_x, tile_x);
+                const u32 x1 = std::min(max_x, tile_x + TILE_SIZE);
+                const u32 y1 = std::min(max_y, tile_y + TILE_SIZE);
+                for (u32 y = std::max(min_y, tile_y) + 8; y < y1; y += 0x10) {
+                    SwRenderer::EdgeSpan span{EdgeValues(triangle, x0 + 8, y), w_step};
+                    for (u32 span_x = x0 + 8; span_x < x1; span_x += 0x10 * SPAN_PIXELS) {
+                        u32 coverage = span.NextCoverage();
+                        const u32 remaining = (x1 - span_x + Fix12P4::FracMask()) >> 4;
+                        if (remaining < SPAN_PIXELS) {
+                            coverage &= (1U << remaining) - 1;
+                        }
+
+                        u32 expected = 0;
+                        for (u32 lane = 0; lane < SPAN_PIXELS; lane++) {
+                            const u32 x = span_x + lane * 0x10;
+                            const auto w = EdgeValues(triangle, x, y);
+                            if (x < x1 && w[0] >= 0 && w[1] >= 0 && w[2] >= 0) {
+                                expected |= 1U << lane;
+                            }
+                        }
+                        REQUIRE(coverage == expected);
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("SpanInterpolator matches the per pixel interpolation",
+          "[video_core][renderer_software]") {
+    std::mt19937 rng{2};
+    for (u32 i = 0; i < 200; i++) {
+        const ScreenTriangle triangle = MakeTriangle(rng);
+        const std::array<SwRenderer::Vertex, 3> vertices{MakeVertex(rng), MakeVertex(rng),
+                                                         MakeVertex(rng)};
+        const bool w_buffer = i % 2 == 1;
+        const bool lighting = i % 4 >= 2;
+        const float depth_scale = RandomF24(rng, -2.0f, 0.0f).ToFloat32();
+        const float depth_offset = RandomF24(rng, 0.0f, 0.5f).ToFloat32();
+        const SwRenderer::SpanInterpolator interpolator{vertices, depth_scale, depth_offset,
+                                                        w_buffer, lighting};
+        const u32 num_attributes = lighting ? SwRenderer::NumSpanAttributes : SwRenderer::QuatX;
+
+        const auto& pos = triangle.pos;
+        const u32 min_x = std::min({pos[0].x, pos[1].x, pos[2].x}) & Fix12P4::IntMask();
+        const u32 min_y = std::min({pos[0].y, pos[1].y, pos[2].y}) & Fix12P4::IntMask();
+        const u32 max_x = std::max({pos[0].x, pos[1].x, pos[2].x});
+        const u32 max_y = std::max({pos[0].y, pos[1].y, pos[2].y});
+        const auto w_step = EdgeSteps(triangle);
+
+        SwRenderer::SpanValues values;
+        for (u32 y = min_y + 8; y < max_y; y += 0x10) {
+            const auto row_w = EdgeValues(triangle, min_x + 8, y);
+            for (u32 span_x = min_x + 8; span_x < max_x; span_x += 0x10 * SPAN_PIXELS) {
+                const s32 column = static_cast<s32>((span_x - min_x) >> 4);
+                interpolator.Interpolate(row_w, w_step, column, values);
+
+                for (u32 lane = 0; lane < SPAN_PIXELS; lane++) {
+                    const auto w = EdgeValues(triangle, span_x + lane * 0x10, y);
+                    if (w[0] < 0 || w[1] < 0 || w[2] < 0) {
+                        continue;
+                    }
+                    const auto expected =
+                        InterpolatePixel(vertices, w, depth_scale, depth_offset, w_buffer);
+                    REQUIRE(values.depth[lane] == expected.depth[0]);
+                    for (u32 attr = 0; attr < num_attributes; attr++) {
+                        REQUIRE(values.attributes[attr][lane] == expected.attributes[attr][0]);
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("Span depth tests match the per pixel depth test", "[video_core][renderer_software]") {
+    constexpr std::array compare_funcs = {
+        FramebufferRegs::CompareFunc::Never,
+        FramebufferRegs::CompareFunc::Always,
+        FramebufferRegs::CompareFunc::Equal,
+        FramebufferRegs::CompareFunc::NotEqual,
+        FramebufferRegs::CompareFunc::LessThan,
+        FramebufferRegs::CompareFunc::LessThanOrEqual,
+        FramebufferRegs::CompareFunc::GreaterThan,
+        FramebufferRegs::CompareFunc::GreaterThanOrEqual,
+    };
+    // Interpolated depths are clamped to [0, 1], which lets NaN through
+    constexpr std::array special_depths = {
+        0.0f,
+        1.0f,
+        0.5f,
+        std::numeric_limits<float>::quiet_NaN(),
+    };
+
+    std::mt19937 rng{3};
+    std::uniform_real_distribution<float> depth_dist(0.0f, 1.0f);
+    for (const u32 max_value : {0xFFFFU, 0xFFFFFFU}) {
+        for (const auto func : compare_funcs) {
+            for (u32 i = 0; i < 1000; i++) {
+                std::array<float, SPAN_PIXELS> depth;
+                std::array<u32, SPAN_PIXELS> ref_z;
+                for (u32 lane = 0; lane < SPAN_PIXELS; lane++) {
+                    depth[lane] = rng() % 4 == 0 ? special_depths[rng() % special_depths.size()]
+                                                 : depth_dist(rng);
+                    ref_z[lane] = static_cast<u32>(rng() % (max_value + 1));
+                }
+
+                std::array<u32, SPAN_PIXELS> expected_z;
+                for (u32 lane = 0; lane < SPAN_PIXELS; lane++) {
+                    const float value = depth[lane] * static_cast<float>(max_value);
+                    expected_z[lane] = std::isnan(value) ? 0 : static_cast<u32>(value);
+                    // Make equal depths likely
+                    if (rng() % 3 == 0) {
+                        ref_z[lane] = expected_z[lane];
+                    }
+                }
+
+                const auto z = SwRenderer::DepthToInts(depth, max_value);
+                REQUIRE(z == expected_z);
+
+                u32 expected_mask = 0;
+                for (u32 lane = 0; lane < SPAN_PIXELS; lane++) {
+                    if (CompareScalar(func, z[lane], ref_z[lane])) {
+                        expected_mask |= 1U << lane;
+                    }
+                }
+                REQUIRE(SwRenderer::CompareLanes(func, z, ref_z) == expected_mask);
+            }
+        }
+    }
+}
@@ -0,0 +1,76 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <utility>
+#include <catch2/catch_test_macros.hpp>
+#include <nihstro/inline_assembly.h>
+#include "video_core/shader/shader_interpreter.h"
+
+using ShaderInterpreter = Pica::Shader::InterpreterEngine;
+
+using DestRegister = nihstro::DestRegister;
+using OpCode = nihstro::OpCode;
+using SourceRegister = nihstro::SourceRegister;
+
+static std::unique_ptr<Pica::Shader::ShaderSetup> CompileShaderSetup(
+    std::initializer_list<nihstro::InlineAsm> code) {
+    const auto shbin = nihstro::InlineAsm::CompileToRawBinary(code);
+
+    auto shader = std::make_unique<Pica::Shader::ShaderSetup>();
+
+    std::transform(shbin.program.begin(), shbin.program.end(), shader->program_code.begin(),
+                   [](const auto& x) { return x.hex; });
+    std::transform(shbin.swizzle_table.begin(), shbin.swizzle_table.end(),
+                   shader->swizzle_data.begin(), [](const auto& x) { return x.hex; });
+
+    return shader;
+}
+
+TEST_CASE("Interpreter Cache", "[video_core][shader][shader_interpreter]") {
+    const auto sh_input = SourceRegister::MakeInput(0);
+    const auto sh_output = DestRegister::MakeOutput(0);
+
+    const auto shader_setup = CompileShaderSetup({
+        {OpCode::Id::MOV, sh_output, sh_input},
+        {OpCode::Id::END},
+    });
+    ShaderInterpreter shader_interpreter;
+
+    const Common::Vec4f input{1.0f, 2.0f, 3.0f, 4.0f};
+
+    // The decoded program must be replaced when the swizzle data changes
+    const std::array<std::pair<u32, Common::Vec4f>, 3> patterns = {{
+        {0x1B << 5 | 0xF, {1.0f, 2.0f, 3.0f, 4.0f}},               // xyzw
+        {0xE4 << 5 | 0xF, {4.0f, 3.0f, 2.0f, 1.0f}},               // wzyx
+        {0x55 << 5 | 0xF | 1 << 4, {-2.0f, -2.0f, -2.0f, -2.0f}}, // -yyyy
+    }};
+
+    for (const auto& [pattern, expected] : patterns) {
+        shader_setup->swizzle_data[0] = pattern;
+        shader_setup->MarkSwizzleDataDirty();
+        shader_setup->engine_data.cached_shader = nullptr;
+
+        Pica::Shader::UnitState shader_unit_decoded;
+        Pica::Shader::UnitState shader_unit_cached;
+        for (std::size_t i = 0; i < 4; ++i) {
+            shader_unit_decoded.registers.input[0][i] = Pica::f24::FromFloat32(input[i]);
+        }
+        shader_unit_cached.registers.input[0] = shader_unit_decoded.registers.input[0];
+
+        // Without SetupBatch the program is decoded for the run only
+        shader_interpreter.Run(*shader_setup, shader_unit_decoded);
+
+        shader_interpreter.SetupBatch(*shader_setup, 0);
+        REQUIRE(shader_setup->engine_data.cached_shader != nullptr);
+        shader_interpreter.Run(*shader_setup, shader_unit_cached);
+
+        for (std::size_t i = 0; i < 4; ++i) {
+            REQUIRE(shader_unit_decoded.registers.output[0][i].ToFloat32() == expected[i]);
+            REQUIRE(shader_unit_cached.registers.output[0][i].ToFloat32() == expected[i]);
+        }
+    }
+}
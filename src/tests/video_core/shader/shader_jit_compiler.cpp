@@ -3,7 +3,7 @@
 // Refer to the license.txt file included.
 
 #include "common/arch.h"
-#if CITRA_ARCH(x86_64)
+#if CITRA_ARCH(x86_64) || CITRA_ARCH(arm64)
 
 #include <algorithm>
 #include <cmath>
@@ -13,7 +13,11 @@
 #include <catch2/catch_test_macros.hpp>
 #include <nihstro/inline_assembly.h>
 #include "video_core/shader/shader_interpreter.h"
+#if CITRA_ARCH(x86_64)
 #include "video_core/shader/shader_jit_x64_compiler.h"
+#elif CITRA_ARCH(arm64)
+#include "video_core/shader/shader_jit_a64_compiler.h"
+#endif
 
 using JitShader = Pica::Shader::JitShader;
 using ShaderInterpreter = Pica::Shader::InterpreterEngine;
@@ -458,4 +462,95 @@ TEST_CASE("Nested Loop", "[video_core][shader][shader_jit]") {
     }
 }
 
+TEST_CASE("Swizzle", "[video_core][shader][shader_jit]") {
+    const auto sh_input = SourceRegister::MakeInput(0);
+    const auto sh_output = DestRegister::MakeOutput(0);
+
+    auto shader_test = ShaderTest({
+        {OpCode::Id::MOV, sh_output, sh_input},
+        {OpCode::Id::END},
+    });
+
+    const Common::Vec4f input{1.0f, 2.0f, 3.0f, 4.0f};
+
+    // Raw src1 selectors (two bits per component, X in the upper bits) with various dest masks
+    // (X in bit 3) and source negation
+    const std::array<u32, 6> patterns = {
+        0xE4 << 5 | 0xF,                // wzyx
+        0x55 << 5 | 0xF,                // yyyy
+        0x1B << 5 | 0xA,                // xyzw, write xz
+        0x9C << 5 | 0x5,                // zxwy, write yw
+        0x00 << 5 | 0x8 | 1 << 4,       // -xxxx, write x
+        0x78 << 5 | 0xE | 1 << 4,       // -ywzx, write xyz
+    };
+
+    for (const u32 pattern : patterns) {
+        shader_test.shader_setup->swizzle_data[0] = pattern;
+
+        auto shader_jit = std::make_unique<JitShader>();
+        shader_jit->Compile(&shader_test.shader_setup->program_code,
+                            &shader_test.shader_setup->swizzle_data);
+
+        Pica::Shader::UnitState shader_unit_jit;
+        Pica::Shader::UnitState shader_unit_interpreter;
+        shader_unit_jit.registers.output[0] = Common::Vec4<Pica::f24>::AssignToAll(
+            Pica::f24::FromFloat32(-1.0f));
+        shader_unit_interpreter.registers.output[0] = shader_unit_jit.registers.output[0];
+        for (std::size_t i = 0; i < 4; ++i) {
+            shader_unit_jit.registers.input[0][i] = Pica::f24::FromFloat32(input[i]);
+        }
+        shader_unit_interpreter.registers.input[0] = shader_unit_jit.registers.input[0];
+
+        shader_jit->Run(*shader_test.shader_setup, shader_unit_jit, 0);
+        shader_test.shader_interpreter.Run(*shader_test.shader_setup, shader_unit_interpreter);
+
+        for (std::size_t i = 0; i < 4; ++i) {
+            REQUIRE(shader_unit_jit.registers.output[0][i].ToFloat32() ==
+                    shader_unit_interpreter.registers.output[0][i].ToFloat32());
+        }
+    }
+}
+
+#if CITRA_ARCH(x86_64)
+TEST_CASE("Batch", "[video_core][shader][shader_jit]") {
+    const auto sh_input1 = SourceRegister::MakeInput(0);
+    const auto sh_input2 = SourceRegister::MakeInput(1);
+    const auto sh_output = DestRegister::MakeOutput(0);
+
+    auto shader_test = ShaderTest({
+        {OpCode::Id::ADD, sh_output, sh_input1, sh_input2},
+        {OpCode::Id::END},
+    });
+
+    constexpr std::size_t num_vertices = 5;
+    std::vector<Pica::Shader::AttributeBuffer> inputs(num_vertices);
+    std::vector<Pica::Shader::AttributeBuffer> outputs(num_vertices);
+    for (std::size_t i = 0; i < num_vertices; ++i) {
+        const auto value = Pica::f24::FromFloat32(static_cast<float>(i));
+        inputs[i].attr[0] = Common::Vec4<Pica::f24>::AssignToAll(value);
+        inputs[i].attr[1] = Common::Vec4<Pica::f24>::AssignToAll(Pica::f24::FromFloat32(1.0f));
+    }
+
+    Pica::Shader::JitBatch batch{};
+    batch.input = inputs.data();
+    batch.output = outputs.data();
+    batch.count = num_vertices;
+    batch.num_inputs = 2;
+    batch.input_offsets[0] = static_cast<u32>(Pica::Shader::UnitState::InputOffset(0));
+    batch.input_offsets[1] = static_cast<u32>(Pica::Shader::UnitState::InputOffset(1));
+    batch.num_outputs = 1;
+    batch.output_offsets[0] = static_cast<u32>(Pica::Shader::UnitState::OutputOffset(0));
+    batch.entry = shader_test.shader_jit.GetEntry(0);
+
+    Pica::Shader::UnitState shader_unit;
+    shader_test.shader_jit.RunBatch(*shader_test.shader_setup, shader_unit, batch);
+
+    for (std::size_t i = 0; i < num_vertices; ++i) {
+        REQUIRE(outputs[i].attr[0].x.ToFloat32() == static_cast<float>(i) + 1.0f);
+        REQUIRE(outputs[i].attr[0].w.ToFloat32() == static_cast<float>(i) + 1.0f);
+    }
+}
+
 #endif // CITRA_ARCH(x86_64)
+
+#endif // CITRA_ARCH(x86_64) || CITRA_ARCH(arm64)
@@ -2,11 +2,15 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <array>
+#include <bit>
 #include <cstddef>
 #include <cstring>
 #include <memory>
+#include <span>
 #include <utility>
+#include <vector>
 #include "common/assert.h"
 #include "common/logging/log.h"
 #include "common/microprofile.h"
@@ -38,6 +42,66 @@ constexpr std::array<u32, 16> expand_bits_to_bytes{
 };
 
 MICROPROFILE_DEFINE(GPU_Drawing, "GPU", "Drawing", MP_RGB(50, 50, 240));
+MICROPROFILE_DEFINE(GPU_CommandList, "GPU", "Command List", MP_RGB(100, 100, 255));
+
+// Non-indexed draws with at least this many vertices are split across several shader units
+constexpr u32 MIN_PARALLEL_VERTICES = 256;
+
+// Indices are at most 16 bits wide, so a bigger cache could never be fully used
+constexpr std::size_t MAX_VERTEX_CACHE_SIZE = 0x10000;
+
+/**
+ * Direct-mapped cache of vertex shader outputs for indexed draws, keyed by vertex index. Entries are
+ * tagged with the draw that wrote them, so the cache is valid for the whole draw and doesn't need
+ * to be cleared between draws.
+ */
+class VertexCache {
+public:
+    /// Invalidates all entries and resizes the cache to hold (at least) `size` vertices
+    void Reset(std::size_t size) {
+        size = size ? std::bit_ceil(std::min(size, MAX_VERTEX_CACHE_SIZE)) : 0;
+        if (size != tags.size()) {
+            tags.assign(size, {});
+            outputs.resize(size);
+            draw_id = 0;
+        }
+        if (++draw_id == 0) {
+            std::fill(tags.begin(), tags.end(), Tag{});
+            draw_id = 1;
+        }
+    }
+
+    /// Returns the cached output for `vertex`, or nullptr if it hasn't been shaded during this draw
+    const Shader::AttributeBuffer* Lookup(u32 vertex) const {
+        if (tags.empty()) {
+            return nullptr;
+        }
+        const std::size_t slot = vertex & (tags.size() - 1);
+        const Tag& tag = tags[slot];
+        return tag.draw_id == draw_id && tag.vertex == vertex ? &outputs[slot] : nullptr;
+    }
+
+    void Insert(u32 vertex, const Shader::AttributeBuffer& output) {
+        if (tags.empty()) {
+            return;
+        }
+        const std::size_t slot = vertex & (tags.size() - 1);
+        tags[slot] = {vertex, draw_id};
+        outputs[slot] = output;
+    }
+
+private:
+    struct Tag {
+        u32 vertex = 0;
+        u32 draw_id = 0; ///< Zero never matches, as the current draw id starts at one
+    };
+
+    std::vector<Tag> tags;
+    std::vector<Shader::AttributeBuffer> outputs;
+    u32 draw_id = 0;
+};
+
+static VertexCache vertex_cache;
 
 static const char* GetShaderSetupTypeName(Shader::ShaderSetup& setup) {
     if (&setup == &g_state.vs) {
@@ -113,7 +177,64 @@ static void WriteUniformFloatReg(ShaderRegs& config, Shader::ShaderSetup& setup,
     }
 }
 
-static void WritePicaReg(u32 id, u32 value, u32 mask) {
+/**
+ * Runs the vertex shader of a non-indexed draw in batches and submits the results to the geometry
+ * pipeline in order. Large draws are split across several shader units when `workers` is set.
+ */
+static void RunVertexShaderBatched(Common::ThreadWorker* workers, const VertexLoader& loader,
+                                   u32 base_address, Shader::ShaderEngine* shader_engine) {
+    const auto& regs = g_state.regs;
+    const u32 num_vertices = regs.pipeline.num_vertices;
+    const u32 vertex_offset = regs.pipeline.vertex_offset;
+
+    std::vector<Shader::AttributeBuffer> vs_inputs(num_vertices);
+    std::vector<Shader::AttributeBuffer> vs_outputs(num_vertices);
+
+    const auto run_chunk = [&](u32 begin, u32 end) {
+        loader.LoadVertices(base_address, begin + vertex_offset,
+                            std::span{vs_inputs}.subspan(begin, end - begin));
+        Shader::UnitState shader_unit;
+        shader_engine->RunBatch(g_state.vs, shader_unit, regs.vs,
+                                std::span{vs_inputs}.subspan(begin, end - begin),
+                                std::span{vs_outputs}.subspan(begin, end - begin));
+    };
+
+    if (workers && num_vertices >= MIN_PARALLEL_VERTICES) {
+        const u32 num_units = static_cast<u32>(workers->NumWorkers());
+        const u32 chunk_size = (num_vertices + num_units - 1) / num_units;
+        for (u32 begin = 0; begin < num_vertices; begin += chunk_size) {
+            const u32 end = std::min(begin + chunk_size, num_vertices);
+            workers->QueueWork([&run_chunk, begin, end] { run_chunk(begin, end); });
+        }
+        workers->WaitForRequests();
+    } else {
+        run_chunk(0, num_vertices);
+    }
+
+    for (const auto& vs_output : vs_outputs) {
+        g_state.geometry_pipeline.SubmitVertex(vs_output);
+    }
+}
+
+/**
+ * Returns true if writing the register has an effect on the rasterizer even when the write doesn't
+ * change its value, e.g. because it feeds the next entry of a lookup table.
+ */
+static bool IsDataPortRegister(u32 id) {
+    const auto in_range = [id](u32 first, u32 last) { return id >= first && id <= last; };
+    return in_range(PICA_REG_INDEX(texturing.fog_lut_data[0]),
+                    PICA_REG_INDEX(texturing.fog_lut_data[7])) ||
+           in_range(PICA_REG_INDEX(texturing.proctex_lut_data[0]),
+                    PICA_REG_INDEX(texturing.proctex_lut_data[7])) ||
+           in_range(PICA_REG_INDEX(lighting.lut_data[0]), PICA_REG_INDEX(lighting.lut_data[7]));
+}
+
+/**
+ * Writes a PICA register and runs its side effects.
+ * @returns true if the rasterizer was notified of the write, false if it was skipped because the
+ * write left the register unchanged
+ */
+static bool WritePicaReg(u32 id, u32 value, u32 mask) {
     auto& regs = g_state.regs;
 
     if (id >= Regs::NUM_REGS) {
@@ -121,7 +242,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
             HW_GPU,
             "Commandlist tried to write to invalid register 0x{:03X} (value: {:08X}, mask: {:X})",
             id, value, mask);
-        return;
+        return false;
     }
 
     // TODO: Figure out how register masking acts on e.g. vs.uniform_setup.set_value
@@ -343,15 +464,9 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
 
         DebugUtils::MemoryAccessTracker memory_accesses;
 
-        // Simple circular-replacement vertex cache
-        // The size has been tuned for optimal balance between hit-rate and the cost of lookup
-        const std::size_t VERTEX_CACHE_SIZE = 32;
-        std::array<bool, VERTEX_CACHE_SIZE> vertex_cache_valid{};
-        std::array<u16, VERTEX_CACHE_SIZE> vertex_cache_ids;
-        std::array<Shader::AttributeBuffer, VERTEX_CACHE_SIZE> vertex_cache;
         Shader::AttributeBuffer vs_output;
-
-        unsigned int vertex_cache_pos = 0;
+        u32 vertex_cache_hits = 0;
+        u32 vertex_cache_misses = 0;
 
         auto* shader_engine = Shader::GetEngine();
         Shader::UnitState shader_unit;
@@ -363,60 +478,70 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
         if (g_state.geometry_pipeline.NeedIndexInput())
             ASSERT(is_indexed);
 
-        for (unsigned int index = 0; index < regs.pipeline.num_vertices; ++index) {
-            // Indexed rendering doesn't use the start offset
-            unsigned int vertex =
-                is_indexed ? (index_u16 ? index_address_16[index] : index_address_8[index])
-                           : (index + regs.pipeline.vertex_offset);
+        if (!is_indexed && !g_debug_context) {
+            RunVertexShaderBatched(Shader::GetUnitWorkers(), loader, base_address, shader_engine);
+        } else {
+            if (is_indexed) {
+                vertex_cache.Reset(VideoCore::g_vertex_cache_size);
+            }
+
+            for (unsigned int index = 0; index < regs.pipeline.num_vertices; ++index) {
+                // Indexed rendering doesn't use the start offset
+                unsigned int vertex =
+                    is_indexed ? (index_u16 ? index_address_16[index] : index_address_8[index])
+                               : (index + regs.pipeline.vertex_offset);
 
-            bool vertex_cache_hit = false;
+                const Shader::AttributeBuffer* cached_output = nullptr;
 
-            if (is_indexed) {
-                if (g_state.geometry_pipeline.NeedIndexInput()) {
-                    g_state.geometry_pipeline.SubmitIndex(vertex);
-                    continue;
-                }
+                if (is_indexed) {
+                    if (g_state.geometry_pipeline.NeedIndexInput()) {
+                        g_state.geometry_pipeline.SubmitIndex(vertex);
+                        continue;
+                    }
 
-                if (g_debug_context && Pica::g_debug_context->recorder) {
-                    int size = index_u16 ? 2 : 1;
-                    memory_accesses.AddAccess(base_address + index_info.offset + size * index,
-                                              size);
-                }
+                    if (g_debug_context && Pica::g_debug_context->recorder) {
+                        int size = index_u16 ? 2 : 1;
+                        memory_accesses.AddAccess(base_address + index_info.offset + size * index,
+                                                  size);
+                    }
 
-                for (unsigned int i = 0; i < VERTEX_CACHE_SIZE; ++i) {
-                    if (vertex_cache_valid[i] && vertex == vertex_cache_ids[i]) {
-                        vs_output = vertex_cache[i];
-                        vertex_cache_hit = true;
-                        break;
+                    cached_output = vertex_cache.Lookup(vertex);
+                    if (cached_output) {
+                        ++vertex_cache_hits;
+                    } else {
+                        ++vertex_cache_misses;
                     }
                 }
-            }
 
-            if (!vertex_cache_hit) {
-                // Initialize data for the current vertex
-                Shader::AttributeBuffer input;
-                loader.LoadVertex(base_address, index, vertex, input, memory_accesses);
+                if (cached_output) {
+                    vs_output = *cached_output;
+                } else {
+                    // Initialize data for the current vertex
+                    Shader::AttributeBuffer input;
+                    loader.LoadVertex(base_address, index, vertex, input, memory_accesses);
 
-                // Send to vertex shader
-                if (g_debug_context)
-                    g_debug_context->OnEvent(DebugContext::Event::VertexShaderInvocation,
-                                             (void*)&input);
-                shader_unit.LoadInput(regs.vs, input);
-                shader_engine->Run(g_state.vs, shader_unit);
-                shader_unit.WriteOutput(regs.vs, vs_output);
+                    // Send to vertex shader
+                    if (g_debug_context)
+                        g_debug_context->OnEvent(DebugContext::Event::VertexShaderInvocation,
+                                                 (void*)&input);
+                    shader_unit.LoadInput(regs.vs, input);
+                    shader_engine->Run(g_state.vs, shader_unit);
+                    shader_unit.WriteOutput(regs.vs, vs_output);
 
-                if (is_indexed) {
-                    vertex_cache[vertex_cache_pos] = vs_output;
-                    vertex_cache_valid[vertex_cache_pos] = true;
-                    vertex_cache_ids[vertex_cache_pos] = vertex;
-                    vertex_cache_pos = (vertex_cache_pos + 1) % VERTEX_CACHE_SIZE;
+                    if (is_indexed) {
+                        vertex_cache.Insert(vertex, vs_output);
+                    }
                 }
-            }
 
-            // Send to geometry pipeline
-            g_state.geometry_pipeline.SubmitVertex(vs_output);
+                // Send to geometry pipeline
+                g_state.geometry_pipeline.SubmitVertex(vs_output);
+            }
         }
 
+        // Every hit is a vertex shader invocation saved by the cache
+        MICROPROFILE_META_CPU("Vertex cache hits", vertex_cache_hits);
+        MICROPROFILE_META_CPU("Vertex cache misses", vertex_cache_misses);
+
         for (auto& range : memory_accesses.ranges) {
             g_debug_context->recorder->MemoryAccessed(
                 VideoCore::g_memory->GetPhysicalPointer(range.first), range.second, range.first);
@@ -638,14 +763,22 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
         break;
     }
 
-    VideoCore::g_renderer->Rasterizer()->NotifyPicaRegisterChanged(id);
+    // Titles re-submit whole register blocks for every draw, so most writes don't change anything
+    // the rasterizer derives from the registers. Writes to data ports always have an effect.
+    const bool notify = regs.reg_array[id] != old_value || IsDataPortRegister(id);
+    if (notify) {
+        VideoCore::g_renderer->Rasterizer()->NotifyPicaRegisterChanged(id);
+    }
 
     if (g_debug_context)
         g_debug_context->OnEvent(DebugContext::Event::PicaCommandProcessed,
                                  reinterpret_cast<void*>(&id));
+
+    return notify;
 }
 
 void ProcessCommandList(PAddr list, u32 size) {
+    MICROPROFILE_SCOPE(GPU_CommandList);
 
     u32* buffer = (u32*)VideoCore::g_memory->GetPhysicalPointer(list);
 
@@ -657,6 +790,15 @@ void ProcessCommandList(PAddr list, u32 size) {
     g_state.cmd_list.head_ptr = g_state.cmd_list.current_ptr = buffer;
     g_state.cmd_list.length = size / sizeof(u32);
 
+    int reg_writes = 0;
+    int reg_writes_skipped = 0;
+    const auto write_reg = [&](u32 id, u32 value, u32 mask) {
+        ++reg_writes;
+        if (!WritePicaReg(id, value, mask)) {
+            ++reg_writes_skipped;
+        }
+    };
+
     while (g_state.cmd_list.current_ptr < g_state.cmd_list.head_ptr + g_state.cmd_list.length) {
 
         // Align read pointer to 8 bytes
@@ -666,13 +808,16 @@ void ProcessCommandList(PAddr list, u32 size) {
         u32 value = *g_state.cmd_list.current_ptr++;
         const CommandHeader header = {*g_state.cmd_list.current_ptr++};
 
-        WritePicaReg(header.cmd_id, value, header.parameter_mask);
+        write_reg(header.cmd_id, value, header.parameter_mask);
 
         for (unsigned i = 0; i < header.extra_data_length; ++i) {
             u32 cmd = header.cmd_id + (header.group_commands ? i + 1 : 0);
-            WritePicaReg(cmd, *g_state.cmd_list.current_ptr++, header.parameter_mask);
+            write_reg(cmd, *g_state.cmd_list.current_ptr++, header.parameter_mask);
         }
     }
+
+    MICROPROFILE_META_CPU("Register writes", reg_writes);
+    MICROPROFILE_META_CPU("Register writes skipped", reg_writes_skipped);
 }
 
 } // namespace Pica::CommandProcessor
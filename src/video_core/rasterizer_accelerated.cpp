@@ -4,6 +4,7 @@
 
 #include <limits>
 #include "common/alignment.h"
+#include "common/microprofile.h"
 #include "core/memory.h"
 #include "video_core/pica_state.h"
 #include "video_core/rasterizer_accelerated.h"
@@ -165,16 +166,90 @@ void RasterizerAccelerated::SyncEntireState() {
     for (unsigned tex_index = 0; tex_index < 3; tex_index++) {
         SyncTextureLodBias(tex_index);
     }
+
+    dirty_state.reset();
+}
+
+void RasterizerAccelerated::SyncDirtyState() {
+    if (dirty_state.none()) {
+        return;
+    }
+
+    MICROPROFILE_META_CPU("State syncs", static_cast<int>(dirty_state.count()));
+
+    const auto is_dirty = [this](DirtyState state, std::size_t index = 0) {
+        return dirty_state.test(static_cast<std::size_t>(state) + index);
+    };
+
+    if (is_dirty(DirtyState::DepthScale)) {
+        SyncDepthScale();
+    }
+    if (is_dirty(DirtyState::DepthOffset)) {
+        SyncDepthOffset();
+    }
+    if (is_dirty(DirtyState::ShadowBias)) {
+        SyncShadowBias();
+    }
+    if (is_dirty(DirtyState::ShadowTextureBias)) {
+        SyncShadowTextureBias();
+    }
+    if (is_dirty(DirtyState::FogColor)) {
+        SyncFogColor();
+    }
+    if (is_dirty(DirtyState::ProcTexNoise)) {
+        SyncProcTexNoise();
+    }
+    if (is_dirty(DirtyState::ProcTexBias)) {
+        SyncProcTexBias();
+    }
+    if (is_dirty(DirtyState::AlphaTest)) {
+        SyncAlphaTest();
+    }
+    if (is_dirty(DirtyState::CombinerColor)) {
+        SyncCombinerColor();
+    }
+    if (is_dirty(DirtyState::TevConstColor)) {
+        const auto& tev_stages = regs.texturing.GetTevStages();
+        for (std::size_t index = 0; index < tev_stages.size(); ++index) {
+            SyncTevConstColor(index, tev_stages[index]);
+        }
+    }
+    if (is_dirty(DirtyState::GlobalAmbient)) {
+        SyncGlobalAmbient();
+    }
+    for (int light_index = 0; light_index < NUM_LIGHTS; ++light_index) {
+        if (!is_dirty(DirtyState::Light, light_index)) {
+            continue;
+        }
+        SyncLightSpecular0(light_index);
+        SyncLightSpecular1(light_index);
+        SyncLightDiffuse(light_index);
+        SyncLightAmbient(light_index);
+        SyncLightPosition(light_index);
+        SyncLightSpotDirection(light_index);
+        SyncLightDistanceAttenuationBias(light_index);
+        SyncLightDistanceAttenuationScale(light_index);
+    }
+    if (is_dirty(DirtyState::TextureLodBias)) {
+        for (int tex_index = 0; tex_index < 3; ++tex_index) {
+            SyncTextureLodBias(tex_index);
+        }
+    }
+    if (is_dirty(DirtyState::ClipCoef)) {
+        SyncClipCoef();
+    }
+
+    dirty_state.reset();
 }
 
 void RasterizerAccelerated::NotifyPicaRegisterChanged(u32 id) {
     switch (id) {
     // Depth modifiers
     case PICA_REG_INDEX(rasterizer.viewport_depth_range):
-        SyncDepthScale();
+        MarkDirty(DirtyState::DepthScale);
         break;
     case PICA_REG_INDEX(rasterizer.viewport_depth_near_plane):
-        SyncDepthOffset();
+        MarkDirty(DirtyState::DepthOffset);
         break;
 
     // Depth buffering
@@ -184,12 +259,12 @@ void RasterizerAccelerated::NotifyPicaRegisterChanged(u32 id) {
 
     // Shadow texture
     case PICA_REG_INDEX(texturing.shadow):
-        SyncShadowTextureBias();
+        MarkDirty(DirtyState::ShadowTextureBias);
         break;
 
     // Fog state
     case PICA_REG_INDEX(texturing.fog_color):
-        SyncFogColor();
+        MarkDirty(DirtyState::FogColor);
         break;
     case PICA_REG_INDEX(texturing.fog_lut_data[0]):
     case PICA_REG_INDEX(texturing.fog_lut_data[1]):
@@ -206,14 +281,14 @@ void RasterizerAccelerated::NotifyPicaRegisterChanged(u32 id) {
     case PICA_REG_INDEX(texturing.proctex):
     case PICA_REG_INDEX(texturing.proctex_lut):
     case PICA_REG_INDEX(texturing.proctex_lut_offset):
-        SyncProcTexBias();
+        MarkDirty(DirtyState::ProcTexBias);
         shader_dirty = true;
         break;
 
     case PICA_REG_INDEX(texturing.proctex_noise_u):
     case PICA_REG_INDEX(texturing.proctex_noise_v):
     case PICA_REG_INDEX(texturing.proctex_noise_frequency):
-        SyncProcTexNoise();
+        MarkDirty(DirtyState::ProcTexNoise);
         break;
 
     case PICA_REG_INDEX(texturing.proctex_lut_data[0]):
@@ -246,12 +321,12 @@ void RasterizerAccelerated::NotifyPicaRegisterChanged(u32 id) {
 
     // Alpha test
     case PICA_REG_INDEX(framebuffer.output_merger.alpha_test):
-        SyncAlphaTest();
+        MarkDirty(DirtyState::AlphaTest);
         shader_dirty = true;
         break;
 
     case PICA_REG_INDEX(framebuffer.shadow):
-        SyncShadowBias();
+        MarkDirty(DirtyState::ShadowBias);
         break;
 
     // Scissor test
@@ -298,27 +373,27 @@ void RasterizerAccelerated::NotifyPicaRegisterChanged(u32 id) {
         shader_dirty = true;
         break;
     case PICA_REG_INDEX(texturing.tev_stage0.const_r):
-        SyncTevConstColor(0, regs.texturing.tev_stage0);
+        MarkDirty(DirtyState::TevConstColor);
         break;
     case PICA_REG_INDEX(texturing.tev_stage1.const_r):
-        SyncTevConstColor(1, regs.texturing.tev_stage1);
+        MarkDirty(DirtyState::TevConstColor);
         break;
     case PICA_REG_INDEX(texturing.tev_stage2.const_r):
-        SyncTevConstColor(2, regs.texturing.tev_stage2);
+        MarkDirty(DirtyState::TevConstColor);
         break;
     case PICA_REG_INDEX(texturing.tev_stage3.const_r):
-        SyncTevConstColor(3, regs.texturing.tev_stage3);
+        MarkDirty(DirtyState::TevConstColor);
         break;
     case PICA_REG_INDEX(texturing.tev_stage4.const_r):
-        SyncTevConstColor(4, regs.texturing.tev_stage4);
+        MarkDirty(DirtyState::TevConstColor);
         break;
     case PICA_REG_INDEX(texturing.tev_stage5.const_r):
-        SyncTevConstColor(5, regs.texturing.tev_stage5);
+        MarkDirty(DirtyState::TevConstColor);
         break;
 
     // TEV combiner buffer color
     case PICA_REG_INDEX(texturing.tev_combiner_buffer_color):
-        SyncCombinerColor();
+        MarkDirty(DirtyState::CombinerColor);
         break;
 
     // Fragment lighting switches
@@ -334,174 +409,174 @@ void RasterizerAccelerated::NotifyPicaRegisterChanged(u32 id) {
 
     // Fragment lighting specular 0 color
     case PICA_REG_INDEX(lighting.light[0].specular_0):
-        SyncLightSpecular0(0);
+        MarkDirty(DirtyState::Light, 0);
         break;
     case PICA_REG_INDEX(lighting.light[1].specular_0):
-        SyncLightSpecular0(1);
+        MarkDirty(DirtyState::Light, 1);
         break;
     case PICA_REG_INDEX(lighting.light[2].specular_0):
-        SyncLightSpecular0(2);
+        MarkDirty(DirtyState::Light, 2);
         break;
     case PICA_REG_INDEX(lighting.light[3].specular_0):
-        SyncLightSpecular0(3);
+        MarkDirty(DirtyState::Light, 3);
         break;
     case PICA_REG_INDEX(lighting.light[4].specular_0):
-        SyncLightSpecular0(4);
+        MarkDirty(DirtyState::Light, 4);
         break;
     case PICA_REG_INDEX(lighting.light[5].specular_0):
-        SyncLightSpecular0(5);
+        MarkDirty(DirtyState::Light, 5);
         break;
     case PICA_REG_INDEX(lighting.light[6].specular_0):
-        SyncLightSpecular0(6);
+        MarkDirty(DirtyState::Light, 6);
         break;
     case PICA_REG_INDEX(lighting.light[7].specular_0):
-        SyncLightSpecular0(7);
+        MarkDirty(DirtyState::Light, 7);
         break;
 
     // Fragment lighting specular 1 color
     case PICA_REG_INDEX(lighting.light[0].specular_1):
-        SyncLightSpecular1(0);
+        MarkDirty(DirtyState::Light, 0);
         break;
     case PICA_REG_INDEX(lighting.light[1].specular_1):
-        SyncLightSpecular1(1);
+        MarkDirty(DirtyState::Light, 1);
         break;
     case PICA_REG_INDEX(lighting.light[2].specular_1):
-        SyncLightSpecular1(2);
+        MarkDirty(DirtyState::Light, 2);
         break;
     case PICA_REG_INDEX(lighting.light[3].specular_1):
-        SyncLightSpecular1(3);
+        MarkDirty(DirtyState::Light, 3);
         break;
     case PICA_REG_INDEX(lighting.light[4].specular_1):
-        SyncLightSpecular1(4);
+        MarkDirty(DirtyState::Light, 4);
         break;
     case PICA_REG_INDEX(lighting.light[5].specular_1):
-        SyncLightSpecular1(5);
+        MarkDirty(DirtyState::Light, 5);
         break;
     case PICA_REG_INDEX(lighting.light[6].specular_1):
-        SyncLightSpecular1(6);
+        MarkDirty(DirtyState::Light, 6);
         break;
     case PICA_REG_INDEX(lighting.light[7].specular_1):
-        SyncLightSpecular1(7);
+        MarkDirty(DirtyState::Light, 7);
         break;
 
     // Fragment lighting diffuse color
     case PICA_REG_INDEX(lighting.light[0].diffuse):
-        SyncLightDiffuse(0);
+        MarkDirty(DirtyState::Light, 0);
         break;
     case PICA_REG_INDEX(lighting.light[1].diffuse):
-        SyncLightDiffuse(1);
+        MarkDirty(DirtyState::Light, 1);
         break;
     case PICA_REG_INDEX(lighting.light[2].diffuse):
-        SyncLightDiffuse(2);
+        MarkDirty(DirtyState::Light, 2);
         break;
     case PICA_REG_INDEX(lighting.light[3].diffuse):
-        SyncLightDiffuse(3);
+        MarkDirty(DirtyState::Light, 3);
         break;
     case PICA_REG_INDEX(lighting.light[4].diffuse):
-        SyncLightDiffuse(4);
+        MarkDirty(DirtyState::Light, 4);
         break;
     case PICA_REG_INDEX(lighting.light[5].diffuse):
-        SyncLightDiffuse(5);
+        MarkDirty(DirtyState::Light, 5);
         break;
     case PICA_REG_INDEX(lighting.light[6].diffuse):
-        SyncLightDiffuse(6);
+        MarkDirty(DirtyState::Light, 6);
         break;
     case PICA_REG_INDEX(lighting.light[7].diffuse):
-        SyncLightDiffuse(7);
+        MarkDirty(DirtyState::Light, 7);
         break;
 
     // Fragment lighting ambient color
     case PICA_REG_INDEX(lighting.light[0].ambient):
-        SyncLightAmbient(0);
+        MarkDirty(DirtyState::Light, 0);
         break;
     case PICA_REG_INDEX(lighting.light[1].ambient):
-        SyncLightAmbient(1);
+        MarkDirty(DirtyState::Light, 1);
         break;
     case PICA_REG_INDEX(lighting.light[2].ambient):
-        SyncLightAmbient(2);
+        MarkDirty(DirtyState::Light, 2);
         break;
     case PICA_REG_INDEX(lighting.light[3].ambient):
-        SyncLightAmbient(3);
+        MarkDirty(DirtyState::Light, 3);
         break;
     case PICA_REG_INDEX(lighting.light[4].ambient):
-        SyncLightAmbient(4);
+        MarkDirty(DirtyState::Light, 4);
         break;
     case PICA_REG_INDEX(lighting.light[5].ambient):
-        SyncLightAmbient(5);
+        MarkDirty(DirtyState::Light, 5);
         break;
     case PICA_REG_INDEX(lighting.light[6].ambient):
-        SyncLightAmbient(6);
+        MarkDirty(DirtyState::Light, 6);
         break;
     case PICA_REG_INDEX(lighting.light[7].ambient):
-        SyncLightAmbient(7);
+        MarkDirty(DirtyState::Light, 7);
         break;
 
     // Fragment lighting position
     case PICA_REG_INDEX(lighting.light[0].x):
     case PICA_REG_INDEX(lighting.light[0].z):
-        SyncLightPosition(0);
+        MarkDirty(DirtyState::Light, 0);
         break;
     case PICA_REG_INDEX(lighting.light[1].x):
     case PICA_REG_INDEX(lighting.light[1].z):
-        SyncLightPosition(1);
+        MarkDirty(DirtyState::Light, 1);
         break;
     case PICA_REG_INDEX(lighting.light[2].x):
     case PICA_REG_INDEX(lighting.light[2].z):
-        SyncLightPosition(2);
+        MarkDirty(DirtyState::Light, 2);
         break;
     case PICA_REG_INDEX(lighting.light[3].x):
     case PICA_REG_INDEX(lighting.light[3].z):
-        SyncLightPosition(3);
+        MarkDirty(DirtyState::Light, 3);
         break;
     case PICA_REG_INDEX(lighting.light[4].x):
     case PICA_REG_INDEX(lighting.light[4].z):
-        SyncLightPosition(4);
+        MarkDirty(DirtyState::Light, 4);
         break;
     case PICA_REG_INDEX(lighting.light[5].x):
     case PICA_REG_INDEX(lighting.light[5].z):
-        SyncLightPosition(5);
+        MarkDirty(DirtyState::Light, 5);
         break;
     case PICA_REG_INDEX(lighting.light[6].x):
     case PICA_REG_INDEX(lighting.light[6].z):
-        SyncLightPosition(6);
+        MarkDirty(DirtyState::Light, 6);
         break;
     case PICA_REG_INDEX(lighting.light[7].x):
     case PICA_REG_INDEX(lighting.light[7].z):
-        SyncLightPosition(7);
+        MarkDirty(DirtyState::Light, 7);
         break;
 
     // Fragment spot lighting direction
     case PICA_REG_INDEX(lighting.light[0].spot_x):
     case PICA_REG_INDEX(lighting.light[0].spot_z):
-        SyncLightSpotDirection(0);
+        MarkDirty(DirtyState::Light, 0);
         break;
     case PICA_REG_INDEX(lighting.light[1].spot_x):
     case PICA_REG_INDEX(lighting.light[1].spot_z):
-        SyncLightSpotDirection(1);
+        MarkDirty(DirtyState::Light, 1);
         break;
     case PICA_REG_INDEX(lighting.light[2].spot_x):
     case PICA_REG_INDEX(lighting.light[2].spot_z):
-        SyncLightSpotDirection(2);
+        MarkDirty(DirtyState::Light, 2);
         break;
     case PICA_REG_INDEX(lighting.light[3].spot_x):
     case PICA_REG_INDEX(lighting.light[3].spot_z):
-        SyncLightSpotDirection(3);
+        MarkDirty(DirtyState::Light, 3);
         break;
     case PICA_REG_INDEX(lighting.light[4].spot_x):
     case PICA_REG_INDEX(lighting.light[4].spot_z):
-        SyncLightSpotDirection(4);
+        MarkDirty(DirtyState::Light, 4);
         break;
     case PICA_REG_INDEX(lighting.light[5].spot_x):
     case PICA_REG_INDEX(lighting.light[5].spot_z):
-        SyncLightSpotDirection(5);
+        MarkDirty(DirtyState::Light, 5);
         break;
     case PICA_REG_INDEX(lighting.light[6].spot_x):
     case PICA_REG_INDEX(lighting.light[6].spot_z):
-        SyncLightSpotDirection(6);
+        MarkDirty(DirtyState::Light, 6);
         break;
     case PICA_REG_INDEX(lighting.light[7].spot_x):
     case PICA_REG_INDEX(lighting.light[7].spot_z):
-        SyncLightSpotDirection(7);
+        MarkDirty(DirtyState::Light, 7);
         break;
 
     // Fragment lighting light source config
@@ -518,59 +593,59 @@ void RasterizerAccelerated::NotifyPicaRegisterChanged(u32 id) {
 
     // Fragment lighting distance attenuation bias
     case PICA_REG_INDEX(lighting.light[0].dist_atten_bias):
-        SyncLightDistanceAttenuationBias(0);
+        MarkDirty(DirtyState::Light, 0);
         break;
     case PICA_REG_INDEX(lighting.light[1].dist_atten_bias):
-        SyncLightDistanceAttenuationBias(1);
+        MarkDirty(DirtyState::Light, 1);
         break;
     case PICA_REG_INDEX(lighting.light[2].dist_atten_bias):
-        SyncLightDistanceAttenuationBias(2);
+        MarkDirty(DirtyState::Light, 2);
         break;
     case PICA_REG_INDEX(lighting.light[3].dist_atten_bias):
-        SyncLightDistanceAttenuationBias(3);
+        MarkDirty(DirtyState::Light, 3);
         break;
     case PICA_REG_INDEX(lighting.light[4].dist_atten_bias):
-        SyncLightDistanceAttenuationBias(4);
+        MarkDirty(DirtyState::Light, 4);
         break;
     case PICA_REG_INDEX(lighting.light[5].dist_atten_bias):
-        SyncLightDistanceAttenuationBias(5);
+        MarkDirty(DirtyState::Light, 5);
         break;
     case PICA_REG_INDEX(lighting.light[6].dist_atten_bias):
-        SyncLightDistanceAttenuationBias(6);
+        MarkDirty(DirtyState::Light, 6);
         break;
     case PICA_REG_INDEX(lighting.light[7].dist_atten_bias):
-        SyncLightDistanceAttenuationBias(7);
+        MarkDirty(DirtyState::Light, 7);
         break;
 
     // Fragment lighting distance attenuation scale
     case PICA_REG_INDEX(lighting.light[0].dist_atten_scale):
-        SyncLightDistanceAttenuationScale(0);
+        MarkDirty(DirtyState::Light, 0);
         break;
     case PICA_REG_INDEX(lighting.light[1].dist_atten_scale):
-        SyncLightDistanceAttenuationScale(1);
+        MarkDirty(DirtyState::Light, 1);
         break;
     case PICA_REG_INDEX(lighting.light[2].dist_atten_scale):
-        SyncLightDistanceAttenuationScale(2);
+        MarkDirty(DirtyState::Light, 2);
         break;
     case PICA_REG_INDEX(lighting.light[3].dist_atten_scale):
-        SyncLightDistanceAttenuationScale(3);
+        MarkDirty(DirtyState::Light, 3);
         break;
     case PICA_REG_INDEX(lighting.light[4].dist_atten_scale):
-        SyncLightDistanceAttenuationScale(4);
+        MarkDirty(DirtyState::Light, 4);
         break;
     case PICA_REG_INDEX(lighting.light[5].dist_atten_scale):
-        SyncLightDistanceAttenuationScale(5);
+        MarkDirty(DirtyState::Light, 5);
         break;
     case PICA_REG_INDEX(lighting.light[6].dist_atten_scale):
-        SyncLightDistanceAttenuationScale(6);
+        MarkDirty(DirtyState::Light, 6);
         break;
     case PICA_REG_INDEX(lighting.light[7].dist_atten_scale):
-        SyncLightDistanceAttenuationScale(7);
+        MarkDirty(DirtyState::Light, 7);
         break;
 
     // Fragment lighting global ambient color (emission + ambient * ambient)
     case PICA_REG_INDEX(lighting.global_ambient):
-        SyncGlobalAmbient();
+        MarkDirty(DirtyState::GlobalAmbient);
         break;
 
     // Fragment lighting lookup tables
@@ -590,13 +665,13 @@ void RasterizerAccelerated::NotifyPicaRegisterChanged(u32 id) {
 
     // Texture LOD biases
     case PICA_REG_INDEX(texturing.texture0.lod.bias):
-        SyncTextureLodBias(0);
+        MarkDirty(DirtyState::TextureLodBias);
         break;
     case PICA_REG_INDEX(texturing.texture1.lod.bias):
-        SyncTextureLodBias(1);
+        MarkDirty(DirtyState::TextureLodBias);
         break;
     case PICA_REG_INDEX(texturing.texture2.lod.bias):
-        SyncTextureLodBias(2);
+        MarkDirty(DirtyState::TextureLodBias);
         break;
 
     // Clipping plane
@@ -604,7 +679,7 @@ void RasterizerAccelerated::NotifyPicaRegisterChanged(u32 id) {
     case PICA_REG_INDEX(rasterizer.clip_coef[1]):
     case PICA_REG_INDEX(rasterizer.clip_coef[2]):
     case PICA_REG_INDEX(rasterizer.clip_coef[3]):
-        SyncClipCoef();
+        MarkDirty(DirtyState::ClipCoef);
         break;
 
     default:
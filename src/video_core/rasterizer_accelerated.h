@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <bitset>
 #include "common/vector_math.h"
 #include "video_core/rasterizer_interface.h"
 #include "video_core/regs_texturing.h"
@@ -36,6 +37,12 @@ protected:
     /// Notifies that a fixed function PICA register changed to the video backend
     virtual void NotifyFixedFunctionPicaRegisterChanged(u32 id) = 0;
 
+    /**
+     * Syncs the uniforms of the state blocks whose registers changed since the last call. Register
+     * writes only mark their block dirty, so this must be called before the uniforms are used.
+     */
+    void SyncDirtyState();
+
     /// Syncs the depth scale to match the PICA register
     void SyncDepthScale();
 
@@ -101,6 +108,32 @@ protected:
     void SyncClipCoef();
 
 protected:
+    static constexpr int NUM_LIGHTS = 8;
+
+    /// Groups of uniforms that are synced together from the PICA registers
+    enum class DirtyState : std::size_t {
+        DepthScale,
+        DepthOffset,
+        ShadowBias,
+        ShadowTextureBias,
+        FogColor,
+        ProcTexNoise,
+        ProcTexBias,
+        AlphaTest,
+        CombinerColor,
+        TevConstColor,
+        GlobalAmbient,
+        TextureLodBias,
+        ClipCoef,
+        Light, ///< One block per light source, starting here
+        NumStates = Light + NUM_LIGHTS,
+    };
+
+    /// Marks a state block to be synced by the next SyncDirtyState call
+    void MarkDirty(DirtyState state, std::size_t index = 0) {
+        dirty_state.set(static_cast<std::size_t>(state) + index);
+    }
+
     /// Structure that keeps tracks of the uniform state
     struct UniformBlockData {
         Pica::Shader::UniformData data{};
@@ -145,6 +178,7 @@ protected:
 
     std::vector<HardwareVertex> vertex_batch;
     bool shader_dirty = true;
+    std::bitset<static_cast<std::size_t>(DirtyState::NumStates)> dirty_state;
 
     UniformBlockData uniform_block_data{};
     std::array<std::array<Common::Vec2f, 256>, Pica::LightingRegs::NumLightingSampler>
@@ -0,0 +1,64 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include "video_core/rasterizer_cache/decoded_texture_cache.h"
+
+namespace VideoCore {
+
+DecodedTextureCache::DecodedTextureCache(std::size_t budget_) : budget{budget_} {}
+
+DecodedTextureCache::~DecodedTextureCache() = default;
+
+void DecodedTextureCache::SetBudget(std::size_t budget_) {
+    budget = budget_;
+    EvictUntil(budget);
+}
+
+bool DecodedTextureCache::Lookup(u64 key, std::span<u8> dest) {
+    const auto it = entry_map.find(key);
+    if (it == entry_map.end() || it->second->data.size() != dest.size()) {
+        return false;
+    }
+    entries.splice(entries.begin(), entries, it->second);
+    std::memcpy(dest.data(), it->second->data.data(), dest.size());
+    return true;
+}
+
+void DecodedTextureCache::Insert(u64 key, std::span<const u8> data) {
+    if (data.size() > budget) {
+        return;
+    }
+
+    if (const auto it = entry_map.find(key); it != entry_map.end()) {
+        cached_size -= it->second->data.size();
+        entries.erase(it->second);
+        entry_map.erase(it);
+    }
+
+    EvictUntil(budget - data.size());
+    entries.push_front(Entry{
+        .key = key,
+        .data = std::vector<u8>(data.begin(), data.end()),
+    });
+    entry_map.emplace(key, entries.begin());
+    cached_size += data.size();
+}
+
+void DecodedTextureCache::Clear() {
+    entries.clear();
+    entry_map.clear();
+    cached_size = 0;
+}
+
+void DecodedTextureCache::EvictUntil(std::size_t size) {
+    while (cached_size > size) {
+        const Entry& entry = entries.back();
+        cached_size -= entry.data.size();
+        entry_map.erase(entry.key);
+        entries.pop_back();
+    }
+}
+
+} // namespace VideoCore
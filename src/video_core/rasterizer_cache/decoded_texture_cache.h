@@ -0,0 +1,58 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <list>
+#include <span>
+#include <unordered_map>
+#include <vector>
+#include "common/common_types.h"
+#include "common/hash.h"
+
+namespace VideoCore {
+
+/**
+ * Least recently used cache of decoded texture data keyed by a hash of the guest texture contents.
+ * It lets surfaces of expensive formats, such as ETC1, that get evicted and recreated skip the
+ * decode when the guest data is unchanged. Cached data is bounded by a memory budget in bytes.
+ */
+class DecodedTextureCache {
+public:
+    explicit DecodedTextureCache(std::size_t budget = 0);
+    ~DecodedTextureCache();
+
+    /// Returns true if the cache is allowed to hold any data.
+    [[nodiscard]] bool IsEnabled() const noexcept {
+        return budget != 0;
+    }
+
+    /// Changes the memory budget, evicting entries until the cached data fits.
+    void SetBudget(std::size_t budget);
+
+    /// Copies the decoded data of key into dest and returns true if it is cached with that size.
+    bool Lookup(u64 key, std::span<u8> dest);
+
+    /// Inserts a copy of the decoded data of key, evicting least recently used entries as needed.
+    void Insert(u64 key, std::span<const u8> data);
+
+    /// Removes all cached entries.
+    void Clear();
+
+private:
+    /// Evicts least recently used entries until the cached data is not larger than size.
+    void EvictUntil(std::size_t size);
+
+    struct Entry {
+        u64 key;
+        std::vector<u8> data;
+    };
+
+    std::list<Entry> entries; ///< Ordered from most to least recently used
+    std::unordered_map<u64, std::list<Entry>::iterator, Common::IdentityHash<u64>> entry_map;
+    std::size_t budget;
+    std::size_t cached_size = 0;
+};
+
+} // namespace VideoCore
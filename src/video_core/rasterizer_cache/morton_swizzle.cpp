@@ -0,0 +1,283 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include "common/arch.h"
+#include "video_core/rasterizer_cache/morton_swizzle.h"
+#include "video_core/simd_utils.h"
+#include "video_core/utils.h"
+
+#if CITRA_ARCH(x86_64)
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#include "common/x64/cpu_detect.h"
+#elif CITRA_ARCH(arm64)
+#include <arm_neon.h>
+#endif
+
+namespace VideoCore {
+
+#if CITRA_ARCH(x86_64) || CITRA_ARCH(arm64)
+
+// In a morton tile the two rows of each 2x2 block are interleaved, so four consecutive pixels of
+// a tile hold two pixels of an even row followed by two pixels of the next row. The kernels below
+// load two such groups and deinterleave them with 64-bit unpacks into two rows of four pixels.
+
+#if CITRA_ARCH(x86_64)
+using Vec = __m128i;
+
+static inline Vec Load(const u8* source) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(source));
+}
+
+static inline void Store(u8* dest, Vec value) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), value);
+}
+
+static inline Vec UnpackLo64(Vec a, Vec b) {
+    return _mm_unpacklo_epi64(a, b);
+}
+
+static inline Vec UnpackHi64(Vec a, Vec b) {
+    return _mm_unpackhi_epi64(a, b);
+}
+
+/// Reorders the 32-bit lanes [a, b, c, d] to [a, c, b, d]. This is its own inverse.
+static inline Vec Swap32Middle(Vec value) {
+    return _mm_shuffle_epi32(value, _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+static inline Vec ByteSwap32(Vec value) {
+    value = _mm_or_si128(_mm_slli_epi16(value, 8), _mm_srli_epi16(value, 8));
+    value = _mm_shufflelo_epi16(value, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm_shufflehi_epi16(value, _MM_SHUFFLE(2, 3, 0, 1));
+}
+
+static inline Vec RotateLeft32(Vec value, int amount) {
+    return _mm_or_si128(_mm_slli_epi32(value, amount), _mm_srli_epi32(value, 32 - amount));
+}
+
+/// Shuffles the bytes of `value` by `indices`, zeroing the bytes whose index has the top bit set
+TARGET_SSSE3 static inline Vec ShuffleBytes(Vec value, const u8* indices) {
+    return _mm_shuffle_epi8(value, Load(indices));
+}
+
+static inline Vec Or(Vec a, Vec b) {
+    return _mm_or_si128(a, b);
+}
+#elif CITRA_ARCH(arm64)
+using Vec = uint8x16_t;
+
+static inline Vec Load(const u8* source) {
+    return vld1q_u8(source);
+}
+
+static inline void Store(u8* dest, Vec value) {
+    vst1q_u8(dest, value);
+}
+
+static inline Vec UnpackLo64(Vec a, Vec b) {
+    return vreinterpretq_u8_u64(vzip1q_u64(vreinterpretq_u64_u8(a), vreinterpretq_u64_u8(b)));
+}
+
+static inline Vec UnpackHi64(Vec a, Vec b) {
+    return vreinterpretq_u8_u64(vzip2q_u64(vreinterpretq_u64_u8(a), vreinterpretq_u64_u8(b)));
+}
+
+/// Reorders the 32-bit lanes [a, b, c, d] to [a, c, b, d]. This is its own inverse.
+static inline Vec Swap32Middle(Vec value) {
+    const uint32x4_t lanes = vreinterpretq_u32_u8(value);
+    return UnpackLo64(vreinterpretq_u8_u32(vuzp1q_u32(lanes, lanes)),
+                      vreinterpretq_u8_u32(vuzp2q_u32(lanes, lanes)));
+}
+
+static inline Vec ByteSwap32(Vec value) {
+    return vrev32q_u8(value);
+}
+
+static inline Vec RotateLeft32(Vec value, int amount) {
+    const uint32x4_t lanes = vreinterpretq_u32_u8(value);
+    return vreinterpretq_u8_u32(vorrq_u32(vshlq_u32(lanes, vdupq_n_s32(amount)),
+                                          vshlq_u32(lanes, vdupq_n_s32(amount - 32))));
+}
+
+/// Shuffles the bytes of `value` by `indices`, zeroing the bytes whose index is out of range
+static inline Vec ShuffleBytes(Vec value, const u8* indices) {
+    return vqtbl1q_u8(value, vld1q_u8(indices));
+}
+
+static inline Vec Or(Vec a, Vec b) {
+    return vorrq_u8(a, b);
+}
+#endif
+
+/// Loads the 12 bytes of four 24-bit pixels without reading past them
+static inline Vec Load12(const u8* source) {
+    alignas(16) u8 bytes[16]{};
+    std::memcpy(bytes, source, 12);
+    return Load(bytes);
+}
+
+static inline void Store12(u8* dest, Vec value) {
+    alignas(16) u8 bytes[16];
+    Store(bytes, value);
+    std::memcpy(dest, bytes, 12);
+}
+
+/// Per-pixel transform applied to 32-bit pixels while copying them
+enum class Transform32 {
+    None,
+    ByteSwap,
+    RotateLeft8,
+    RotateRight8,
+};
+
+template <Transform32 transform>
+static inline Vec Apply(Vec value) {
+    if constexpr (transform == Transform32::ByteSwap) {
+        return ByteSwap32(value);
+    } else if constexpr (transform == Transform32::RotateLeft8) {
+        return RotateLeft32(value, 8);
+    } else if constexpr (transform == Transform32::RotateRight8) {
+        return RotateLeft32(value, 24);
+    } else {
+        return value;
+    }
+}
+
+template <bool morton_to_linear, Transform32 transform>
+static void MortonCopyTile32(u32 stride, u8* tile, u8* linear) {
+    for (u32 y = 0; y < 8; y += 2) {
+        u8* row0 = linear + (7 - y) * stride * 4;
+        u8* row1 = linear + (6 - y) * stride * 4;
+        for (u32 x = 0; x < 8; x += 4) {
+            u8* block = tile + MortonInterleave(x, y) * 4;
+            if constexpr (morton_to_linear) {
+                const Vec v0 = Load(block);
+                const Vec v1 = Load(block + 16);
+                Store(row0 + x * 4, Apply<transform>(UnpackLo64(v0, v1)));
+                Store(row1 + x * 4, Apply<transform>(UnpackHi64(v0, v1)));
+            } else {
+                const Vec r0 = Apply<transform>(Load(row0 + x * 4));
+                const Vec r1 = Apply<transform>(Load(row1 + x * 4));
+                Store(block, UnpackLo64(r0, r1));
+                Store(block + 16, UnpackHi64(r0, r1));
+            }
+        }
+    }
+}
+
+template <bool morton_to_linear>
+static void MortonCopyTile16(u32 stride, u8* tile, u8* linear) {
+    // With 16-bit pixels each vector holds two 2x2 blocks, so the pixel pairs of each row are
+    // gathered with a lane shuffle first.
+    for (u32 y = 0; y < 8; y += 2) {
+        u8* row0 = linear + (7 - y) * stride * 2;
+        u8* row1 = linear + (6 - y) * stride * 2;
+        u8* block0 = tile + MortonInterleave(0, y) * 2;
+        u8* block1 = tile + MortonInterleave(4, y) * 2;
+        if constexpr (morton_to_linear) {
+            const Vec v0 = Swap32Middle(Load(block0));
+            const Vec v1 = Swap32Middle(Load(block1));
+            Store(row0, UnpackLo64(v0, v1));
+            Store(row1, UnpackHi64(v0, v1));
+        } else {
+            const Vec r0 = Load(row0);
+            const Vec r1 = Load(row1);
+            Store(block0, Swap32Middle(UnpackLo64(r0, r1)));
+            Store(block1, Swap32Middle(UnpackHi64(r0, r1)));
+        }
+    }
+}
+
+template <bool morton_to_linear>
+static void MortonCopyTile24(u32 stride, u8* tile, u8* linear) {
+    // 24-bit pixels don't fit vector lanes, copy the pixel pairs of each row instead
+    for (u32 y = 0; y < 8; y += 2) {
+        u8* row0 = linear + (7 - y) * stride * 3;
+        u8* row1 = linear + (6 - y) * stride * 3;
+        for (u32 x = 0; x < 8; x += 2) {
+            u8* block = tile + MortonInterleave(x, y) * 3;
+            if constexpr (morton_to_linear) {
+                std::memcpy(row0 + x * 3, block, 6);
+                std::memcpy(row1 + x * 3, block + 6, 6);
+            } else {
+                std::memcpy(block, row0 + x * 3, 6);
+                std::memcpy(block + 6, row1 + x * 3, 6);
+            }
+        }
+    }
+}
+
+alignas(16) constexpr u8 ALPHA_MASK[16] = {0, 0, 0, 0xFF, 0, 0, 0, 0xFF,
+                                           0, 0, 0, 0xFF, 0, 0, 0, 0xFF};
+
+template <bool morton_to_linear>
+TARGET_SSSE3 static void MortonCopyTileRGB8Converted(u32 stride, u8* tile, u8* linear) {
+    for (u32 y = 0; y < 8; y += 2) {
+        u8* row0 = linear + (7 - y) * stride * 4;
+        u8* row1 = linear + (6 - y) * stride * 4;
+        for (u32 x = 0; x < 8; x += 4) {
+            u8* block = tile + MortonInterleave(x, y) * 3;
+            if constexpr (morton_to_linear) {
+                const Vec alpha = Load(ALPHA_MASK);
+                const Vec v0 = Or(ShuffleBytes(Load12(block), RGB8_TO_RGBA8), alpha);
+                const Vec v1 = Or(ShuffleBytes(Load12(block + 12), RGB8_TO_RGBA8), alpha);
+                Store(row0 + x * 4, UnpackLo64(v0, v1));
+                Store(row1 + x * 4, UnpackHi64(v0, v1));
+            } else {
+                const Vec r0 = Load(row0 + x * 4);
+                const Vec r1 = Load(row1 + x * 4);
+                Store12(block, ShuffleBytes(UnpackLo64(r0, r1), RGBA8_TO_RGB8));
+                Store12(block + 12, ShuffleBytes(UnpackHi64(r0, r1), RGBA8_TO_RGB8));
+            }
+        }
+    }
+}
+
+template <bool morton_to_linear>
+static MortonTileFunc GetMortonTileFuncImpl(PixelFormat format, bool converted) {
+    switch (format) {
+    case PixelFormat::RGBA8:
+        return converted ? &MortonCopyTile32<morton_to_linear, Transform32::ByteSwap>
+                         : &MortonCopyTile32<morton_to_linear, Transform32::None>;
+    case PixelFormat::RGB8:
+        if (converted) {
+#if CITRA_ARCH(x86_64)
+            if (!Common::GetCPUCaps().ssse3) {
+                return nullptr;
+            }
+#endif
+            return &MortonCopyTileRGB8Converted<morton_to_linear>;
+        }
+        return &MortonCopyTile24<morton_to_linear>;
+    case PixelFormat::RGB5A1:
+    case PixelFormat::RGB565:
+    case PixelFormat::RGBA4:
+    case PixelFormat::D16:
+        // Conversions expand the channels to RGBA8, which is left to the scalar path
+        return converted ? nullptr : &MortonCopyTile16<morton_to_linear>;
+    case PixelFormat::D24S8:
+        // Depth stencil is stored as S8D24 on the host regardless of conversion
+        return morton_to_linear ? &MortonCopyTile32<true, Transform32::RotateLeft8>
+                                : &MortonCopyTile32<false, Transform32::RotateRight8>;
+    default:
+        return nullptr;
+    }
+}
+
+MortonTileFunc GetMortonTileFunc(bool morton_to_linear, PixelFormat format, bool converted) {
+    return morton_to_linear ? GetMortonTileFuncImpl<true>(format, converted)
+                            : GetMortonTileFuncImpl<false>(format, converted);
+}
+
+#else
+
+MortonTileFunc GetMortonTileFunc(bool morton_to_linear, PixelFormat format, bool converted) {
+    return nullptr;
+}
+
+#endif
+
+} // namespace VideoCore
@@ -0,0 +1,26 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "common/common_types.h"
+#include "video_core/rasterizer_cache/pixel_format.h"
+
+namespace VideoCore {
+
+/**
+ * Converts a whole 8x8 tile between the morton and linear layouts.
+ * @param stride The width of the linear buffer in pixels
+ * @param tile The tiled pixel data
+ * @param linear The linear pixel data, pointing to the start of the last (bottom) row of the tile
+ */
+using MortonTileFunc = void (*)(u32 stride, u8* tile, u8* linear);
+
+/**
+ * Returns a SIMD kernel that behaves like MortonCopyTile for the given direction and format, or
+ * nullptr if there is none for this format or it isn't supported by the host CPU.
+ */
+MortonTileFunc GetMortonTileFunc(bool morton_to_linear, PixelFormat format, bool converted);
+
+} // namespace VideoCore
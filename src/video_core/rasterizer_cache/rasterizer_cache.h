@@ -31,6 +31,11 @@ constexpr auto RangeFromInterval(const auto& map, const auto& interval) {
     return boost::make_iterator_range(map.equal_range(interval));
 }
 
+/// Returns the memory budget of the decoded texture cache in bytes
+inline std::size_t DecodedTextureCacheBudget() {
+    return static_cast<std::size_t>(Settings::values.texture_decode_cache_size.GetValue()) << 20;
+}
+
 template <class T>
 RasterizerCache<T>::RasterizerCache(Memory::MemorySystem& memory_,
                                     CustomTexManager& custom_tex_manager_, Runtime& runtime_,
@@ -39,7 +44,8 @@ RasterizerCache<T>::RasterizerCache(Memory::MemorySystem& memory_,
       renderer{renderer_}, resolution_scale_factor{renderer.GetResolutionScaleFactor()},
       use_filter{Settings::values.texture_filter.GetValue() != Settings::TextureFilter::None},
       dump_textures{Settings::values.dump_textures.GetValue()},
-      use_custom_textures{Settings::values.custom_textures.GetValue()} {
+      use_custom_textures{Settings::values.custom_textures.GetValue()},
+      decoded_texture_cache{DecodedTextureCacheBudget()} {
     using TextureConfig = Pica::TexturingRegs::TextureConfig;
 
     // Create null handles for all cached resources
@@ -76,6 +82,7 @@ RasterizerCache<T>::~RasterizerCache() {
 template <class T>
 void RasterizerCache<T>::TickFrame() {
     custom_tex_manager.TickFrame();
+    decoded_texture_cache.SetBudget(DecodedTextureCacheBudget());
 
     const u32 scale_factor = renderer.GetResolutionScaleFactor();
     const bool resolution_scale_changed = resolution_scale_factor != scale_factor;
@@ -1009,11 +1016,31 @@ void RasterizerCache<T>::UploadSurface(Surface& surface, SurfaceInterval interva
     }
 
     const auto upload_data = source_ptr.GetWriteBytes(load_info.end - load_info.addr);
-    DecodeTexture(load_info, load_info.addr, load_info.end, upload_data, staging.mapped,
-                  runtime.NeedsConversion(surface.pixel_format));
+    const bool convert = runtime.NeedsConversion(surface.pixel_format);
+
+    // Compressed textures are expensive to decode, so keep the decoded data around in case the
+    // surface is recreated with the same contents
+    const bool use_decoded_cache = decoded_texture_cache.IsEnabled() &&
+                                   (load_info.pixel_format == PixelFormat::ETC1 ||
+                                    load_info.pixel_format == PixelFormat::ETC1A4);
+    const bool needs_hash = use_decoded_cache || dump_textures;
+    const u64 hash = needs_hash ? Common::ComputeHash64(upload_data.data(), upload_data.size()) : 0;
+
+    if (use_decoded_cache) {
+        std::size_t decoded_key = hash;
+        Common::HashCombine(decoded_key, static_cast<u64>(load_info.width) << 32 | load_info.height);
+        Common::HashCombine(decoded_key, static_cast<u64>(load_info.pixel_format) << 1 | convert);
+        if (!decoded_texture_cache.Lookup(decoded_key, staging.mapped)) {
+            DecodeTexture(load_info, load_info.addr, load_info.end, upload_data, staging.mapped,
+                          convert);
+            decoded_texture_cache.Insert(decoded_key, staging.mapped);
+        }
+    } else {
+        DecodeTexture(load_info, load_info.addr, load_info.end, upload_data, staging.mapped,
+                      convert);
+    }
 
     if (dump_textures && False(surface.flags & SurfaceFlagBits::Custom)) {
-        const u64 hash = Common::ComputeHash64(upload_data.data(), upload_data.size());
         const u32 level = surface.LevelOf(load_info.addr);
         custom_tex_manager.DumpTexture(load_info, level, upload_data, hash);
     }
@@ -1114,6 +1141,7 @@ void RasterizerCache<T>::DownloadSurface(Surface& surface, SurfaceInterval inter
     const auto download_dest = dest_ptr.GetWriteBytes(flush_end - flush_start);
     EncodeTexture(flush_info, flush_start, flush_end, staging.mapped, download_dest,
                   runtime.NeedsConversion(surface.pixel_format));
+    memory.MarkRegionDirty(flush_start, flush_end - flush_start);
 }
 
 template <class T>
@@ -1146,6 +1174,7 @@ void RasterizerCache<T>::DownloadFillSurface(Surface& surface, SurfaceInterval i
     if (backup_bytes) {
         std::memcpy(&dest_ptr[coarse_start_offset], &backup_data[0], backup_bytes);
     }
+    memory.MarkRegionDirty(flush_start, download_size);
 }
 
 template <class T>
@@ -10,6 +10,7 @@
 #include <vector>
 #include <boost/icl/interval_map.hpp>
 #include <tsl/robin_map.h>
+#include "video_core/rasterizer_cache/decoded_texture_cache.h"
 #include "video_core/rasterizer_cache/sampler_params.h"
 #include "video_core/rasterizer_cache/surface_params.h"
 #include "video_core/rasterizer_cache/texture_cube.h"
@@ -220,6 +221,7 @@ private:
     bool use_filter;
     bool dump_textures;
     bool use_custom_textures;
+    DecodedTextureCache decoded_texture_cache;
 };
 
 } // namespace VideoCore
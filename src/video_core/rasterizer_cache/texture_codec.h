@@ -9,6 +9,7 @@
 #include <span>
 #include "common/alignment.h"
 #include "common/color.h"
+#include "video_core/rasterizer_cache/morton_swizzle.h"
 #include "video_core/rasterizer_cache/pixel_format.h"
 #include "video_core/texture/etc1.h"
 #include "video_core/utils.h"
@@ -254,8 +255,8 @@ constexpr void MortonCopyTile(u32 stride, std::span<u8> tile_buffer, std::span<u
  * in the linear_buffer.
  */
 template <bool morton_to_linear, PixelFormat format, bool converted = false>
-static constexpr void MortonCopy(u32 width, u32 height, u32 start_offset, u32 end_offset,
-                                 std::span<u8> linear_buffer, std::span<u8> tiled_buffer) {
+static void MortonCopy(u32 width, u32 height, u32 start_offset, u32 end_offset,
+                       std::span<u8> linear_buffer, std::span<u8> tiled_buffer) {
     constexpr u32 bytes_per_pixel = GetFormatBpp(format) / 8;
     constexpr u32 aligned_bytes_per_pixel = converted ? 4 : GetFormatBytesPerPixel(format);
     constexpr u32 tile_size = GetFormatBpp(format) * 64 / 8;
@@ -278,6 +279,16 @@ static constexpr void MortonCopy(u32 width, u32 height, u32 start_offset, u32 en
     u32 linear_offset = ((height - 8 - y) * width + x) * aligned_bytes_per_pixel;
     u32 tiled_offset = 0;
 
+    // Use the SIMD kernel for whole tiles when the host has one for this format
+    const MortonTileFunc copy_tile_simd = GetMortonTileFunc(morton_to_linear, format, converted);
+    const auto copy_tile = [&](std::span<u8> tiled_data, std::span<u8> linear_data) {
+        if (copy_tile_simd) {
+            copy_tile_simd(width, tiled_data.data(), linear_data.data());
+        } else {
+            MortonCopyTile<morton_to_linear, format, converted>(width, tiled_data, linear_data);
+        }
+    };
+
     const auto linear_next_tile = [&] {
         x = (x + 8) % width;
         linear_offset += 8 * aligned_bytes_per_pixel;
@@ -296,7 +307,7 @@ static constexpr void MortonCopy(u32 width, u32 height, u32 start_offset, u32 en
     if (start_offset < aligned_start_offset && !morton_to_linear) {
         std::array<u8, tile_size> tmp_buf;
         auto linear_data = linear_buffer.subspan(linear_offset, linear_tile_stride);
-        MortonCopyTile<morton_to_linear, format, converted>(width, tmp_buf, linear_data);
+        copy_tile(tmp_buf, linear_data);
 
         std::memcpy(tiled_buffer.data(), tmp_buf.data() + start_offset - aligned_down_start_offset,
                     std::min(aligned_start_offset, end_offset) - start_offset);
@@ -313,7 +324,7 @@ static constexpr void MortonCopy(u32 width, u32 height, u32 start_offset, u32 en
         while (tiled_offset < buffer_end) {
             auto linear_data = linear_buffer.subspan(linear_offset, linear_tile_stride);
             auto tiled_data = tiled_buffer.subspan(tiled_offset, tile_size);
-            MortonCopyTile<morton_to_linear, format, converted>(width, tiled_data, linear_data);
+            copy_tile(tiled_data, linear_data);
             tiled_offset += tile_size;
             linear_next_tile();
         }
@@ -324,7 +335,7 @@ static constexpr void MortonCopy(u32 width, u32 height, u32 start_offset, u32 en
     if (end_offset > std::max(aligned_start_offset, aligned_end_offset) && !morton_to_linear) {
         std::array<u8, tile_size> tmp_buf;
         auto linear_data = linear_buffer.subspan(linear_offset, linear_tile_stride);
-        MortonCopyTile<morton_to_linear, format, converted>(width, tmp_buf, linear_data);
+        copy_tile(tmp_buf, linear_data);
         std::memcpy(tiled_buffer.data() + tiled_offset, tmp_buf.data(),
                     end_offset - aligned_end_offset);
     }
@@ -2,12 +2,61 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include "common/thread_worker.h"
 #include "video_core/rasterizer_cache/surface_params.h"
 #include "video_core/rasterizer_cache/texture_codec.h"
 #include "video_core/rasterizer_cache/utils.h"
 
 namespace VideoCore {
 
+namespace {
+
+/// Minimum number of pixels before compressed textures are decoded on multiple threads
+constexpr u32 PARALLEL_DECODE_THRESHOLD = 128 * 128;
+
+/**
+ * ETC1 decoding is bound by the per pixel block decode rather than memory bandwidth, so whole
+ * tiled textures are split into bands of tile rows and unswizzled on the decode workers.
+ * Returns false if the texture should be decoded serially instead.
+ */
+bool DecodeTextureParallel(const SurfaceParams& surface_info, u32 start_offset, u32 end_offset,
+                           MortonFunc unswizzle, std::span<u8> source, std::span<u8> dest) {
+    const PixelFormat format = surface_info.pixel_format;
+    if (format != PixelFormat::ETC1 && format != PixelFormat::ETC1A4) {
+        return false;
+    }
+
+    const u32 width = surface_info.width;
+    const u32 height = surface_info.height;
+    const u32 tile_row_size = width * GetFormatBpp(format);
+    if (width * height < PARALLEL_DECODE_THRESHOLD || start_offset != 0 ||
+        end_offset != tile_row_size * (height / 8)) {
+        return false;
+    }
+
+    Common::ThreadWorker* workers = Common::GetSharedThreadWorker();
+    if (!workers) {
+        return false;
+    }
+
+    const u32 num_tile_rows = height / 8;
+    const u32 num_tasks = std::min<u32>(static_cast<u32>(workers->NumWorkers()), num_tile_rows);
+    const u32 rows_per_task = (num_tile_rows + num_tasks - 1) / num_tasks;
+    for (u32 row = 0; row < num_tile_rows; row += rows_per_task) {
+        const u32 band_start = row * tile_row_size;
+        const u32 band_end = std::min(row + rows_per_task, num_tile_rows) * tile_row_size;
+        workers->QueueWork([=] {
+            unswizzle(width, height, band_start, band_end, dest,
+                      source.subspan(band_start, band_end - band_start));
+        });
+    }
+    workers->WaitForRequests();
+    return true;
+}
+
+} // Anonymous namespace
+
 u32 MipLevels(u32 width, u32 height, u32 max_level) {
     u32 levels = 1;
     while (width > 8 && height > 8) {
@@ -55,8 +104,13 @@ void DecodeTexture(const SurfaceParams& surface_info, PAddr start_addr, PAddr en
         const MortonFunc UnswizzleImpl =
             (convert ? UNSWIZZLE_TABLE_CONVERTED : UNSWIZZLE_TABLE)[func_index];
         if (UnswizzleImpl) {
-            UnswizzleImpl(surface_info.width, surface_info.height, start_addr - surface_info.addr,
-                          end_addr - surface_info.addr, dest, source);
+            const u32 start_offset = start_addr - surface_info.addr;
+            const u32 end_offset = end_addr - surface_info.addr;
+            if (!DecodeTextureParallel(surface_info, start_offset, end_offset, UnswizzleImpl,
+                                       source, dest)) {
+                UnswizzleImpl(surface_info.width, surface_info.height, start_offset, end_offset,
+                              dest, source);
+            }
             return;
         }
     } else {
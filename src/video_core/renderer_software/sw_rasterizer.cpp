@@ -2,10 +2,16 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <thread>
 #include <boost/container/static_vector.hpp>
+#include "common/hash.h"
 #include "common/logging/log.h"
 #include "common/microprofile.h"
 #include "common/quaternion.h"
+#include "common/settings.h"
 #include "common/vector_math.h"
 #include "core/memory.h"
 #include "video_core/pica_state.h"
@@ -14,6 +20,7 @@
 #include "video_core/renderer_software/sw_lighting.h"
 #include "video_core/renderer_software/sw_proctex.h"
 #include "video_core/renderer_software/sw_rasterizer.h"
+#include "video_core/renderer_software/sw_span.h"
 #include "video_core/renderer_software/sw_texturing.h"
 #include "video_core/shader/shader.h"
 #include "video_core/texture/texture_decode.h"
@@ -27,44 +34,71 @@ using Pica::TexturingRegs;
 using Pica::Texture::LookupTexture;
 using Pica::Texture::TextureInfo;
 
-struct Vertex : Pica::Shader::OutputVertex {
-    Vertex(const OutputVertex& v) : OutputVertex(v) {}
+/// Triangle that passed culling, with its vertices in counter-clockwise order.
+struct RasterizerSoftware::Triangle {
+    std::array<Vertex, 3> vertices;
+    std::array<Common::Vec3<Fix12P4>, 3> vtxpos;
+    std::array<int, 3> bias;
+    u16 min_x;
+    u16 min_y;
+    u16 max_x;
+    u16 max_y;
+};
 
-    /// Attributes used to store intermediate results position after perspective divide.
-    Common::Vec3<f24> screenpos;
+/// Pixel pipeline specialized for a TEV and output merger configuration.
+struct RasterizerSoftware::PixelPipeline {
+    /// Slots of the values a TEV stage can take its inputs from.
+    enum SourceSlot : u8 {
+        PrimaryColor,
+        PrimaryFragmentColor,
+        SecondaryFragmentColor,
+        Texture0,
+        PreviousBuffer = Texture0 + 4,
+        Constant,
+        Previous,
+        NumSourceSlots,
+    };
 
-    /**
-     * Linear interpolation
-     * factor: 0=this, 1=vtx
-     * Note: This function cannot be called after perspective divide.
-     **/
-    void Lerp(f24 factor, const Vertex& vtx) {
-        pos = pos * factor + vtx.pos * (f24::One() - factor);
-        quat = quat * factor + vtx.quat * (f24::One() - factor);
-        color = color * factor + vtx.color * (f24::One() - factor);
-        tc0 = tc0 * factor + vtx.tc0 * (f24::One() - factor);
-        tc1 = tc1 * factor + vtx.tc1 * (f24::One() - factor);
-        tc0_w = tc0_w * factor + vtx.tc0_w * (f24::One() - factor);
-        view = view * factor + vtx.view * (f24::One() - factor);
-        tc2 = tc2 * factor + vtx.tc2 * (f24::One() - factor);
-    }
+    /// TEV stage with its sources, modifiers and operations resolved.
+    struct CombinerStage {
+        std::array<SourceSlot, 3> color_sources;
+        std::array<ColorModifierFunc, 3> color_modifiers;
+        ColorCombineFunc color_combine;
+        std::array<SourceSlot, 3> alpha_sources;
+        std::array<AlphaModifierFunc, 3> alpha_modifiers;
+        /// Null for Dot3_RGBA, which writes its result to the alpha component as well.
+        AlphaCombineFunc alpha_combine;
+        Common::Vec4<u8> constant;
+        u32 color_multiplier;
+        u32 alpha_multiplier;
+        /// Whether the stage passes the previous combiner output through unchanged.
+        bool passthrough;
+        bool updates_buffer_color;
+        bool updates_buffer_alpha;
+    };
 
-    /**
-     * Linear interpolation
-     * factor: 0=v0, 1=v1
-     * Note: This function cannot be called after perspective divide.
-     **/
-    static Vertex Lerp(f24 factor, const Vertex& v0, const Vertex& v1) {
-        Vertex ret = v0;
-        ret.Lerp(factor, v1);
-        return ret;
-    }
+    /// Whether a stage uses a configuration the specialized path doesn't know, in which case the
+    /// generic interpreter runs instead.
+    bool generic;
+    std::array<CombinerStage, 6> stages;
+    Common::Vec4<u8> combiner_buffer_color;
+    /// Whether the blended color overwrites the framebuffer without depending on it.
+    bool replace_color;
 };
 
 namespace {
 
+/// Number of pixel pipelines kept before the cache is cleared.
+constexpr std::size_t MAX_PIXEL_PIPELINES = 256;
+
 MICROPROFILE_DEFINE(GPU_Rasterization, "GPU", "Rasterization", MP_RGB(50, 50, 240));
 
+/// Size of a screen tile in 12.4 fixed point (32x32 pixels).
+constexpr u32 TILE_SHIFT = 5 + 4;
+constexpr u32 TILE_SIZE = 1U << TILE_SHIFT;
+/// Number of tiles per axis needed to cover the whole 12.4 coordinate space.
+constexpr u32 TILES_PER_AXIS = 0x10000 / TILE_SIZE;
+
 struct ClippingEdge {
 public:
     constexpr ClippingEdge(Common::Vec4<f24> coeffs,
@@ -96,7 +130,54 @@ private:
 } // Anonymous namespace
 
 RasterizerSoftware::RasterizerSoftware(Memory::MemorySystem& memory_)
-    : memory{memory_}, state{Pica::g_state}, regs{state.regs}, fb{memory, regs.framebuffer} {}
+    : memory{memory_}, state{Pica::g_state}, regs{state.regs}, fb{memory, regs.framebuffer} {
+    u32 num_threads = Settings::values.sw_rasterizer_threads.GetValue();
+    if (num_threads == 0) {
+        num_threads = std::max(std::thread::hardware_concurrency(), 1U);
+    }
+    if (num_threads > 1) {
+        workers = std::make_unique<Common::ThreadWorker>(num_threads, "SwRasterizer");
+        bins.resize(TILES_PER_AXIS * TILES_PER_AXIS);
+    }
+}
+
+RasterizerSoftware::~RasterizerSoftware() = default;
+
+void RasterizerSoftware::DrawTriangles() {
+    FlushBins();
+
+    // The framebuffer is written through raw pointers, report it to the dirty page tracking
+    if (memory.IsDirtyPageTrackingEnabled()) {
+        const auto& framebuffer = regs.framebuffer.framebuffer;
+        const u32 num_pixels = framebuffer.GetWidth() * framebuffer.GetHeight();
+        memory.MarkRegionDirty(framebuffer.GetColorBufferPhysicalAddress(),
+                               num_pixels * Pica::FramebufferRegs::BytesPerColorPixel(
+                                                framebuffer.color_format));
+        memory.MarkRegionDirty(framebuffer.GetDepthBufferPhysicalAddress(),
+                               num_pixels * Pica::FramebufferRegs::BytesPerDepthPixel(
+                                                framebuffer.depth_format));
+    }
+}
+
+void RasterizerSoftware::FlushAll() {
+    FlushBins();
+}
+
+void RasterizerSoftware::FlushRegion(PAddr addr, u32 size) {
+    FlushBins();
+}
+
+void RasterizerSoftware::InvalidateRegion(PAddr addr, u32 size) {
+    FlushBins();
+}
+
+void RasterizerSoftware::FlushAndInvalidateRegion(PAddr addr, u32 size) {
+    FlushBins();
+}
+
+void RasterizerSoftware::ClearAll(bool flush) {
+    FlushBins();
+}
 
 void RasterizerSoftware::AddTriangle(const Pica::Shader::OutputVertex& v0,
                                      const Pica::Shader::OutputVertex& v1,
@@ -223,8 +304,6 @@ void RasterizerSoftware::MakeScreenCoords(Vertex& vtx) {
 
 void RasterizerSoftware::ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2,
                                          bool reversed) {
-    MICROPROFILE_SCOPE(GPU_Rasterization);
-
     // Vertex positions in rasterizer coordinates
     static auto screen_to_rasterizer_coords = [](const Common::Vec3<f24>& vec) {
         return Common::Vec3{Fix12P4::FromFloat24(vec.x), Fix12P4::FromFloat24(vec.y),
@@ -287,169 +366,474 @@ void RasterizerSoftware::ProcessTriangle(const Vertex& v0, const Vertex& v1, con
     const int bias2 =
         IsRightSideOrFlatBottomEdge(vtxpos[2].xy(), vtxpos[0].xy(), vtxpos[1].xy()) ? -1 : 0;
 
-    const auto w_inverse = Common::MakeVec(v0.pos.w, v1.pos.w, v2.pos.w);
+    const Triangle triangle{
+        .vertices = {v0, v1, v2},
+        .vtxpos = vtxpos,
+        .bias = {bias0, bias1, bias2},
+        .min_x = min_x,
+        .min_y = min_y,
+        .max_x = max_x,
+        .max_y = max_y,
+    };
+
+    if (!draw_state) {
+        draw_state = MakeDrawState();
+    }
+    if (draw_state->binned) {
+        BinTriangle(triangle);
+        return;
+    }
+
+    MICROPROFILE_SCOPE(GPU_Rasterization);
+    u32 last_pixel;
+    RasterizeTriangle(triangle, 0, 0, 0x10000, 0x10000, combiner_output, last_pixel);
+}
+
+bool RasterizerSoftware::RasterizeTriangle(const Triangle& triangle, u32 x0, u32 y0, u32 x1,
+                                           u32 y1, Common::Vec4<u8>& combiner_output,
+                                           u32& last_pixel) const {
+    const auto& vtxpos = triangle.vtxpos;
+    const int bias0 = triangle.bias[0];
+    const int bias1 = triangle.bias[1];
+    const int bias2 = triangle.bias[2];
+
+    // Restrict the bounding box to the requested rectangle. Both are aligned to pixel
+    // boundaries, so the sampled pixel centers remain unchanged.
+    const u32 min_x = std::max<u32>(triangle.min_x, x0);
+    const u32 min_y = std::max<u32>(triangle.min_y, y0);
+    const u32 max_x = std::min<u32>(triangle.max_x, x1);
+    const u32 max_y = std::min<u32>(triangle.max_y, y1);
+
+    // Convert the scissor box coordinates to 12.4 fixed point
+    const u16 scissor_x1 = static_cast<u16>(regs.rasterizer.scissor_test.x1 << 4);
+    const u16 scissor_y1 = static_cast<u16>(regs.rasterizer.scissor_test.y1 << 4);
+    // x2,y2 have +1 added to cover the entire sub-pixel area
+    const u16 scissor_x2 = static_cast<u16>((regs.rasterizer.scissor_test.x2 + 1) << 4);
+    const u16 scissor_y2 = static_cast<u16>((regs.rasterizer.scissor_test.y2 + 1) << 4);
+
+    bool shaded = false;
+
+    // Per pixel increments of the edge functions along the x axis.
+    const auto edge_step = [](const Common::Vec3<Fix12P4>& a, const Common::Vec3<Fix12P4>& b) {
+        return (static_cast<s32>(a.y) - static_cast<s32>(b.y)) * 0x10;
+    };
+    const std::array<s32, 3> w_step = {
+        edge_step(vtxpos[1], vtxpos[2]),
+        edge_step(vtxpos[2], vtxpos[0]),
+        edge_step(vtxpos[0], vtxpos[1]),
+    };
+
+    const SpanInterpolator interpolator{
+        triangle.vertices,
+        f24::FromRaw(regs.rasterizer.viewport_depth_range).ToFloat32(),
+        f24::FromRaw(regs.rasterizer.viewport_depth_near_plane).ToFloat32(),
+        regs.rasterizer.depthmap_enable == Pica::RasterizerRegs::DepthBuffering::WBuffering,
+        !regs.lighting.disable,
+    };
+    const bool scissor_exclude =
+        regs.rasterizer.scissor_test.mode == RasterizerRegs::ScissorMode::Exclude;
+    const bool shadow_mode = regs.framebuffer.output_merger.fragment_operation_mode ==
+                             FramebufferRegs::FragmentOperationMode::Shadow;
 
     auto textures = regs.texturing.GetTextures();
     const auto tev_stages = regs.texturing.GetTevStages();
 
+    SpanValues values;
+    std::array<Common::Vec4<u8>, SPAN_PIXELS> span_output;
+
     // Enter rasterization loop, starting at the center of the topleft bounding box corner.
     // TODO: Not sure if looping through x first might be faster
-    for (u16 y = min_y + 8; y < max_y; y += 0x10) {
-        for (u16 x = min_x + 8; x < max_x; x += 0x10) {
-            // Do not process the pixel if it's inside the scissor box and the scissor mode is set
-            // to Exclude.
-            if (regs.rasterizer.scissor_test.mode == RasterizerRegs::ScissorMode::Exclude) {
-                if (x >= scissor_x1 && x < scissor_x2 && y >= scissor_y1 && y < scissor_y2) {
-                    continue;
-                }
-            }
+    for (u32 y = min_y + 8; y < max_y; y += 0x10) {
+        // Calculate the barycentric coordinates w0, w1 and w2 at the start of the row
+        const Common::Vec2<Fix12P4> row_start{static_cast<u16>(min_x + 8), static_cast<u16>(y)};
+        const std::array<s32, 3> row_w = {
+            bias0 + SignedArea(vtxpos[1].xy(), vtxpos[2].xy(), row_start),
+            bias1 + SignedArea(vtxpos[2].xy(), vtxpos[0].xy(), row_start),
+            bias2 + SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), row_start),
+        };
+        EdgeSpan span{row_w, w_step};
 
-            // Calculate the barycentric coordinates w0, w1 and w2
-            const s32 w0 = bias0 + SignedArea(vtxpos[1].xy(), vtxpos[2].xy(), {x, y});
-            const s32 w1 = bias1 + SignedArea(vtxpos[2].xy(), vtxpos[0].xy(), {x, y});
-            const s32 w2 = bias2 + SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), {x, y});
-            const s32 wsum = w0 + w1 + w2;
+        for (u32 span_x = min_x + 8; span_x < max_x; span_x += 0x10 * SPAN_PIXELS) {
+            u32 coverage = span.NextCoverage();
 
-            // If current pixel is not covered by the current primitive
-            if (w0 < 0 || w1 < 0 || w2 < 0) {
-                continue;
+            // Pixels past the bounding box are not part of the span
+            const u32 remaining = (max_x - span_x + Fix12P4::FracMask()) >> 4;
+            if (remaining < SPAN_PIXELS) {
+                coverage &= (1U << remaining) - 1;
             }
 
-            const auto baricentric_coordinates = Common::MakeVec(
-                f24::FromFloat32(static_cast<f32>(w0)), f24::FromFloat32(static_cast<f32>(w1)),
-                f24::FromFloat32(static_cast<f32>(w2)));
-            const f24 interpolated_w_inverse =
-                f24::One() / Common::Dot(w_inverse, baricentric_coordinates);
-
-            // interpolated_z = z / w
-            const float interpolated_z_over_w =
-                (v0.screenpos[2].ToFloat32() * w0 + v1.screenpos[2].ToFloat32() * w1 +
-                 v2.screenpos[2].ToFloat32() * w2) /
-                wsum;
-
-            // Not fully accurate. About 3 bits in precision are missing.
-            // Z-Buffer (z / w * scale + offset)
-            const float depth_scale =
-                f24::FromRaw(regs.rasterizer.viewport_depth_range).ToFloat32();
-            const float depth_offset =
-                f24::FromRaw(regs.rasterizer.viewport_depth_near_plane).ToFloat32();
-            float depth = interpolated_z_over_w * depth_scale + depth_offset;
-
-            // Potentially switch to W-Buffer
-            if (regs.rasterizer.depthmap_enable ==
-                Pica::RasterizerRegs::DepthBuffering::WBuffering) {
-                // W-Buffer (z * scale + w * offset = (z / w * scale + offset) * w)
-                depth *= interpolated_w_inverse.ToFloat32() * wsum;
+            // Do not process the pixels inside the scissor box if the scissor mode is set to
+            // Exclude.
+            if (scissor_exclude && y >= scissor_y1 && y < scissor_y2) {
+                for (u32 lane = 0; lane < SPAN_PIXELS; lane++) {
+                    const u32 x = span_x + lane * 0x10;
+                    if (x >= scissor_x1 && x < scissor_x2) {
+                        coverage &= ~(1U << lane);
+                    }
+                }
             }
 
-            // Clamp the result
-            depth = std::clamp(depth, 0.0f, 1.0f);
-
-            /**
-             * Perspective correct attribute interpolation:
-             * Attribute values cannot be calculated by simple linear interpolation since
-             * they are not linear in screen space. For example, when interpolating a
-             * texture coordinate across two vertices, something simple like
-             *     u = (u0*w0 + u1*w1)/(w0+w1)
-             * will not work. However, the attribute value divided by the
-             * clipspace w-coordinate (u/w) and and the inverse w-coordinate (1/w) are linear
-             * in screenspace. Hence, we can linearly interpolate these two independently and
-             * calculate the interpolated attribute by dividing the results.
-             * I.e.
-             *     u_over_w   = ((u0/v0.pos.w)*w0 + (u1/v1.pos.w)*w1)/(w0+w1)
-             *     one_over_w = (( 1/v0.pos.w)*w0 + ( 1/v1.pos.w)*w1)/(w0+w1)
-             *     u = u_over_w / one_over_w
-             *
-             * The generalization to three vertices is straightforward in baricentric coordinates.
-             **/
-            const auto get_interpolated_attribute = [&](f24 attr0, f24 attr1, f24 attr2) {
-                auto attr_over_w = Common::MakeVec(attr0, attr1, attr2);
-                f24 interpolated_attr_over_w = Common::Dot(attr_over_w, baricentric_coordinates);
-                return interpolated_attr_over_w * interpolated_w_inverse;
-            };
+            if (coverage == 0) {
+                continue;
+            }
 
-            const Common::Vec4<u8> primary_color{
-                static_cast<u8>(
-                    round(get_interpolated_attribute(v0.color.r(), v1.color.r(), v2.color.r())
-                              .ToFloat32() *
-                          255)),
-                static_cast<u8>(
-                    round(get_interpolated_attribute(v0.color.g(), v1.color.g(), v2.color.g())
-                              .ToFloat32() *
-                          255)),
-                static_cast<u8>(
-                    round(get_interpolated_attribute(v0.color.b(), v1.color.b(), v2.color.b())
-                              .ToFloat32() *
-                          255)),
-                static_cast<u8>(
-                    round(get_interpolated_attribute(v0.color.a(), v1.color.a(), v2.color.a())
-                              .ToFloat32() *
-                          255)),
-            };
+            const s32 column = static_cast<s32>((span_x - min_x) >> 4);
+            interpolator.Interpolate(row_w, w_step, column, values);
 
-            std::array<Common::Vec2<f24>, 3> uv;
-            uv[0].u() = get_interpolated_attribute(v0.tc0.u(), v1.tc0.u(), v2.tc0.u());
-            uv[0].v() = get_interpolated_attribute(v0.tc0.v(), v1.tc0.v(), v2.tc0.v());
-            uv[1].u() = get_interpolated_attribute(v0.tc1.u(), v1.tc1.u(), v2.tc1.u());
-            uv[1].v() = get_interpolated_attribute(v0.tc1.v(), v1.tc1.v(), v2.tc1.v());
-            uv[2].u() = get_interpolated_attribute(v0.tc2.u(), v1.tc2.u(), v2.tc2.u());
-            uv[2].v() = get_interpolated_attribute(v0.tc2.v(), v1.tc2.v(), v2.tc2.v());
-
-            // Sample bound texture units.
-            const f24 tc0_w = get_interpolated_attribute(v0.tc0_w, v1.tc0_w, v2.tc0_w);
-            const auto texture_color = TextureColor(uv, textures, tc0_w);
-
-            Common::Vec4<u8> primary_fragment_color = {0, 0, 0, 0};
-            Common::Vec4<u8> secondary_fragment_color = {0, 0, 0, 0};
-
-            if (!regs.lighting.disable) {
-                const auto normquat =
-                    Common::Quaternion<f32>{
-                        {get_interpolated_attribute(v0.quat.x, v1.quat.x, v2.quat.x).ToFloat32(),
-                         get_interpolated_attribute(v0.quat.y, v1.quat.y, v2.quat.y).ToFloat32(),
-                         get_interpolated_attribute(v0.quat.z, v1.quat.z, v2.quat.z).ToFloat32()},
-                        get_interpolated_attribute(v0.quat.w, v1.quat.w, v2.quat.w).ToFloat32(),
-                    }
-                        .Normalized();
+            // The texture combiners run pixel by pixel, as each can depend on the output of the
+            // previous one. The pixels that pass the alpha test are depth tested together.
+            u32 tested = 0;
+            for (u32 lane = 0; lane < SPAN_PIXELS; lane++) {
+                if ((coverage & (1U << lane)) == 0) {
+                    continue;
+                }
+                const u32 x = span_x + lane * 0x10;
+                const auto attribute = [&](SpanAttribute attr) {
+                    return f24::FromFloat32(values.attributes[attr][lane]);
+                };
+                const auto color_channel = [&](SpanAttribute attr) {
+                    return static_cast<u8>(round(attribute(attr).ToFloat32() * 255));
+                };
 
-                const Common::Vec3f view{
-                    get_interpolated_attribute(v0.view.x, v1.view.x, v2.view.x).ToFloat32(),
-                    get_interpolated_attribute(v0.view.y, v1.view.y, v2.view.y).ToFloat32(),
-                    get_interpolated_attribute(v0.view.z, v1.view.z, v2.view.z).ToFloat32(),
+                const Common::Vec4<u8> primary_color{
+                    color_channel(ColorR),
+                    color_channel(ColorG),
+                    color_channel(ColorB),
+                    color_channel(ColorA),
                 };
-                std::tie(primary_fragment_color, secondary_fragment_color) = ComputeFragmentsColors(
-                    regs.lighting, state.lighting, normquat, view, texture_color);
-            }
 
-            // Write the TEV stages.
-            WriteTevConfig(texture_color, tev_stages, primary_color, primary_fragment_color,
-                           secondary_fragment_color);
-
-            const auto& output_merger = regs.framebuffer.output_merger;
-            if (output_merger.fragment_operation_mode ==
-                FramebufferRegs::FragmentOperationMode::Shadow) {
-                u32 depth_int = static_cast<u32>(depth * 0xFFFFFF);
-                // Use green color as the shadow intensity
-                u8 stencil = combiner_output.y;
-                fb.DrawShadowMapPixel(x >> 4, y >> 4, depth_int, stencil);
-                // Skip the normal output merger pipeline if it is in shadow mode
-                continue;
+                std::array<Common::Vec2<f24>, 3> uv;
+                uv[0].u() = attribute(Tc0U);
+                uv[0].v() = attribute(Tc0V);
+                uv[1].u() = attribute(Tc1U);
+                uv[1].v() = attribute(Tc1V);
+                uv[2].u() = attribute(Tc2U);
+                uv[2].v() = attribute(Tc2V);
+
+                // Sample bound texture units.
+                const auto texture_color = TextureColor(uv, textures, attribute(Tc0W));
+
+                Common::Vec4<u8> primary_fragment_color = {0, 0, 0, 0};
+                Common::Vec4<u8> secondary_fragment_color = {0, 0, 0, 0};
+
+                if (!regs.lighting.disable) {
+                    const auto normquat =
+                        Common::Quaternion<f32>{
+                            {attribute(QuatX).ToFloat32(), attribute(QuatY).ToFloat32(),
+                             attribute(QuatZ).ToFloat32()},
+                            attribute(QuatW).ToFloat32(),
+                        }
+                            .Normalized();
+
+                    const Common::Vec3f view{
+                        attribute(ViewX).ToFloat32(),
+                        attribute(ViewY).ToFloat32(),
+                        attribute(ViewZ).ToFloat32(),
+                    };
+                    std::tie(primary_fragment_color, secondary_fragment_color) =
+                        ComputeFragmentsColors(regs.lighting, state.lighting, normquat, view,
+                                               texture_color);
+                }
+
+                // Write the TEV stages.
+                if (draw_state->pipeline->generic) {
+                    WriteTevConfig(texture_color, tev_stages, primary_color,
+                                   primary_fragment_color, secondary_fragment_color,
+                                   combiner_output);
+                } else {
+                    WriteTevPipeline(texture_color, primary_color, primary_fragment_color,
+                                     secondary_fragment_color, combiner_output);
+                }
+                last_pixel = (y << 16) | x;
+                shaded = true;
+
+                const float depth = values.depth[lane];
+                if (shadow_mode) {
+                    u32 depth_int = static_cast<u32>(depth * 0xFFFFFF);
+                    // Use green color as the shadow intensity
+                    u8 stencil = combiner_output.y;
+                    fb.DrawShadowMapPixel(x >> 4, y >> 4, depth_int, stencil);
+                    // Skip the normal output merger pipeline if it is in shadow mode
+                    continue;
+                }
+
+                // Does alpha testing happen before or after stencil?
+                if (!DoAlphaTest(combiner_output.a())) {
+                    continue;
+                }
+                WriteFog(combiner_output, depth);
+                span_output[lane] = combiner_output;
+                tested |= 1U << lane;
             }
 
-            // Does alpha testing happen before or after stencil?
-            if (!DoAlphaTest(combiner_output.a())) {
+            if (tested == 0) {
                 continue;
             }
-            WriteFog(combiner_output, depth);
-            if (!DoDepthStencilTest(x, y, depth)) {
+            const u32 passed = DoDepthStencilTestSpan(span_x, y, values.depth, tested);
+            if (regs.framebuffer.framebuffer.allow_color_write == 0) {
                 continue;
             }
-            const auto result = PixelColor(x, y, combiner_output);
-            if (regs.framebuffer.framebuffer.allow_color_write != 0) {
+            for (u32 lane = 0; lane < SPAN_PIXELS; lane++) {
+                if ((passed & (1U << lane)) == 0) {
+                    continue;
+                }
+                const u32 x = span_x + lane * 0x10;
+                const auto result = PixelColor(x, y, span_output[lane]);
                 fb.DrawPixel(x >> 4, y >> 4, result);
             }
         }
     }
+
+    return shaded;
+}
+
+RasterizerSoftware::DrawState RasterizerSoftware::MakeDrawState() {
+    DrawState draw{};
+    draw.binned = workers && CanBinDraw();
+    draw.pipeline = &GetPixelPipeline();
+    return draw;
+}
+
+const RasterizerSoftware::PixelPipeline& RasterizerSoftware::GetPixelPipeline() {
+    const auto tev_stages = regs.texturing.GetTevStages();
+    const auto& buffer_input = regs.texturing.tev_combiner_buffer_input;
+    const auto& output_merger = regs.framebuffer.output_merger;
+
+    std::size_t key = Common::ComputeHash64(tev_stages.data(), sizeof(tev_stages));
+    Common::HashCombine(key, buffer_input.update_mask_rgb | buffer_input.update_mask_a << 4);
+    Common::HashCombine(key, regs.texturing.tev_combiner_buffer_color.raw);
+    Common::HashCombine(key, Common::ComputeStructHash64(output_merger));
+
+    if (const auto it = pipelines.find(key); it != pipelines.end()) {
+        return *it->second;
+    }
+    if (pipelines.size() >= MAX_PIXEL_PIPELINES) {
+        pipelines.clear();
+    }
+
+    using PipelineSlot = PixelPipeline::SourceSlot;
+    using Source = TexturingRegs::TevStageConfig::Source;
+    using Operation = TexturingRegs::TevStageConfig::Operation;
+    auto pipeline = std::make_unique<PixelPipeline>();
+    pipeline->generic = false;
+
+    const auto get_slot = [&pipeline](Source source) {
+        switch (source) {
+        case Source::PrimaryColor:
+            return PipelineSlot::PrimaryColor;
+        case Source::PrimaryFragmentColor:
+            return PipelineSlot::PrimaryFragmentColor;
+        case Source::SecondaryFragmentColor:
+            return PipelineSlot::SecondaryFragmentColor;
+        case Source::Texture0:
+        case Source::Texture1:
+        case Source::Texture2:
+        case Source::Texture3:
+            return static_cast<PipelineSlot>(PipelineSlot::Texture0 +
+                                             (static_cast<u32>(source) -
+                                              static_cast<u32>(Source::Texture0)));
+        case Source::PreviousBuffer:
+            return PipelineSlot::PreviousBuffer;
+        case Source::Constant:
+            return PipelineSlot::Constant;
+        case Source::Previous:
+            return PipelineSlot::Previous;
+        default:
+            pipeline->generic = true;
+            return PipelineSlot::PrimaryColor;
+        }
+    };
+
+    for (std::size_t i = 0; i < tev_stages.size(); i++) {
+        const auto& config = tev_stages[i];
+        auto& stage = pipeline->stages[i];
+        stage.color_sources = {get_slot(config.color_source1), get_slot(config.color_source2),
+                               get_slot(config.color_source3)};
+        stage.color_modifiers = {GetColorModifierFunc(config.color_modifier1),
+                                 GetColorModifierFunc(config.color_modifier2),
+                                 GetColorModifierFunc(config.color_modifier3)};
+        stage.color_combine = GetColorCombineFunc(config.color_op);
+        stage.alpha_sources = {get_slot(config.alpha_source1), get_slot(config.alpha_source2),
+                               get_slot(config.alpha_source3)};
+        stage.alpha_modifiers = {GetAlphaModifierFunc(config.alpha_modifier1),
+                                 GetAlphaModifierFunc(config.alpha_modifier2),
+                                 GetAlphaModifierFunc(config.alpha_modifier3)};
+        const bool dot3_rgba = config.color_op == Operation::Dot3_RGBA;
+        stage.alpha_combine = dot3_rgba ? nullptr : GetAlphaCombineFunc(config.alpha_op);
+        stage.constant = Common::MakeVec(config.const_r.Value(), config.const_g.Value(),
+                                         config.const_b.Value(), config.const_a.Value())
+                             .Cast<u8>();
+        stage.color_multiplier = config.GetColorMultiplier();
+        stage.alpha_multiplier = config.GetAlphaMultiplier();
+        stage.passthrough =
+            config.color_op == Operation::Replace && config.alpha_op == Operation::Replace &&
+            config.color_source1 == Source::Previous && config.alpha_source1 == Source::Previous &&
+            config.color_modifier1 == TexturingRegs::TevStageConfig::ColorModifier::SourceColor &&
+            config.alpha_modifier1 == TexturingRegs::TevStageConfig::AlphaModifier::SourceAlpha &&
+            config.GetColorMultiplier() == 1 && config.GetAlphaMultiplier() == 1;
+        stage.updates_buffer_color =
+            buffer_input.TevStageUpdatesCombinerBufferColor(static_cast<unsigned>(i));
+        stage.updates_buffer_alpha =
+            buffer_input.TevStageUpdatesCombinerBufferAlpha(static_cast<unsigned>(i));
+
+        const bool known_functions =
+            std::ranges::all_of(stage.color_modifiers, [](auto func) { return func; }) &&
+            std::ranges::all_of(stage.alpha_modifiers, [](auto func) { return func; }) &&
+            stage.color_combine && (dot3_rgba || stage.alpha_combine);
+        if (!stage.passthrough && !known_functions) {
+            pipeline->generic = true;
+        }
+    }
+
+    const auto& buffer_color = regs.texturing.tev_combiner_buffer_color;
+    pipeline->combiner_buffer_color =
+        Common::MakeVec(buffer_color.r.Value(), buffer_color.g.Value(), buffer_color.b.Value(),
+                        buffer_color.a.Value())
+            .Cast<u8>();
+
+    // Blending with (One, Zero, Add) and the Copy logic op both output the source color as is.
+    using BlendFactor = FramebufferRegs::BlendFactor;
+    using BlendEquation = FramebufferRegs::BlendEquation;
+    const auto& blending = output_merger.alpha_blending;
+    const bool replace_blend =
+        output_merger.alphablend_enable
+            ? blending.factor_source_rgb == BlendFactor::One &&
+                  blending.factor_source_a == BlendFactor::One &&
+                  blending.factor_dest_rgb == BlendFactor::Zero &&
+                  blending.factor_dest_a == BlendFactor::Zero &&
+                  blending.blend_equation_rgb == BlendEquation::Add &&
+                  blending.blend_equation_a == BlendEquation::Add
+            : output_merger.logic_op == FramebufferRegs::LogicOp::Copy;
+    pipeline->replace_color = replace_blend && output_merger.red_enable &&
+                              output_merger.green_enable && output_merger.blue_enable &&
+                              output_merger.alpha_enable;
+
+    return *pipelines.emplace(key, std::move(pipeline)).first->second;
+}
+
+bool RasterizerSoftware::CanBinDraw() const {
+    // Tiles are shaded independently, which is only equivalent to the serial order when no pixel
+    // depends on another one. The first TEV stage may read the combiner output of the previously
+    // shaded pixel, and textures may sample the buffers that are being rendered to.
+    using Source = TexturingRegs::TevStageConfig::Source;
+    const auto& first_stage = regs.texturing.GetTevStages()[0];
+    for (const Source source :
+         {first_stage.color_source1.Value(), first_stage.color_source2.Value(),
+          first_stage.color_source3.Value(), first_stage.alpha_source1.Value(),
+          first_stage.alpha_source2.Value(), first_stage.alpha_source3.Value()}) {
+        if (source == Source::Previous) {
+            return false;
+        }
+    }
+
+    const auto& framebuffer = regs.framebuffer.framebuffer;
+    const u32 num_pixels = framebuffer.width * framebuffer.height;
+    const PAddr color_addr = framebuffer.GetColorBufferPhysicalAddress();
+    const PAddr color_end =
+        color_addr + num_pixels * FramebufferRegs::BytesPerColorPixel(framebuffer.color_format);
+    const PAddr depth_addr = framebuffer.GetDepthBufferPhysicalAddress();
+    const PAddr depth_end =
+        depth_addr + num_pixels * FramebufferRegs::BytesPerDepthPixel(framebuffer.depth_format);
+
+    for (const auto& texture : regs.texturing.GetTextures()) {
+        if (!texture.enabled) {
+            continue;
+        }
+        const PAddr texture_addr = texture.config.GetPhysicalAddress();
+        const PAddr texture_end =
+            texture_addr + TexturingRegs::NibblesPerPixel(texture.format) *
+                               texture.config.width * texture.config.height / 2;
+        if ((texture_addr < color_end && color_addr < texture_end) ||
+            (texture_addr < depth_end && depth_addr < texture_end)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void RasterizerSoftware::BinTriangle(const Triangle& triangle) {
+    if (triangle.min_x >= triangle.max_x || triangle.min_y >= triangle.max_y) {
+        return;
+    }
+
+    const u32 index = static_cast<u32>(triangles.size());
+    triangles.push_back(triangle);
+
+    const u32 tile_x0 = triangle.min_x >> TILE_SHIFT;
+    const u32 tile_y0 = triangle.min_y >> TILE_SHIFT;
+    const u32 tile_x1 = (triangle.max_x - 1U) >> TILE_SHIFT;
+    const u32 tile_y1 = (triangle.max_y - 1U) >> TILE_SHIFT;
+    for (u32 tile_y = tile_y0; tile_y <= tile_y1; tile_y++) {
+        for (u32 tile_x = tile_x0; tile_x <= tile_x1; tile_x++) {
+            const u32 tile = tile_y * TILES_PER_AXIS + tile_x;
+            if (bins[tile].empty()) {
+                active_bins.push_back(tile);
+            }
+            bins[tile].push_back(index);
+        }
+    }
+}
+
+void RasterizerSoftware::FlushBins() {
+    if (triangles.empty()) {
+        draw_state.reset();
+        return;
+    }
+
+    MICROPROFILE_SCOPE(GPU_Rasterization);
+
+    // The combiner output of the last pixel in submission order has to be carried over to the
+    // next draw, so each tile remembers the last pixel it shaded. Keys are ordered like the
+    // serial rasterizer visits pixels: by triangle, then by row, then by column.
+    struct TileResult {
+        u64 last_key;
+        Common::Vec4<u8> combiner_output;
+        bool shaded;
+    };
+    std::vector<TileResult> results(active_bins.size());
+    std::atomic<std::size_t> next_bin{0};
+
+    const auto shade_bins = [this, &results, &next_bin] {
+        std::size_t i;
+        while ((i = next_bin.fetch_add(1, std::memory_order_relaxed)) < active_bins.size()) {
+            const u32 tile = active_bins[i];
+            const u32 x0 = (tile % TILES_PER_AXIS) << TILE_SHIFT;
+            const u32 y0 = (tile / TILES_PER_AXIS) << TILE_SHIFT;
+            auto& result = results[i];
+            result = {};
+            for (const u32 index : bins[tile]) {
+                u32 last_pixel;
+                if (RasterizeTriangle(triangles[index], x0, y0, x0 + TILE_SIZE, y0 + TILE_SIZE,
+                                      result.combiner_output, last_pixel)) {
+                    result.last_key = (static_cast<u64>(index) << 32) | last_pixel;
+                    result.shaded = true;
+                }
+            }
+        }
+    };
+
+    const std::size_t num_tasks = std::min(workers->NumWorkers(), active_bins.size());
+    for (std::size_t i = 0; i < num_tasks; i++) {
+        workers->QueueWork(shade_bins);
+    }
+    workers->WaitForRequests();
+
+    const TileResult* last = nullptr;
+    for (const auto& result : results) {
+        if (result.shaded && (!last || result.last_key > last->last_key)) {
+            last = &result;
+        }
+    }
+    if (last) {
+        combiner_output = last->combiner_output;
+    }
+
+    for (const u32 tile : active_bins) {
+        bins[tile].clear();
+    }
+    active_bins.clear();
+    triangles.clear();
+    draw_state.reset();
 }
 
 std::array<Common::Vec4<u8>, 4> RasterizerSoftware::TextureColor(
@@ -574,6 +958,10 @@ std::array<Common::Vec4<u8>, 4> RasterizerSoftware::TextureColor(
 
 Common::Vec4<u8> RasterizerSoftware::PixelColor(u16 x, u16 y,
                                                 Common::Vec4<u8>& combiner_output) const {
+    if (draw_state->pipeline->replace_color) {
+        return combiner_output;
+    }
+
     const auto dest = fb.GetPixel(x >> 4, y >> 4);
     Common::Vec4<u8> blend_output = combiner_output;
 
@@ -663,11 +1051,74 @@ Common::Vec4<u8> RasterizerSoftware::PixelColor(u16 x, u16 y,
     return result;
 }
 
+void RasterizerSoftware::WriteTevPipeline(std::span<const Common::Vec4<u8>, 4> texture_color,
+                                          Common::Vec4<u8> primary_color,
+                                          Common::Vec4<u8> primary_fragment_color,
+                                          Common::Vec4<u8> secondary_fragment_color,
+                                          Common::Vec4<u8>& combiner_output) const {
+    using SourceSlot = PixelPipeline::SourceSlot;
+    const PixelPipeline& pipeline = *draw_state->pipeline;
+
+    std::array<Common::Vec4<u8>, SourceSlot::NumSourceSlots> sources;
+    sources[SourceSlot::PrimaryColor] = primary_color;
+    sources[SourceSlot::PrimaryFragmentColor] = primary_fragment_color;
+    sources[SourceSlot::SecondaryFragmentColor] = secondary_fragment_color;
+    for (u32 i = 0; i < texture_color.size(); i++) {
+        sources[SourceSlot::Texture0 + i] = texture_color[i];
+    }
+
+    Common::Vec4<u8> combiner_buffer = {0, 0, 0, 0};
+    Common::Vec4<u8> next_combiner_buffer = pipeline.combiner_buffer_color;
+
+    for (const auto& stage : pipeline.stages) {
+        if (!stage.passthrough) {
+            sources[SourceSlot::PreviousBuffer] = combiner_buffer;
+            sources[SourceSlot::Constant] = stage.constant;
+            sources[SourceSlot::Previous] = combiner_output;
+
+            const std::array<Common::Vec3<u8>, 3> color_result = {
+                stage.color_modifiers[0](sources[stage.color_sources[0]]),
+                stage.color_modifiers[1](sources[stage.color_sources[1]]),
+                stage.color_modifiers[2](sources[stage.color_sources[2]]),
+            };
+            const Common::Vec3<u8> color_output = stage.color_combine(color_result);
+
+            u8 alpha_output;
+            if (!stage.alpha_combine) {
+                // result of Dot3_RGBA operation is also placed to the alpha component
+                alpha_output = color_output.x;
+            } else {
+                const std::array<u8, 3> alpha_result = {{
+                    stage.alpha_modifiers[0](sources[stage.alpha_sources[0]]),
+                    stage.alpha_modifiers[1](sources[stage.alpha_sources[1]]),
+                    stage.alpha_modifiers[2](sources[stage.alpha_sources[2]]),
+                }};
+                alpha_output = stage.alpha_combine(alpha_result);
+            }
+
+            combiner_output[0] = std::min(255U, color_output.r() * stage.color_multiplier);
+            combiner_output[1] = std::min(255U, color_output.g() * stage.color_multiplier);
+            combiner_output[2] = std::min(255U, color_output.b() * stage.color_multiplier);
+            combiner_output[3] = std::min(255U, alpha_output * stage.alpha_multiplier);
+        }
+
+        combiner_buffer = next_combiner_buffer;
+        if (stage.updates_buffer_color) {
+            next_combiner_buffer.r() = combiner_output.r();
+            next_combiner_buffer.g() = combiner_output.g();
+            next_combiner_buffer.b() = combiner_output.b();
+        }
+        if (stage.updates_buffer_alpha) {
+            next_combiner_buffer.a() = combiner_output.a();
+        }
+    }
+}
+
 void RasterizerSoftware::WriteTevConfig(
     std::span<const Common::Vec4<u8>, 4> texture_color,
     std::span<const Pica::TexturingRegs::TevStageConfig, 6> tev_stages,
     Common::Vec4<u8> primary_color, Common::Vec4<u8> primary_fragment_color,
-    Common::Vec4<u8> secondary_fragment_color) {
+    Common::Vec4<u8> secondary_fragment_color, Common::Vec4<u8>& combiner_output) const {
     /**
      * Texture environment - consists of 6 stages of color and alpha combining.
      * Color combiners take three input color values from some source (e.g. interpolated
@@ -684,10 +1135,32 @@ void RasterizerSoftware::WriteTevConfig(
                         regs.texturing.tev_combiner_buffer_color.a.Value())
             .Cast<u8>();
 
+    const auto update_combiner_buffer = [&](u32 tev_stage_index) {
+        combiner_buffer = next_combiner_buffer;
+
+        if (regs.texturing.tev_combiner_buffer_input.TevStageUpdatesCombinerBufferColor(
+                tev_stage_index)) {
+            next_combiner_buffer.r() = combiner_output.r();
+            next_combiner_buffer.g() = combiner_output.g();
+            next_combiner_buffer.b() = combiner_output.b();
+        }
+
+        if (regs.texturing.tev_combiner_buffer_input.TevStageUpdatesCombinerBufferAlpha(
+                tev_stage_index)) {
+            next_combiner_buffer.a() = combiner_output.a();
+        }
+    };
+
     for (u32 tev_stage_index = 0; tev_stage_index < tev_stages.size(); ++tev_stage_index) {
         const auto& tev_stage = tev_stages[tev_stage_index];
         using Source = TexturingRegs::TevStageConfig::Source;
 
+        if (draw_state->pipeline->stages[tev_stage_index].passthrough) {
+            // The combiner output is left untouched, only the combiner buffer advances.
+            update_combiner_buffer(tev_stage_index);
+            continue;
+        }
+
         auto get_source = [&](Source source) -> Common::Vec4<u8> {
             switch (source) {
             case Source::PrimaryColor:
@@ -752,19 +1225,7 @@ void RasterizerSoftware::WriteTevConfig(
         combiner_output[2] = std::min(255U, color_output.b() * tev_stage.GetColorMultiplier());
         combiner_output[3] = std::min(255U, alpha_output * tev_stage.GetAlphaMultiplier());
 
-        combiner_buffer = next_combiner_buffer;
-
-        if (regs.texturing.tev_combiner_buffer_input.TevStageUpdatesCombinerBufferColor(
-                tev_stage_index)) {
-            next_combiner_buffer.r() = combiner_output.r();
-            next_combiner_buffer.g() = combiner_output.g();
-            next_combiner_buffer.b() = combiner_output.b();
-        }
-
-        if (regs.texturing.tev_combiner_buffer_input.TevStageUpdatesCombinerBufferAlpha(
-                tev_stage_index)) {
-            next_combiner_buffer.a() = combiner_output.a();
-        }
+        update_combiner_buffer(tev_stage_index);
     }
 }
 
@@ -828,6 +1289,49 @@ bool RasterizerSoftware::DoAlphaTest(u8 alpha) const {
     }
 }
 
+u32 RasterizerSoftware::DoDepthStencilTestSpan(u32 x, u32 y,
+                                               std::span<const float, 4> depth,
+                                               u32 mask) const {
+    const auto& framebuffer = regs.framebuffer.framebuffer;
+    const auto& output_merger = regs.framebuffer.output_merger;
+    const auto lane_x = [x](u32 lane) { return static_cast<u16>(x + lane * 0x10); };
+
+    // Stencil updates depend on the outcome of each test, so test those pixels one by one
+    if (output_merger.stencil_test.enable &&
+        framebuffer.depth_format == FramebufferRegs::DepthFormat::D24S8) {
+        u32 passed = 0;
+        for (u32 lane = 0; lane < SPAN_PIXELS; lane++) {
+            if ((mask & (1U << lane)) != 0 &&
+                DoDepthStencilTest(lane_x(lane), static_cast<u16>(y), depth[lane])) {
+                passed |= 1U << lane;
+            }
+        }
+        return passed;
+    }
+
+    const u32 num_bits = FramebufferRegs::DepthBitsPerPixel(framebuffer.depth_format);
+    const auto z = DepthToInts({depth[0], depth[1], depth[2], depth[3]}, (1 << num_bits) - 1);
+
+    u32 passed = mask;
+    if (output_merger.depth_test_enable) {
+        std::array<u32, SPAN_PIXELS> ref_z{};
+        for (u32 lane = 0; lane < SPAN_PIXELS; lane++) {
+            if ((mask & (1U << lane)) != 0) {
+                ref_z[lane] = fb.GetDepth(lane_x(lane) >> 4, y >> 4);
+            }
+        }
+        passed &= CompareLanes(output_merger.depth_test_func, z, ref_z);
+    }
+    if (framebuffer.allow_depth_stencil_write != 0 && output_merger.depth_write_enable) {
+        for (u32 lane = 0; lane < SPAN_PIXELS; lane++) {
+            if ((passed & (1U << lane)) != 0) {
+                fb.SetDepth(lane_x(lane) >> 4, y >> 4, z[lane]);
+            }
+        }
+    }
+    return passed;
+}
+
 bool RasterizerSoftware::DoDepthStencilTest(u16 x, u16 y, float depth) const {
     const auto& framebuffer = regs.framebuffer.framebuffer;
     const auto stencil_test = regs.framebuffer.output_merger.stencil_test;
@@ -4,8 +4,13 @@
 
 #pragma once
 
+#include <memory>
+#include <optional>
 #include <span>
+#include <unordered_map>
+#include <vector>
 
+#include "common/thread_worker.h"
 #include "video_core/rasterizer_interface.h"
 #include "video_core/regs_texturing.h"
 #include "video_core/renderer_software/sw_clipper.h"
@@ -27,18 +32,39 @@ struct Vertex;
 class RasterizerSoftware : public VideoCore::RasterizerInterface {
 public:
     explicit RasterizerSoftware(Memory::MemorySystem& memory);
+    ~RasterizerSoftware() override;
 
     void AddTriangle(const Pica::Shader::OutputVertex& v0, const Pica::Shader::OutputVertex& v1,
                      const Pica::Shader::OutputVertex& v2) override;
-    void DrawTriangles() override {}
+    void DrawTriangles() override;
     void NotifyPicaRegisterChanged(u32 id) override {}
-    void FlushAll() override {}
-    void FlushRegion(PAddr addr, u32 size) override {}
-    void InvalidateRegion(PAddr addr, u32 size) override {}
-    void FlushAndInvalidateRegion(PAddr addr, u32 size) override {}
-    void ClearAll(bool flush) override {}
+    void FlushAll() override;
+    void FlushRegion(PAddr addr, u32 size) override;
+    void InvalidateRegion(PAddr addr, u32 size) override;
+    void FlushAndInvalidateRegion(PAddr addr, u32 size) override;
+    void ClearAll(bool flush) override;
 
 private:
+    struct Triangle;
+    struct PixelPipeline;
+
+    /// Pixel pipeline configuration that stays constant for the duration of a draw.
+    struct DrawState {
+        /// Whether the triangles of the draw are binned and shaded by the worker pool.
+        bool binned;
+        /// Pixel pipeline specialized for the TEV and output merger configuration of the draw.
+        const PixelPipeline* pipeline;
+    };
+
+    /// Resolves the draw state from the current register configuration.
+    DrawState MakeDrawState();
+
+    /**
+     * Returns the pixel pipeline specialized for the current TEV and output merger
+     * configuration, creating it the first time the configuration is used.
+     **/
+    const PixelPipeline& GetPixelPipeline();
+
     /// Computes the screen coordinates of the provided vertex.
     void MakeScreenCoords(Vertex& vtx);
 
@@ -46,6 +72,23 @@ private:
     void ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2,
                          bool reversed = false);
 
+    /**
+     * Rasterizes the pixels of the triangle that lie inside the rectangle [x0, x1) x [y0, y1),
+     * given in 12.4 fixed point coordinates. Returns true if any pixel reached the texture
+     * combiners, in which case last_pixel holds the packed (y << 16 | x) position of the last one.
+     **/
+    bool RasterizeTriangle(const Triangle& triangle, u32 x0, u32 y0, u32 x1, u32 y1,
+                           Common::Vec4<u8>& combiner_output, u32& last_pixel) const;
+
+    /// Returns true if the current draw can be split into screen tiles and shaded in parallel.
+    bool CanBinDraw() const;
+
+    /// Records the triangle into every screen tile its bounding box overlaps.
+    void BinTriangle(const Triangle& triangle);
+
+    /// Shades all binned triangles on the worker pool and clears the bins.
+    void FlushBins();
+
     /// Returns the texture color of the currently processed pixel.
     std::array<Common::Vec4<u8>, 4> TextureColor(
         std::span<const Common::Vec2<f24>, 3> uv,
@@ -54,11 +97,18 @@ private:
     /// Returns the final pixel color with blending or logic ops applied.
     Common::Vec4<u8> PixelColor(u16 x, u16 y, Common::Vec4<u8>& combiner_output) const;
 
-    /// Emulates the TEV configuration and returns the combiner output.
+    /// Runs the TEV stages of the specialized pipeline and writes the combiner output.
+    void WriteTevPipeline(std::span<const Common::Vec4<u8>, 4> texture_color,
+                          Common::Vec4<u8> primary_color, Common::Vec4<u8> primary_fragment_color,
+                          Common::Vec4<u8> secondary_fragment_color,
+                          Common::Vec4<u8>& combiner_output) const;
+
+    /// Emulates the TEV configuration and writes the combiner output.
     void WriteTevConfig(std::span<const Common::Vec4<u8>, 4> texture_color,
                         std::span<const Pica::TexturingRegs::TevStageConfig, 6> tev_stages,
                         Common::Vec4<u8> primary_color, Common::Vec4<u8> primary_fragment_color,
-                        Common::Vec4<u8> secondary_fragment_color);
+                        Common::Vec4<u8> secondary_fragment_color,
+                        Common::Vec4<u8>& combiner_output) const;
 
     /// Blends fog to the combiner output if enabled.
     void WriteFog(Common::Vec4<u8>& combiner_output, float depth) const;
@@ -69,6 +119,12 @@ private:
     /// Performs the depth stencil test. Returns false if the test failed.
     bool DoDepthStencilTest(u16 x, u16 y, float depth) const;
 
+    /**
+     * Performs the depth stencil test for the pixels of a span of four, starting at x and given in
+     * mask. Returns the mask of the pixels that passed.
+     **/
+    u32 DoDepthStencilTestSpan(u32 x, u32 y, std::span<const float, 4> depth, u32 mask) const;
+
 private:
     Memory::MemorySystem& memory;
     Pica::State& state;
@@ -77,6 +133,15 @@ private:
     // Kirby Blowout Blast relies on the combiner output of a previous draw
     // in order to render the sky correctly.
     Common::Vec4<u8> combiner_output{};
+
+    // Tiled rendering state. Triangles of a draw are recorded into screen tile bins and
+    // shaded by the worker pool when the draw is flushed.
+    std::unique_ptr<Common::ThreadWorker> workers;
+    std::vector<Triangle> triangles;
+    std::vector<std::vector<u32>> bins;
+    std::vector<u32> active_bins;
+    std::optional<DrawState> draw_state;
+    std::unordered_map<u64, std::unique_ptr<PixelPipeline>> pipelines;
 };
 
 } // namespace SwRenderer
@@ -0,0 +1,483 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include "common/arch.h"
+#include "common/common_types.h"
+#include "video_core/pica_types.h"
+#include "video_core/regs_framebuffer.h"
+#include "video_core/shader/shader.h"
+
+#if CITRA_ARCH(x86_64)
+#include <emmintrin.h>
+#elif CITRA_ARCH(arm64)
+#include <arm_neon.h>
+#endif
+
+namespace SwRenderer {
+
+using Pica::f24;
+
+struct Vertex : Pica::Shader::OutputVertex {
+    Vertex(const OutputVertex& v) : OutputVertex(v) {}
+
+    /// Attributes used to store intermediate results position after perspective divide.
+    Common::Vec3<f24> screenpos;
+
+    /**
+     * Linear interpolation
+     * factor: 0=this, 1=vtx
+     * Note: This function cannot be called after perspective divide.
+     **/
+    void Lerp(f24 factor, const Vertex& vtx) {
+        pos = pos * factor + vtx.pos * (f24::One() - factor);
+        quat = quat * factor + vtx.quat * (f24::One() - factor);
+        color = color * factor + vtx.color * (f24::One() - factor);
+        tc0 = tc0 * factor + vtx.tc0 * (f24::One() - factor);
+        tc1 = tc1 * factor + vtx.tc1 * (f24::One() - factor);
+        tc0_w = tc0_w * factor + vtx.tc0_w * (f24::One() - factor);
+        view = view * factor + vtx.view * (f24::One() - factor);
+        tc2 = tc2 * factor + vtx.tc2 * (f24::One() - factor);
+    }
+
+    /**
+     * Linear interpolation
+     * factor: 0=v0, 1=v1
+     * Note: This function cannot be called after perspective divide.
+     **/
+    static Vertex Lerp(f24 factor, const Vertex& v0, const Vertex& v1) {
+        Vertex ret = v0;
+        ret.Lerp(factor, v1);
+        return ret;
+    }
+};
+
+/// Number of horizontally adjacent pixels evaluated together by the span kernels.
+constexpr u32 SPAN_PIXELS = 4;
+
+// Four wide float operations of the span kernels, with SSE2 and NEON implementations and a scalar
+// fallback for the other architectures.
+#if CITRA_ARCH(x86_64)
+using F32x4 = __m128;
+
+inline F32x4 Splat(float value) {
+    return _mm_set1_ps(value);
+}
+
+inline F32x4 FromInts(const std::array<s32, SPAN_PIXELS>& values) {
+    return _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(values.data())));
+}
+
+inline F32x4 Add(F32x4 a, F32x4 b) {
+    return _mm_add_ps(a, b);
+}
+
+inline F32x4 Mul(F32x4 a, F32x4 b) {
+    return _mm_mul_ps(a, b);
+}
+
+inline F32x4 Div(F32x4 a, F32x4 b) {
+    return _mm_div_ps(a, b);
+}
+
+/// Multiplies like f24 does, giving 0 instead of NaN when multiplying inf by zero.
+inline F32x4 PicaMul(F32x4 a, F32x4 b) {
+    const __m128 result = _mm_mul_ps(a, b);
+    const __m128 nan_result = _mm_cmpunord_ps(result, result);
+    const __m128 nan_input = _mm_cmpunord_ps(a, b);
+    return _mm_andnot_ps(_mm_andnot_ps(nan_input, nan_result), result);
+}
+
+/// Clamps to [0, 1] like std::clamp, which lets NaN through.
+inline F32x4 Clamp01(F32x4 value) {
+    const __m128 one = _mm_set1_ps(1.0f);
+    value = _mm_andnot_ps(_mm_cmplt_ps(value, _mm_setzero_ps()), value);
+    const __m128 above = _mm_cmplt_ps(one, value);
+    return _mm_or_ps(_mm_and_ps(above, one), _mm_andnot_ps(above, value));
+}
+
+inline void Store(std::array<float, SPAN_PIXELS>& out, F32x4 value) {
+    _mm_storeu_ps(out.data(), value);
+}
+#elif CITRA_ARCH(arm64)
+using F32x4 = float32x4_t;
+
+inline F32x4 Splat(float value) {
+    return vdupq_n_f32(value);
+}
+
+inline F32x4 FromInts(const std::array<s32, SPAN_PIXELS>& values) {
+    return vcvtq_f32_s32(vld1q_s32(values.data()));
+}
+
+inline F32x4 Add(F32x4 a, F32x4 b) {
+    return vaddq_f32(a, b);
+}
+
+inline F32x4 Mul(F32x4 a, F32x4 b) {
+    return vmulq_f32(a, b);
+}
+
+inline F32x4 Div(F32x4 a, F32x4 b) {
+    return vdivq_f32(a, b);
+}
+
+/// Multiplies like f24 does, giving 0 instead of NaN when multiplying inf by zero.
+inline F32x4 PicaMul(F32x4 a, F32x4 b) {
+    const float32x4_t result = vmulq_f32(a, b);
+    const uint32x4_t nan_result = vmvnq_u32(vceqq_f32(result, result));
+    const uint32x4_t ordered_input = vandq_u32(vceqq_f32(a, a), vceqq_f32(b, b));
+    return vbslq_f32(vandq_u32(nan_result, ordered_input), vdupq_n_f32(0.0f), result);
+}
+
+/// Clamps to [0, 1] like std::clamp, which lets NaN through.
+inline F32x4 Clamp01(F32x4 value) {
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    value = vbslq_f32(vcltq_f32(value, zero), zero, value);
+    return vbslq_f32(vcltq_f32(one, value), one, value);
+}
+
+inline void Store(std::array<float, SPAN_PIXELS>& out, F32x4 value) {
+    vst1q_f32(out.data(), value);
+}
+#else
+using F32x4 = std::array<float, SPAN_PIXELS>;
+
+template <typename Op>
+inline F32x4 PerLane(F32x4 a, F32x4 b, Op op) {
+    for (u32 lane = 0; lane < SPAN_PIXELS; lane++) {
+        a[lane] = op(a[lane], b[lane]);
+    }
+    return a;
+}
+
+inline F32x4 Splat(float value) {
+    F32x4 result;
+    result.fill(value);
+    return result;
+}
+
+inline F32x4 FromInts(const std::array<s32, SPAN_PIXELS>& values) {
+    F32x4 result;
+    for (u32 lane = 0; lane < SPAN_PIXELS; lane++) {
+        result[lane] = static_cast<float>(values[lane]);
+    }
+    return result;
+}
+
+inline F32x4 Add(F32x4 a, F32x4 b) {
+    return PerLane(a, b, [](float x, float y) { return x + y; });
+}
+
+inline F32x4 Mul(F32x4 a, F32x4 b) {
+    return PerLane(a, b, [](float x, float y) { return x * y; });
+}
+
+inline F32x4 Div(F32x4 a, F32x4 b) {
+    return PerLane(a, b, [](float x, float y) { return x / y; });
+}
+
+/// Multiplies like f24 does, giving 0 instead of NaN when multiplying inf by zero.
+inline F32x4 PicaMul(F32x4 a, F32x4 b) {
+    return PerLane(a, b, [](float x, float y) {
+        return (f24::FromFloat32(x) * f24::FromFloat32(y)).ToFloat32();
+    });
+}
+
+/// Clamps to [0, 1] like std::clamp, which lets NaN through.
+inline F32x4 Clamp01(F32x4 value) {
+    for (float& lane : value) {
+        lane = std::clamp(lane, 0.0f, 1.0f);
+    }
+    return value;
+}
+
+inline void Store(std::array<float, SPAN_PIXELS>& out, F32x4 value) {
+    out = value;
+}
+#endif
+
+/**
+ * Converts depth values in [0, 1] to integers of max_value steps. NaN converts to 0, as the
+ * scalar float to integer conversion does.
+ **/
+inline std::array<u32, SPAN_PIXELS> DepthToInts(const std::array<float, SPAN_PIXELS>& depth,
+                                                u32 max_value) {
+    std::array<u32, SPAN_PIXELS> result;
+#if CITRA_ARCH(x86_64)
+    __m128 value = _mm_loadu_ps(depth.data());
+    value = _mm_and_ps(_mm_cmpord_ps(value, value), value);
+    value = _mm_mul_ps(value, _mm_set1_ps(static_cast<float>(max_value)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(result.data()), _mm_cvttps_epi32(value));
+#elif CITRA_ARCH(arm64)
+    const float32x4_t value =
+        vmulq_f32(vld1q_f32(depth.data()), vdupq_n_f32(static_cast<float>(max_value)));
+    vst1q_u32(result.data(), vcvtq_u32_f32(value));
+#else
+    for (u32 lane = 0; lane < SPAN_PIXELS; lane++) {
+        const float value = depth[lane] * static_cast<float>(max_value);
+        result[lane] = std::isnan(value) ? 0 : static_cast<u32>(value);
+    }
+#endif
+    return result;
+}
+
+/// Returns a mask of the lanes where a compares to b as func requires. Both must fit in 24 bits.
+inline u32 CompareLanes(Pica::FramebufferRegs::CompareFunc func,
+                        const std::array<u32, SPAN_PIXELS>& a,
+                        const std::array<u32, SPAN_PIXELS>& b) {
+#if CITRA_ARCH(x86_64)
+    const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a.data()));
+    const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b.data()));
+    const auto to_mask = [](__m128i lanes) {
+        return static_cast<u32>(_mm_movemask_ps(_mm_castsi128_ps(lanes)));
+    };
+    const u32 equal = to_mask(_mm_cmpeq_epi32(va, vb));
+    const u32 less = to_mask(_mm_cmplt_epi32(va, vb));
+    const u32 greater = to_mask(_mm_cmpgt_epi32(va, vb));
+#elif CITRA_ARCH(arm64)
+    static constexpr std::array<u32, 4> lane_bits{1, 2, 4, 8};
+    const uint32x4_t va = vld1q_u32(a.data());
+    const uint32x4_t vb = vld1q_u32(b.data());
+    const auto to_mask = [](uint32x4_t lanes) {
+        return vaddvq_u32(vandq_u32(lanes, vld1q_u32(lane_bits.data())));
+    };
+    const u32 equal = to_mask(vceqq_u32(va, vb));
+    const u32 less = to_mask(vcltq_u32(va, vb));
+    const u32 greater = to_mask(vcgtq_u32(va, vb));
+#else
+    u32 equal = 0;
+    u32 less = 0;
+    u32 greater = 0;
+    for (u32 lane = 0; lane < SPAN_PIXELS; lane++) {
+        equal |= (a[lane] == b[lane] ? 1U : 0U) << lane;
+        less |= (a[lane] < b[lane] ? 1U : 0U) << lane;
+        greater |= (a[lane] > b[lane] ? 1U : 0U) << lane;
+    }
+#endif
+    switch (func) {
+    case Pica::FramebufferRegs::CompareFunc::Never:
+        return 0;
+    case Pica::FramebufferRegs::CompareFunc::Always:
+        return 0xF;
+    case Pica::FramebufferRegs::CompareFunc::Equal:
+        return equal;
+    case Pica::FramebufferRegs::CompareFunc::NotEqual:
+        return equal ^ 0xF;
+    case Pica::FramebufferRegs::CompareFunc::LessThan:
+        return less;
+    case Pica::FramebufferRegs::CompareFunc::LessThanOrEqual:
+        return less | equal;
+    case Pica::FramebufferRegs::CompareFunc::GreaterThan:
+        return greater;
+    case Pica::FramebufferRegs::CompareFunc::GreaterThanOrEqual:
+        return greater | equal;
+    }
+    return 0;
+}
+
+/// Vertex attributes interpolated by SpanInterpolator, the lighting ones last.
+enum SpanAttribute : u32 {
+    ColorR,
+    ColorG,
+    ColorB,
+    ColorA,
+    Tc0U,
+    Tc0V,
+    Tc1U,
+    Tc1V,
+    Tc2U,
+    Tc2V,
+    Tc0W,
+    QuatX,
+    QuatY,
+    QuatZ,
+    QuatW,
+    ViewX,
+    ViewY,
+    ViewZ,
+    NumSpanAttributes,
+};
+
+/// Depth and perspective correct attributes of the pixels of a span.
+struct SpanValues {
+    std::array<float, SPAN_PIXELS> depth;
+    std::array<std::array<float, SPAN_PIXELS>, NumSpanAttributes> attributes;
+};
+
+/**
+ * Interpolates the depth and the vertex attributes of a triangle for spans of four horizontally
+ * adjacent pixels. Each lane performs the same f24 operations in the same order as interpolating
+ * a single pixel, so the results don't depend on the pixels being evaluated together.
+ **/
+class SpanInterpolator {
+public:
+    explicit SpanInterpolator(const std::array<Vertex, 3>& vertices, float depth_scale,
+                              float depth_offset, bool w_buffer, bool lighting)
+        : depth_scale{Splat(depth_scale)}, depth_offset{Splat(depth_offset)}, w_buffer{w_buffer},
+          num_attributes{lighting ? NumSpanAttributes : QuatX} {
+        for (u32 i = 0; i < 3; i++) {
+            const Vertex& v = vertices[i];
+            w_inverse[i] = Splat(v.pos.w.ToFloat32());
+            z[i] = Splat(v.screenpos[2].ToFloat32());
+            const std::array<f24, NumSpanAttributes> values = {
+                v.color.r(), v.color.g(), v.color.b(), v.color.a(), v.tc0.u(), v.tc0.v(),
+                v.tc1.u(),   v.tc1.v(),   v.tc2.u(),   v.tc2.v(),   v.tc0_w,   v.quat.x,
+                v.quat.y,    v.quat.z,    v.quat.w,    v.view.x,    v.view.y,  v.view.z,
+            };
+            for (u32 attr = 0; attr < NumSpanAttributes; attr++) {
+                attributes[attr][i] = Splat(values[attr].ToFloat32());
+            }
+        }
+    }
+
+    /**
+     * Interpolates the span starting at the given column of a row, whose first pixel has the
+     * edge function values row_w.
+     **/
+    void Interpolate(const std::array<s32, 3>& row_w, const std::array<s32, 3>& w_step,
+                     s32 column, SpanValues& out) const {
+        std::array<std::array<s32, SPAN_PIXELS>, 3> w;
+        std::array<s32, SPAN_PIXELS> wsum;
+        for (u32 lane = 0; lane < SPAN_PIXELS; lane++) {
+            const s32 offset = column + static_cast<s32>(lane);
+            for (u32 i = 0; i < 3; i++) {
+                w[i][lane] = row_w[i] + w_step[i] * offset;
+            }
+            wsum[lane] = w[0][lane] + w[1][lane] + w[2][lane];
+        }
+
+        const F32x4 baricentric[3] = {FromInts(w[0]), FromInts(w[1]), FromInts(w[2])};
+        const auto dot = [&](const F32x4(&values)[3]) {
+            return Add(Add(PicaMul(values[0], baricentric[0]), PicaMul(values[1], baricentric[1])),
+                       PicaMul(values[2], baricentric[2]));
+        };
+        const F32x4 interpolated_w_inverse = Div(Splat(1.0f), dot(w_inverse));
+        const F32x4 sum = FromInts(wsum);
+
+        // Z-Buffer (z / w * scale + offset), potentially switched to a W-Buffer
+        // (z * scale + w * offset = (z / w * scale + offset) * w)
+        const F32x4 z_sum = Add(Add(Mul(z[0], baricentric[0]), Mul(z[1], baricentric[1])),
+                                Mul(z[2], baricentric[2]));
+        const F32x4 z_over_w = Div(z_sum, sum);
+        F32x4 depth = Add(Mul(z_over_w, depth_scale), depth_offset);
+        if (w_buffer) {
+            depth = Mul(depth, Mul(interpolated_w_inverse, sum));
+        }
+        Store(out.depth, Clamp01(depth));
+
+        /**
+         * Perspective correct attribute interpolation:
+         * Attribute values cannot be calculated by simple linear interpolation since
+         * they are not linear in screen space. For example, when interpolating a
+         * texture coordinate across two vertices, something simple like
+         *     u = (u0*w0 + u1*w1)/(w0+w1)
+         * will not work. However, the attribute value divided by the
+         * clipspace w-coordinate (u/w) and and the inverse w-coordinate (1/w) are linear
+         * in screenspace. Hence, we can linearly interpolate these two independently and
+         * calculate the interpolated attribute by dividing the results.
+         * I.e.
+         *     u_over_w   = ((u0/v0.pos.w)*w0 + (u1/v1.pos.w)*w1)/(w0+w1)
+         *     one_over_w = (( 1/v0.pos.w)*w0 + ( 1/v1.pos.w)*w1)/(w0+w1)
+         *     u = u_over_w / one_over_w
+         *
+         * The generalization to three vertices is straightforward in baricentric coordinates.
+         **/
+        for (u32 attr = 0; attr < num_attributes; attr++) {
+            Store(out.attributes[attr], PicaMul(dot(attributes[attr]), interpolated_w_inverse));
+        }
+    }
+
+private:
+    F32x4 w_inverse[3];
+    F32x4 z[3];
+    F32x4 attributes[NumSpanAttributes][3];
+    F32x4 depth_scale;
+    F32x4 depth_offset;
+    bool w_buffer;
+    u32 num_attributes;
+};
+
+/**
+ * Evaluates the three edge functions of a triangle for spans of four horizontally adjacent
+ * pixels. The edge functions are linear, so stepping them by a constant per pixel gives exactly
+ * the same values as calling SignedArea for each pixel.
+ **/
+class EdgeSpan {
+public:
+    explicit EdgeSpan(const std::array<s32, 3>& w, const std::array<s32, 3>& step) {
+#if CITRA_ARCH(x86_64)
+        for (u32 i = 0; i < 3; i++) {
+            edges[i] = _mm_setr_epi32(w[i], w[i] + step[i], w[i] + step[i] * 2, w[i] + step[i] * 3);
+            steps[i] = _mm_set1_epi32(step[i] * 4);
+        }
+#elif CITRA_ARCH(arm64)
+        for (u32 i = 0; i < 3; i++) {
+            const std::array<s32, 4> lanes{w[i], w[i] + step[i], w[i] + step[i] * 2,
+                                           w[i] + step[i] * 3};
+            edges[i] = vld1q_s32(lanes.data());
+            steps[i] = vdupq_n_s32(step[i] * 4);
+        }
+#else
+        edges = w;
+        steps = step;
+#endif
+    }
+
+    /// Returns a mask of the pixels of the current span that lie inside all three edges and
+    /// advances to the next span.
+    u32 NextCoverage() {
+#if CITRA_ARCH(x86_64)
+        // A pixel is covered when none of its edge function values is negative.
+        const __m128i any_negative = _mm_or_si128(_mm_or_si128(edges[0], edges[1]), edges[2]);
+        const u32 mask = _mm_movemask_ps(_mm_castsi128_ps(any_negative)) ^ 0xF;
+        for (u32 i = 0; i < 3; i++) {
+            edges[i] = _mm_add_epi32(edges[i], steps[i]);
+        }
+        return mask;
+#elif CITRA_ARCH(arm64)
+        static constexpr std::array<u32, 4> lane_bits{1, 2, 4, 8};
+        const int32x4_t any_negative = vorrq_s32(vorrq_s32(edges[0], edges[1]), edges[2]);
+        const uint32x4_t covered = vcgezq_s32(any_negative);
+        const u32 mask = vaddvq_u32(vandq_u32(covered, vld1q_u32(lane_bits.data())));
+        for (u32 i = 0; i < 3; i++) {
+            edges[i] = vaddq_s32(edges[i], steps[i]);
+        }
+        return mask;
+#else
+        u32 mask = 0;
+        for (u32 lane = 0; lane < 4; lane++) {
+            const s32 offset = static_cast<s32>(lane);
+            if (edges[0] + steps[0] * offset >= 0 && edges[1] + steps[1] * offset >= 0 &&
+                edges[2] + steps[2] * offset >= 0) {
+                mask |= 1U << lane;
+            }
+        }
+        for (u32 i = 0; i < 3; i++) {
+            edges[i] += steps[i] * 4;
+        }
+        return mask;
+#endif
+    }
+
+private:
+#if CITRA_ARCH(x86_64)
+    __m128i edges[3];
+    __m128i steps[3];
+#elif CITRA_ARCH(arm64)
+    int32x4_t edges[3];
+    int32x4_t steps[3];
+#else
+    std::array<s32, 3> edges;
+    std::array<s32, 3> steps;
+#endif
+};
+
+} // namespace SwRenderer
@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include "common/assert.h"
+#include "common/common_funcs.h"
 #include "common/common_types.h"
 #include "common/vector_math.h"
 #include "video_core/regs_texturing.h"
@@ -50,8 +51,10 @@ int GetWrappedTexCoord(Pica::TexturingRegs::TextureConfig::WrapMode mode, s32 va
     }
 };
 
-Common::Vec3<u8> GetColorModifier(TevStageConfig::ColorModifier factor,
-                                  const Common::Vec4<u8>& values) {
+namespace {
+
+FORCE_INLINE Common::Vec3<u8> ColorModifierImpl(TevStageConfig::ColorModifier factor,
+                                                const Common::Vec4<u8>& values) {
     using ColorModifier = TevStageConfig::ColorModifier;
 
     switch (factor) {
@@ -79,7 +82,8 @@ Common::Vec3<u8> GetColorModifier(TevStageConfig::ColorModifier factor,
     UNREACHABLE();
 };
 
-u8 GetAlphaModifier(TevStageConfig::AlphaModifier factor, const Common::Vec4<u8>& values) {
+FORCE_INLINE u8 AlphaModifierImpl(TevStageConfig::AlphaModifier factor,
+                                  const Common::Vec4<u8>& values) {
     using AlphaModifier = TevStageConfig::AlphaModifier;
 
     switch (factor) {
@@ -103,8 +107,8 @@ u8 GetAlphaModifier(TevStageConfig::AlphaModifier factor, const Common::Vec4<u8>
     UNREACHABLE();
 };
 
-Common::Vec3<u8> ColorCombine(TevStageConfig::Operation op,
-                              std::span<const Common::Vec3<u8>, 3> input) {
+FORCE_INLINE Common::Vec3<u8> ColorCombineImpl(TevStageConfig::Operation op,
+                                               std::span<const Common::Vec3<u8>, 3> input) {
     using Operation = TevStageConfig::Operation;
 
     switch (op) {
@@ -175,7 +179,7 @@ Common::Vec3<u8> ColorCombine(TevStageConfig::Operation op,
     }
 };
 
-u8 AlphaCombine(TevStageConfig::Operation op, const std::array<u8, 3>& input) {
+FORCE_INLINE u8 AlphaCombineImpl(TevStageConfig::Operation op, const std::array<u8, 3>& input) {
     switch (op) {
         using Operation = TevStageConfig::Operation;
     case Operation::Replace:
@@ -204,4 +208,149 @@ u8 AlphaCombine(TevStageConfig::Operation op, const std::array<u8, 3>& input) {
     }
 };
 
+template <TevStageConfig::ColorModifier factor>
+Common::Vec3<u8> ColorModifierOp(const Common::Vec4<u8>& values) {
+    return ColorModifierImpl(factor, values);
+}
+
+template <TevStageConfig::AlphaModifier factor>
+u8 AlphaModifierOp(const Common::Vec4<u8>& values) {
+    return AlphaModifierImpl(factor, values);
+}
+
+template <TevStageConfig::Operation op>
+Common::Vec3<u8> ColorCombineOp(std::span<const Common::Vec3<u8>, 3> input) {
+    return ColorCombineImpl(op, input);
+}
+
+template <TevStageConfig::Operation op>
+u8 AlphaCombineOp(const std::array<u8, 3>& input) {
+    return AlphaCombineImpl(op, input);
+}
+
+} // Anonymous namespace
+
+Common::Vec3<u8> GetColorModifier(TevStageConfig::ColorModifier factor,
+                                  const Common::Vec4<u8>& values) {
+    return ColorModifierImpl(factor, values);
+}
+
+u8 GetAlphaModifier(TevStageConfig::AlphaModifier factor, const Common::Vec4<u8>& values) {
+    return AlphaModifierImpl(factor, values);
+}
+
+Common::Vec3<u8> ColorCombine(TevStageConfig::Operation op,
+                              std::span<const Common::Vec3<u8>, 3> input) {
+    return ColorCombineImpl(op, input);
+}
+
+u8 AlphaCombine(TevStageConfig::Operation op, const std::array<u8, 3>& input) {
+    return AlphaCombineImpl(op, input);
+}
+
+ColorModifierFunc GetColorModifierFunc(TevStageConfig::ColorModifier factor) {
+    using ColorModifier = TevStageConfig::ColorModifier;
+
+    switch (factor) {
+    case ColorModifier::SourceColor:
+        return &ColorModifierOp<ColorModifier::SourceColor>;
+    case ColorModifier::OneMinusSourceColor:
+        return &ColorModifierOp<ColorModifier::OneMinusSourceColor>;
+    case ColorModifier::SourceAlpha:
+        return &ColorModifierOp<ColorModifier::SourceAlpha>;
+    case ColorModifier::OneMinusSourceAlpha:
+        return &ColorModifierOp<ColorModifier::OneMinusSourceAlpha>;
+    case ColorModifier::SourceRed:
+        return &ColorModifierOp<ColorModifier::SourceRed>;
+    case ColorModifier::OneMinusSourceRed:
+        return &ColorModifierOp<ColorModifier::OneMinusSourceRed>;
+    case ColorModifier::SourceGreen:
+        return &ColorModifierOp<ColorModifier::SourceGreen>;
+    case ColorModifier::OneMinusSourceGreen:
+        return &ColorModifierOp<ColorModifier::OneMinusSourceGreen>;
+    case ColorModifier::SourceBlue:
+        return &ColorModifierOp<ColorModifier::SourceBlue>;
+    case ColorModifier::OneMinusSourceBlue:
+        return &ColorModifierOp<ColorModifier::OneMinusSourceBlue>;
+    }
+    return nullptr;
+}
+
+AlphaModifierFunc GetAlphaModifierFunc(TevStageConfig::AlphaModifier factor) {
+    using AlphaModifier = TevStageConfig::AlphaModifier;
+
+    switch (factor) {
+    case AlphaModifier::SourceAlpha:
+        return &AlphaModifierOp<AlphaModifier::SourceAlpha>;
+    case AlphaModifier::OneMinusSourceAlpha:
+        return &AlphaModifierOp<AlphaModifier::OneMinusSourceAlpha>;
+    case AlphaModifier::SourceRed:
+        return &AlphaModifierOp<AlphaModifier::SourceRed>;
+    case AlphaModifier::OneMinusSourceRed:
+        return &AlphaModifierOp<AlphaModifier::OneMinusSourceRed>;
+    case AlphaModifier::SourceGreen:
+        return &AlphaModifierOp<AlphaModifier::SourceGreen>;
+    case AlphaModifier::OneMinusSourceGreen:
+        return &AlphaModifierOp<AlphaModifier::OneMinusSourceGreen>;
+    case AlphaModifier::SourceBlue:
+        return &AlphaModifierOp<AlphaModifier::SourceBlue>;
+    case AlphaModifier::OneMinusSourceBlue:
+        return &AlphaModifierOp<AlphaModifier::OneMinusSourceBlue>;
+    }
+    return nullptr;
+}
+
+ColorCombineFunc GetColorCombineFunc(TevStageConfig::Operation op) {
+    using Operation = TevStageConfig::Operation;
+
+    switch (op) {
+    case Operation::Replace:
+        return &ColorCombineOp<Operation::Replace>;
+    case Operation::Modulate:
+        return &ColorCombineOp<Operation::Modulate>;
+    case Operation::Add:
+        return &ColorCombineOp<Operation::Add>;
+    case Operation::AddSigned:
+        return &ColorCombineOp<Operation::AddSigned>;
+    case Operation::Lerp:
+        return &ColorCombineOp<Operation::Lerp>;
+    case Operation::Subtract:
+        return &ColorCombineOp<Operation::Subtract>;
+    case Operation::Dot3_RGB:
+    case Operation::Dot3_RGBA:
+        return &ColorCombineOp<Operation::Dot3_RGB>;
+    case Operation::MultiplyThenAdd:
+        return &ColorCombineOp<Operation::MultiplyThenAdd>;
+    case Operation::AddThenMultiply:
+        return &ColorCombineOp<Operation::AddThenMultiply>;
+    default:
+        return nullptr;
+    }
+}
+
+AlphaCombineFunc GetAlphaCombineFunc(TevStageConfig::Operation op) {
+    using Operation = TevStageConfig::Operation;
+
+    switch (op) {
+    case Operation::Replace:
+        return &AlphaCombineOp<Operation::Replace>;
+    case Operation::Modulate:
+        return &AlphaCombineOp<Operation::Modulate>;
+    case Operation::Add:
+        return &AlphaCombineOp<Operation::Add>;
+    case Operation::AddSigned:
+        return &AlphaCombineOp<Operation::AddSigned>;
+    case Operation::Lerp:
+        return &AlphaCombineOp<Operation::Lerp>;
+    case Operation::Subtract:
+        return &AlphaCombineOp<Operation::Subtract>;
+    case Operation::MultiplyThenAdd:
+        return &AlphaCombineOp<Operation::MultiplyThenAdd>;
+    case Operation::AddThenMultiply:
+        return &AlphaCombineOp<Operation::AddThenMultiply>;
+    default:
+        return nullptr;
+    }
+}
+
 } // namespace SwRenderer
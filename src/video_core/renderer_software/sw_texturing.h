@@ -25,4 +25,21 @@ Common::Vec3<u8> ColorCombine(Pica::TexturingRegs::TevStageConfig::Operation op,
 
 u8 AlphaCombine(Pica::TexturingRegs::TevStageConfig::Operation op, const std::array<u8, 3>& input);
 
+using ColorModifierFunc = Common::Vec3<u8> (*)(const Common::Vec4<u8>& values);
+using AlphaModifierFunc = u8 (*)(const Common::Vec4<u8>& values);
+using ColorCombineFunc = Common::Vec3<u8> (*)(std::span<const Common::Vec3<u8>, 3> input);
+using AlphaCombineFunc = u8 (*)(const std::array<u8, 3>& input);
+
+/// Returns GetColorModifier specialized for the factor, or nullptr if the factor is unknown.
+ColorModifierFunc GetColorModifierFunc(Pica::TexturingRegs::TevStageConfig::ColorModifier factor);
+
+/// Returns GetAlphaModifier specialized for the factor, or nullptr if the factor is unknown.
+AlphaModifierFunc GetAlphaModifierFunc(Pica::TexturingRegs::TevStageConfig::AlphaModifier factor);
+
+/// Returns ColorCombine specialized for the operation, or nullptr if the operation is unknown.
+ColorCombineFunc GetColorCombineFunc(Pica::TexturingRegs::TevStageConfig::Operation op);
+
+/// Returns AlphaCombine specialized for the operation, or nullptr if the operation is unknown.
+AlphaCombineFunc GetAlphaCombineFunc(Pica::TexturingRegs::TevStageConfig::Operation op);
+
 } // namespace SwRenderer
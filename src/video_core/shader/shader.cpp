@@ -2,8 +2,10 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cmath>
 #include <cstring>
+#include <thread>
 #include "common/arch.h"
 #include "common/assert.h"
 #include "common/bit_set.h"
@@ -15,7 +17,9 @@
 #include "video_core/shader/shader_interpreter.h"
 #if CITRA_ARCH(x86_64)
 #include "video_core/shader/shader_jit_x64.h"
-#endif // CITRA_ARCH(x86_64)
+#elif CITRA_ARCH(arm64)
+#include "video_core/shader/shader_jit_a64.h"
+#endif
 #include "video_core/video_core.h"
 
 namespace Pica::Shader {
@@ -137,27 +141,61 @@ MICROPROFILE_DEFINE(GPU_Shader, "GPU", "Shader", MP_RGB(50, 50, 240));
 
 #if CITRA_ARCH(x86_64)
 static std::unique_ptr<JitX64Engine> jit_engine;
-#endif // CITRA_ARCH(x86_64)
+#elif CITRA_ARCH(arm64)
+static std::unique_ptr<JitA64Engine> jit_engine;
+#endif
 static InterpreterEngine interpreter_engine;
+static std::unique_ptr<Common::ThreadWorker> unit_workers;
+
+void ShaderEngine::RunBatch(const ShaderSetup& setup, UnitState& state, const ShaderRegs& config,
+                            std::span<const AttributeBuffer> inputs,
+                            std::span<AttributeBuffer> outputs) const {
+    ASSERT(inputs.size() == outputs.size());
+    for (std::size_t i = 0; i < inputs.size(); ++i) {
+        state.LoadInput(config, inputs[i]);
+        Run(setup, state);
+        state.WriteOutput(config, outputs[i]);
+    }
+}
 
 ShaderEngine* GetEngine() {
-#if CITRA_ARCH(x86_64)
+#if CITRA_ARCH(x86_64) || CITRA_ARCH(arm64)
     // TODO(yuriks): Re-initialize on each change rather than being persistent
     if (VideoCore::g_shader_jit_enabled) {
         if (jit_engine == nullptr) {
+#if CITRA_ARCH(x86_64)
             jit_engine = std::make_unique<JitX64Engine>();
+#elif CITRA_ARCH(arm64)
+            jit_engine = std::make_unique<JitA64Engine>();
+#endif
         }
         return jit_engine.get();
     }
-#endif // CITRA_ARCH(x86_64)
+#endif
 
     return &interpreter_engine;
 }
 
+Common::ThreadWorker* GetUnitWorkers() {
+    u32 num_threads = VideoCore::g_vertex_shader_threads;
+    if (num_threads == 0) {
+        num_threads = std::max(std::thread::hardware_concurrency(), 1U);
+    }
+    if (num_threads <= 1) {
+        unit_workers = nullptr;
+        return nullptr;
+    }
+    if (unit_workers == nullptr || unit_workers->NumWorkers() != num_threads) {
+        unit_workers = std::make_unique<Common::ThreadWorker>(num_threads, "ShaderUnit");
+    }
+    return unit_workers.get();
+}
+
 void Shutdown() {
-#if CITRA_ARCH(x86_64)
+#if CITRA_ARCH(x86_64) || CITRA_ARCH(arm64)
     jit_engine = nullptr;
-#endif // CITRA_ARCH(x86_64)
+#endif
+    unit_workers = nullptr;
 }
 
 } // namespace Pica::Shader
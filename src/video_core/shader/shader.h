@@ -15,6 +15,7 @@
 #include "common/common_funcs.h"
 #include "common/common_types.h"
 #include "common/hash.h"
+#include "common/thread_worker.h"
 #include "common/vector_math.h"
 #include "video_core/pica_types.h"
 #include "video_core/regs_rasterizer.h"
@@ -126,9 +127,9 @@ static_assert(std::is_standard_layout<GSEmitter>::value, "GSEmitter is not stand
 
 /**
  * This structure contains the state information that needs to be unique for a shader unit. The 3DS
- * has four shader units that process shaders in parallel. At the present, Citra only implements a
- * single shader unit that processes all shaders serially. Putting the state information in a struct
- * here will make it easier for us to parallelize the shader processing later.
+ * has four shader units that process shaders in parallel. By default Citra processes all shaders
+ * serially on a single unit, but large vertex batches can be split across several units running
+ * on the workers returned by GetUnitWorkers.
  */
 struct UnitState {
     explicit UnitState(GSEmitter* emitter = nullptr);
@@ -252,7 +253,7 @@ struct ShaderSetup {
     /// Data private to ShaderEngines
     struct EngineData {
         unsigned int entry_point;
-        /// Used by the JIT, points to a compiled shader object.
+        /// Points to the compiled shader of the JIT or the decoded program of the interpreter.
         const void* cached_shader = nullptr;
     } engine_data;
 
@@ -316,10 +317,29 @@ public:
      * @param state Shader unit state, must be setup with input data before each shader invocation.
      */
     virtual void Run(const ShaderSetup& setup, UnitState& state) const = 0;
+
+    /**
+     * Runs the currently setup shader once for each of the given input vertices, writing the
+     * shaded vertices to the matching entries of `outputs`. Engines that can do so amortize the
+     * per-invocation setup over the whole batch.
+     *
+     * @param setup Shader engine state, must be setup with SetupBatch on each shader change.
+     * @param state Shader unit state used for all invocations of the batch.
+     * @param config Shader registers describing the input and output register mapping.
+     * @param inputs Input vertices of the batch.
+     * @param outputs Output vertices of the batch, must be the same size as `inputs`.
+     */
+    virtual void RunBatch(const ShaderSetup& setup, UnitState& state, const ShaderRegs& config,
+                          std::span<const AttributeBuffer> inputs,
+                          std::span<AttributeBuffer> outputs) const;
 };
 
 // TODO(yuriks): Remove and make it non-global state somewhere
 ShaderEngine* GetEngine();
+
+/// Returns the worker pool used to emulate additional shader units, or nullptr if shaders are
+/// processed serially.
+Common::ThreadWorker* GetUnitWorkers();
 void Shutdown();
 
 } // namespace Pica::Shader
@@ -6,6 +6,7 @@
 #include <array>
 #include <cmath>
 #include <numeric>
+#include <vector>
 #include <boost/container/static_vector.hpp>
 #include <nihstro/shader_bytecode.h>
 #include "common/assert.h"
@@ -35,8 +36,219 @@ struct CallStackElement {
     u32 loop_address;   // The address where we'll return to after each loop iteration
 };
 
+/// Register file a source operand of a micro-op reads from
+enum class SourceFile : u8 {
+    Input,
+    Temporary,
+    FloatUniform,
+    Dummy,
+};
+
+/// Register file a micro-op writes its result to
+enum class DestFile : u8 {
+    Output,
+    Temporary,
+    Dummy,
+};
+
+/// Source operand of a micro-op, with its register and swizzle resolved
+struct MicroOpSource {
+    SourceRegister reg;
+    SourceFile file;
+    u8 index;
+    /// Offset by an address register, so the register can only be looked up when running
+    bool relative;
+    bool negate;
+    std::array<u8, 4> selector;
+};
+
+/**
+ * Shader instruction with its operand descriptor resolved. The interpreter runs these instead of
+ * decoding the instruction word and swizzle pattern again for every vertex.
+ */
+struct MicroOp {
+    Instruction instr; ///< Original instruction, for conditions, emit flags and logging
+    OpCode::Type type;
+    OpCode::Id opcode; ///< Effective opcode for arithmetic and multiply-add instructions
+    u8 address_register_index;
+    DestFile dest_file;
+    u8 dest_index;
+    u8 dest_mask; ///< Bit i is set if component i of the destination is written
+    std::array<MicroOpSource, 3> src;
+    u16 dest_offset; ///< Jump target of flow control instructions
+    u16 num_instructions;
+    u16 return_offset; ///< Where the call stack element pushed by the instruction returns to
+
+    bool DestComponentEnabled(int i) const {
+        return (dest_mask >> i) & 1;
+    }
+};
+
+/// Shader program decoded into micro-ops, indexed by program counter
+struct MicroOpProgram {
+    /// Micro-ops up to the last non-zero instruction word. All following words are zero as well,
+    /// so they decode to the same micro-op as the last one.
+    std::vector<MicroOp> ops;
+
+    const MicroOp& Fetch(u32 program_counter) const {
+        return ops[std::min<std::size_t>(program_counter, ops.size() - 1)];
+    }
+};
+
+static MicroOpSource DecodeSource(SourceRegister reg, bool relative, bool negate,
+                                  std::array<u8, 4> selector) {
+    MicroOpSource source{reg, SourceFile::Dummy, 0, relative, negate, selector};
+    switch (reg.GetRegisterType()) {
+    case RegisterType::Input:
+        source.file = SourceFile::Input;
+        break;
+    case RegisterType::Temporary:
+        source.file = SourceFile::Temporary;
+        break;
+    case RegisterType::FloatUniform:
+        source.file = SourceFile::FloatUniform;
+        break;
+    default:
+        return source;
+    }
+    source.index = static_cast<u8>(reg.GetIndex());
+    return source;
+}
+
+static void DecodeDest(MicroOp& op, nihstro::DestRegister dest) {
+    if (dest < 0x10) {
+        op.dest_file = DestFile::Output;
+        op.dest_index = static_cast<u8>(dest.GetIndex());
+    } else if (dest < 0x20) {
+        op.dest_file = DestFile::Temporary;
+        op.dest_index = static_cast<u8>(dest.GetIndex());
+    } else {
+        op.dest_file = DestFile::Dummy;
+        op.dest_index = 0;
+    }
+}
+
+static u8 DecodeDestMask(const SwizzlePattern& swizzle) {
+    u8 mask = 0;
+    for (int i = 0; i < 4; ++i) {
+        mask |= (swizzle.DestComponentEnabled(i) ? 1 : 0) << i;
+    }
+    return mask;
+}
+
+static MicroOp DecodeInstruction(const SwizzleData& swizzle_data, u32 program_counter,
+                                 Instruction instr) {
+    MicroOp op{};
+    op.instr = instr;
+    op.type = instr.opcode.Value().GetInfo().type;
+
+    switch (op.type) {
+    case OpCode::Type::Arithmetic: {
+        const SwizzlePattern swizzle = {swizzle_data[instr.common.operand_desc_id]};
+        const bool is_inverted =
+            (0 != (instr.opcode.Value().GetInfo().subtype & OpCode::Info::SrcInversed));
+        const bool relative = instr.common.address_register_index != 0;
+
+        op.opcode = instr.opcode.Value().EffectiveOpCode();
+        op.address_register_index = static_cast<u8>(instr.common.address_register_index);
+        op.src[0] = DecodeSource(instr.common.GetSrc1(is_inverted), relative && !is_inverted,
+                                 swizzle.negate_src1,
+                                 {static_cast<u8>(swizzle.src1_selector_0.Value()),
+                                  static_cast<u8>(swizzle.src1_selector_1.Value()),
+                                  static_cast<u8>(swizzle.src1_selector_2.Value()),
+                                  static_cast<u8>(swizzle.src1_selector_3.Value())});
+        op.src[1] = DecodeSource(instr.common.GetSrc2(is_inverted), relative && is_inverted,
+                                 swizzle.negate_src2,
+                                 {static_cast<u8>(swizzle.src2_selector_0.Value()),
+                                  static_cast<u8>(swizzle.src2_selector_1.Value()),
+                                  static_cast<u8>(swizzle.src2_selector_2.Value()),
+                                  static_cast<u8>(swizzle.src2_selector_3.Value())});
+        DecodeDest(op, instr.common.dest.Value());
+        op.dest_mask = DecodeDestMask(swizzle);
+        break;
+    }
+
+    case OpCode::Type::MultiplyAdd: {
+        op.opcode = instr.opcode.Value().EffectiveOpCode();
+        if (op.opcode != OpCode::Id::MAD && op.opcode != OpCode::Id::MADI) {
+            break;
+        }
+
+        const SwizzlePattern mad_swizzle = {swizzle_data[instr.mad.operand_desc_id]};
+        const bool is_inverted = (op.opcode == OpCode::Id::MADI);
+        const bool relative = instr.mad.address_register_index != 0;
+
+        op.address_register_index = static_cast<u8>(instr.mad.address_register_index);
+        op.src[0] = DecodeSource(instr.mad.GetSrc1(is_inverted), false, mad_swizzle.negate_src1,
+                                 {static_cast<u8>(mad_swizzle.src1_selector_0.Value()),
+                                  static_cast<u8>(mad_swizzle.src1_selector_1.Value()),
+                                  static_cast<u8>(mad_swizzle.src1_selector_2.Value()),
+                                  static_cast<u8>(mad_swizzle.src1_selector_3.Value())});
+        op.src[1] = DecodeSource(instr.mad.GetSrc2(is_inverted), relative && !is_inverted,
+                                 mad_swizzle.negate_src2,
+                                 {static_cast<u8>(mad_swizzle.src2_selector_0.Value()),
+                                  static_cast<u8>(mad_swizzle.src2_selector_1.Value()),
+                                  static_cast<u8>(mad_swizzle.src2_selector_2.Value()),
+                                  static_cast<u8>(mad_swizzle.src2_selector_3.Value())});
+        op.src[2] = DecodeSource(instr.mad.GetSrc3(is_inverted), relative && is_inverted,
+                                 mad_swizzle.negate_src3,
+                                 {static_cast<u8>(mad_swizzle.src3_selector_0.Value()),
+                                  static_cast<u8>(mad_swizzle.src3_selector_1.Value()),
+                                  static_cast<u8>(mad_swizzle.src3_selector_2.Value()),
+                                  static_cast<u8>(mad_swizzle.src3_selector_3.Value())});
+        DecodeDest(op, instr.mad.dest.Value());
+        op.dest_mask = DecodeDestMask(mad_swizzle);
+        break;
+    }
+
+    default: {
+        op.opcode = instr.opcode.Value();
+        op.dest_offset = static_cast<u16>(instr.flow_control.dest_offset);
+        op.num_instructions = static_cast<u16>(instr.flow_control.num_instructions);
+
+        switch (op.opcode) {
+        case OpCode::Id::CALL:
+        case OpCode::Id::CALLU:
+        case OpCode::Id::CALLC:
+            op.return_offset = static_cast<u16>(program_counter + 1);
+            break;
+        case OpCode::Id::IFU:
+        case OpCode::Id::IFC:
+            op.return_offset = op.dest_offset + op.num_instructions;
+            break;
+        case OpCode::Id::LOOP:
+            op.return_offset = op.dest_offset + 1;
+            break;
+        default:
+            break;
+        }
+        break;
+    }
+    }
+
+    return op;
+}
+
+static MicroOpProgram DecodeProgram(const ProgramCode& program_code,
+                                    const SwizzleData& swizzle_data) {
+    const auto last_used = std::find_if(program_code.rbegin(), program_code.rend(),
+                                        [](u32 word) { return word != 0; });
+    // Keep one zero word after the last used one, if there is room, to stand for the rest
+    const std::size_t size =
+        std::min<std::size_t>(program_code.rend() - last_used + 1, program_code.size());
+
+    MicroOpProgram program;
+    program.ops.reserve(size);
+    for (u32 program_counter = 0; program_counter < size; ++program_counter) {
+        program.ops.push_back(
+            DecodeInstruction(swizzle_data, program_counter, {program_code[program_counter]}));
+    }
+    return program;
+}
+
 template <bool Debug>
-static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData<Debug>& debug_data,
+static void RunInterpreter(const ShaderSetup& setup, UnitState& state,
+                           const MicroOpProgram& program, DebugData<Debug>& debug_data,
                            unsigned offset) {
     // TODO: Is there a maximal size for this?
     boost::container::static_vector<CallStackElement, 16> call_stack;
@@ -76,11 +288,21 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
     };
 
     const auto& uniforms = setup.uniforms;
-    const auto& swizzle_data = setup.swizzle_data;
-    const auto& program_code = setup.program_code;
 
     // Placeholder for invalid inputs
-    static f24 dummy_vec4_float24[4];
+    static Common::Vec4<f24> dummy_vec4_float24;
+
+    const std::array<const Common::Vec4<f24>*, 4> source_files = {
+        state.registers.input.data(),
+        state.registers.temporary.data(),
+        uniforms.f.data(),
+        &dummy_vec4_float24,
+    };
+    const std::array<Common::Vec4<f24>*, 3> dest_files = {
+        state.registers.output.data(),
+        state.registers.temporary.data(),
+        &dummy_vec4_float24,
+    };
 
     unsigned iteration = 0;
     bool exit_loop = false;
@@ -102,8 +324,8 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
             }
         }
 
-        const Instruction instr = {program_code[program_counter]};
-        const SwizzlePattern swizzle = {swizzle_data[instr.common.operand_desc_id]};
+        const MicroOp& op = program.Fetch(program_counter);
+        const Instruction instr = op.instr;
 
         Record<DebugDataRecord::CUR_INSTR>(debug_data, iteration, program_counter);
         if (iteration > 0)
@@ -123,69 +345,64 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
                 return &uniforms.f[source_reg.GetIndex()].x;
 
             default:
-                return dummy_vec4_float24;
+                return &dummy_vec4_float24.x;
             }
         };
 
-        switch (instr.opcode.Value().GetInfo().type) {
-        case OpCode::Type::Arithmetic: {
-            const bool is_inverted =
-                (0 != (instr.opcode.Value().GetInfo().subtype & OpCode::Info::SrcInversed));
+        auto LookupSource = [&](const MicroOpSource& source, int address_offset) -> const f24* {
+            if (source.relative) {
+                return LookupSourceRegister(source.reg + address_offset);
+            }
+            return &source_files[static_cast<std::size_t>(source.file)][source.index].x;
+        };
 
+        switch (op.type) {
+        case OpCode::Type::Arithmetic: {
             const int address_offset =
-                (instr.common.address_register_index == 0)
+                (op.address_register_index == 0)
                     ? 0
-                    : state.address_registers[instr.common.address_register_index - 1];
+                    : state.address_registers[op.address_register_index - 1];
 
-            const f24* src1_ = LookupSourceRegister(instr.common.GetSrc1(is_inverted) +
-                                                    (is_inverted ? 0 : address_offset));
-            const f24* src2_ = LookupSourceRegister(instr.common.GetSrc2(is_inverted) +
-                                                    (is_inverted ? address_offset : 0));
-
-            const bool negate_src1 = ((bool)swizzle.negate_src1 != false);
-            const bool negate_src2 = ((bool)swizzle.negate_src2 != false);
+            const f24* src1_ = LookupSource(op.src[0], address_offset);
+            const f24* src2_ = LookupSource(op.src[1], address_offset);
 
             f24 src1[4] = {
-                src1_[(int)swizzle.src1_selector_0.Value()],
-                src1_[(int)swizzle.src1_selector_1.Value()],
-                src1_[(int)swizzle.src1_selector_2.Value()],
-                src1_[(int)swizzle.src1_selector_3.Value()],
+                src1_[op.src[0].selector[0]],
+                src1_[op.src[0].selector[1]],
+                src1_[op.src[0].selector[2]],
+                src1_[op.src[0].selector[3]],
             };
-            if (negate_src1) {
+            if (op.src[0].negate) {
                 src1[0] = -src1[0];
                 src1[1] = -src1[1];
                 src1[2] = -src1[2];
                 src1[3] = -src1[3];
             }
             f24 src2[4] = {
-                src2_[(int)swizzle.src2_selector_0.Value()],
-                src2_[(int)swizzle.src2_selector_1.Value()],
-                src2_[(int)swizzle.src2_selector_2.Value()],
-                src2_[(int)swizzle.src2_selector_3.Value()],
+                src2_[op.src[1].selector[0]],
+                src2_[op.src[1].selector[1]],
+                src2_[op.src[1].selector[2]],
+                src2_[op.src[1].selector[3]],
             };
-            if (negate_src2) {
+            if (op.src[1].negate) {
                 src2[0] = -src2[0];
                 src2[1] = -src2[1];
                 src2[2] = -src2[2];
                 src2[3] = -src2[3];
             }
 
-            f24* dest = (instr.common.dest.Value() < 0x10)
-                            ? &state.registers.output[instr.common.dest.Value().GetIndex()][0]
-                        : (instr.common.dest.Value() < 0x20)
-                            ? &state.registers.temporary[instr.common.dest.Value().GetIndex()][0]
-                            : dummy_vec4_float24;
+            f24* dest = &dest_files[static_cast<std::size_t>(op.dest_file)][op.dest_index].x;
 
             debug_data.max_opdesc_id =
                 std::max<u32>(debug_data.max_opdesc_id, 1 + instr.common.operand_desc_id);
 
-            switch (instr.opcode.Value().EffectiveOpCode()) {
+            switch (op.opcode) {
             case OpCode::Id::ADD: {
                 Record<DebugDataRecord::SRC1>(debug_data, iteration, src1);
                 Record<DebugDataRecord::SRC2>(debug_data, iteration, src2);
                 Record<DebugDataRecord::DEST_IN>(debug_data, iteration, dest);
                 for (int i = 0; i < 4; ++i) {
-                    if (!swizzle.DestComponentEnabled(i))
+                    if (!op.DestComponentEnabled(i))
                         continue;
 
                     dest[i] = src1[i] + src2[i];
@@ -199,7 +416,7 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
                 Record<DebugDataRecord::SRC2>(debug_data, iteration, src2);
                 Record<DebugDataRecord::DEST_IN>(debug_data, iteration, dest);
                 for (int i = 0; i < 4; ++i) {
-                    if (!swizzle.DestComponentEnabled(i))
+                    if (!op.DestComponentEnabled(i))
                         continue;
 
                     dest[i] = src1[i] * src2[i];
@@ -212,7 +429,7 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
                 Record<DebugDataRecord::SRC1>(debug_data, iteration, src1);
                 Record<DebugDataRecord::DEST_IN>(debug_data, iteration, dest);
                 for (int i = 0; i < 4; ++i) {
-                    if (!swizzle.DestComponentEnabled(i))
+                    if (!op.DestComponentEnabled(i))
                         continue;
 
                     dest[i] = f24::FromFloat32(std::floor(src1[i].ToFloat32()));
@@ -225,7 +442,7 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
                 Record<DebugDataRecord::SRC2>(debug_data, iteration, src2);
                 Record<DebugDataRecord::DEST_IN>(debug_data, iteration, dest);
                 for (int i = 0; i < 4; ++i) {
-                    if (!swizzle.DestComponentEnabled(i))
+                    if (!op.DestComponentEnabled(i))
                         continue;
 
                     // NOTE: Exact form required to match NaN semantics to hardware:
@@ -241,7 +458,7 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
                 Record<DebugDataRecord::SRC2>(debug_data, iteration, src2);
                 Record<DebugDataRecord::DEST_IN>(debug_data, iteration, dest);
                 for (int i = 0; i < 4; ++i) {
-                    if (!swizzle.DestComponentEnabled(i))
+                    if (!op.DestComponentEnabled(i))
                         continue;
 
                     // NOTE: Exact form required to match NaN semantics to hardware:
@@ -260,7 +477,7 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
                 Record<DebugDataRecord::SRC2>(debug_data, iteration, src2);
                 Record<DebugDataRecord::DEST_IN>(debug_data, iteration, dest);
 
-                OpCode::Id opcode = instr.opcode.Value().EffectiveOpCode();
+                const OpCode::Id opcode = op.opcode;
                 if (opcode == OpCode::Id::DPH || opcode == OpCode::Id::DPHI)
                     src1[3] = f24::One();
 
@@ -268,7 +485,7 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
                 f24 dot = std::inner_product(src1, src1 + num_components, src2, f24::Zero());
 
                 for (int i = 0; i < 4; ++i) {
-                    if (!swizzle.DestComponentEnabled(i))
+                    if (!op.DestComponentEnabled(i))
                         continue;
 
                     dest[i] = dot;
@@ -283,7 +500,7 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
                 Record<DebugDataRecord::DEST_IN>(debug_data, iteration, dest);
                 f24 rcp_res = f24::FromFloat32(1.0f / src1[0].ToFloat32());
                 for (int i = 0; i < 4; ++i) {
-                    if (!swizzle.DestComponentEnabled(i))
+                    if (!op.DestComponentEnabled(i))
                         continue;
 
                     dest[i] = rcp_res;
@@ -298,7 +515,7 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
                 Record<DebugDataRecord::DEST_IN>(debug_data, iteration, dest);
                 f24 rsq_res = f24::FromFloat32(1.0f / std::sqrt(src1[0].ToFloat32()));
                 for (int i = 0; i < 4; ++i) {
-                    if (!swizzle.DestComponentEnabled(i))
+                    if (!op.DestComponentEnabled(i))
                         continue;
 
                     dest[i] = rsq_res;
@@ -310,7 +527,7 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
             case OpCode::Id::MOVA: {
                 Record<DebugDataRecord::SRC1>(debug_data, iteration, src1);
                 for (int i = 0; i < 2; ++i) {
-                    if (!swizzle.DestComponentEnabled(i))
+                    if (!op.DestComponentEnabled(i))
                         continue;
 
                     // TODO: Figure out how the rounding is done on hardware
@@ -325,7 +542,7 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
                 Record<DebugDataRecord::SRC1>(debug_data, iteration, src1);
                 Record<DebugDataRecord::DEST_IN>(debug_data, iteration, dest);
                 for (int i = 0; i < 4; ++i) {
-                    if (!swizzle.DestComponentEnabled(i))
+                    if (!op.DestComponentEnabled(i))
                         continue;
 
                     dest[i] = src1[i];
@@ -340,7 +557,7 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
                 Record<DebugDataRecord::SRC2>(debug_data, iteration, src2);
                 Record<DebugDataRecord::DEST_IN>(debug_data, iteration, dest);
                 for (int i = 0; i < 4; ++i) {
-                    if (!swizzle.DestComponentEnabled(i))
+                    if (!op.DestComponentEnabled(i))
                         continue;
 
                     dest[i] = (src1[i] >= src2[i]) ? f24::One() : f24::Zero();
@@ -354,7 +571,7 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
                 Record<DebugDataRecord::SRC2>(debug_data, iteration, src2);
                 Record<DebugDataRecord::DEST_IN>(debug_data, iteration, dest);
                 for (int i = 0; i < 4; ++i) {
-                    if (!swizzle.DestComponentEnabled(i))
+                    if (!op.DestComponentEnabled(i))
                         continue;
 
                     dest[i] = (src1[i] < src2[i]) ? f24::One() : f24::Zero();
@@ -411,7 +628,7 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
                 // EX2 only takes first component exp2 and writes it to all dest components
                 f24 ex2_res = f24::FromFloat32(std::exp2(src1[0].ToFloat32()));
                 for (int i = 0; i < 4; ++i) {
-                    if (!swizzle.DestComponentEnabled(i))
+                    if (!op.DestComponentEnabled(i))
                         continue;
 
                     dest[i] = ex2_res;
@@ -428,7 +645,7 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
                 // LG2 only takes the first component log2 and writes it to all dest components
                 f24 lg2_res = f24::FromFloat32(std::log2(src1[0].ToFloat32()));
                 for (int i = 0; i < 4; ++i) {
-                    if (!swizzle.DestComponentEnabled(i))
+                    if (!op.DestComponentEnabled(i))
                         continue;
 
                     dest[i] = lg2_res;
@@ -450,77 +667,62 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
         }
 
         case OpCode::Type::MultiplyAdd: {
-            if ((instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MAD) ||
-                (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI)) {
-                const SwizzlePattern& mad_swizzle = *reinterpret_cast<const SwizzlePattern*>(
-                    &swizzle_data[instr.mad.operand_desc_id]);
-
-                bool is_inverted = (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI);
-
+            if ((op.opcode == OpCode::Id::MAD) || (op.opcode == OpCode::Id::MADI)) {
                 const int address_offset =
-                    (instr.mad.address_register_index == 0)
+                    (op.address_register_index == 0)
                         ? 0
-                        : state.address_registers[instr.mad.address_register_index - 1];
-
-                const f24* src1_ = LookupSourceRegister(instr.mad.GetSrc1(is_inverted));
-                const f24* src2_ = LookupSourceRegister(instr.mad.GetSrc2(is_inverted) +
-                                                        (!is_inverted * address_offset));
-                const f24* src3_ = LookupSourceRegister(instr.mad.GetSrc3(is_inverted) +
-                                                        (is_inverted * address_offset));
+                        : state.address_registers[op.address_register_index - 1];
 
-                const bool negate_src1 = ((bool)mad_swizzle.negate_src1 != false);
-                const bool negate_src2 = ((bool)mad_swizzle.negate_src2 != false);
-                const bool negate_src3 = ((bool)mad_swizzle.negate_src3 != false);
+                const f24* src1_ = LookupSource(op.src[0], address_offset);
+                const f24* src2_ = LookupSource(op.src[1], address_offset);
+                const f24* src3_ = LookupSource(op.src[2], address_offset);
 
                 f24 src1[4] = {
-                    src1_[(int)mad_swizzle.src1_selector_0.Value()],
-                    src1_[(int)mad_swizzle.src1_selector_1.Value()],
-                    src1_[(int)mad_swizzle.src1_selector_2.Value()],
-                    src1_[(int)mad_swizzle.src1_selector_3.Value()],
+                    src1_[op.src[0].selector[0]],
+                    src1_[op.src[0].selector[1]],
+                    src1_[op.src[0].selector[2]],
+                    src1_[op.src[0].selector[3]],
                 };
-                if (negate_src1) {
+                if (op.src[0].negate) {
                     src1[0] = -src1[0];
                     src1[1] = -src1[1];
                     src1[2] = -src1[2];
                     src1[3] = -src1[3];
                 }
                 f24 src2[4] = {
-                    src2_[(int)mad_swizzle.src2_selector_0.Value()],
-                    src2_[(int)mad_swizzle.src2_selector_1.Value()],
-                    src2_[(int)mad_swizzle.src2_selector_2.Value()],
-                    src2_[(int)mad_swizzle.src2_selector_3.Value()],
+                    src2_[op.src[1].selector[0]],
+                    src2_[op.src[1].selector[1]],
+                    src2_[op.src[1].selector[2]],
+                    src2_[op.src[1].selector[3]],
                 };
-                if (negate_src2) {
+                if (op.src[1].negate) {
                     src2[0] = -src2[0];
                     src2[1] = -src2[1];
                     src2[2] = -src2[2];
                     src2[3] = -src2[3];
                 }
                 f24 src3[4] = {
-                    src3_[(int)mad_swizzle.src3_selector_0.Value()],
-                    src3_[(int)mad_swizzle.src3_selector_1.Value()],
-                    src3_[(int)mad_swizzle.src3_selector_2.Value()],
-                    src3_[(int)mad_swizzle.src3_selector_3.Value()],
+                    src3_[op.src[2].selector[0]],
+                    src3_[op.src[2].selector[1]],
+                    src3_[op.src[2].selector[2]],
+                    src3_[op.src[2].selector[3]],
                 };
-                if (negate_src3) {
+                if (op.src[2].negate) {
                     src3[0] = -src3[0];
                     src3[1] = -src3[1];
                     src3[2] = -src3[2];
                     src3[3] = -src3[3];
                 }
 
-                f24* dest = (instr.mad.dest.Value() < 0x10)
-                                ? &state.registers.output[instr.mad.dest.Value().GetIndex()][0]
-                            : (instr.mad.dest.Value() < 0x20)
-                                ? &state.registers.temporary[instr.mad.dest.Value().GetIndex()][0]
-                                : dummy_vec4_float24;
+                f24* dest =
+                    &dest_files[static_cast<std::size_t>(op.dest_file)][op.dest_index].x;
 
                 Record<DebugDataRecord::SRC1>(debug_data, iteration, src1);
                 Record<DebugDataRecord::SRC2>(debug_data, iteration, src2);
                 Record<DebugDataRecord::SRC3>(debug_data, iteration, src3);
                 Record<DebugDataRecord::DEST_IN>(debug_data, iteration, dest);
                 for (int i = 0; i < 4; ++i) {
-                    if (!mad_swizzle.DestComponentEnabled(i))
+                    if (!op.DestComponentEnabled(i))
                         continue;
 
                     dest[i] = src1[i] * src2[i] + src3[i];
@@ -536,7 +738,7 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
 
         default: {
             // Handle each instruction on its own
-            switch (instr.opcode.Value()) {
+            switch (op.opcode) {
             case OpCode::Id::END:
                 exit_loop = true;
                 break;
@@ -544,7 +746,7 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
             case OpCode::Id::JMPC:
                 Record<DebugDataRecord::COND_CMP_IN>(debug_data, iteration, state.conditional_code);
                 if (evaluate_condition(instr.flow_control)) {
-                    program_counter = instr.flow_control.dest_offset - 1;
+                    program_counter = op.dest_offset - 1;
                 }
                 break;
 
@@ -554,29 +756,26 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
 
                 if (uniforms.b[instr.flow_control.bool_uniform_id] ==
                     !(instr.flow_control.num_instructions & 1)) {
-                    program_counter = instr.flow_control.dest_offset - 1;
+                    program_counter = op.dest_offset - 1;
                 }
                 break;
 
             case OpCode::Id::CALL:
-                call(instr.flow_control.dest_offset, instr.flow_control.num_instructions,
-                     program_counter + 1, 0, 0);
+                call(op.dest_offset, op.num_instructions, op.return_offset, 0, 0);
                 break;
 
             case OpCode::Id::CALLU:
                 Record<DebugDataRecord::COND_BOOL_IN>(
                     debug_data, iteration, uniforms.b[instr.flow_control.bool_uniform_id]);
                 if (uniforms.b[instr.flow_control.bool_uniform_id]) {
-                    call(instr.flow_control.dest_offset, instr.flow_control.num_instructions,
-                         program_counter + 1, 0, 0);
+                    call(op.dest_offset, op.num_instructions, op.return_offset, 0, 0);
                 }
                 break;
 
             case OpCode::Id::CALLC:
                 Record<DebugDataRecord::COND_CMP_IN>(debug_data, iteration, state.conditional_code);
                 if (evaluate_condition(instr.flow_control)) {
-                    call(instr.flow_control.dest_offset, instr.flow_control.num_instructions,
-                         program_counter + 1, 0, 0);
+                    call(op.dest_offset, op.num_instructions, op.return_offset, 0, 0);
                 }
                 break;
 
@@ -587,13 +786,10 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
                 Record<DebugDataRecord::COND_BOOL_IN>(
                     debug_data, iteration, uniforms.b[instr.flow_control.bool_uniform_id]);
                 if (uniforms.b[instr.flow_control.bool_uniform_id]) {
-                    call(program_counter + 1, instr.flow_control.dest_offset - program_counter - 1,
-                         instr.flow_control.dest_offset + instr.flow_control.num_instructions, 0,
-                         0);
+                    call(program_counter + 1, op.dest_offset - program_counter - 1,
+                         op.return_offset, 0, 0);
                 } else {
-                    call(instr.flow_control.dest_offset, instr.flow_control.num_instructions,
-                         instr.flow_control.dest_offset + instr.flow_control.num_instructions, 0,
-                         0);
+                    call(op.dest_offset, op.num_instructions, op.return_offset, 0, 0);
                 }
 
                 break;
@@ -603,13 +799,10 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
 
                 Record<DebugDataRecord::COND_CMP_IN>(debug_data, iteration, state.conditional_code);
                 if (evaluate_condition(instr.flow_control)) {
-                    call(program_counter + 1, instr.flow_control.dest_offset - program_counter - 1,
-                         instr.flow_control.dest_offset + instr.flow_control.num_instructions, 0,
-                         0);
+                    call(program_counter + 1, op.dest_offset - program_counter - 1,
+                         op.return_offset, 0, 0);
                 } else {
-                    call(instr.flow_control.dest_offset, instr.flow_control.num_instructions,
-                         instr.flow_control.dest_offset + instr.flow_control.num_instructions, 0,
-                         0);
+                    call(op.dest_offset, op.num_instructions, op.return_offset, 0, 0);
                 }
 
                 break;
@@ -623,8 +816,8 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
                 state.address_registers[2] = loop_param.y;
 
                 Record<DebugDataRecord::LOOP_INT_IN>(debug_data, iteration, loop_param);
-                call(program_counter + 1, instr.flow_control.dest_offset - program_counter,
-                     instr.flow_control.dest_offset + 1, loop_param.x, loop_param.z);
+                call(program_counter + 1, op.dest_offset - program_counter, op.return_offset,
+                     loop_param.x, loop_param.z);
                 break;
             }
 
@@ -660,9 +853,26 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
     }
 }
 
+InterpreterEngine::InterpreterEngine() = default;
+InterpreterEngine::~InterpreterEngine() = default;
+
 void InterpreterEngine::SetupBatch(ShaderSetup& setup, unsigned int entry_point) {
     ASSERT(entry_point < MAX_PROGRAM_CODE_LENGTH);
     setup.engine_data.entry_point = entry_point;
+
+    u64 code_hash = setup.GetProgramCodeHash();
+    u64 swizzle_hash = setup.GetSwizzleDataHash();
+
+    u64 cache_key = code_hash ^ swizzle_hash;
+    auto iter = cache.find(cache_key);
+    if (iter != cache.end()) {
+        setup.engine_data.cached_shader = iter->second.get();
+    } else {
+        auto program = std::make_unique<MicroOpProgram>(
+            DecodeProgram(setup.program_code, setup.swizzle_data));
+        setup.engine_data.cached_shader = program.get();
+        cache.emplace_hint(iter, cache_key, std::move(program));
+    }
 }
 
 MICROPROFILE_DECLARE(GPU_Shader);
@@ -672,7 +882,15 @@ void InterpreterEngine::Run(const ShaderSetup& setup, UnitState& state) const {
     MICROPROFILE_SCOPE(GPU_Shader);
 
     DebugData<false> dummy_debug_data;
-    RunInterpreter(setup, state, dummy_debug_data, setup.engine_data.entry_point);
+    if (setup.engine_data.cached_shader != nullptr) {
+        const auto& program = *static_cast<const MicroOpProgram*>(setup.engine_data.cached_shader);
+        RunInterpreter(setup, state, program, dummy_debug_data, setup.engine_data.entry_point);
+        return;
+    }
+
+    // The setup wasn't prepared with SetupBatch, so decode the program for this run only
+    const MicroOpProgram program = DecodeProgram(setup.program_code, setup.swizzle_data);
+    RunInterpreter(setup, state, program, dummy_debug_data, setup.engine_data.entry_point);
 }
 
 DebugData<true> InterpreterEngine::ProduceDebugInfo(const ShaderSetup& setup,
@@ -684,7 +902,8 @@ DebugData<true> InterpreterEngine::ProduceDebugInfo(const ShaderSetup& setup,
     // Setup input register table
     state.registers.input.fill(Common::Vec4<f24>::AssignToAll(f24::Zero()));
     state.LoadInput(config, input);
-    RunInterpreter(setup, state, debug_data, setup.engine_data.entry_point);
+    const MicroOpProgram program = DecodeProgram(setup.program_code, setup.swizzle_data);
+    RunInterpreter(setup, state, program, debug_data, setup.engine_data.entry_point);
     return debug_data;
 }
 
@@ -4,13 +4,21 @@
 
 #pragma once
 
+#include <memory>
+#include <unordered_map>
+#include "common/common_types.h"
 #include "video_core/shader/debug_data.h"
 #include "video_core/shader/shader.h"
 
 namespace Pica::Shader {
 
+struct MicroOpProgram;
+
 class InterpreterEngine final : public ShaderEngine {
 public:
+    InterpreterEngine();
+    ~InterpreterEngine() override;
+
     void SetupBatch(ShaderSetup& setup, unsigned int entry_point) override;
     void Run(const ShaderSetup& setup, UnitState& state) const override;
 
@@ -23,6 +31,10 @@ public:
      */
     DebugData<true> ProduceDebugInfo(const ShaderSetup& setup, const AttributeBuffer& input,
                                      const ShaderRegs& config) const;
+
+private:
+    /// Programs decoded into micro-ops, keyed by the hashes of their code and swizzle data
+    std::unordered_map<u64, std::unique_ptr<MicroOpProgram>> cache;
 };
 
 } // namespace Pica::Shader
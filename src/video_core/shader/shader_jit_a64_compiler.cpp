@@ -0,0 +1,1143 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/arch.h"
+#if CITRA_ARCH(arm64)
+
+#include <algorithm>
+#include <cstdint>
+#include <nihstro/shader_bytecode.h>
+#include <oaknut/oaknut.hpp>
+#include "common/aarch64/oaknut_abi.h"
+#include "common/aarch64/oaknut_util.h"
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "common/vector_math.h"
+#include "video_core/pica_state.h"
+#include "video_core/pica_types.h"
+#include "video_core/shader/shader.h"
+#include "video_core/shader/shader_jit_a64_compiler.h"
+
+using namespace Common::A64;
+using namespace oaknut;
+using namespace oaknut::util;
+
+using nihstro::DestRegister;
+using nihstro::RegisterType;
+
+namespace Pica::Shader {
+
+typedef void (JitShader::*JitFunction)(Instruction instr);
+
+const JitFunction instr_table[64] = {
+    &JitShader::Compile_ADD,    // add
+    &JitShader::Compile_DP3,    // dp3
+    &JitShader::Compile_DP4,    // dp4
+    &JitShader::Compile_DPH,    // dph
+    nullptr,                    // unknown
+    &JitShader::Compile_EX2,    // ex2
+    &JitShader::Compile_LG2,    // lg2
+    nullptr,                    // unknown
+    &JitShader::Compile_MUL,    // mul
+    &JitShader::Compile_SGE,    // sge
+    &JitShader::Compile_SLT,    // slt
+    &JitShader::Compile_FLR,    // flr
+    &JitShader::Compile_MAX,    // max
+    &JitShader::Compile_MIN,    // min
+    &JitShader::Compile_RCP,    // rcp
+    &JitShader::Compile_RSQ,    // rsq
+    nullptr,                    // unknown
+    nullptr,                    // unknown
+    &JitShader::Compile_MOVA,   // mova
+    &JitShader::Compile_MOV,    // mov
+    nullptr,                    // unknown
+    nullptr,                    // unknown
+    nullptr,                    // unknown
+    nullptr,                    // unknown
+    &JitShader::Compile_DPH,    // dphi
+    nullptr,                    // unknown
+    &JitShader::Compile_SGE,    // sgei
+    &JitShader::Compile_SLT,    // slti
+    nullptr,                    // unknown
+    nullptr,                    // unknown
+    nullptr,                    // unknown
+    nullptr,                    // unknown
+    nullptr,                    // unknown
+    &JitShader::Compile_NOP,    // nop
+    &JitShader::Compile_END,    // end
+    &JitShader::Compile_BREAKC, // breakc
+    &JitShader::Compile_CALL,   // call
+    &JitShader::Compile_CALLC,  // callc
+    &JitShader::Compile_CALLU,  // callu
+    &JitShader::Compile_IF,     // ifu
+    &JitShader::Compile_IF,     // ifc
+    &JitShader::Compile_LOOP,   // loop
+    &JitShader::Compile_EMIT,   // emit
+    &JitShader::Compile_SETE,   // sete
+    &JitShader::Compile_JMP,    // jmpc
+    &JitShader::Compile_JMP,    // jmpu
+    &JitShader::Compile_CMP,    // cmp
+    &JitShader::Compile_CMP,    // cmp
+    &JitShader::Compile_MAD,    // madi
+    &JitShader::Compile_MAD,    // madi
+    &JitShader::Compile_MAD,    // madi
+    &JitShader::Compile_MAD,    // madi
+    &JitShader::Compile_MAD,    // madi
+    &JitShader::Compile_MAD,    // madi
+    &JitShader::Compile_MAD,    // madi
+    &JitShader::Compile_MAD,    // madi
+    &JitShader::Compile_MAD,    // mad
+    &JitShader::Compile_MAD,    // mad
+    &JitShader::Compile_MAD,    // mad
+    &JitShader::Compile_MAD,    // mad
+    &JitShader::Compile_MAD,    // mad
+    &JitShader::Compile_MAD,    // mad
+    &JitShader::Compile_MAD,    // mad
+    &JitShader::Compile_MAD,    // mad
+};
+
+// The following is used to alias some commonly used registers. Generally, X0-X2 and Q0-Q4 can be
+// used as scratch registers within a compiler function. The other registers have designated
+// purposes, as documented below:
+
+/// General purpose scratch registers
+constexpr XReg XSCRATCH0 = X0;
+constexpr WReg WSCRATCH0 = W0;
+constexpr XReg XSCRATCH1 = X1;
+constexpr WReg WSCRATCH1 = W1;
+constexpr XReg XSCRATCH2 = X2;
+constexpr WReg WSCRATCH2 = W2;
+/// Pointer to the uniform memory
+constexpr XReg UNIFORMS = X9;
+/// The two 32-bit VS address offset registers set by the MOVA instruction
+constexpr XReg ADDROFFS_REG_0 = X10;
+constexpr XReg ADDROFFS_REG_1 = X11;
+/// VS loop count register (Multiplied by 16)
+constexpr WReg LOOPCOUNT_REG = W12;
+/// Current VS loop iteration number (we could probably use LOOPCOUNT_REG, but this quicker)
+constexpr WReg LOOPCOUNT = W6;
+/// Number to increment LOOPCOUNT_REG by on each loop iteration (Multiplied by 16)
+constexpr WReg LOOPINC = W7;
+/// Result of the previous CMP instruction for the X-component comparison
+constexpr XReg COND0 = X13;
+/// Result of the previous CMP instruction for the Y-component comparison
+constexpr XReg COND1 = X14;
+/// Pointer to the UnitState instance for the current VS unit
+constexpr XReg STATE = X15;
+/// Stack pointer at the entry of the shader program, used by END to return to the caller
+constexpr XReg PROGRAM_STACK = X19;
+/// SIMD scratch register
+constexpr QReg SCRATCH = Q0;
+/// Loaded with the first swizzled source register, otherwise can be used as a scratch register
+constexpr QReg SRC1 = Q1;
+/// Loaded with the second swizzled source register, otherwise can be used as a scratch register
+constexpr QReg SRC2 = Q2;
+/// Loaded with the third swizzled source register, otherwise can be used as a scratch register
+constexpr QReg SRC3 = Q3;
+/// Additional scratch register
+constexpr QReg SCRATCH2 = Q4;
+/// Constant vector of [1.0f, 1.0f, 1.0f, 1.0f], used to efficiently set a vector to one
+constexpr QReg ONE = Q14;
+
+// State registers that must not be modified by external functions calls
+// Scratch registers, e.g., SRC1 and SCRATCH, have to be saved on the side if needed
+static const std::bitset<64> persistent_regs = BuildRegSet({
+    // Pointers to register blocks
+    UNIFORMS,
+    STATE,
+    // Cached registers
+    ADDROFFS_REG_0,
+    ADDROFFS_REG_1,
+    LOOPCOUNT_REG,
+    COND0,
+    COND1,
+    // Constants
+    ONE,
+    // Loop variables
+    LOOPCOUNT,
+    LOOPINC,
+});
+
+/// Raw constant for the source register selector that indicates no swizzling is performed
+static const u8 NO_SRC_REG_SWIZZLE = 0x1b;
+/// Raw constant for the destination register enable mask that indicates all components are enabled
+static const u8 NO_DEST_REG_MASK = 0xf;
+
+static void LogCritical(const char* msg) {
+    LOG_CRITICAL(HW_GPU, "{}", msg);
+}
+
+void JitShader::Compile_Assert(bool condition, const char* msg) {
+    if (!condition) {
+        ABI_PushRegisters(*this, PersistentCallerSavedRegs());
+        MOVP2R(ABI_PARAM1, msg);
+        CallFarFunction(*this, LogCritical);
+        ABI_PopRegisters(*this, PersistentCallerSavedRegs());
+    }
+}
+
+/**
+ * Loads and swizzles a source register into the specified vector register.
+ * @param instr VS instruction, used for determining how to load the source register
+ * @param src_num Number indicating which source register to load (1 = src1, 2 = src2, 3 = src3)
+ * @param src_reg SourceRegister object corresponding to the source register to load
+ * @param dest Destination vector register to store the loaded, swizzled source register
+ */
+void JitShader::Compile_SwizzleSrc(Instruction instr, unsigned src_num, SourceRegister src_reg,
+                                   QReg dest) {
+    XReg src_ptr = XZR;
+    std::size_t src_offset;
+    switch (src_reg.GetRegisterType()) {
+    case RegisterType::FloatUniform:
+        src_ptr = UNIFORMS;
+        src_offset = Uniforms::GetFloatUniformOffset(src_reg.GetIndex());
+        break;
+    case RegisterType::Input:
+        src_ptr = STATE;
+        src_offset = UnitState::InputOffset(src_reg.GetIndex());
+        break;
+    case RegisterType::Temporary:
+        src_ptr = STATE;
+        src_offset = UnitState::TemporaryOffset(src_reg.GetIndex());
+        break;
+    default:
+        UNREACHABLE_MSG("Encountered unknown source register type: {}", src_reg.GetRegisterType());
+        break;
+    }
+
+    const u32 src_offset_disp = static_cast<u32>(src_offset);
+    ASSERT_MSG(src_offset == static_cast<std::size_t>(src_offset_disp),
+               "Source register offset too large for int type");
+
+    unsigned operand_desc_id;
+
+    const bool is_inverted =
+        (0 != (instr.opcode.Value().GetInfo().subtype & OpCode::Info::SrcInversed));
+
+    unsigned address_register_index;
+    unsigned offset_src;
+
+    if (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MAD ||
+        instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI) {
+        operand_desc_id = instr.mad.operand_desc_id;
+        offset_src = is_inverted ? 3 : 2;
+        address_register_index = instr.mad.address_register_index;
+    } else {
+        operand_desc_id = instr.common.operand_desc_id;
+        offset_src = is_inverted ? 2 : 1;
+        address_register_index = instr.common.address_register_index;
+    }
+
+    if (src_num == offset_src && address_register_index != 0) {
+        switch (address_register_index) {
+        case 1: // address offset 1
+            ADD(XSCRATCH2, src_ptr, ADDROFFS_REG_0);
+            break;
+        case 2: // address offset 2
+            ADD(XSCRATCH2, src_ptr, ADDROFFS_REG_1);
+            break;
+        case 3: // address offset 3
+            ADD(XSCRATCH2, src_ptr, LOOPCOUNT_REG.toX());
+            break;
+        default:
+            UNREACHABLE();
+            break;
+        }
+        LDR(dest, XSCRATCH2, src_offset_disp);
+    } else {
+        // Load the source
+        LDR(dest, src_ptr, src_offset_disp);
+    }
+
+    SwizzlePattern swiz = {(*swizzle_data)[operand_desc_id]};
+
+    // Generate instructions for source register swizzling as needed
+    const u8 sel = swiz.GetRawSelector(src_num);
+    if (sel != NO_SRC_REG_SWIZZLE) {
+        const std::array<u8, 4> components = {
+            static_cast<u8>((sel >> 6) & 3),
+            static_cast<u8>((sel >> 4) & 3),
+            static_cast<u8>((sel >> 2) & 3),
+            static_cast<u8>(sel & 3),
+        };
+
+        if (std::all_of(components.begin(), components.end(),
+                        [&](u8 component) { return component == components[0]; })) {
+            // Broadcast a single component
+            DUP(dest.S4(), dest.Selem()[components[0]]);
+        } else {
+            // Shuffle the bytes of the vector using the precomputed indices for this selector
+            ADR(XSCRATCH0, swizzle_table);
+            LDR(SCRATCH, XSCRATCH0, sel * 16);
+            TBL(dest.B16(), List{dest.B16()}, SCRATCH.B16());
+        }
+    }
+
+    // If the source register should be negated, flip the sign bit
+    const bool negate[] = {swiz.negate_src1, swiz.negate_src2, swiz.negate_src3};
+    if (negate[src_num - 1]) {
+        FNEG(dest.S4(), dest.S4());
+    }
+}
+
+void JitShader::Compile_DestEnable(Instruction instr, QReg src) {
+    DestRegister dest;
+    unsigned operand_desc_id;
+    if (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MAD ||
+        instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI) {
+        operand_desc_id = instr.mad.operand_desc_id;
+        dest = instr.mad.dest.Value();
+    } else {
+        operand_desc_id = instr.common.operand_desc_id;
+        dest = instr.common.dest.Value();
+    }
+
+    SwizzlePattern swiz = {(*swizzle_data)[operand_desc_id]};
+
+    std::size_t dest_offset_disp;
+    switch (dest.GetRegisterType()) {
+    case RegisterType::Output:
+        dest_offset_disp = UnitState::OutputOffset(dest.GetIndex());
+        break;
+    case RegisterType::Temporary:
+        dest_offset_disp = UnitState::TemporaryOffset(dest.GetIndex());
+        break;
+    default:
+        UNREACHABLE_MSG("Encountered unknown destination register type: {}",
+                        dest.GetRegisterType());
+        break;
+    }
+
+    // If all components are enabled, write the result to the destination register
+    if (swiz.dest_mask == NO_DEST_REG_MASK) {
+        // Store dest back to memory
+        STR(src, STATE, dest_offset_disp);
+
+    } else {
+        // Not all components are enabled, so insert the enabled components of the result into the
+        // destination register...
+        LDR(SCRATCH, STATE, dest_offset_disp);
+
+        for (int i = 0; i < 4; ++i) {
+            if (swiz.DestComponentEnabled(i)) {
+                INS(SCRATCH.Selem()[i], src.Selem()[i]);
+            }
+        }
+
+        // Store dest back to memory
+        STR(SCRATCH, STATE, dest_offset_disp);
+    }
+}
+
+void JitShader::Compile_SanitizedMul(QReg src1, QReg src2, QReg scratch) {
+    // 0 * inf and inf * 0 in the PICA should return 0 instead of NaN. This can be implemented by
+    // checking for NaNs before and after the multiplication.  If the multiplication result is NaN
+    // where neither source was, this NaN was generated by a 0 * inf multiplication, and so the
+    // result should be transformed to 0 to match PICA fp rules.
+
+    FMUL(scratch.S4(), src1.S4(), src2.S4());
+
+    // Set src1 to mask of (src1 != NaN and src2 != NaN)
+    FCMEQ(src1.S4(), src1.S4(), src1.S4());
+    FCMEQ(src2.S4(), src2.S4(), src2.S4());
+    AND(src1.B16(), src1.B16(), src2.B16());
+
+    // Set src2 to mask of (result != NaN)
+    FCMEQ(src2.S4(), scratch.S4(), scratch.S4());
+
+    // Clear components where the result is NaN where neither source was NaN
+    BIC(src1.B16(), src1.B16(), src2.B16());
+    BIC(src1.B16(), scratch.B16(), src1.B16());
+}
+
+void JitShader::Compile_EvaluateCondition(Instruction instr) {
+    // Sets `dest` to 1 if `cond` equals `ref`, and to 0 otherwise
+    const auto compare = [this](WReg dest, XReg cond, u32 ref) {
+        if (ref) {
+            MOV(dest, cond.toW());
+        } else {
+            EOR(dest, cond.toW(), 1);
+        }
+    };
+
+    switch (instr.flow_control.op) {
+    case Instruction::FlowControlType::Or:
+        compare(WSCRATCH0, COND0, instr.flow_control.refx.Value());
+        compare(WSCRATCH1, COND1, instr.flow_control.refy.Value());
+        ORR(WSCRATCH0, WSCRATCH0, WSCRATCH1);
+        break;
+
+    case Instruction::FlowControlType::And:
+        compare(WSCRATCH0, COND0, instr.flow_control.refx.Value());
+        compare(WSCRATCH1, COND1, instr.flow_control.refy.Value());
+        AND(WSCRATCH0, WSCRATCH0, WSCRATCH1);
+        break;
+
+    case Instruction::FlowControlType::JustX:
+        compare(WSCRATCH0, COND0, instr.flow_control.refx.Value());
+        break;
+
+    case Instruction::FlowControlType::JustY:
+        compare(WSCRATCH0, COND1, instr.flow_control.refy.Value());
+        break;
+    }
+
+    CMP(WSCRATCH0, 0);
+}
+
+void JitShader::Compile_UniformCondition(Instruction instr) {
+    std::size_t offset = Uniforms::GetBoolUniformOffset(instr.flow_control.bool_uniform_id);
+    LDRB(WSCRATCH0, UNIFORMS, offset);
+    CMP(WSCRATCH0, 0);
+}
+
+std::bitset<64> JitShader::PersistentCallerSavedRegs() {
+    return persistent_regs & ABI_ALL_CALLER_SAVED;
+}
+
+void JitShader::Compile_ADD(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+    Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
+    FADD(SRC1.S4(), SRC1.S4(), SRC2.S4());
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitShader::Compile_DP3(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+    Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
+
+    Compile_SanitizedMul(SRC1, SRC2, SCRATCH);
+
+    // Clear the 4th component and sum up the others
+    INS(SRC1.Selem()[3], WZR);
+    FADDP(SRC1.S4(), SRC1.S4(), SRC1.S4());
+    FADDP(SRC1.S4(), SRC1.S4(), SRC1.S4());
+
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitShader::Compile_DP4(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+    Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
+
+    Compile_SanitizedMul(SRC1, SRC2, SCRATCH);
+
+    FADDP(SRC1.S4(), SRC1.S4(), SRC1.S4());
+    FADDP(SRC1.S4(), SRC1.S4(), SRC1.S4());
+
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitShader::Compile_DPH(Instruction instr) {
+    if (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::DPHI) {
+        Compile_SwizzleSrc(instr, 1, instr.common.src1i, SRC1);
+        Compile_SwizzleSrc(instr, 2, instr.common.src2i, SRC2);
+    } else {
+        Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+        Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
+    }
+
+    // Set 4th component to 1.0
+    INS(SRC1.Selem()[3], ONE.Selem()[0]);
+
+    Compile_SanitizedMul(SRC1, SRC2, SCRATCH);
+
+    FADDP(SRC1.S4(), SRC1.S4(), SRC1.S4());
+    FADDP(SRC1.S4(), SRC1.S4(), SRC1.S4());
+
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitShader::Compile_EX2(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+    BL(exp2_subroutine);
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitShader::Compile_LG2(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+    BL(log2_subroutine);
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitShader::Compile_MUL(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+    Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
+    Compile_SanitizedMul(SRC1, SRC2, SCRATCH);
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitShader::Compile_SGE(Instruction instr) {
+    if (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::SGEI) {
+        Compile_SwizzleSrc(instr, 1, instr.common.src1i, SRC1);
+        Compile_SwizzleSrc(instr, 2, instr.common.src2i, SRC2);
+    } else {
+        Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+        Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
+    }
+
+    FCMGE(SRC2.S4(), SRC1.S4(), SRC2.S4());
+    AND(SRC2.B16(), SRC2.B16(), ONE.B16());
+
+    Compile_DestEnable(instr, SRC2);
+}
+
+void JitShader::Compile_SLT(Instruction instr) {
+    if (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::SLTI) {
+        Compile_SwizzleSrc(instr, 1, instr.common.src1i, SRC1);
+        Compile_SwizzleSrc(instr, 2, instr.common.src2i, SRC2);
+    } else {
+        Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+        Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
+    }
+
+    FCMGT(SRC1.S4(), SRC2.S4(), SRC1.S4());
+    AND(SRC1.B16(), SRC1.B16(), ONE.B16());
+
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitShader::Compile_FLR(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+    FRINTM(SRC1.S4(), SRC1.S4());
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitShader::Compile_MAX(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+    Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
+    // FMAX would return NaN, but PICA200 returns SRC2 in case of NaN.
+    FCMGT(SCRATCH.S4(), SRC1.S4(), SRC2.S4());
+    BIF(SRC1.B16(), SRC2.B16(), SCRATCH.B16());
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitShader::Compile_MIN(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+    Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
+    // FMIN would return NaN, but PICA200 returns SRC2 in case of NaN.
+    FCMGT(SCRATCH.S4(), SRC2.S4(), SRC1.S4());
+    BIF(SRC1.B16(), SRC2.B16(), SCRATCH.B16());
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitShader::Compile_MOVA(Instruction instr) {
+    SwizzlePattern swiz = {(*swizzle_data)[instr.common.operand_desc_id]};
+
+    if (!swiz.DestComponentEnabled(0) && !swiz.DestComponentEnabled(1)) {
+        return; // NoOp
+    }
+
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+
+    // Convert floats to integers using truncation (only care about X and Y components)
+    FCVTZS(SRC1.S4(), SRC1.S4());
+
+    // Handle destination enable
+    if (swiz.DestComponentEnabled(0)) {
+        // Move and sign-extend X component
+        SMOV(ADDROFFS_REG_0, SRC1.Selem()[0]);
+
+        // Multiply by 16 to be used as an offset later
+        LSL(ADDROFFS_REG_0, ADDROFFS_REG_0, 4);
+    }
+    if (swiz.DestComponentEnabled(1)) {
+        // Move and sign-extend Y component
+        SMOV(ADDROFFS_REG_1, SRC1.Selem()[1]);
+
+        // Multiply by 16 to be used as an offset later
+        LSL(ADDROFFS_REG_1, ADDROFFS_REG_1, 4);
+    }
+}
+
+void JitShader::Compile_MOV(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitShader::Compile_RCP(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+
+    // FRECPE is only accurate to 8 bits, a full division is closer to the precision of the PICA
+    FDIV(SRC1.toS(), ONE.toS(), SRC1.toS());
+    DUP(SRC1.S4(), SRC1.Selem()[0]); // XYWZ -> XXXX
+
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitShader::Compile_RSQ(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+
+    // FRSQRTE is only accurate to 8 bits, a full square root and division is closer to the
+    // precision of the PICA
+    FSQRT(SRC1.toS(), SRC1.toS());
+    FDIV(SRC1.toS(), ONE.toS(), SRC1.toS());
+    DUP(SRC1.S4(), SRC1.Selem()[0]); // XYWZ -> XXXX
+
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitShader::Compile_NOP(Instruction instr) {}
+
+void JitShader::Compile_END(Instruction instr) {
+    // Save conditional code
+    STRB(COND0.toW(), STATE, offsetof(UnitState, conditional_code[0]));
+    STRB(COND1.toW(), STATE, offsetof(UnitState, conditional_code[1]));
+
+    // Save address/loop registers
+    ASR(XSCRATCH0, ADDROFFS_REG_0, 4);
+    ASR(XSCRATCH1, ADDROFFS_REG_1, 4);
+    ASR(WSCRATCH2, LOOPCOUNT_REG, 4);
+    STR(WSCRATCH0, STATE, offsetof(UnitState, address_registers[0]));
+    STR(WSCRATCH1, STATE, offsetof(UnitState, address_registers[1]));
+    STR(WSCRATCH2, STATE, offsetof(UnitState, address_registers[2]));
+
+    // Return to the caller, discarding the frames of any subroutine we are in
+    MOV(SP, PROGRAM_STACK);
+    ABI_PopRegisters(*this, ABI_ALL_CALLEE_SAVED);
+    RET();
+}
+
+void JitShader::Compile_BREAKC(Instruction instr) {
+    Compile_Assert(loop_depth, "BREAKC must be inside a LOOP");
+    if (loop_depth) {
+        Compile_EvaluateCondition(instr);
+        ASSERT(!loop_break_labels.empty());
+        B(NE, loop_break_labels.back());
+    }
+}
+
+void JitShader::Compile_CALL(Instruction instr) {
+    // Push offset of the return and the address to return to
+    Label return_label;
+    MOV(WSCRATCH0, instr.flow_control.dest_offset + instr.flow_control.num_instructions);
+    ADR(XSCRATCH1, return_label);
+    STP(XSCRATCH0, XSCRATCH1, SP, PRE_INDEXED, -16);
+
+    // Call the subroutine
+    B(instruction_labels[instr.flow_control.dest_offset]);
+
+    // Skip over the return offset and address that are on the stack
+    l(return_label);
+    ADD(SP, SP, 16);
+}
+
+void JitShader::Compile_CALLC(Instruction instr) {
+    Compile_EvaluateCondition(instr);
+    Label b;
+    B(EQ, b);
+    Compile_CALL(instr);
+    l(b);
+}
+
+void JitShader::Compile_CALLU(Instruction instr) {
+    Compile_UniformCondition(instr);
+    Label b;
+    B(EQ, b);
+    Compile_CALL(instr);
+    l(b);
+}
+
+void JitShader::Compile_CMP(Instruction instr) {
+    using Op = Instruction::Common::CompareOpType::Op;
+    Op op_x = instr.common.compare_op.x;
+    Op op_y = instr.common.compare_op.y;
+
+    Compile_SwizzleSrc(instr, 1, instr.common.src1, SRC1);
+    Compile_SwizzleSrc(instr, 2, instr.common.src2, SRC2);
+
+    // NEON only has EQ, GE and GT comparisons. LT and LE are emulated by swapping the operands,
+    // NEQ by inverting EQ, which also makes it match when used with NaNs like on the PICA.
+    const auto compare = [this](QReg dest, Op op) {
+        switch (op) {
+        case Op::Equal:
+            FCMEQ(dest.S4(), SRC1.S4(), SRC2.S4());
+            break;
+        case Op::NotEqual:
+            FCMEQ(dest.S4(), SRC1.S4(), SRC2.S4());
+            NOT(dest.B16(), dest.B16());
+            break;
+        case Op::LessThan:
+            FCMGT(dest.S4(), SRC2.S4(), SRC1.S4());
+            break;
+        case Op::LessEqual:
+            FCMGE(dest.S4(), SRC2.S4(), SRC1.S4());
+            break;
+        case Op::GreaterThan:
+            FCMGT(dest.S4(), SRC1.S4(), SRC2.S4());
+            break;
+        case Op::GreaterEqual:
+            FCMGE(dest.S4(), SRC1.S4(), SRC2.S4());
+            break;
+        default:
+            UNREACHABLE_MSG("Unknown compare mode {:x}", static_cast<int>(op));
+            break;
+        }
+    };
+
+    compare(SCRATCH, op_x);
+    if (op_x != op_y) {
+        // Compare Y-component separately
+        compare(SCRATCH2, op_y);
+        INS(SCRATCH.Selem()[1], SCRATCH2.Selem()[1]);
+    }
+
+    // Extract the X and Y results
+    UMOV(XSCRATCH0, SCRATCH.Delem()[0]);
+    UBFX(COND0, XSCRATCH0, 31, 1);
+    LSR(COND1, XSCRATCH0, 63);
+}
+
+void JitShader::Compile_MAD(Instruction instr) {
+    Compile_SwizzleSrc(instr, 1, instr.mad.src1, SRC1);
+
+    if (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI) {
+        Compile_SwizzleSrc(instr, 2, instr.mad.src2i, SRC2);
+        Compile_SwizzleSrc(instr, 3, instr.mad.src3i, SRC3);
+    } else {
+        Compile_SwizzleSrc(instr, 2, instr.mad.src2, SRC2);
+        Compile_SwizzleSrc(instr, 3, instr.mad.src3, SRC3);
+    }
+
+    Compile_SanitizedMul(SRC1, SRC2, SCRATCH);
+    FADD(SRC1.S4(), SRC1.S4(), SRC3.S4());
+
+    Compile_DestEnable(instr, SRC1);
+}
+
+void JitShader::Compile_IF(Instruction instr) {
+    Compile_Assert(instr.flow_control.dest_offset >= program_counter,
+                   "Backwards if-statements not supported");
+    Label l_else, l_endif;
+
+    // Evaluate the "IF" condition
+    if (instr.opcode.Value() == OpCode::Id::IFU) {
+        Compile_UniformCondition(instr);
+    } else if (instr.opcode.Value() == OpCode::Id::IFC) {
+        Compile_EvaluateCondition(instr);
+    }
+    B(EQ, l_else);
+
+    // Compile the code that corresponds to the condition evaluating as true
+    Compile_Block(instr.flow_control.dest_offset);
+
+    // If there isn't an "ELSE" condition, we are done here
+    if (instr.flow_control.num_instructions == 0) {
+        l(l_else);
+        return;
+    }
+
+    B(l_endif);
+
+    l(l_else);
+    // This code corresponds to the "ELSE" condition
+    // Comple the code that corresponds to the condition evaluating as false
+    Compile_Block(instr.flow_control.dest_offset + instr.flow_control.num_instructions);
+
+    l(l_endif);
+}
+
+void JitShader::Compile_LOOP(Instruction instr) {
+    Compile_Assert(instr.flow_control.dest_offset >= program_counter,
+                   "Backwards loops not supported");
+    Compile_Assert(loop_depth < 1, "Nested loops may not be supported");
+    if (loop_depth++) {
+        const auto loop_save_regs = BuildRegSet({LOOPCOUNT_REG, LOOPINC, LOOPCOUNT});
+        ABI_PushRegisters(*this, loop_save_regs);
+    }
+
+    // This decodes the fields from the integer uniform at index instr.flow_control.int_uniform_id.
+    // The Y (LOOPCOUNT_REG) and Z (LOOPINC) component are kept multiplied by 16 (Left shifted by
+    // 4 bits) to be used as an offset into the 16-byte vector registers later
+    std::size_t offset = Uniforms::GetIntUniformOffset(instr.flow_control.int_uniform_id);
+    LDR(LOOPCOUNT, UNIFORMS, offset);
+    UBFX(LOOPCOUNT_REG, LOOPCOUNT, 8, 8); // Y-component is the start
+    LSL(LOOPCOUNT_REG, LOOPCOUNT_REG, 4);
+    UBFX(LOOPINC, LOOPCOUNT, 16, 8); // Z-component is the incrementer
+    LSL(LOOPINC, LOOPINC, 4);
+    UBFX(LOOPCOUNT, LOOPCOUNT, 0, 8);   // X-component is iteration count
+    ADD(LOOPCOUNT, LOOPCOUNT, 1);       // Iteration count is X-component + 1
+
+    Label l_loop_start;
+    l(l_loop_start);
+
+    loop_break_labels.emplace_back(Label());
+    Compile_Block(instr.flow_control.dest_offset + 1);
+
+    ADD(LOOPCOUNT_REG, LOOPCOUNT_REG, LOOPINC); // Increment LOOPCOUNT_REG by Z-component
+    SUBS(LOOPCOUNT, LOOPCOUNT, 1);              // Increment loop count by 1
+    B(NE, l_loop_start);                        // Loop if not equal
+
+    l(loop_break_labels.back());
+    loop_break_labels.pop_back();
+
+    if (--loop_depth) {
+        const auto loop_save_regs = BuildRegSet({LOOPCOUNT_REG, LOOPINC, LOOPCOUNT});
+        ABI_PopRegisters(*this, loop_save_regs);
+    }
+}
+
+void JitShader::Compile_JMP(Instruction instr) {
+    if (instr.opcode.Value() == OpCode::Id::JMPC)
+        Compile_EvaluateCondition(instr);
+    else if (instr.opcode.Value() == OpCode::Id::JMPU)
+        Compile_UniformCondition(instr);
+    else
+        UNREACHABLE();
+
+    bool inverted_condition =
+        (instr.opcode.Value() == OpCode::Id::JMPU) && (instr.flow_control.num_instructions & 1);
+
+    Label& b = instruction_labels[instr.flow_control.dest_offset];
+    if (inverted_condition) {
+        B(EQ, b);
+    } else {
+        B(NE, b);
+    }
+}
+
+static void Emit(GSEmitter* emitter, Common::Vec4<f24> (*output)[16]) {
+    emitter->Emit(*output);
+}
+
+void JitShader::Compile_EMIT(Instruction instr) {
+    Label have_emitter, end;
+    LDR(XSCRATCH0, STATE, offsetof(UnitState, emitter_ptr));
+    CBNZ(XSCRATCH0, have_emitter);
+
+    ABI_PushRegisters(*this, PersistentCallerSavedRegs());
+    MOVP2R(ABI_PARAM1, "Execute EMIT on VS");
+    CallFarFunction(*this, LogCritical);
+    ABI_PopRegisters(*this, PersistentCallerSavedRegs());
+    B(end);
+
+    l(have_emitter);
+    ABI_PushRegisters(*this, PersistentCallerSavedRegs());
+    MOV(ABI_PARAM1, XSCRATCH0);
+    ADD(ABI_PARAM2, STATE, offsetof(UnitState, registers.output));
+    CallFarFunction(*this, Emit);
+    ABI_PopRegisters(*this, PersistentCallerSavedRegs());
+    l(end);
+}
+
+void JitShader::Compile_SETE(Instruction instr) {
+    Label have_emitter, end;
+    LDR(XSCRATCH0, STATE, offsetof(UnitState, emitter_ptr));
+    CBNZ(XSCRATCH0, have_emitter);
+
+    ABI_PushRegisters(*this, PersistentCallerSavedRegs());
+    MOVP2R(ABI_PARAM1, "Execute SETEMIT on VS");
+    CallFarFunction(*this, LogCritical);
+    ABI_PopRegisters(*this, PersistentCallerSavedRegs());
+    B(end);
+
+    l(have_emitter);
+    MOV(WSCRATCH1, instr.setemit.vertex_id);
+    STRB(WSCRATCH1, XSCRATCH0, offsetof(GSEmitter, vertex_id));
+    MOV(WSCRATCH1, instr.setemit.prim_emit);
+    STRB(WSCRATCH1, XSCRATCH0, offsetof(GSEmitter, prim_emit));
+    MOV(WSCRATCH1, instr.setemit.winding);
+    STRB(WSCRATCH1, XSCRATCH0, offsetof(GSEmitter, winding));
+    l(end);
+}
+
+void JitShader::Compile_Block(unsigned end) {
+    while (program_counter < end) {
+        Compile_NextInstr();
+    }
+}
+
+void JitShader::Compile_Return() {
+    // Peek return offset and address on the stack and check if we're at that offset
+    LDP(XSCRATCH0, XSCRATCH1, SP);
+    CMP(WSCRATCH0, program_counter);
+
+    // If so, jump back to before CALL
+    Label b;
+    B(NE, b);
+    BR(XSCRATCH1);
+    l(b);
+}
+
+void JitShader::Compile_NextInstr() {
+    if (std::binary_search(return_offsets.begin(), return_offsets.end(), program_counter)) {
+        Compile_Return();
+    }
+
+    l(instruction_labels[program_counter]);
+    instruction_addresses[program_counter] = CodeGenerator::ptr<const std::byte*>();
+
+    Instruction instr = {(*program_code)[program_counter++]};
+
+    OpCode::Id opcode = instr.opcode.Value();
+    auto instr_func = instr_table[static_cast<unsigned>(opcode)];
+
+    if (instr_func) {
+        // JIT the instruction!
+        ((*this).*instr_func)(instr);
+    } else {
+        // Unhandled instruction
+        LOG_CRITICAL(HW_GPU, "Unhandled instruction: 0x{:02x} (0x{:08x})",
+                     static_cast<u32>(instr.opcode.Value().EffectiveOpCode()), instr.hex);
+    }
+}
+
+void JitShader::FindReturnOffsets() {
+    return_offsets.clear();
+
+    for (std::size_t offset = 0; offset < program_code->size(); ++offset) {
+        Instruction instr = {(*program_code)[offset]};
+
+        switch (instr.opcode.Value()) {
+        case OpCode::Id::CALL:
+        case OpCode::Id::CALLC:
+        case OpCode::Id::CALLU:
+            return_offsets.push_back(instr.flow_control.dest_offset +
+                                     instr.flow_control.num_instructions);
+            break;
+        default:
+            break;
+        }
+    }
+
+    // Sort for efficient binary search later
+    std::sort(return_offsets.begin(), return_offsets.end());
+}
+
+void JitShader::Compile(const std::array<u32, MAX_PROGRAM_CODE_LENGTH>* program_code_,
+                        const std::array<u32, MAX_SWIZZLE_DATA_LENGTH>* swizzle_data_) {
+    program_code = program_code_;
+    swizzle_data = swizzle_data_;
+
+    // Reset flow control state
+    program = CodeGenerator::ptr<CompiledShader*>();
+    program_counter = 0;
+    loop_depth = 0;
+
+    // Find all `CALL` instructions and identify return locations
+    FindReturnOffsets();
+
+    ABI_PushRegisters(*this, ABI_ALL_CALLEE_SAVED);
+    MOV(PROGRAM_STACK, SP);
+
+    MOV(UNIFORMS, ABI_PARAM1);
+    MOV(STATE, ABI_PARAM2);
+
+    // Load address/loop registers
+    LDRSW(ADDROFFS_REG_0, STATE, offsetof(UnitState, address_registers[0]));
+    LDRSW(ADDROFFS_REG_1, STATE, offsetof(UnitState, address_registers[1]));
+    LDR(LOOPCOUNT_REG, STATE, offsetof(UnitState, address_registers[2]));
+    LSL(ADDROFFS_REG_0, ADDROFFS_REG_0, 4);
+    LSL(ADDROFFS_REG_1, ADDROFFS_REG_1, 4);
+    LSL(LOOPCOUNT_REG, LOOPCOUNT_REG, 4);
+
+    // Load conditional code
+    LDRB(COND0.toW(), STATE, offsetof(UnitState, conditional_code[0]));
+    LDRB(COND1.toW(), STATE, offsetof(UnitState, conditional_code[1]));
+
+    // Used to set a register to one
+    MOV(WSCRATCH0, 0x3F800000);
+    DUP(ONE.S4(), WSCRATCH0);
+
+    // Push a dummy return offset to catch any potential return checks (see Compile_Return) that
+    // happen in shader main routine.
+    MOV(WSCRATCH0, 0xFFFFFFFF);
+    STP(XSCRATCH0, XZR, SP, PRE_INDEXED, -16);
+
+    // Jump to start of the shader program
+    BR(ABI_PARAM3);
+
+    // Compile entire program
+    Compile_Block(static_cast<unsigned>(program_code->size()));
+
+    // Free memory that's no longer needed
+    program_code = nullptr;
+    swizzle_data = nullptr;
+    return_offsets.clear();
+    return_offsets.shrink_to_fit();
+
+    protect();
+    invalidate_all();
+
+    const std::size_t code_size =
+        static_cast<std::size_t>(CodeGenerator::ptr<const std::byte*>() - code_begin);
+    ASSERT_MSG(code_size <= MAX_SHADER_SIZE, "Compiled a shader that exceeds the allocated size!");
+    LOG_DEBUG(HW_GPU, "Compiled shader size={}", code_size);
+}
+
+JitShader::JitShader()
+    : oaknut::CodeBlock(MAX_SHADER_SIZE), oaknut::CodeGenerator(oaknut::CodeBlock::ptr()) {
+    unprotect();
+    code_begin = CodeGenerator::ptr<const std::byte*>();
+    CompilePrelude();
+}
+
+void JitShader::CompilePrelude() {
+    log2_subroutine = CompilePrelude_Log2();
+    exp2_subroutine = CompilePrelude_Exp2();
+    swizzle_table = CompilePrelude_SwizzleTable();
+}
+
+Label JitShader::CompilePrelude_Log2() {
+    Label subroutine;
+
+    // NEON does not have a log instruction, thus we must approximate.
+    // We perform this approximation first performaing a range reduction into the range [1.0, 2.0).
+    // A minimax polynomial which was fit for the function log2(x) / (x - 1) is then evaluated.
+    // We multiply the result by (x - 1) then restore the result into the appropriate range.
+
+    // Coefficients for the minimax polynomial.
+    // f(x) computes approximately log2(x) / (x - 1).
+    // f(x) = c4 + x * (c3 + x * (c2 + x * (c1 + x * c0)).
+    Label constants;
+    l(constants);
+    dw(0x3d74552f); // c0
+    dw(0xbeee7397); // c1
+    dw(0x3fbd96dd); // c2
+    dw(0xc02153f6); // c3
+    dw(0x4038d96c); // c4
+    dw(0xff800000); // -inf
+    dw(0x7fc00000); // default qnan
+
+    Label input_is_nan, input_is_zero, input_out_of_range;
+
+    l(input_out_of_range);
+    B(EQ, input_is_zero);
+    LDR(SRC1.toS(), XSCRATCH0, 24);
+    DUP(SRC1.S4(), SRC1.Selem()[0]);
+    RET();
+    l(input_is_zero);
+    LDR(SRC1.toS(), XSCRATCH0, 20);
+    DUP(SRC1.S4(), SRC1.Selem()[0]);
+    RET();
+
+    l(subroutine);
+    ADR(XSCRATCH0, constants);
+
+    // Here we handle edge cases: input in {NaN, 0, -Inf, Negative}.
+    FMOV(SCRATCH.toS(), WZR);
+    FCMP(SRC1.toS(), SCRATCH.toS());
+    B(VS, input_is_nan);
+    B(LS, input_out_of_range);
+
+    // Split input: SRC1=MANT[1,2) SCRATCH2=Exponent
+    FMOV(WSCRATCH1, SRC1.toS());
+    UBFX(WSCRATCH2, WSCRATCH1, 23, 8);
+    SUB(WSCRATCH2, WSCRATCH2, 0x7f);
+    SCVTF(SCRATCH2.toS(), WSCRATCH2);
+    // SCRATCH2 now contains the exponent of the input.
+    AND(WSCRATCH1, WSCRATCH1, 0x007fffff);
+    ORR(WSCRATCH1, WSCRATCH1, 0x3f800000);
+    FMOV(SRC1.toS(), WSCRATCH1);
+    // SRC1 now contains the mantissa of the input.
+
+    // Complete computation of polynomial
+    LDP(SCRATCH.toS(), SRC2.toS(), XSCRATCH0, 0);
+    FMADD(SCRATCH.toS(), SCRATCH.toS(), SRC1.toS(), SRC2.toS());
+    LDP(SRC2.toS(), SRC3.toS(), XSCRATCH0, 8);
+    FMADD(SCRATCH.toS(), SCRATCH.toS(), SRC1.toS(), SRC2.toS());
+    FMADD(SCRATCH.toS(), SCRATCH.toS(), SRC1.toS(), SRC3.toS());
+    LDR(SRC2.toS(), XSCRATCH0, 16);
+    FMADD(SCRATCH.toS(), SCRATCH.toS(), SRC1.toS(), SRC2.toS());
+    FSUB(SRC1.toS(), SRC1.toS(), ONE.toS());
+    FMADD(SCRATCH2.toS(), SCRATCH.toS(), SRC1.toS(), SCRATCH2.toS());
+
+    // Duplicate result across vector
+    DUP(SRC1.S4(), SCRATCH2.Selem()[0]);
+    RET();
+
+    l(input_is_nan);
+    DUP(SRC1.S4(), SRC1.Selem()[0]);
+    RET();
+
+    return subroutine;
+}
+
+Label JitShader::CompilePrelude_Exp2() {
+    Label subroutine;
+
+    // NEON does not have a exp instruction, thus we must approximate.
+    // We perform this approximation first performaing a range reduction into the range [-0.5, 0.5).
+    // A minimax polynomial which was fit for the function exp2(x) is then evaluated.
+    // We then restore the result into the appropriate range.
+
+    Label constants;
+    l(constants);
+    dw(0x43010000); // input_max
+    dw(0xc2fdffff); // input_min
+    dw(0x3c5dbe69); // c0
+    dw(0x3f000000); // half
+    dw(0x3d5509f9); // c1
+    dw(0x3e773cc5); // c2
+    dw(0x3f3168b3); // c3
+    dw(0x3f800016); // c4
+
+    Label ret_label;
+
+    l(subroutine);
+    ADR(XSCRATCH0, constants);
+
+    // Handle edge cases
+    FCMP(SRC1.toS(), SRC1.toS());
+    B(VS, ret_label);
+
+    // Clamp to maximum range since we shift the value directly into the exponent.
+    LDP(SCRATCH.toS(), SCRATCH2.toS(), XSCRATCH0, 0);
+    FMIN(SRC1.toS(), SRC1.toS(), SCRATCH.toS());
+    FMAX(SRC1.toS(), SRC1.toS(), SCRATCH2.toS());
+
+    // Decompose input:
+    // SCRATCH=2^round(input)
+    // SRC1=input-round(input) [-0.5, 0.5)
+    LDR(SCRATCH2.toS(), XSCRATCH0, 12);
+    FSUB(SCRATCH.toS(), SRC1.toS(), SCRATCH2.toS());
+    FCVTZS(WSCRATCH1, SCRATCH.toS());
+    SCVTF(SCRATCH.toS(), WSCRATCH1);
+    // SCRATCH now contains input rounded to the nearest integer.
+    ADD(WSCRATCH1, WSCRATCH1, 0x7f);
+    FSUB(SRC1.toS(), SRC1.toS(), SCRATCH.toS());
+    // SRC1 contains input - round(input), which is in [-0.5, 0.5).
+    LSL(WSCRATCH1, WSCRATCH1, 23);
+    FMOV(SCRATCH.toS(), WSCRATCH1);
+    // SCRATCH contains 2^(round(input)).
+
+    // Complete computation of polynomial.
+    LDR(SCRATCH2.toS(), XSCRATCH0, 8);
+    LDP(SRC2.toS(), SRC3.toS(), XSCRATCH0, 16);
+    FMADD(SCRATCH2.toS(), SCRATCH2.toS(), SRC1.toS(), SRC2.toS());
+    FMADD(SCRATCH2.toS(), SCRATCH2.toS(), SRC1.toS(), SRC3.toS());
+    LDP(SRC2.toS(), SRC3.toS(), XSCRATCH0, 24);
+    FMADD(SCRATCH2.toS(), SCRATCH2.toS(), SRC1.toS(), SRC2.toS());
+    FMADD(SRC1.toS(), SRC1.toS(), SCRATCH2.toS(), SRC3.toS());
+
+    FMUL(SRC1.toS(), SRC1.toS(), SCRATCH.toS());
+
+    // Duplicate result across vector
+    l(ret_label);
+    DUP(SRC1.S4(), SRC1.Selem()[0]);
+
+    RET();
+
+    return subroutine;
+}
+
+Label JitShader::CompilePrelude_SwizzleTable() {
+    Label table;
+
+    // TBL byte indices implementing each source register selector. The selector stores the source
+    // component of X in its upper two bits, down to the one of W in its lower two bits.
+    l(table);
+    for (u32 sel = 0; sel < 256; ++sel) {
+        for (u32 i = 0; i < 4; ++i) {
+            const u32 component = (sel >> (6 - 2 * i)) & 3;
+            dw(0x03020100 + component * 0x04040404);
+        }
+    }
+
+    return table;
+}
+
+} // namespace Pica::Shader
+
+#endif // CITRA_ARCH(arm64)
@@ -6,6 +6,7 @@
 #if CITRA_ARCH(x86_64)
 
 #include "common/assert.h"
+#include "common/bit_set.h"
 #include "common/microprofile.h"
 #include "video_core/shader/shader.h"
 #include "video_core/shader/shader_jit_x64.h"
@@ -46,6 +47,37 @@ void JitX64Engine::Run(const ShaderSetup& setup, UnitState& state) const {
     shader->Run(setup, state, setup.engine_data.entry_point);
 }
 
+void JitX64Engine::RunBatch(const ShaderSetup& setup, UnitState& state, const ShaderRegs& config,
+                            std::span<const AttributeBuffer> inputs,
+                            std::span<AttributeBuffer> outputs) const {
+    ASSERT(setup.engine_data.cached_shader != nullptr);
+    ASSERT(inputs.size() == outputs.size());
+    if (inputs.empty()) {
+        return;
+    }
+
+    MICROPROFILE_SCOPE(GPU_Shader);
+
+    const JitShader* shader = static_cast<const JitShader*>(setup.engine_data.cached_shader);
+
+    JitBatch batch;
+    batch.input = inputs.data();
+    batch.output = outputs.data();
+    batch.count = static_cast<u32>(inputs.size());
+    batch.num_inputs = config.max_input_attribute_index + 1;
+    for (u32 attr = 0; attr < batch.num_inputs; ++attr) {
+        batch.input_offsets[attr] =
+            static_cast<u32>(UnitState::InputOffset(config.GetRegisterForAttribute(attr)));
+    }
+    batch.num_outputs = 0;
+    for (int reg : Common::BitSet<u32>(config.output_mask)) {
+        batch.output_offsets[batch.num_outputs++] = static_cast<u32>(UnitState::OutputOffset(reg));
+    }
+    batch.entry = shader->GetEntry(setup.engine_data.entry_point);
+
+    shader->RunBatch(setup, state, batch);
+}
+
 } // namespace Pica::Shader
 
 #endif // CITRA_ARCH(x86_64)
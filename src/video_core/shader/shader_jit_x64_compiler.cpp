@@ -127,6 +127,10 @@ constexpr Reg64 COND0 = r13;
 constexpr Reg64 COND1 = r14;
 /// Pointer to the UnitState instance for the current VS unit
 constexpr Reg64 STATE = r15;
+/// Pointer to the JitBatch being processed by the batch entry point
+constexpr Reg64 BATCH = rbx;
+/// Stack pointer at the call into the shader program, used by END to return to the entry point
+constexpr Reg64 PROGRAM_STACK = rbp;
 /// SIMD scratch register
 constexpr Xmm SCRATCH = xmm0;
 /// Loaded with the first swizzled source register, otherwise can be used as a scratch register
@@ -382,18 +386,18 @@ void JitShader::Compile_EvaluateCondition(Instruction instr) {
     switch (instr.flow_control.op) {
     case Instruction::FlowControlType::Or:
         mov(eax, COND0);
-        mov(ebx, COND1);
+        mov(edx, COND1);
         xor_(eax, (instr.flow_control.refx.Value() ^ 1));
-        xor_(ebx, (instr.flow_control.refy.Value() ^ 1));
-        or_(eax, ebx);
+        xor_(edx, (instr.flow_control.refy.Value() ^ 1));
+        or_(eax, edx);
         break;
 
     case Instruction::FlowControlType::And:
         mov(eax, COND0);
-        mov(ebx, COND1);
+        mov(edx, COND1);
         xor_(eax, (instr.flow_control.refx.Value() ^ 1));
-        xor_(ebx, (instr.flow_control.refy.Value() ^ 1));
-        and_(eax, ebx);
+        xor_(edx, (instr.flow_control.refy.Value() ^ 1));
+        and_(eax, edx);
         break;
 
     case Instruction::FlowControlType::JustX:
@@ -666,7 +670,8 @@ void JitShader::Compile_END(Instruction instr) {
     mov(dword[STATE + offsetof(UnitState, address_registers[1])], ADDROFFS_REG_1.cvt32());
     mov(dword[STATE + offsetof(UnitState, address_registers[2])], LOOPCOUNT_REG);
 
-    ABI_PopRegistersAndAdjustStack(*this, ABI_ALL_CALLEE_SAVED, 8, 16);
+    // Return to the entry point, discarding the frames of any subroutine we are in
+    lea(rsp, ptr[PROGRAM_STACK - 8]);
     ret();
 }
 
@@ -966,29 +971,22 @@ void JitShader::FindReturnOffsets() {
     std::sort(return_offsets.begin(), return_offsets.end());
 }
 
-void JitShader::Compile(const std::array<u32, MAX_PROGRAM_CODE_LENGTH>* program_code_,
-                        const std::array<u32, MAX_SWIZZLE_DATA_LENGTH>* swizzle_data_) {
-    program_code = program_code_;
-    swizzle_data = swizzle_data_;
-
-    // Reset flow control state
-    program = (CompiledShader*)getCurr();
-    program_counter = 0;
-    loop_depth = 0;
-    instruction_labels.fill(Xbyak::Label());
-
-    // Find all `CALL` instructions and identify return locations
-    FindReturnOffsets();
+void JitShader::Compile_EntrySetup() {
+    mov(STATE, ABI_PARAM2);
+    mov(UNIFORMS, ABI_PARAM1);
 
-    // The stack pointer is 8 modulo 16 at the entry of a procedure
-    // We reserve 16 bytes and assign a dummy value to the first 8 bytes, to catch any potential
-    // return checks (see Compile_Return) that happen in shader main routine.
-    ABI_PushRegistersAndAdjustStack(*this, ABI_ALL_CALLEE_SAVED, 8, 16);
-    mov(qword[rsp + 8], 0xFFFFFFFFFFFFFFFFULL);
+    // Used to set a register to one
+    static const __m128 one = {1.f, 1.f, 1.f, 1.f};
+    mov(rax, reinterpret_cast<std::size_t>(&one));
+    movaps(ONE, xword[rax]);
 
-    mov(UNIFORMS, ABI_PARAM1);
-    mov(STATE, ABI_PARAM2);
+    // Used to negate registers
+    static const __m128 neg = {-0.f, -0.f, -0.f, -0.f};
+    mov(rax, reinterpret_cast<std::size_t>(&neg));
+    movaps(NEGBIT, xword[rax]);
+}
 
+void JitShader::Compile_CallProgram(const Xbyak::Operand& target) {
     // Load address/loop registers
     movsxd(ADDROFFS_REG_0, dword[STATE + offsetof(UnitState, address_registers[0])]);
     movsxd(ADDROFFS_REG_1, dword[STATE + offsetof(UnitState, address_registers[1])]);
@@ -1001,18 +999,82 @@ void JitShader::Compile(const std::array<u32, MAX_PROGRAM_CODE_LENGTH>* program_
     mov(COND0, byte[STATE + offsetof(UnitState, conditional_code[0])]);
     mov(COND1, byte[STATE + offsetof(UnitState, conditional_code[1])]);
 
-    // Used to set a register to one
-    static const __m128 one = {1.f, 1.f, 1.f, 1.f};
-    mov(rax, reinterpret_cast<std::size_t>(&one));
-    movaps(ONE, xword[rax]);
+    // The stack pointer is 0 modulo 16 here. We push a dummy return offset to catch any potential
+    // return checks (see Compile_Return) that happen in shader main routine, which also keeps the
+    // stack aligned after the call below.
+    push(qword, 0xFFFFFFFF);
+    mov(PROGRAM_STACK, rsp);
+    call(target);
+    add(rsp, 8);
+}
 
-    // Used to negate registers
-    static const __m128 neg = {-0.f, -0.f, -0.f, -0.f};
-    mov(rax, reinterpret_cast<std::size_t>(&neg));
-    movaps(NEGBIT, xword[rax]);
+void JitShader::Compile(const std::array<u32, MAX_PROGRAM_CODE_LENGTH>* program_code_,
+                        const std::array<u32, MAX_SWIZZLE_DATA_LENGTH>* swizzle_data_) {
+    program_code = program_code_;
+    swizzle_data = swizzle_data_;
 
-    // Jump to start of the shader program
-    jmp(ABI_PARAM3);
+    // Reset flow control state
+    program_counter = 0;
+    loop_depth = 0;
+    instruction_labels.fill(Xbyak::Label());
+
+    // Find all `CALL` instructions and identify return locations
+    FindReturnOffsets();
+
+    // Entry point running a single invocation of the shader
+    program = (CompiledShader*)getCurr();
+    ABI_PushRegistersAndAdjustStack(*this, ABI_ALL_CALLEE_SAVED, 8);
+    Compile_EntrySetup();
+    Compile_CallProgram(ABI_PARAM3);
+    ABI_PopRegistersAndAdjustStack(*this, ABI_ALL_CALLEE_SAVED, 8);
+    ret();
+
+    // Entry point running the shader for every vertex of a JitBatch. The uniform pointer and the
+    // constants are only set up once, only the inputs and outputs are exchanged per vertex.
+    batch_program = (CompiledBatch*)getCurr();
+    ABI_PushRegistersAndAdjustStack(*this, ABI_ALL_CALLEE_SAVED, 8);
+    mov(BATCH, ABI_PARAM3);
+    Compile_EntrySetup();
+
+    Label vertex_loop, input_loop, output_loop, outputs_done;
+    L(vertex_loop);
+
+    // Load the input attributes into their registers
+    mov(rax, qword[BATCH + offsetof(JitBatch, input)]);
+    xor_(ecx, ecx);
+    L(input_loop);
+    mov(edx, dword[BATCH + rcx * 4 + offsetof(JitBatch, input_offsets)]);
+    movaps(SCRATCH, xword[rax]);
+    movaps(xword[STATE + rdx], SCRATCH);
+    add(rax, static_cast<u32>(sizeof(Common::Vec4<f24>)));
+    inc(ecx);
+    cmp(ecx, dword[BATCH + offsetof(JitBatch, num_inputs)]);
+    jb(input_loop);
+
+    Compile_CallProgram(qword[BATCH + offsetof(JitBatch, entry)]);
+
+    // Store the enabled output registers
+    mov(rax, qword[BATCH + offsetof(JitBatch, output)]);
+    xor_(ecx, ecx);
+    cmp(dword[BATCH + offsetof(JitBatch, num_outputs)], 0);
+    je(outputs_done);
+    L(output_loop);
+    mov(edx, dword[BATCH + rcx * 4 + offsetof(JitBatch, output_offsets)]);
+    movaps(SCRATCH, xword[STATE + rdx]);
+    movaps(xword[rax], SCRATCH);
+    add(rax, static_cast<u32>(sizeof(Common::Vec4<f24>)));
+    inc(ecx);
+    cmp(ecx, dword[BATCH + offsetof(JitBatch, num_outputs)]);
+    jb(output_loop);
+    L(outputs_done);
+
+    add(qword[BATCH + offsetof(JitBatch, input)], static_cast<u32>(sizeof(AttributeBuffer)));
+    add(qword[BATCH + offsetof(JitBatch, output)], static_cast<u32>(sizeof(AttributeBuffer)));
+    dec(dword[BATCH + offsetof(JitBatch, count)]);
+    jnz(vertex_loop, T_NEAR);
+
+    ABI_PopRegistersAndAdjustStack(*this, ABI_ALL_CALLEE_SAVED, 8);
+    ret();
 
     // Compile entire program
     Compile_Block(static_cast<unsigned>(program_code->size()));
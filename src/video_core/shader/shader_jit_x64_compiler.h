@@ -28,6 +28,25 @@ namespace Pica::Shader {
 /// Memory allocated for each compiled shader
 constexpr std::size_t MAX_SHADER_SIZE = MAX_PROGRAM_CODE_LENGTH * 64;
 
+/**
+ * Parameters of a batch of vertices shaded by a single call into the compiled shader. The input
+ * and output pointers and the vertex count are consumed by the emitted loop.
+ */
+struct JitBatch {
+    const AttributeBuffer* input;
+    AttributeBuffer* output;
+    u32 count;
+    /// Number of input attributes to load and output registers to store per vertex
+    u32 num_inputs;
+    u32 num_outputs;
+    /// Offset in UnitState of the register each input attribute is loaded into
+    std::array<u32, 16> input_offsets;
+    /// Offset in UnitState of each output register, in the order they are written to the output
+    std::array<u32, 16> output_offsets;
+    /// Address in the compiled code to start executing each vertex at
+    const u8* entry;
+};
+
 /**
  * This class implements the shader JIT compiler. It recompiles a Pica shader program into x86_64
  * code that can be executed on the host machine directly.
@@ -40,6 +59,16 @@ public:
         program(&setup.uniforms, &state, instruction_labels[offset].getAddress());
     }
 
+    /// Runs the shader for every vertex of the batch, keeping the uniforms and constants pinned in
+    /// host registers for the whole batch.
+    void RunBatch(const ShaderSetup& setup, UnitState& state, JitBatch& batch) const {
+        batch_program(&setup.uniforms, &state, &batch);
+    }
+
+    const u8* GetEntry(unsigned offset) const {
+        return instruction_labels[offset].getAddress();
+    }
+
     void Compile(const std::array<u32, MAX_PROGRAM_CODE_LENGTH>* program_code,
                  const std::array<u32, MAX_SWIZZLE_DATA_LENGTH>* swizzle_data);
 
@@ -87,6 +116,18 @@ private:
      */
     void Compile_SanitizedMul(Xbyak::Xmm src1, Xbyak::Xmm src2, Xbyak::Xmm scratch);
 
+    /**
+     * Emits the code shared by the entry points that loads the uniform pointer, the state pointer
+     * and the constant registers.
+     */
+    void Compile_EntrySetup();
+
+    /**
+     * Emits the code to load the address registers and the conditional code from the unit state
+     * and call into the shader program at the address stored in `target`.
+     */
+    void Compile_CallProgram(const Xbyak::Operand& target);
+
     void Compile_EvaluateCondition(Instruction instr);
     void Compile_UniformCondition(Instruction instr);
 
@@ -136,6 +177,9 @@ private:
     using CompiledShader = void(const void* setup, void* state, const u8* start_addr);
     CompiledShader* program = nullptr;
 
+    using CompiledBatch = void(const void* setup, void* state, JitBatch* batch);
+    CompiledBatch* batch_program = nullptr;
+
     Xbyak::Label log2_subroutine;
     Xbyak::Label exp2_subroutine;
 };
@@ -0,0 +1,26 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "common/arch.h"
+#include "common/common_types.h"
+
+/// Compiles a function with SSSE3 enabled. Callers must check the host supports it at runtime.
+#if CITRA_ARCH(x86_64) && (defined(__GNUC__) || defined(__clang__))
+#define TARGET_SSSE3 __attribute__((target("ssse3")))
+#else
+#define TARGET_SSSE3
+#endif
+
+namespace VideoCore {
+
+/// Byte indices expanding four BGR8 pixels to RGBA8, with the alpha left zero
+alignas(16) constexpr u8 RGB8_TO_RGBA8[16] = {2, 1, 0, 0x80, 5, 4, 3, 0x80,
+                                              8, 7, 6, 0x80, 11, 10, 9, 0x80};
+/// Byte indices packing four RGBA8 pixels to BGR8
+alignas(16) constexpr u8 RGBA8_TO_RGB8[16] = {2,  1,  0,  6,    5,    4,    10,   9,
+                                              8,  14, 13, 12,   0x80, 0x80, 0x80, 0x80};
+
+} // namespace VideoCore
@@ -1,5 +1,8 @@
+#include <cstring>
 #include <memory>
+#include <type_traits>
 #include "common/alignment.h"
+#include "common/arch.h"
 #include "common/assert.h"
 #include "common/bit_field.h"
 #include "common/common_types.h"
@@ -14,8 +17,115 @@
 #include "video_core/vertex_loader.h"
 #include "video_core/video_core.h"
 
+#if CITRA_ARCH(x86_64)
+#include <emmintrin.h>
+#elif CITRA_ARCH(arm64)
+#include <arm_neon.h>
+#endif
+
 namespace Pica {
 
+static_assert(sizeof(Common::Vec4<f24>) == 4 * sizeof(float),
+              "Attributes are written to the input buffer as four packed floats");
+
+/// Values of the components that are missing from attributes with less than four elements
+alignas(16) constexpr std::array<float, 4> default_components = {0.0f, 0.0f, 0.0f, 1.0f};
+
+/**
+ * Converts an attribute with `N` elements of type `T` to floats. Components the attribute doesn't
+ * have are set to (0, 0, 0, 1). Integer formats are converted with SIMD where available.
+ */
+template <typename T, u32 N>
+static void LoadAttribute(const u8* source, Common::Vec4<f24>& dest) {
+    if constexpr (std::is_same_v<T, float>) {
+        std::array<float, 4> components = default_components;
+        std::memcpy(components.data(), source, N * sizeof(T));
+        std::memcpy(&dest, components.data(), sizeof(dest));
+    } else {
+        // Copy to a zero padded buffer so that the vector loads can't read past the attribute
+        alignas(16) T data[8]{};
+        std::memcpy(data, source, N * sizeof(T));
+#if CITRA_ARCH(x86_64)
+        __m128i values;
+        if constexpr (sizeof(T) == 1) {
+            s32 raw;
+            std::memcpy(&raw, data, sizeof(raw));
+            values = _mm_cvtsi32_si128(raw);
+            values = _mm_unpacklo_epi8(values, values);
+            values = _mm_unpacklo_epi16(values, values);
+            values = std::is_signed_v<T> ? _mm_srai_epi32(values, 24) : _mm_srli_epi32(values, 24);
+        } else {
+            values = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(data));
+            values = _mm_srai_epi32(_mm_unpacklo_epi16(values, values), 16);
+        }
+        __m128 result = _mm_cvtepi32_ps(values);
+        if constexpr (N < 4) {
+            const __m128 mask = _mm_castsi128_ps(
+                _mm_setr_epi32(N > 0 ? -1 : 0, N > 1 ? -1 : 0, N > 2 ? -1 : 0, 0));
+            result = _mm_or_ps(_mm_and_ps(mask, result),
+                               _mm_andnot_ps(mask, _mm_load_ps(default_components.data())));
+        }
+        _mm_storeu_ps(reinterpret_cast<float*>(&dest), result);
+#elif CITRA_ARCH(arm64)
+        float32x4_t result;
+        if constexpr (std::is_same_v<T, s8>) {
+            result = vcvtq_f32_s32(vmovl_s16(vget_low_s16(vmovl_s8(vld1_s8(data)))));
+        } else if constexpr (std::is_same_v<T, u8>) {
+            result = vcvtq_f32_u32(vmovl_u16(vget_low_u16(vmovl_u8(vld1_u8(data)))));
+        } else {
+            result = vcvtq_f32_s32(vmovl_s16(vld1_s16(data)));
+        }
+        if constexpr (N < 4) {
+            alignas(16) constexpr u32 mask[4] = {N > 0 ? ~0U : 0, N > 1 ? ~0U : 0,
+                                                 N > 2 ? ~0U : 0, 0};
+            result = vbslq_f32(vld1q_u32(mask), result, vld1q_f32(default_components.data()));
+        }
+        vst1q_f32(reinterpret_cast<float*>(&dest), result);
+#else
+        for (u32 comp = 0; comp < 4; ++comp) {
+            dest[comp] = f24::FromFloat32(comp < N ? static_cast<float>(data[comp])
+                                                   : default_components[comp]);
+        }
+#endif
+    }
+}
+
+template <typename T, u32 N>
+static void LoadAttributeStream(const u8* source, u32 stride, std::size_t attribute,
+                                std::span<Shader::AttributeBuffer> inputs) {
+    for (auto& input : inputs) {
+        LoadAttribute<T, N>(source, input.attr[attribute]);
+        source += stride;
+    }
+}
+
+using AttributeStreamLoader = void (*)(const u8*, u32, std::size_t,
+                                      std::span<Shader::AttributeBuffer>);
+
+template <typename T>
+static constexpr std::array<AttributeStreamLoader, 4> attribute_stream_loaders = {
+    &LoadAttributeStream<T, 1>,
+    &LoadAttributeStream<T, 2>,
+    &LoadAttributeStream<T, 3>,
+    &LoadAttributeStream<T, 4>,
+};
+
+/// Picks the loader specialized for the given attribute format and number of elements (1 to 4)
+static AttributeStreamLoader GetAttributeLoader(PipelineRegs::VertexAttributeFormat format,
+                                                u32 num_elements) {
+    switch (format) {
+    case PipelineRegs::VertexAttributeFormat::BYTE:
+        return attribute_stream_loaders<s8>[num_elements - 1];
+    case PipelineRegs::VertexAttributeFormat::UBYTE:
+        return attribute_stream_loaders<u8>[num_elements - 1];
+    case PipelineRegs::VertexAttributeFormat::SHORT:
+        return attribute_stream_loaders<s16>[num_elements - 1];
+    case PipelineRegs::VertexAttributeFormat::FLOAT:
+        return attribute_stream_loaders<float>[num_elements - 1];
+    }
+    UNREACHABLE();
+}
+
 void VertexLoader::Setup(const PipelineRegs& regs) {
     ASSERT_MSG(!is_setup, "VertexLoader is not intended to be setup more than once.");
 
@@ -54,6 +164,9 @@ void VertexLoader::Setup(const PipelineRegs& regs) {
                     attribute_config.GetFormat(attribute_index);
                 vertex_attribute_elements[attribute_index] =
                     attribute_config.GetNumElements(attribute_index);
+                vertex_attribute_loaders[attribute_index] =
+                    GetAttributeLoader(vertex_attribute_formats[attribute_index],
+                                       vertex_attribute_elements[attribute_index]);
                 offset += attribute_config.GetStride(attribute_index);
             } else if (attribute_index < 16) {
                 // Attribute ids 12, 13, 14 and 15 signify 4, 8, 12 and 16-byte paddings,
@@ -72,7 +185,7 @@ void VertexLoader::Setup(const PipelineRegs& regs) {
 
 void VertexLoader::LoadVertex(u32 base_address, int index, int vertex,
                               Shader::AttributeBuffer& input,
-                              DebugUtils::MemoryAccessTracker& memory_accesses) {
+                              DebugUtils::MemoryAccessTracker& memory_accesses) const {
     ASSERT_MSG(is_setup, "A VertexLoader needs to be setup before loading vertices.");
 
     for (int i = 0; i < num_total_attributes; ++i) {
@@ -93,47 +206,11 @@ void VertexLoader::LoadVertex(u32 base_address, int index, int vertex,
                              : 1));
             }
 
-            switch (vertex_attribute_formats[i]) {
-            case PipelineRegs::VertexAttributeFormat::BYTE: {
-                const s8* srcdata = reinterpret_cast<const s8*>(
-                    VideoCore::g_memory->GetPhysicalPointer(source_addr));
-                for (unsigned int comp = 0; comp < vertex_attribute_elements[i]; ++comp) {
-                    input.attr[i][comp] = f24::FromFloat32(srcdata[comp]);
-                }
-                break;
-            }
-            case PipelineRegs::VertexAttributeFormat::UBYTE: {
-                const u8* srcdata = reinterpret_cast<const u8*>(
-                    VideoCore::g_memory->GetPhysicalPointer(source_addr));
-                for (unsigned int comp = 0; comp < vertex_attribute_elements[i]; ++comp) {
-                    input.attr[i][comp] = f24::FromFloat32(srcdata[comp]);
-                }
-                break;
-            }
-            case PipelineRegs::VertexAttributeFormat::SHORT: {
-                const s16* srcdata = reinterpret_cast<const s16*>(
-                    VideoCore::g_memory->GetPhysicalPointer(source_addr));
-                for (unsigned int comp = 0; comp < vertex_attribute_elements[i]; ++comp) {
-                    input.attr[i][comp] = f24::FromFloat32(srcdata[comp]);
-                }
-                break;
-            }
-            case PipelineRegs::VertexAttributeFormat::FLOAT: {
-                const float* srcdata = reinterpret_cast<const float*>(
-                    VideoCore::g_memory->GetPhysicalPointer(source_addr));
-                for (unsigned int comp = 0; comp < vertex_attribute_elements[i]; ++comp) {
-                    input.attr[i][comp] = f24::FromFloat32(srcdata[comp]);
-                }
-                break;
-            }
-            }
-
-            // Default attribute values set if array elements have < 4 components. This
-            // is *not* carried over from the default attribute settings even if they're
-            // enabled for this attribute.
-            for (unsigned int comp = vertex_attribute_elements[i]; comp < 4; ++comp) {
-                input.attr[i][comp] = comp == 3 ? f24::One() : f24::Zero();
-            }
+            // The loader sets the components missing from arrays with < 4 elements to
+            // (0, 0, 0, 1). This is *not* carried over from the default attribute settings
+            // even if they're enabled for this attribute.
+            vertex_attribute_loaders[i](VideoCore::g_memory->GetPhysicalPointer(source_addr), 0, i,
+                                        {&input, 1});
 
             LOG_TRACE(HW_GPU,
                       "Loaded {} components of attribute {:x} for vertex {:x} (index {:x}) from "
@@ -158,4 +235,22 @@ void VertexLoader::LoadVertex(u32 base_address, int index, int vertex,
     }
 }
 
+void VertexLoader::LoadVertices(u32 base_address, u32 first_vertex,
+                                std::span<Shader::AttributeBuffer> inputs) const {
+    ASSERT_MSG(is_setup, "A VertexLoader needs to be setup before loading vertices.");
+
+    for (int i = 0; i < num_total_attributes; ++i) {
+        if (vertex_attribute_elements[i] != 0) {
+            const u32 source_addr = base_address + vertex_attribute_sources[i] +
+                                    vertex_attribute_strides[i] * first_vertex;
+            vertex_attribute_loaders[i](VideoCore::g_memory->GetPhysicalPointer(source_addr),
+                                        vertex_attribute_strides[i], i, inputs);
+        } else if (vertex_attribute_is_default[i]) {
+            for (auto& input : inputs) {
+                input.attr[i] = g_state.input_default_attributes.attr[i];
+            }
+        }
+    }
+}
+
 } // namespace Pica
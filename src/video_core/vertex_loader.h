@@ -1,6 +1,7 @@
 #pragma once
 
 #include <array>
+#include <span>
 #include "common/common_types.h"
 #include "video_core/regs_pipeline.h"
 
@@ -23,18 +24,31 @@ public:
 
     void Setup(const PipelineRegs& regs);
     void LoadVertex(u32 base_address, int index, int vertex, Shader::AttributeBuffer& input,
-                    DebugUtils::MemoryAccessTracker& memory_accesses);
+                    DebugUtils::MemoryAccessTracker& memory_accesses) const;
+
+    /**
+     * Loads the consecutive vertices starting at `first_vertex` into `inputs`, one attribute
+     * stream at a time. Memory accesses are not tracked, so this must not be used while a debug
+     * context is recording.
+     */
+    void LoadVertices(u32 base_address, u32 first_vertex,
+                      std::span<Shader::AttributeBuffer> inputs) const;
 
     int GetNumTotalAttributes() const {
         return num_total_attributes;
     }
 
 private:
+    /// Converts an attribute of each of `inputs`, reading them `stride` bytes apart from `source`
+    using AttributeLoader = void (*)(const u8* source, u32 stride, std::size_t attribute,
+                                     std::span<Shader::AttributeBuffer> inputs);
+
     std::array<u32, 16> vertex_attribute_sources;
     std::array<u32, 16> vertex_attribute_strides{};
     std::array<PipelineRegs::VertexAttributeFormat, 16> vertex_attribute_formats;
     std::array<u32, 16> vertex_attribute_elements{};
     std::array<bool, 16> vertex_attribute_is_default;
+    std::array<AttributeLoader, 16> vertex_attribute_loaders{};
     int num_total_attributes = 0;
     bool is_setup = false;
 };
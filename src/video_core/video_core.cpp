@@ -23,6 +23,8 @@ std::unique_ptr<RendererBase> g_renderer{}; ///< Renderer plugin
 std::atomic<bool> g_shader_jit_enabled;
 std::atomic<bool> g_hw_shader_enabled;
 std::atomic<bool> g_hw_shader_accurate_mul;
+std::atomic<u32> g_vertex_shader_threads;
+std::atomic<u32> g_vertex_cache_size;
 
 Memory::MemorySystem* g_memory;
 
@@ -7,6 +7,7 @@
 #include <atomic>
 #include <functional>
 #include <memory>
+#include "common/common_types.h"
 
 namespace Frontend {
 class EmuWindow;
@@ -31,6 +32,8 @@ extern std::unique_ptr<RendererBase> g_renderer; ///< Renderer plugin
 extern std::atomic<bool> g_shader_jit_enabled;
 extern std::atomic<bool> g_hw_shader_enabled;
 extern std::atomic<bool> g_hw_shader_accurate_mul;
+extern std::atomic<u32> g_vertex_shader_threads;
+extern std::atomic<u32> g_vertex_cache_size;
 
 extern Memory::MemorySystem* g_memory;
 